@@ -41,6 +41,7 @@ public:
     MTLGrammar(OBJState* state);
 
     void resetCurrentTexture();
+    void finishCurrentTexture(OBJTextureSlot slot);
     void finishCurrentMaterial();
 
 protected:
@@ -0,0 +1,275 @@
+/*
+ * Copyright 2016 Steven T Sell (ssell@vertexfragment.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef __H__OBJ_PARSER_ARENA__H__
+#define __H__OBJ_PARSER_ARENA__H__
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+//------------------------------------------------------------------------------------------
+
+/**
+ * \class OBJArena
+ *
+ * Monotonic memory arena used to back the containers of an OBJState.
+ *
+ * Small allocations are bumped out of a list of shared blocks, while allocations larger 
+ * than half of the block size (typically the vertex and face buffers) are given a dedicated 
+ * block of their own. Individual deallocations are mostly ignored: only the most recent 
+ * allocation in a shared block is rolled back, and dedicated blocks are freed immediately.
+ *
+ * All memory is reclaimed at once by reset. Shared blocks are retained between resets, so
+ * an arena that is reused for many parses will quickly stop requesting memory from the system.
+ *
+ * If huge pages are enabled, dedicated blocks of at least 2 MiB are mapped directly and 
+ * marked as eligible for (transparent) huge pages, reducing TLB pressure when walking
+ * large vertex buffers. If the system does not support them, regular pages are used.
+ *
+ * \note The arena is not thread-safe.
+ */
+class OBJArena
+{
+public:
+
+    /**
+     * \param[in] blockSize Size, in bytes, of each shared block.
+     * \param[in] hugePages If true, large dedicated blocks will request huge pages.
+     */
+    OBJArena(std::size_t blockSize = 1048576, bool hugePages = false);
+    ~OBJArena();
+
+    /**
+     * \param[in] bytes     Size of the allocation.
+     * \param[in] alignment Required alignment. Must be a power of two.
+     * \return Pointer to the allocated memory. Throws std::bad_alloc on failure.
+     */
+    void* allocate(std::size_t bytes, std::size_t alignment);
+
+    /**
+     * Returns memory to the arena. This only has an effect if the allocation is the latest
+     * within its shared block, or if the allocation was given a dedicated block.
+     *
+     * \param[in] ptr   Pointer previously returned by allocate.
+     * \param[in] bytes Size originally passed to allocate.
+     */
+    void deallocate(void* ptr, std::size_t bytes);
+
+    /**
+     * Reclaims all allocations. Shared blocks are retained, dedicated blocks are freed.
+     * \note Any remaining pointers into the arena are invalidated.
+     */
+    void reset();
+
+    /**
+     * Reclaims all allocations and frees all blocks.
+     */
+    void release();
+
+    /**
+     * \return Number of bytes currently handed out by the arena (including alignment padding).
+     */
+    std::size_t getBytesUsed() const;
+
+    /**
+     * \return Number of bytes currently held by the arena, whether in use or not.
+     */
+    std::size_t getBytesReserved() const;
+
+    bool usesHugePages() const;
+
+protected:
+
+    struct Block
+    {
+        char* base;             ///< Start of the underlying allocation
+        char* data;             ///< Start of usable memory (may differ from base for dedicated blocks)
+        std::size_t size;       ///< Usable size, starting from data
+        std::size_t used;       ///< Bytes in use, starting from data
+        bool mapped;            ///< True if the block was mapped directly from the system
+        std::size_t mappedSize; ///< Size of the mapping if mapped is true
+    };
+
+    Block createBlock(std::size_t size, std::size_t alignment);
+    void destroyBlock(Block const& block);
+
+    void* allocateDedicated(std::size_t bytes, std::size_t alignment);
+
+    //--------------------------------------------------------------------
+
+    std::vector<Block> m_Blocks;             ///< Shared blocks that small allocations are bumped out of
+    std::vector<Block> m_DedicatedBlocks;    ///< Blocks each holding a single large allocation
+
+    std::size_t m_CurrentBlock;              ///< Index of the shared block currently being allocated from
+    std::size_t m_BlockSize;
+    bool m_HugePages;
+
+private:
+
+    OBJArena(OBJArena const&) = delete;
+    OBJArena& operator=(OBJArena const&) = delete;
+};
+
+//------------------------------------------------------------------------------------------
+
+/**
+ * \class OBJArenaAllocator
+ *
+ * Standard allocator that sources its memory from an OBJArena.
+ * If no arena is provided, the global operator new/delete are used instead.
+ *
+ * Copies of a container do not inherit the arena (see select_on_container_copy_construction),
+ * while moved and swapped containers keep their own. Elements that must live in the arena
+ * are therefore constructed with the allocator, and assigned to, rather than copied in.
+ */
+template<typename T>
+class OBJArenaAllocator
+{
+public:
+
+    typedef T value_type;
+    typedef T* pointer;
+    typedef T const* const_pointer;
+    typedef T& reference;
+    typedef T const& const_reference;
+    typedef std::size_t size_type;
+    typedef std::ptrdiff_t difference_type;
+
+    template<typename U>
+    struct rebind
+    {
+        typedef OBJArenaAllocator<U> other;
+    };
+
+    OBJArenaAllocator()
+        : m_pArena(nullptr)
+    {
+
+    }
+
+    explicit OBJArenaAllocator(OBJArena* arena)
+        : m_pArena(arena)
+    {
+
+    }
+
+    template<typename U>
+    OBJArenaAllocator(OBJArenaAllocator<U> const& other)
+        : m_pArena(other.getArena())
+    {
+
+    }
+
+    T* allocate(std::size_t count)
+    {
+        T* result = nullptr;
+
+        if(m_pArena)
+        {
+            result = static_cast<T*>(m_pArena->allocate(count * sizeof(T), std::alignment_of<T>::value));
+        }
+        else
+        {
+            result = static_cast<T*>(::operator new(count * sizeof(T)));
+        }
+
+        return result;
+    }
+
+    void deallocate(T* ptr, std::size_t count)
+    {
+        if(m_pArena)
+        {
+            m_pArena->deallocate(ptr, count * sizeof(T));
+        }
+        else
+        {
+            ::operator delete(ptr);
+        }
+    }
+
+    /**
+     * Copies are allocated from the heap, so that a copy taken out of a state
+     * remains valid once the arena is reset, and may be made from any thread.
+     */
+    OBJArenaAllocator select_on_container_copy_construction() const
+    {
+        return OBJArenaAllocator();
+    }
+
+    OBJArena* getArena() const
+    {
+        return m_pArena;
+    }
+
+protected:
+
+    OBJArena* m_pArena;
+
+private:
+};
+
+template<typename T, typename U>
+bool operator==(OBJArenaAllocator<T> const& lhs, OBJArenaAllocator<U> const& rhs)
+{
+    return (lhs.getArena() == rhs.getArena());
+}
+
+template<typename T, typename U>
+bool operator!=(OBJArenaAllocator<T> const& lhs, OBJArenaAllocator<U> const& rhs)
+{
+    return (lhs.getArena() != rhs.getArena());
+}
+
+template<typename T>
+using OBJArenaVector = std::vector<T, OBJArenaAllocator<T>>;
+
+using OBJArenaString = std::basic_string<char, std::char_traits<char>, OBJArenaAllocator<char>>;
+
+/**
+ * Empties a container and frees its storage back to its allocator.
+ *
+ * Unlike clear, no capacity is retained. This (or OBJAbandonContainer) must be done to every 
+ * arena-backed container before the arena is reset, as the retained capacity would otherwise dangle.
+ */
+template<typename T>
+void OBJReleaseContainer(T& container)
+{
+    T(container.get_allocator()).swap(container);
+}
+
+/**
+ * Empties an arena-backed container in constant time, by dropping its elements and storage
+ * without destroying or freeing them.
+ *
+ * Only valid if the container, and everything owned by its elements, was allocated from 
+ * the arena, and if the arena is reset before it is used again. Otherwise the elements leak.
+ */
+template<typename T>
+void OBJAbandonContainer(T& container)
+{
+    const typename T::allocator_type allocator = container.get_allocator();
+    new (&container) T(allocator);
+}
+
+//------------------------------------------------------------------------------------------
+
+#endif
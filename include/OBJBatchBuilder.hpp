@@ -0,0 +1,139 @@
+/*
+ * Copyright 2016 Steven T Sell (ssell@vertexfragment.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef __H__OBJ_PARSER_BATCH_BUILDER__H__
+#define __H__OBJ_PARSER_BATCH_BUILDER__H__
+
+#include "OBJArena.hpp"
+#include "OBJStructs.hpp"
+
+#include <string>
+#include <vector>
+
+class OBJGroup;
+class OBJMaterial;
+class OBJState;
+
+//------------------------------------------------------------------------------------------
+
+/**
+ * \struct OBJDrawBatch
+ * \brief Run of faces within OBJDrawBatches::faces that share a material (and optionally smoothing group).
+ */
+struct OBJDrawBatch
+{
+    OBJDrawBatch();
+
+    uint32_t material;      ///< Index into OBJDrawBatches::materials, or OBJDrawBatches::NoMaterial
+    uint32_t smoothing;     ///< Smoothing group of all faces. Always 0 if smoothing groups are not split.
+    uint32_t firstFace;     ///< Offset of the first face within OBJDrawBatches::faces
+    uint32_t faceCount;     ///< Number of consecutive faces in the batch
+};
+
+/**
+ * \struct OBJDrawBatches
+ * \brief Faces of a state partitioned by material. See OBJBatchBuilder.
+ */
+struct OBJDrawBatches
+{
+    static const uint32_t NoMaterial = 0xFFFFFFFF;   ///< Faces without a material, or with a material not defined by any parsed library
+
+    /**
+     * Returns the index of the named material within materials, or NoMaterial if there is no such material.
+     * \param[in] name
+     */
+    uint32_t findMaterial(OBJArenaString const& name) const;
+
+    std::vector<OBJMaterial const*> materials;       ///< All parsed materials, sorted by name. Invalidated when the state is cleared.
+    std::vector<OBJDrawBatch> batches;               ///< Sorted by material index (NoMaterial last), then smoothing group
+    std::vector<OBJFace const*> faces;               ///< All faces, ordered by batch. Within a batch, in group order and then face order.
+};
+
+//------------------------------------------------------------------------------------------
+
+/**
+ * \class OBJBatchBuilder
+ *
+ * Partitions the faces of all groups of a parsed state into per-material draw batches.
+ *
+ * Materials are resolved once per unique render state, rather than once per face, and 
+ * faces are counted by render state range. The groups are then split into contiguous 
+ * chunks of roughly equal face counts, which are counted and scattered into place on 
+ * separate threads. As each chunk writes to precomputed offsets, the ordering of the 
+ * result does not depend on the number of threads.
+ */
+class OBJBatchBuilder
+{
+public:
+
+    OBJBatchBuilder();
+    ~OBJBatchBuilder();
+
+    /**
+     * Sets whether faces of different smoothing groups are placed in separate batches. Default is false.
+     * \param[in] split
+     */
+    void setSplitSmoothing(bool split);
+
+    /**
+     * Sets the maximum number of threads used to build the batches. 
+     *
+     * \param[in] count If 0 (the default), the number of hardware threads is used.
+     */
+    void setThreadCount(uint32_t count);
+
+    /**
+     * Builds the draw batches from the faces of all groups of the state.
+     *
+     * \param[in]  state   State to read the faces and materials from.
+     * \param[out] batches Receives the batches. Any previous contents are replaced.
+     * \return False if the state has more faces than may be addressed by 32-bit offsets.
+     */
+    bool build(OBJState const& state, OBJDrawBatches& batches);
+
+protected:
+
+    /**
+     * Contiguous range of groups processed by a single thread.
+     */
+    struct Chunk
+    {
+        std::size_t firstGroup;
+        std::size_t endGroup;
+        std::vector<uint32_t> offsets;      ///< Per batch; face counts of the chunk, and then write offsets
+    };
+
+    void resolveRenderStates(OBJState const& state, OBJDrawBatches& batches);
+    void splitChunks(uint64_t faceCount, std::size_t batchCount);
+    void countChunk(Chunk& chunk) const;
+    void scatterChunk(Chunk& chunk, OBJDrawBatches& batches) const;
+
+    //--------------------------------------------------------------------
+
+    bool m_SplitSmoothing;
+    uint32_t m_ThreadCount;
+
+    std::vector<OBJGroup const*> m_Groups;
+    std::vector<uint32_t> m_RenderStateBatches;     ///< Batch index of each render state of the current build
+    std::vector<Chunk> m_Chunks;
+
+private:
+};
+
+//------------------------------------------------------------------------------------------
+
+#endif
@@ -21,7 +21,9 @@
 
 #define BOOST_SPIRIT_USE_PHOENIX_V3
 
+#ifdef _MSC_VER
 #pragma warning (disable:4348)
+#endif
 #include <boost/spirit/include/qi.hpp>
 #include <boost/spirit/include/phoenix.hpp>
 
@@ -17,6 +17,8 @@
 #ifndef __H__OBJ_PARSER_FREE_FORM_ATTRIBUTE_STATE__H__
 #define __H__OBJ_PARSER_FREE_FORM_ATTRIBUTE_STATE__H__
 
+#include "OBJArena.hpp"
+
 #include <boost/fusion/adapted.hpp>
 #include <cstdint>
 #include <vector>
@@ -51,6 +53,24 @@ struct OBJFreeFormAttributeState
     
     }
 
+    /**
+     * \param[in] arena Arena to allocate the basis matrices from. May be nullptr.
+     */
+    explicit OBJFreeFormAttributeState(OBJArena* arena)
+        : type(OBJFreeFormType::None),
+          rational(false),
+          degreeU(0),
+          degreeV(0),
+          stepU(0),
+          stepV(0),
+          mergeGroupNumber(0),
+          mergeGroupResolution(0.0f),
+          basisMatrixU(OBJArenaAllocator<float>(arena)),
+          basisMatrixV(OBJArenaAllocator<float>(arena))
+    {
+    
+    }
+
     //--------------------------------------------------------------------
 
     OBJFreeFormType type;                   ///< 
@@ -65,8 +85,8 @@ struct OBJFreeFormAttributeState
     int32_t mergeGroupNumber;               ///< Merging group number. A value of 0 indicates no adjacency detection.
     float mergeGroupResolution;             ///< Maximum distance between two merged surfaces. Must be greater than 0.0 if merging is on.
 
-    std::vector<float> basisMatrixU;        ///< 
-    std::vector<float> basisMatrixV;        ///< 
+    OBJArenaVector<float> basisMatrixU;     ///< 
+    OBJArenaVector<float> basisMatrixV;     ///< 
 };
 
 //------------------------------------------------------------------------------------------
@@ -19,11 +19,19 @@
 
 #include "OBJStructs.hpp"
 #include "OBJFreeFormAttributeState.hpp"
+#include "OBJArena.hpp"
 
 //------------------------------------------------------------------------------------------
 
 /**
  * \class OBJFreeFormState
+ *
+ * Container of all free-form geometry and attributes.
+ *
+ * The variable-length data of each free-form (control points, parameters, trimming
+ * curves, etc.) is not owned by the free-form itself, but is instead stored within
+ * one of several shared pools. Each free-form references its data via OBJPoolRange
+ * members, which may be resolved using the get methods of this class.
  */
 class OBJFreeFormState
 {
@@ -38,34 +46,97 @@ class OBJFreeFormState
 public:
 
     OBJFreeFormState();
-    ~OBJFreeFormState();
 
-    void addCurve(uint32_t state, float startParam, float endParam, std::vector<OBJVertexGroup> const& controlPoints);
-    void addCurve2D(uint32_t state, std::vector<int32_t> const& controlPoints);
-    void addSurface(uint32_t state, float startU, float endU, float startV, float endV, std::vector<OBJVertexGroup> const& controlPoints);
+    /**
+     * \param[in] arena Arena to allocate all containers and pools from. May be nullptr.
+     */
+    explicit OBJFreeFormState(OBJArena* arena);
 
-    void addParameterU(std::vector<float> const& parameters);
-    void addParameterV(std::vector<float> const& parameters);
+    ~OBJFreeFormState();
+
+    /**
+     * Clears all free-forms, attribute states, and pools. Pool capacity is retained.
+     */
+    void clear();
+
+    /**
+     * As clear, but the storage of all containers and pools is also freed.
+     * This, or abandon, must be called prior to resetting the arena that the state was created with.
+     */
+    void release();
+
+    /**
+     * As release, but in constant time: the containers and pools are dropped without being destroyed
+     * or freed (see OBJAbandonContainer). Only valid if the state was created with an arena, and 
+     * if that arena is reset immediately after.
+     */
+    void abandon();
+
+    /**
+     * Exchanges all free-forms, attribute states, and pools (along with their storage) of two states.
+     * \param[in] other
+     */
+    void swap(OBJFreeFormState& other);
+
+    void addCurve(uint32_t state, float startParam, float endParam);
+    void addCurve2D(uint32_t state);
+    void addSurface(uint32_t state, float startU, float endU, float startV, float endV);
+
+    void addControlPoint(OBJVertexGroup const& point);
+    void addCurve2DPoint(OBJIndex point);
+
+    void addParameterU(float parameter);
+    void addParameterV(float parameter);
     void addTrim(OBJSimpleCurve const& trim);
     void addHole(OBJSimpleCurve const& hole);
     void addSpecialCurve(OBJSimpleCurve const& scurve);
-    void addSpecialPoints(std::vector<int32_t> const& points);
+    void addSpecialPoint(OBJIndex point);
+
+    /**
+     * \param[in] range Range within controlPointPool. See OBJCurve::controlPoints and OBJSurface::controlPoints.
+     * \return Pointer to the first element of the range, or nullptr if the range is empty.
+     */
+    OBJVertexGroup const* getControlPoints(OBJPoolRange const& range) const;
+
+    /**
+     * \param[in] range Range within parameterPool. See OBJFreeForm::parametersU and OBJFreeForm::parametersV.
+     * \return Pointer to the first element of the range, or nullptr if the range is empty.
+     */
+    float const* getParameters(OBJPoolRange const& range) const;
+
+    /**
+     * \param[in] range Range within simpleCurvePool. See OBJFreeForm::trims, OBJFreeForm::holes, and OBJFreeForm::specialCurves.
+     * \return Pointer to the first element of the range, or nullptr if the range is empty.
+     */
+    OBJSimpleCurve const* getSimpleCurves(OBJPoolRange const& range) const;
+
+    /**
+     * \param[in] range Range within indexPool. See OBJCurve2D::parameterVertexIndices and OBJFreeForm::specialPoints.
+     * \return Pointer to the first element of the range, or nullptr if the range is empty.
+     */
+    OBJIndex const* getIndices(OBJPoolRange const& range) const;
 
     //--------------------------------------------------------------------
     
-    std::vector<OBJFreeFormAttributeState> attributeStates;     ///< Collection of all attribute states. Each state represents a 'ctype' statement and the following state settings.
+    OBJArenaVector<OBJFreeFormAttributeState> attributeStates;  ///< Collection of all attribute states. Each state represents a 'ctype' statement and the following state settings.
+
+    OBJArenaVector<OBJVector3> vertexParameterData;             ///< Collection of all data specified by 'vp' statements. These are referenced by OBJCurve2D::parameterVertexIndices.
 
-    std::vector<OBJVector3> vertexParameterData;                ///< Collection of all data specified by 'vp' statements. These are referenced by OBJCurve2D::parameterVertexIndices.
+    OBJArenaVector<OBJCurve> curves;                            ///< Collection of all Curves specified by 'curv' statements.
+    OBJArenaVector<OBJCurve2D> curves2D;                        ///< Collection of all Curve2Ds specified by 'curv2' statements.
+    OBJArenaVector<OBJSurface> surfaces;                        ///< Collection of all Surfaces specified by 'surf' statements.
 
-    std::vector<OBJCurve> curves;                               ///< Collection of all Curves specified by 'curv' statements.
-    std::vector<OBJCurve2D> curves2D;                           ///< Collection of all Curve2Ds specified by 'curv2' statements.
-    std::vector<OBJSurface> surfaces;                           ///< Collection of all Surfaces specified by 'surf' statements.
+    OBJArenaVector<OBJSurfaceConnection> connections;           ///< Collection of all Surface connections specified by 'con' statements.
 
-    std::vector<OBJSurfaceConnection> connections;              ///< Collection of all Surface connections specified by 'con' statements.
+    OBJArenaVector<OBJVertexGroup> controlPointPool;            ///< Control points of all curves and surfaces.
+    OBJArenaVector<float> parameterPool;                        ///< Parameter values of all free-forms ('parm' statements).
+    OBJArenaVector<OBJSimpleCurve> simpleCurvePool;             ///< Trims, holes, and special curves of all free-forms.
+    OBJArenaVector<OBJIndex> indexPool;                         ///< Curve2D parameter vertex indices and special points of all free-forms.
 
 protected:
 
     OBJFreeForm* getLatestFreeForm();
+    OBJPoolRange* getLatestControlPoints();
 
     //--------------------------------------------------------------------
 
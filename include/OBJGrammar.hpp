@@ -50,14 +50,20 @@ private:
     void setupGroupRules();
     void setupVertexRules();
     void setupFaceRules();
+    void setupMaterialRules();
+    void setupRenderStateRules();
+
+#ifndef OBJ_PARSER_NO_FREE_FORMS
     void setupFreeFormRules();
     void setupFreeFormStart();
     void setupFreeFormBody();
     void setupFreeFormEnd();
     void setupFreeFormAttributes();
     void setupFreeFormConnections();
-    void setupMaterialRules();
-    void setupRenderStateRules();
+    void setupFreeFormTechniqueRules();
+#else
+    void setupFreeFormSkipRule();
+#endif
 
     //--------------------------------------------------------------------------------------
     // Member Variables
@@ -70,7 +76,11 @@ private:
     qi::rule<OBJIterator, OBJSkipper> ruleStart;
     qi::rule<OBJIterator, OBJSkipper> ruleVertices;
     qi::rule<OBJIterator, OBJSkipper> ruleFaces;
+#ifndef OBJ_PARSER_NO_FREE_FORMS
     qi::rule<OBJIterator, OBJSkipper> ruleFreeForms;
+#else
+    qi::rule<OBJIterator, OBJSkipper> ruleFreeFormSkip;     ///< Consumes free-form statements without storing them
+#endif
     qi::rule<OBJIterator, OBJSkipper> ruleMaterials;
     qi::rule<OBJIterator, OBJSkipper> ruleRenderState;
     qi::rule<OBJIterator, OBJSkipper> ruleEmptyLine;
@@ -88,10 +98,13 @@ private:
 
     qi::rule<OBJIterator, OBJVector2(), OBJSkipper> ruleVector2Data;            ///< Parses "#.# #.#" of vertex point declarations (vt)
     qi::rule<OBJIterator, OBJVector3(), OBJSkipper> ruleVector3Data;            ///< Parses "#.# #.# #.#" of vertex point declarations (vn)
-    qi::rule<OBJIterator, OBJVector4(), OBJSkipper> ruleVector4Data;            ///< Parses "#.# #.# #.# #.#" where the fourth element is optional (v)
-    qi::rule<OBJIterator, OBJVertexGroup(), OBJSkipper> ruleVertexGroupData;    ///< Parses "#/#/#" of vertex group declarations. Secondary elements (and their slashes) are optional.
-    qi::rule<OBJIterator, int32_t(), OBJSkipper> ruleIndexValue;
-    qi::rule<OBJIterator, std::vector<OBJVertexGroup>(), OBJSkipper> ruleIndexList;
+    qi::rule<OBJIterator, OBJParsedSpatialVector(), OBJSkipper> ruleVector4Data; ///< Parses "#.# #.# #.# #.#" where the fourth element is optional and defaults to 1.0 (v)
+#ifndef OBJ_PARSER_NO_FREE_FORMS
+    qi::rule<OBJIterator, OBJVector3(), OBJSkipper> ruleVertexParameterData;    ///< Parses "#.# #.# #.#" where the second and third elements are optional (vp)
+#endif
+    qi::rule<OBJIterator, OBJParsedVertexGroup(), OBJSkipper> ruleVertexGroupData; ///< Parses "#/#/#" of vertex group declarations. Secondary elements (and their slashes) are optional.
+    qi::rule<OBJIterator, OBJParsedVertexGroup(), OBJSkipper> ruleListVertexGroupData; ///< As ruleVertexGroupData, but the spatial index is required. Used for variable-length lists.
+    qi::rule<OBJIterator, OBJIndex(), OBJSkipper> ruleIndexValue;
     qi::rule<OBJIterator, std::string(), OBJSkipper> ruleName;
 
     //--------------------------------------------------------------------
@@ -101,18 +114,22 @@ private:
     qi::rule<OBJIterator, OBJSkipper> ruleVertexSpatial;
     qi::rule<OBJIterator, OBJSkipper> ruleVertexTexture;
     qi::rule<OBJIterator, OBJSkipper> ruleVertexNormal;
+#ifndef OBJ_PARSER_NO_FREE_FORMS
     qi::rule<OBJIterator, OBJSkipper> ruleVertexParameter;
+#endif
 
     //--------------------------------------------------------------------
     // Face Rules
     //--------------------------------------------------------------------
 
-    qi::rule<OBJIterator, OBJFace(), OBJSkipper> ruleFaceData;
+    qi::rule<OBJIterator, OBJParsedFace(), OBJSkipper> ruleFaceData;
     qi::rule<OBJIterator, OBJSkipper> ruleFace;
 
     qi::rule<OBJIterator, OBJSkipper> ruleLine;
     qi::rule<OBJIterator, OBJSkipper> rulePoint;
 
+#ifndef OBJ_PARSER_NO_FREE_FORMS
+
     //--------------------------------------------------------------------
     // Free-Form Rules
     //--------------------------------------------------------------------
@@ -122,18 +139,18 @@ private:
     qi::rule<OBJIterator, OBJSkipper> ruleFreeFormStart;
 
     qi::rule<OBJIterator, OBJSkipper> ruleFreeFormCurve;  
-    qi::rule<OBJIterator, OBJCurve(), OBJSkipper> ruleFreeFormCurveData;
-
     qi::rule<OBJIterator, OBJSkipper> ruleFreeFormCurve2D;  
-    qi::rule<OBJIterator, std::vector<int32_t>(), OBJSkipper> ruleFreeFormCurve2DData;
-
     qi::rule<OBJIterator, OBJSkipper> ruleFreeFormSurface; 
-    qi::rule<OBJIterator, OBJSurface(), OBJSkipper> ruleFreeFormSurfaceData;
+    qi::rule<OBJIterator, OBJSkipper> ruleFreeFormControlPoints;   ///< Parses the control point list of curves and surfaces, appending each point as it is parsed
 
     // body statements (may only appear between start and end statements)
 
     qi::rule<OBJIterator, OBJSkipper> ruleFreeFormBody;
 
+    qi::rule<OBJIterator, OBJSimpleCurve(), OBJSkipper> ruleSimpleCurveData;
+
+    qi::rule<OBJIterator, OBJSkipper> ruleFreeFormParameterU;      // parm u
+    qi::rule<OBJIterator, OBJSkipper> ruleFreeFormParameterV;      // parm v
     qi::rule<OBJIterator, OBJSkipper> ruleFreeFormParameter;       // parm
     qi::rule<OBJIterator, OBJSkipper> ruleFreeFormTrim;            // trim
     qi::rule<OBJIterator, OBJSkipper> ruleFreeFormHole;            // hole
@@ -154,9 +171,18 @@ private:
     qi::rule<OBJIterator, OBJSkipper> ruleFreeFormBasisMatrix;     // bmat
     qi::rule<OBJIterator, OBJSkipper> ruleFreeFormMergeGroup;      // mg
 
+    qi::rule<OBJIterator, bool(), OBJSkipper> ruleFreeFormRational;
+    qi::rule<OBJIterator, OBJSkipper> ruleFreeFormTypes;
+    qi::rule<OBJIterator, std::vector<float>(), OBJSkipper> ruleFreeFormMatrixData;
+    qi::rule<OBJIterator, OBJSkipper> ruleFreeFormBasisU;
+    qi::rule<OBJIterator, OBJSkipper> ruleFreeFormBasisV;
+
     // connections
 
     qi::rule<OBJIterator, OBJSkipper> ruleFreeFormConnection;      // con
+    qi::rule<OBJIterator, OBJSurfaceConnection(), OBJSkipper> ruleFreeFormConnectionData;
+
+#endif
 
     //--------------------------------------------------------------------
     // Material Rules
@@ -186,9 +212,19 @@ private:
 
     // free-form only
 
+#ifndef OBJ_PARSER_NO_FREE_FORMS
     qi::rule<OBJIterator, OBJSkipper> ruleFreeFormCurveTech; 
     qi::rule<OBJIterator, OBJSkipper> ruleFreeFormSurfaceTech;  
 
+    qi::rule<OBJIterator, OBJSkipper> ruleCurveParametric;         // ctech cparm
+    qi::rule<OBJIterator, OBJSkipper> ruleCurveSpatial;            // ctech cspace
+    qi::rule<OBJIterator, OBJSkipper> ruleCurveCurvature;          // ctech curv
+    qi::rule<OBJIterator, OBJSkipper> ruleSurfaceParametricA;      // stech cparma
+    qi::rule<OBJIterator, OBJSkipper> ruleSurfaceParametricB;      // stech cparmb
+    qi::rule<OBJIterator, OBJSkipper> ruleSurfaceSpatial;          // stech cspace
+    qi::rule<OBJIterator, OBJSkipper> ruleSurfaceCurvature;        // stech curv
+#endif
+
     //--------------------------------------------------------------------
     // Non-Rule Members
     //--------------------------------------------------------------------
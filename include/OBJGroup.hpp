@@ -18,6 +18,8 @@
 #define __H__OBJ_PARSER_GROUP__H__
 
 #include "OBJStructs.hpp"
+#include "OBJArena.hpp"
+#include "OBJSegmentedVector.hpp"
 
 //------------------------------------------------------------------------------------------
 
@@ -40,18 +42,113 @@ class OBJGroup
 public:
 
     OBJGroup();
+
+    /**
+     * \param[in] arena Arena to allocate the name and all element containers from. May be nullptr.
+     */
+    explicit OBJGroup(OBJArena* arena);
+
     ~OBJGroup();
 
+    /**
+     * Removes all elements from the group and marks it inactive. Element capacity is retained.
+     */
+    void clear();
+
+    /**
+     * Exchanges the name, elements, and element storage of two groups.
+     * Both groups must have been created with the same arena (or both without one).
+     * \param[in] other
+     */
+    void swap(OBJGroup& other);
+
+    /**
+     * \return Number of bytes of element storage currently held by the group.
+     */
+    std::size_t getCapacityBytes() const;
+
+    /**
+     * Appends a face to the group, extending the current render state range
+     * or starting a new one if the face's render state differs from the last face.
+     *
+     * \param[in] face Face to add. Indices are expected to already be transformed.
+     */
+    void addFace(OBJFace const& face);
+
+    /**
+     * Appends a complete line to the group.
+     * \param[in] line Line vertices. Indices are expected to already be transformed.
+     */
     void addLine(std::vector<OBJVertexGroup> const& line);
+
+    /**
+     * Appends a complete point collection to the group.
+     * \param[in] points Point vertices. Indices are expected to already be transformed.
+     */
     void addPointCollection(std::vector<OBJVertexGroup> const& points);
 
+    /**
+     * Starts a new, empty, line. Following calls to addLineVertex append to this line.
+     */
+    void beginLine();
+
+    /**
+     * Appends a vertex to the line most recently started with beginLine.
+     * \param[in] vertex Indices are expected to already be transformed.
+     */
+    void addLineVertex(OBJVertexGroup const& vertex);
+
+    /**
+     * Starts a new, empty, point collection. Following calls to addPointVertex append to this collection.
+     */
+    void beginPointCollection();
+
+    /**
+     * Appends a vertex to the point collection most recently started with beginPointCollection.
+     * \param[in] vertex Indices are expected to already be transformed.
+     */
+    void addPointVertex(OBJVertexGroup const& vertex);
+
+    /**
+     * \return Number of lines in the group.
+     */
+    OBJCount getLineCount() const;
+
+    /**
+     * Retrieves the vertices of the specified line.
+     *
+     * \param[in]  index Line index in the range [0, getLineCount()).
+     * \param[out] count Number of vertices (segment end points) in the line.
+     * \return Pointer to the first vertex of the line within lineVertices.
+     */
+    OBJVertexGroup const* getLine(OBJCount index, OBJCount& count) const;
+
+    /**
+     * \return Number of point collections in the group.
+     */
+    OBJCount getPointCollectionCount() const;
+
+    /**
+     * Retrieves the vertices of the specified point collection.
+     *
+     * \param[in]  index Point collection index in the range [0, getPointCollectionCount()).
+     * \param[out] count Number of points in the collection.
+     * \return Pointer to the first point of the collection within pointVertices.
+     */
+    OBJVertexGroup const* getPointCollection(OBJCount index, OBJCount& count) const;
+
     //--------------------------------------------------------------------
 
-    std::string name;
+    OBJArenaString name;
+
+    OBJSegmentedVector<OBJFace> faces;                     ///< Faces of the group. Stored in blocks, so appending never relocates existing faces.
+    OBJArenaVector<OBJRenderStateRange> renderStateRanges; ///< Run-length ranges of faces sharing a render state, in face order.
+
+    OBJArenaVector<OBJVertexGroup> lineVertices;           ///< Vertices of all lines, stored back-to-back. See getLine.
+    OBJArenaVector<OBJCount> lineOffsets;                  ///< Offset of the first vertex of each line within lineVertices.
 
-    std::vector<OBJFace> faces; 
-    std::vector<OBJLine> lines;
-    std::vector<OBJPoint> points;
+    OBJArenaVector<OBJVertexGroup> pointVertices;          ///< Vertices of all point collections, stored back-to-back. See getPointCollection.
+    OBJArenaVector<OBJCount> pointOffsets;                 ///< Offset of the first vertex of each point collection within pointVertices.
 
     bool active;
 
@@ -0,0 +1,95 @@
+/*
+ * Copyright 2016 Steven T Sell (ssell@vertexfragment.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef __H__OBJ_PARSER_MAPPED_REGION__H__
+#define __H__OBJ_PARSER_MAPPED_REGION__H__
+
+#include <cstddef>
+
+//------------------------------------------------------------------------------------------
+
+/**
+ * \class OBJMappedRegion
+ *
+ * Block of anonymous memory mapped directly from the system (mmap / VirtualAlloc).
+ *
+ * Mapped memory is zero-filled, committed lazily by the system, and returned to the 
+ * system immediately upon release (rather than to the heap). Optionally, huge pages 
+ * may be requested, which reduces TLB pressure when walking large buffers.
+ */
+class OBJMappedRegion
+{
+public:
+
+    OBJMappedRegion();
+    ~OBJMappedRegion();
+
+    /**
+     * Maps a new region, releasing any previously mapped region.
+     *
+     * \param[in] bytes     Minimum size of the region.
+     * \param[in] hugePages If true, huge pages are requested. Falls back to regular pages if unavailable.
+     * \return True if the region was successfully mapped.
+     */
+    bool create(std::size_t bytes, bool hugePages = false);
+
+    /**
+     * Unmaps the region, if any.
+     */
+    void release();
+
+    /**
+     * Makes the region read-only. Any following write to it faults.
+     * \return True if the protection was changed.
+     */
+    bool protect();
+
+    void* getData() const;
+    std::size_t getSize() const;
+
+    /**
+     * Maps anonymous memory. If huge pages are requested, the returned region is aligned
+     * to a huge page boundary.
+     *
+     * \param[in,out] bytes     Requested size. Upon success, set to the actual size of the mapping.
+     * \param[in]     hugePages If true, huge pages are requested.
+     * \return Start of the mapping, or nullptr on failure.
+     */
+    static void* mapMemory(std::size_t& bytes, bool hugePages);
+
+    /**
+     * \param[in] ptr   Pointer previously returned by mapMemory.
+     * \param[in] bytes Size of the mapping as returned by mapMemory.
+     */
+    static void unmapMemory(void* ptr, std::size_t bytes);
+
+    static const std::size_t HugePageSize = 2097152;    ///< 2 MiB, the common huge page size on both x86-64 and AArch64
+
+protected:
+
+    void* m_pData;
+    std::size_t m_Size;
+
+private:
+
+    OBJMappedRegion(OBJMappedRegion const&) = delete;
+    OBJMappedRegion& operator=(OBJMappedRegion const&) = delete;
+};
+
+//------------------------------------------------------------------------------------------
+
+#endif
@@ -17,6 +17,7 @@
 #ifndef __H__OBJ_PARSER_MTL_MATERIAL__H__
 #define __H__OBJ_PARSER_MTL_MATERIAL__H__
 
+#include "OBJArena.hpp"
 #include "OBJTextureDescriptor.hpp"
 
 #include <string>
@@ -43,11 +44,16 @@ struct OBJMaterialPropertyRFL
 {
     OBJMaterialPropertyRFL();
 
-    std::string path;
+    /**
+     * \param[in] arena Arena to allocate the path from. May be nullptr.
+     */
+    explicit OBJMaterialPropertyRFL(OBJArena* arena);
+
+    OBJArenaString path;
     float factor;
 };
 
-BOOST_FUSION_ADAPT_STRUCT(OBJMaterialPropertyRFL, (std::string, path), (float, factor));
+BOOST_FUSION_ADAPT_STRUCT(OBJMaterialPropertyRFL, (OBJArenaString, path), (float, factor));
 
 /**
  * \struct OBJMaterialProperty
@@ -61,7 +67,11 @@ BOOST_FUSION_ADAPT_STRUCT(OBJMaterialPropertyRFL, (std::string, path), (float, f
 struct OBJMaterialProperty
 {
     OBJMaterialProperty();
-    OBJMaterialProperty const& operator=(OBJMaterialProperty const& rhs);
+
+    /**
+     * \param[in] arena Arena to allocate the RFL path from. May be nullptr.
+     */
+    explicit OBJMaterialProperty(OBJArena* arena);
 
     //--------------------------------------------------------------------
 
@@ -114,16 +124,55 @@ enum class OBJReflectionMapCubeSide
     Right
 };
 
+/**
+ * \enum OBJTextureSlot
+ *
+ * Texture maps of a material. The cube reflection slots are in the order of OBJReflectionMapCubeSide.
+ */
+enum class OBJTextureSlot
+{
+    Ambient = 0,            ///< map_Ka
+    Diffuse,                ///< map_Kd
+    Specular,               ///< map_Ks
+    SpecularExponent,       ///< map_Ns
+    Emissive,               ///< map_Ke
+    Dissolve,               ///< map_d
+    Decal,                  ///< decal
+    Displacement,           ///< disp
+    Bump,                   ///< bump, map_bump
+    ReflectionSphere,       ///< refl -type sphere
+    ReflectionCubeFront,    ///< refl -type cube_front
+    ReflectionCubeBack,
+    ReflectionCubeTop,
+    ReflectionCubeBottom,
+    ReflectionCubeLeft,
+    ReflectionCubeRight,
+    Count
+};
+
 //------------------------------------------------------------------------------------------
 
 /**
  * \class OBJMaterial
+ *
+ * Textures are stored as OBJTextureId values, which index the OBJTextureTable of the state
+ * that parsed the material (see OBJState::getTextureDescriptor). An id is meaningless without
+ * that table, so materials copied out of a state must be kept together with its table.
+ *
+ * The materials held by an OBJState allocate their strings from its arena (if any),
+ * while copies of a material use the heap.
  */
 class OBJMaterial
 {
 public:
 
     OBJMaterial();
+
+    /**
+     * \param[in] arena Arena to allocate the name and RFL paths from. May be nullptr.
+     */
+    explicit OBJMaterial(OBJArena* arena);
+
     ~OBJMaterial();
 
     //--------------------------------------------------------------------
@@ -131,7 +180,7 @@ public:
     // Name
 
     void setName(std::string const& name);
-    std::string const& getName() const;
+    OBJArenaString const& getName() const;
 
     // Ambient Reflectivity
 
@@ -203,50 +252,66 @@ public:
     void setOpticalDensity(float density);
     float getOpticalDensity() const;
 
+    // Textures
+
+    /**
+     * \param[in] slot
+     * \param[in] id   Id of the descriptor within the texture table of the owning state. 0 for no texture.
+     */
+    void setTexture(OBJTextureSlot slot, OBJTextureId id);
+
+    /**
+     * \param[in] slot
+     * \return Id of the descriptor within the texture table of the owning state (see OBJState::getTextureDescriptor). 0 if no texture.
+     */
+    OBJTextureId getTexture(OBJTextureSlot slot) const;
+
+    // The named accessors below are equivalent to setTexture and getTexture with the matching slot.
+
     // Ambient Texture
 
-    void setAmbientTexture(OBJTextureDescriptor const* descriptor);
-    OBJTextureDescriptor const& getAmbientTexture() const;
+    void setAmbientTexture(OBJTextureId id);
+    OBJTextureId getAmbientTexture() const;
 
     // Diffuse Texture
 
-    void setDiffuseTexture(OBJTextureDescriptor const* descriptor);
-    OBJTextureDescriptor const& getDiffuseTexture() const;
+    void setDiffuseTexture(OBJTextureId id);
+    OBJTextureId getDiffuseTexture() const;
 
     // Specular Texture
 
-    void setSpecularTexture(OBJTextureDescriptor const* descriptor);
-    OBJTextureDescriptor const& getSpecularTexture() const;
+    void setSpecularTexture(OBJTextureId id);
+    OBJTextureId getSpecularTexture() const;
 
     // SpecularExponent Texture
 
-    void setSpecularExponentTexture(OBJTextureDescriptor const* descriptor);
-    OBJTextureDescriptor const& getSpecularExponentTexture() const;
+    void setSpecularExponentTexture(OBJTextureId id);
+    OBJTextureId getSpecularExponentTexture() const;
 
     // Emissive Texture
 
-    void setEmissiveTexture(OBJTextureDescriptor const* descriptor);
-    OBJTextureDescriptor const& getEmissiveTexture() const;
+    void setEmissiveTexture(OBJTextureId id);
+    OBJTextureId getEmissiveTexture() const;
 
     // Dissolve Texture
 
-    void setDissolveTexture(OBJTextureDescriptor const* descriptor);
-    OBJTextureDescriptor const& getDissolveTexture() const;
+    void setDissolveTexture(OBJTextureId id);
+    OBJTextureId getDissolveTexture() const;
 
     // Decal Texture
 
-    void setDecalTexture(OBJTextureDescriptor const* descriptor);
-    OBJTextureDescriptor const& getDecalTexture() const;
+    void setDecalTexture(OBJTextureId id);
+    OBJTextureId getDecalTexture() const;
 
     // Displacement Texture
 
-    void setDisplacementTexture(OBJTextureDescriptor const* descriptor);
-    OBJTextureDescriptor const& getDisplacementTexture() const;
+    void setDisplacementTexture(OBJTextureId id);
+    OBJTextureId getDisplacementTexture() const;
 
     // Bump Texture
 
-    void setBumpTexture(OBJTextureDescriptor const* descriptor);
-    OBJTextureDescriptor const& getBumpTexture() const;
+    void setBumpTexture(OBJTextureId id);
+    OBJTextureId getBumpTexture() const;
 
     // Anti-Aliasing
 
@@ -255,13 +320,27 @@ public:
 
     // Reflection Map
 
+    /**
+     * \return Sphere if the ReflectionSphere slot was set, Cube if any of the cube slots were set, otherwise None.
+     */
     OBJReflectionMapType getReflectionMapType() const;
 
-    void setReflectionMapSphere(OBJTextureDescriptor const* descriptor);
-    OBJTextureDescriptor const& getReflectionMapSphere() const;
+    void setReflectionMapSphere(OBJTextureId id);
+    OBJTextureId getReflectionMapSphere() const;
+
+    void setReflectionMapCubeSide(OBJReflectionMapCubeSide side, OBJTextureId id);
 
-    void setReflectionMapCubeSide(OBJReflectionMapCubeSide side, OBJTextureDescriptor const* descriptor);
-    OBJTextureDescriptor const& getReflectionMapCubeSide(OBJReflectionMapCubeSide side) const;
+    /**
+     * \return Id of the texture of the specified cube side. Equivalent to getTexture with the matching ReflectionCube slot.
+     */
+    OBJTextureId getReflectionMapCubeSide(OBJReflectionMapCubeSide side) const;
+
+    /**
+     * Exchanges all properties (including the name) of two materials.
+     * Each material keeps its own allocator, so the two may belong to different arenas.
+     * \param[in] other
+     */
+    void swap(OBJMaterial& other);
 
 protected:
 
@@ -269,7 +348,7 @@ protected:
     // Member Variables
     //--------------------------------------------------------------------
 
-    std::string m_Name;
+    OBJArenaString m_Name;
 
     //--------------------------------------------------------------------
     // Color and Illumination
@@ -292,15 +371,7 @@ protected:
     //--------------------------------------------------------------------
     // Texture Map
 
-    OBJTextureDescriptor m_TextureAmbient;
-    OBJTextureDescriptor m_TextureDiffuse;
-    OBJTextureDescriptor m_TextureSpecular;
-    OBJTextureDescriptor m_TextureSpecularExponent;
-    OBJTextureDescriptor m_TextureEmissive;
-    OBJTextureDescriptor m_TextureDissolve;
-    OBJTextureDescriptor m_TextureDecal;
-    OBJTextureDescriptor m_TextureDisplacement;
-    OBJTextureDescriptor m_TextureBump;
+    std::array<OBJTextureId, static_cast<std::size_t>(OBJTextureSlot::Count)> m_Textures;   ///< Indexed by OBJTextureSlot. Descriptors are stored once per state, in its OBJTextureTable.
 
     bool m_TextureAntiAliasing;
 
@@ -309,9 +380,6 @@ protected:
 
     OBJReflectionMapType m_ReflectionMapType;
 
-    OBJTextureDescriptor m_ReflectionMapSphere;
-    std::array<OBJTextureDescriptor, 8> m_ReflectionMapCube;
-
 private:
 };
 
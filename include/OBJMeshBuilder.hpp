@@ -0,0 +1,223 @@
+/*
+ * Copyright 2016 Steven T Sell (ssell@vertexfragment.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef __H__OBJ_PARSER_MESH_BUILDER__H__
+#define __H__OBJ_PARSER_MESH_BUILDER__H__
+
+#include "OBJStructs.hpp"
+
+#include <vector>
+
+class OBJGroup;
+class OBJState;
+
+//------------------------------------------------------------------------------------------
+
+/**
+ * \struct OBJMeshSubset
+ * \brief Run of indices within an OBJMesh sharing a single group and render state.
+ */
+struct OBJMeshSubset
+{
+    OBJMeshSubset();
+
+    OBJGroup const* group;      ///< Source group. Invalidated when the state is cleared.
+    uint32_t renderState;       ///< See OBJState::getRenderState
+    uint32_t firstIndex;        ///< Offset of the first index within OBJMesh::indices
+    uint32_t indexCount;        ///< Number of indices (three per triangle)
+    uint32_t baseVertex;        ///< First vertex of the subset if subsets have their own vertices (see OBJMeshBuilder::setSubsetVertexLimit), otherwise 0. Subtracted from the indices in OBJMesh::shortIndices.
+};
+
+/**
+ * \struct OBJMesh
+ * \brief Indexed triangle mesh with an interleaved vertex buffer. See OBJMeshBuilder.
+ *
+ * Each vertex is laid out as: position (x, y, z), then texture coordinate (u, v) 
+ * if included, then normal (x, y, z) if included.
+ */
+struct OBJMesh
+{
+    OBJMesh();
+
+    std::vector<float> vertices;            ///< Interleaved vertex data. vertexCount * vertexStride floats. Empty if not written.
+    std::vector<OBJVertexGroup> sources;    ///< Source vertex group of each vertex. See OBJVertexPacker.
+    std::vector<uint32_t> indices;          ///< Triangle list
+    std::vector<uint16_t> shortIndices;     ///< Triangle list relative to the base vertex of each subset. Empty unless requested.
+    std::vector<OBJMeshSubset> subsets;     ///< In group order, and in face order within each group
+
+    uint32_t vertexCount;
+    uint32_t vertexStride;                  ///< Number of floats per vertex
+    uint32_t textureOffset;                 ///< Offset (in floats) of the texture coordinate within a vertex. 0 if not included.
+    uint32_t normalOffset;                  ///< Offset (in floats) of the normal within a vertex. 0 if not included.
+
+    OBJCount skippedFaces;                  ///< Number of faces skipped for referencing vertices that do not exist
+};
+
+//------------------------------------------------------------------------------------------
+
+/**
+ * \class OBJMeshBuilder
+ *
+ * Converts the faces of a parsed state into an indexed triangle mesh, as consumed by GPUs.
+ *
+ * OBJ faces index positions, texture coordinates, and normals separately, while a GPU
+ * vertex is a single combination of all three. Each unique combination of indices becomes
+ * one output vertex; quads are split into two triangles. 
+ *
+ * The faces are walked once, and the combinations are looked up in an open-addressing
+ * hash table keyed on the vertex group itself. The table is kept between builds, so a
+ * builder reused for similar meshes does not need to allocate it again.
+ */
+class OBJMeshBuilder
+{
+public:
+
+    OBJMeshBuilder();
+    ~OBJMeshBuilder();
+
+    /**
+     * Sets whether texture coordinates are included in the vertices. Default is true.
+     *
+     * When excluded, vertices that differ only in their texture index are merged.
+     * Texture coordinates are never included if the state has none.
+     *
+     * \param[in] include
+     */
+    void setIncludeTexture(bool include);
+
+    /**
+     * Sets whether normals are included in the vertices. Default is true.
+     *
+     * When excluded, vertices that differ only in their normal index are merged.
+     * Normals are never included if the state has none.
+     *
+     * \param[in] include
+     */
+    void setIncludeNormal(bool include);
+
+    /**
+     * Sets whether the interleaved float vertices are written. Default is true.
+     *
+     * If the vertices are instead packed into another format with OBJVertexPacker,
+     * only OBJMesh::sources is needed and the float copy may be skipped.
+     *
+     * \param[in] write
+     */
+    void setWriteVertices(bool write);
+
+    /**
+     * Sets the maximum number of unique vertices referenced by a single subset. Default is 0 (no limit).
+     *
+     * Each subset then receives its own contiguous range of vertices (vertices shared with 
+     * other subsets are duplicated), and subsets with more vertices than the limit are split 
+     * into several subsets of the same group and render state. The triangles of such a subset 
+     * are first ordered along a space-filling curve through their centers, and then taken 
+     * greedily in that order, so that each split covers a compact region of the surface.
+     *
+     * \param[in] limit Values below 3 are treated as 3.
+     */
+    void setSubsetVertexLimit(uint32_t limit);
+
+    /**
+     * Sets whether OBJMesh::shortIndices is written. Default is false.
+     *
+     * Limits subsets to 65,535 vertices (or the subset vertex limit, if lower) so that every 
+     * subset can be drawn with 16-bit indices and its base vertex. The index 0xFFFF is never 
+     * used, leaving it free for primitive restart. OBJMesh::indices is written as well, for
+     * the processing tools, and may be released once it is no longer needed.
+     *
+     * \param[in] write
+     */
+    void setShortIndices(bool write);
+
+    /**
+     * Builds a mesh from the faces of all groups of the state.
+     *
+     * Vertex groups without a texture coordinate or normal (while those are included)
+     * receive zeroes for the missing attribute.
+     *
+     * \param[in]  state State to read the faces and vertex data from.
+     * \param[out] mesh  Receives the mesh. Any previous contents are replaced.
+     * \return False if the mesh would exceed the range of 32-bit indices, or if short indices 
+     *         were requested (see setShortIndices) and could not be built.
+     */
+    bool build(OBJState const& state, OBJMesh& mesh);
+
+    /**
+     * Rewrites OBJMesh::shortIndices and the base vertex of each subset from OBJMesh::indices.
+     *
+     * Intended for after the indices or vertices of a mesh built with short indices have been
+     * reordered by other code. OBJVertexCacheOptimizer calls this itself.
+     *
+     * OBJTangentGenerator::generate calls this itself, after inserting each split vertex directly
+     * after the last vertex of its subset. Tangents may therefore be generated before or after 
+     * optimizeVertexFetch; if before, the splits are then moved into first-use order with the rest.
+     *
+     * \param[in,out] mesh
+     * \return False (leaving shortIndices empty) if the vertices of a subset span more than 65,535 indices.
+     */
+    static bool buildShortIndices(OBJMesh& mesh);
+
+protected:
+
+    struct Slot
+    {
+        OBJVertexGroup key;
+        uint32_t vertex;        ///< Output vertex index, or 0xFFFFFFFF if the slot is empty
+    };
+
+    void resetTable(std::size_t expected);
+    void growTable();
+    Slot& findSlot(OBJVertexGroup const& key);
+    bool isValid(OBJVertexGroup const& group) const;
+    void appendVertex(OBJVertexGroup const& key, OBJState const& state, OBJMesh& mesh) const;
+    uint32_t readFace(OBJFace const& face, OBJVertexGroup* corners) const;
+    bool addTriangle(OBJVertexGroup const& a, OBJVertexGroup const& b, OBJVertexGroup const& c, uint32_t baseVertex, OBJState const& state, OBJMesh& mesh);
+    void gatherTriangles(OBJGroup const* group, OBJRenderStateRange const& range, OBJMesh& mesh);
+    uint32_t countNewVertices(OBJVertexGroup const* triangle, uint32_t baseVertex);
+    std::size_t countUniqueCorners();
+    void sortTrianglesSpatially(OBJState const& state);
+
+    //--------------------------------------------------------------------
+
+    bool m_IncludeTexture;
+    bool m_IncludeNormal;
+    bool m_WriteVertices;
+    bool m_ShortIndices;
+    uint32_t m_SubsetVertexLimit;
+
+    bool m_UseTexture;                  ///< Whether texture coordinates are included in the current build
+    bool m_UseNormal;                   ///< Whether normals are included in the current build
+    OBJCount m_SpatialCount;            ///< Element counts of the current build's state, used to validate indices
+    OBJCount m_TextureCount;
+    OBJCount m_NormalCount;
+
+    std::vector<Slot> m_Slots;          ///< Open-addressing table of vertex groups. Size is a power of two.
+    std::size_t m_SlotMask;
+    std::size_t m_SlotsUsed;
+
+    std::vector<OBJVertexGroup> m_Corners;      ///< Corners of the triangles of the current render state range, three per triangle
+    std::vector<OBJVertexGroup> m_Unique;       ///< Scratch space for counting unique corners
+    std::vector<uint32_t> m_Order;              ///< Order in which the triangles of the current range are emitted. Empty for file order.
+    std::vector<uint64_t> m_SortKeys;           ///< Space-filling curve position (high bits) and triangle (low bits)
+
+private:
+};
+
+//------------------------------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,120 @@
+/*
+ * Copyright 2016 Steven T Sell (ssell@vertexfragment.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef __H__OBJ_PARSER_MESHLET_BUILDER__H__
+#define __H__OBJ_PARSER_MESHLET_BUILDER__H__
+
+#include "OBJStructs.hpp"
+
+#include <vector>
+
+struct OBJMesh;
+class OBJState;
+
+//------------------------------------------------------------------------------------------
+
+/**
+ * \struct OBJMeshlet
+ * \brief Cluster of triangles sharing a small set of vertices, with bounds for culling.
+ *
+ * The cone may be used to reject meshlets facing away from the camera: if 
+ * dot(normalize(coneApex - cameraPosition), coneAxis) >= coneCutoff then every triangle 
+ * of the meshlet is back-facing. A cutoff of 1.0 means the triangles face too many 
+ * directions for the test to ever succeed.
+ */
+struct OBJMeshlet
+{
+    OBJMeshlet();
+
+    uint32_t vertexOffset;      ///< Offset of the first vertex within OBJMeshlets::vertices
+    uint32_t triangleOffset;    ///< Offset of the first triangle within OBJMeshlets::triangles, in triangles
+    uint32_t vertexCount;
+    uint32_t triangleCount;
+    uint32_t subset;            ///< Index of the source OBJMesh subset (and so of its group and render state)
+
+    OBJVector3 center;          ///< Bounding sphere of the vertices
+    float radius;
+
+    OBJVector3 coneApex;
+    OBJVector3 coneAxis;        ///< Unit length, or zero if the cone is unusable
+    float coneCutoff;
+};
+
+/**
+ * \struct OBJMeshlets
+ * \brief Output of OBJMeshletBuilder.
+ */
+struct OBJMeshlets
+{
+    std::vector<OBJMeshlet> meshlets;   ///< In subset order, and in index buffer order within each subset
+    std::vector<uint32_t> vertices;     ///< OBJMesh vertex index of each meshlet vertex
+    std::vector<uint8_t> triangles;     ///< Three meshlet-local vertex indices per triangle
+};
+
+//------------------------------------------------------------------------------------------
+
+/**
+ * \class OBJMeshletBuilder
+ *
+ * Splits the triangles of an OBJMesh into meshlets of bounded vertex and triangle counts.
+ *
+ * Triangles are taken in index buffer order, starting a new meshlet whenever a limit would 
+ * be exceeded, so the index buffer should first be reordered with OBJVertexCacheOptimizer 
+ * for compact meshlets. Meshlets never span subsets. Subsets are distributed over threads.
+ */
+class OBJMeshletBuilder
+{
+public:
+
+    OBJMeshletBuilder();
+    ~OBJMeshletBuilder();
+
+    /**
+     * Sets the maximum size of each meshlet. Defaults are 64 vertices and 124 triangles.
+     *
+     * \param[in] maxVertices  Clamped to the range [3, 255].
+     * \param[in] maxTriangles At least 1.
+     */
+    void setLimits(uint32_t maxVertices, uint32_t maxTriangles);
+
+    /**
+     * Sets the maximum number of threads used.
+     * \param[in] count If 0 (the default), the number of hardware threads is used.
+     */
+    void setThreadCount(uint32_t count);
+
+    /**
+     * Builds the meshlets of all subsets of the mesh.
+     *
+     * \param[in]  state    State the mesh was built from, used to read vertex positions.
+     * \param[in]  mesh     Mesh as built by OBJMeshBuilder.
+     * \param[out] meshlets Receives the meshlets. Any previous contents are replaced.
+     */
+    void build(OBJState const& state, OBJMesh const& mesh, OBJMeshlets& meshlets) const;
+
+protected:
+
+    uint32_t m_MaxVertices;
+    uint32_t m_MaxTriangles;
+    uint32_t m_ThreadCount;
+
+private:
+};
+
+//------------------------------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,121 @@
+/*
+ * Copyright 2016 Steven T Sell (ssell@vertexfragment.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef __H__OBJ_PARSER_NORMAL_GENERATOR__H__
+#define __H__OBJ_PARSER_NORMAL_GENERATOR__H__
+
+#include <cstdint>
+
+class OBJState;
+
+//------------------------------------------------------------------------------------------
+
+/**
+ * \enum OBJNormalWeighting
+ * \brief How the faces around a vertex contribute to its normal.
+ */
+enum class OBJNormalWeighting
+{
+    Angle = 0,          ///< By the angle of the face at the vertex. Independent of how the surface is tessellated.
+    Area                ///< By the area of the face. Large faces dominate.
+};
+
+//------------------------------------------------------------------------------------------
+
+/**
+ * \class OBJNormalGenerator
+ *
+ * Generates vertex normals for the faces of a parsed state and stores them in the state,
+ * as if they had been parsed from 'vn' statements.
+ *
+ * Faces are smoothed together with the other faces sharing their spatial vertex and
+ * smoothing group (OBJRenderState::smoothing). Faces in smoothing group 0 ('s off' or 
+ * 's 0', and the default when no 's' statement is present) are faceted. If a crease 
+ * angle is set, faces meeting at a sharper angle are not smoothed together, even within 
+ * a smoothing group.
+ *
+ * One normal is stored per unique result at each spatial vertex, so vertices are only 
+ * split (by OBJMeshBuilder) where the normals actually differ.
+ *
+ * The work is done in a few passes over flat arrays of faces and vertices, each divided 
+ * into large chunks that are processed on separate threads. The results do not depend 
+ * on the number of threads.
+ */
+class OBJNormalGenerator
+{
+public:
+
+    OBJNormalGenerator();
+    ~OBJNormalGenerator();
+
+    /**
+     * Sets the largest angle between two faces, in degrees, at which they are still smoothed together.
+     * \param[in] degrees Default is 180, which disables creases so that only smoothing groups are used.
+     */
+    void setCreaseAngle(float degrees);
+
+    /**
+     * \param[in] weighting Default is OBJNormalWeighting::Angle.
+     */
+    void setWeighting(OBJNormalWeighting weighting);
+
+    /**
+     * Sets whether all faces are treated as sharing a single smoothing group. Default is false.
+     *
+     * Intended for files without 's' statements, combined with a crease angle.
+     *
+     * \param[in] ignore
+     */
+    void setIgnoreSmoothingGroups(bool ignore);
+
+    /**
+     * Sets whether faces that already reference normals for all of their vertices are given new normals. Default is false.
+     * \param[in] replace
+     */
+    void setReplaceExisting(bool replace);
+
+    /**
+     * Sets the maximum number of threads used.
+     * \param[in] count If 0 (the default), the number of hardware threads is used.
+     */
+    void setThreadCount(uint32_t count);
+
+    /**
+     * Generates normals for the faces of the state.
+     *
+     * New normals are appended to the state's normals (encoded, if the state uses a normal
+     * encoding), and the faces are updated to reference them. Previously parsed normals are kept.
+     *
+     * \param[in,out] state A finalized state, such as from OBJParser::parseOBJFile.
+     * \return False if the state is unchanged because the normal indices would exceed the range of the index type.
+     */
+    bool generate(OBJState& state) const;
+
+protected:
+
+    float m_CreaseAngle;
+    OBJNormalWeighting m_Weighting;
+    bool m_IgnoreSmoothingGroups;
+    bool m_ReplaceExisting;
+    uint32_t m_ThreadCount;
+
+private:
+};
+
+//------------------------------------------------------------------------------------------
+
+#endif
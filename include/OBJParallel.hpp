@@ -0,0 +1,84 @@
+/*
+ * Copyright 2016 Steven T Sell (ssell@vertexfragment.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef __H__OBJ_PARSER_PARALLEL__H__
+#define __H__OBJ_PARSER_PARALLEL__H__
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+//------------------------------------------------------------------------------------------
+
+/**
+ * Returns the number of threads to use for a number of independent work items.
+ *
+ * \param[in] requested If 0, the number of hardware threads is used.
+ * \param[in] workCount The result is never more than this, but always at least one.
+ */
+inline std::size_t OBJGetThreadCount(uint32_t const requested, std::size_t const workCount)
+{
+    const std::size_t threads = (requested > 0) ? requested : std::thread::hardware_concurrency();
+    return std::max(std::min(threads, workCount), static_cast<std::size_t>(1));
+}
+
+/**
+ * Runs the worker on the given number of threads, one of which is the calling thread, 
+ * and returns once all have finished. Workers typically claim work from a shared counter.
+ */
+template<typename Worker>
+void OBJRunWorkers(std::size_t const threadCount, Worker const& worker)
+{
+    std::vector<std::thread> threads;
+    threads.reserve(threadCount);
+
+    for(std::size_t i = 1; i < threadCount; ++i)
+    {
+        threads.push_back(std::thread(worker));
+    }
+
+    worker();
+
+    for(auto iter = threads.begin(); iter != threads.end(); ++iter)
+    {
+        (*iter).join();
+    }
+}
+
+/**
+ * Calls function(index) for every index in [0, count), spread over up to the requested number of threads.
+ * Indices are claimed one at a time, so each should represent a sizable amount of work.
+ */
+template<typename Function>
+void OBJParallelFor(std::size_t const count, uint32_t const requestedThreads, Function const& function)
+{
+    std::atomic<std::size_t> next(0);
+
+    OBJRunWorkers(OBJGetThreadCount(requestedThreads, count), [&next, count, &function]()
+    {
+        for(std::size_t i = next++; i < count; i = next++)
+        {
+            function(i);
+        }
+    });
+}
+
+//------------------------------------------------------------------------------------------
+
+#endif
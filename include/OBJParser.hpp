@@ -28,6 +28,28 @@
 
 //#define OBJ_PARSER_USE_MEM_MAP
 
+// If defined, vertex indices (OBJIndex) and element counts (OBJCount) are 64-bit rather than 32-bit.
+// Required for files with more than 2^31 elements of any one vertex type. Doubles the size of all faces.
+// As with the above, this must be defined for every translation unit (i.e. as a compiler flag).
+
+//#define OBJ_PARSER_USE_64BIT_INDICES
+
+// If defined, the grammar for free-form geometry ('vp', 'cstype', 'curv', 'surf', etc.) and the 
+// free-form render techniques ('ctech', 'stech') is compiled out. These statements are skipped,
+// so files containing them still parse, but without any free-form data.
+
+//#define OBJ_PARSER_NO_FREE_FORMS
+
+// If defined, MTL files are never parsed and MTLGrammar is compiled out. The 'mtllib' and 'usemtl'
+// statements are still read, so library names and per-face material names remain available.
+
+//#define OBJ_PARSER_NO_MTL
+
+// If defined, the vertex conversion kernels of OBJVertexPacker and OBJVertexEncoder use portable
+// code even when SSE2 is available. Both produce identical output.
+
+//#define OBJ_PARSER_NO_SIMD
+
 //------------------------------------------------------------------------------------------
 // OBJ Parser
 //------------------------------------------------------------------------------------------
@@ -62,6 +84,12 @@ public:
     //--------------------------------------------------------------------
 
     OBJParser();
+
+    /**
+     * \param[in] arena Arena to allocate all parsed data from. See OBJState::OBJState(OBJArena*).
+     */
+    explicit OBJParser(OBJArena* arena);
+
     ~OBJParser();
 
     //--------------------------------------------------------------------
@@ -100,8 +128,9 @@ protected:
 
     std::string buildRelativeMTLPath(std::string const& objPath, std::string const& mtlPath);
 
-    std::string extractLastLine(const char* str);
-    std::string extractLastLine(std::ifstream& stream);
+    std::string extractLastLine(const char* start, const char* current, const char* last, uint64_t& offset);
+    std::string extractLastLine(std::ifstream& stream, uint64_t& offset);
+    std::string buildParseError(std::string const& line, uint64_t offset, std::string const& path) const;
 
     //--------------------------------------------------------------------
 
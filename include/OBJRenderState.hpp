@@ -17,7 +17,10 @@
 #ifndef __H__OBJ_PARSER_RENDER_STATE__H__
 #define __H__OBJ_PARSER_RENDER_STATE__H__
 
+#include "OBJArena.hpp"
+
 #include <boost/fusion/adapted.hpp>
+#include <boost/functional/hash.hpp>
 
 #include <string>
 #include <cstdint>
@@ -51,6 +54,12 @@ struct OBJCurveTechnique
 
     }
 
+    bool operator==(OBJCurveTechnique const& rhs) const
+    {
+        return (technique == rhs.technique) && (res == rhs.res) && (maxLength == rhs.maxLength) && 
+               (maxDistance == rhs.maxDistance) && (maxAngle == rhs.maxAngle);
+    }
+
     OBJSubdivision technique;     ///< Subdivision type. For curves this may be: Parametric, Spatial, or Curvature. If None, then this technique has not been specified.
 
     float res;                    ///< Resolution used with Parametric subdivision. 0.0 if not used.
@@ -77,6 +86,12 @@ struct OBJSurfaceTechnique
 
     }
 
+    bool operator==(OBJSurfaceTechnique const& rhs) const
+    {
+        return (technique == rhs.technique) && (resU == rhs.resU) && (resV == rhs.resV) && (maxLength == rhs.maxLength) && 
+               (maxDistance == rhs.maxDistance) && (maxAngle == rhs.maxAngle);
+    }
+
     OBJSubdivision technique;     ///< Subdivision type. For surfaces this may be: ParametricA, ParametricB, Spatial, or Curvature. If None, then this technique has not been specified.
 
     float resU;                   ///< Resolution parameter for the U direction with Parametric subdivision. If technique is ParametricB, then resU == resV
@@ -95,7 +110,12 @@ struct OBJSurfaceTechnique
  * Most commonly used of these is the material name. The rest have highly varying
  * levels of support among OBJ writers, other readers, and end-use implementations.
  *
- * Multiple faces/free-forms may reference the same state.
+ * Multiple faces/free-forms may reference the same state. Identical states are
+ * only ever stored once by the OBJState, so two faces share a render state index
+ * if, and only if, all of their settings are equal.
+ *
+ * The strings of the states held by an OBJState are allocated from its arena (if any).
+ * Copies of a state, such as those returned by OBJState::getRenderState, use the heap.
  */
 struct OBJRenderState
 {
@@ -105,6 +125,29 @@ struct OBJRenderState
     
     }
 
+    /**
+     * Copies the settings of another state, allocating the strings from the specified arena.
+     *
+     * \param[in] other
+     * \param[in] arena May be nullptr, in which case the strings are allocated on the heap.
+     */
+    OBJRenderState(OBJRenderState const& other, OBJArena* arena)
+        : smoothing(other.smoothing), lod(other.lod), bevelInterp(other.bevelInterp), colorInterp(other.colorInterp), dissolveInterp(other.dissolveInterp),
+          material(other.material, OBJArenaAllocator<char>(arena)), textureMap(other.textureMap, OBJArenaAllocator<char>(arena)),
+          shadowObj(other.shadowObj, OBJArenaAllocator<char>(arena)), traceObj(other.traceObj, OBJArenaAllocator<char>(arena)),
+          curveTechnique(other.curveTechnique), surfaceTechnique(other.surfaceTechnique)
+    {
+
+    }
+
+    bool operator==(OBJRenderState const& rhs) const
+    {
+        return (smoothing == rhs.smoothing) && (lod == rhs.lod) && 
+               (bevelInterp == rhs.bevelInterp) && (colorInterp == rhs.colorInterp) && (dissolveInterp == rhs.dissolveInterp) &&
+               (material == rhs.material) && (textureMap == rhs.textureMap) && (shadowObj == rhs.shadowObj) && (traceObj == rhs.traceObj) &&
+               (curveTechnique == rhs.curveTechnique) && (surfaceTechnique == rhs.surfaceTechnique);
+    }
+
     //--------------------------------------------------------------------
 
     uint32_t smoothing;                      ///< Smoothing group number. Default/no smoothing group is 0.
@@ -114,15 +157,37 @@ struct OBJRenderState
     bool colorInterp;                        ///< Sets color interpolation on/off. Default off. Polygons only.
     bool dissolveInterp;                     ///< Sets dissolve interpolation on/off. Default off. Polygons only.
 
-    std::string material;                    ///< Specifies the material to use. Empty means no material. Once set, material can only be changed.
-    std::string textureMap;                  ///< Specifies the texture map to use. Empty or "off" means no map specified.
-    std::string shadowObj;                   ///< Specifies the shadow object filename. Empty means no object specified.
-    std::string traceObj;                    ///< Specifies the ray tracing object filename. Empty means no object specified.
+    OBJArenaString material;                 ///< Specifies the material to use. Empty means no material. Once set, material can only be changed.
+    OBJArenaString textureMap;               ///< Specifies the texture map to use. Empty or "off" means no map specified.
+    OBJArenaString shadowObj;                ///< Specifies the shadow object filename. Empty means no object specified.
+    OBJArenaString traceObj;                 ///< Specifies the ray tracing object filename. Empty means no object specified.
 
     OBJCurveTechnique curveTechnique;        ///< Specifies the curve approximation technique. Free-forms only.
     OBJSurfaceTechnique surfaceTechnique;    ///< Specified the surface approximation technique. Free-froms only.
 };
 
+/**
+ * \struct OBJRenderStateHash
+ * \brief Hash functor used to look up identical render states.
+ *
+ * Only the most commonly varied settings are hashed. Full comparison is
+ * left to OBJRenderState::operator==.
+ */
+struct OBJRenderStateHash
+{
+    std::size_t operator()(OBJRenderState const& state) const
+    {
+        std::size_t seed = 0;
+
+        boost::hash_combine(seed, state.smoothing);
+        boost::hash_combine(seed, state.lod);
+        boost::hash_combine(seed, state.material);
+        boost::hash_combine(seed, state.textureMap);
+
+        return seed;
+    }
+};
+
 //------------------------------------------------------------------------------------------
 
 #endif
\ No newline at end of file
@@ -0,0 +1,425 @@
+/*
+ * Copyright 2016 Steven T Sell (ssell@vertexfragment.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef __H__OBJ_PARSER_SEGMENTED_VECTOR__H__
+#define __H__OBJ_PARSER_SEGMENTED_VECTOR__H__
+
+#include "OBJArena.hpp"
+
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+//------------------------------------------------------------------------------------------
+
+/**
+ * \class OBJSegmentedVector
+ *
+ * Sequence container that stores its elements in a list of fixed-size blocks.
+ *
+ * Unlike std::vector, appending never relocates the existing elements: once the first
+ * block is full a new block is simply added. This avoids both the copy of the entire 
+ * buffer each time the capacity doubles and the resulting peak memory usage of roughly 
+ * three times the final size. Only the first block grows as a vector would, up to the
+ * block size, so that small containers (such as the faces of small groups) stay small.
+ *
+ * Elements remain at stable addresses and may be accessed by index in constant time.
+ * The blocks may be inspected directly via getBlock, or copied out to contiguous memory
+ * in a single pass via copyTo.
+ *
+ * Elements are only ever relocated while the first block is still growing, in which case
+ * they are move constructed into the new block. Element types need not be trivially copyable.
+ */
+template<typename T, std::size_t BlockShift = 14>
+class OBJSegmentedVector
+{
+public:
+
+    typedef T value_type;
+    typedef std::size_t size_type;
+    typedef T& reference;
+    typedef T const& const_reference;
+    typedef OBJArenaAllocator<T> allocator_type;
+
+    static const std::size_t BlockSize = (static_cast<std::size_t>(1) << BlockShift);
+    static const std::size_t BlockMask = (BlockSize - 1);
+
+    /**
+     * \class Iterator
+     * Random-access iterator. Const-qualified if Value is const.
+     */
+    template<typename Value, typename Container>
+    class Iterator
+    {
+    public:
+
+        typedef std::random_access_iterator_tag iterator_category;
+        typedef typename std::remove_const<Value>::type value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef Value* pointer;
+        typedef Value& reference;
+
+        Iterator() : m_pContainer(nullptr), m_Index(0) { }
+        Iterator(Container* container, std::size_t index) : m_pContainer(container), m_Index(index) { }
+
+        Value& operator*() const { return (*m_pContainer)[m_Index]; }
+        Value* operator->() const { return &(*m_pContainer)[m_Index]; }
+        Value& operator[](std::ptrdiff_t offset) const { return (*m_pContainer)[m_Index + offset]; }
+
+        Iterator& operator++() { ++m_Index; return *this; }
+        Iterator operator++(int) { Iterator result(*this); ++m_Index; return result; }
+        Iterator& operator--() { --m_Index; return *this; }
+        Iterator operator--(int) { Iterator result(*this); --m_Index; return result; }
+
+        Iterator& operator+=(std::ptrdiff_t offset) { m_Index += offset; return *this; }
+        Iterator& operator-=(std::ptrdiff_t offset) { m_Index -= offset; return *this; }
+        Iterator operator+(std::ptrdiff_t offset) const { return Iterator(m_pContainer, m_Index + offset); }
+        Iterator operator-(std::ptrdiff_t offset) const { return Iterator(m_pContainer, m_Index - offset); }
+        std::ptrdiff_t operator-(Iterator const& rhs) const { return static_cast<std::ptrdiff_t>(m_Index) - static_cast<std::ptrdiff_t>(rhs.m_Index); }
+
+        bool operator==(Iterator const& rhs) const { return (m_Index == rhs.m_Index); }
+        bool operator!=(Iterator const& rhs) const { return (m_Index != rhs.m_Index); }
+        bool operator<(Iterator const& rhs) const { return (m_Index < rhs.m_Index); }
+        bool operator>(Iterator const& rhs) const { return (m_Index > rhs.m_Index); }
+        bool operator<=(Iterator const& rhs) const { return (m_Index <= rhs.m_Index); }
+        bool operator>=(Iterator const& rhs) const { return (m_Index >= rhs.m_Index); }
+
+    protected:
+
+        Container* m_pContainer;
+        std::size_t m_Index;
+
+    private:
+    };
+
+    typedef Iterator<T, OBJSegmentedVector> iterator;
+    typedef Iterator<T const, OBJSegmentedVector const> const_iterator;
+
+    //--------------------------------------------------------------------
+
+    OBJSegmentedVector()
+        : m_Size(0),
+          m_Capacity(0)
+    {
+
+    }
+
+    explicit OBJSegmentedVector(allocator_type const& allocator)
+        : m_Allocator(allocator),
+          m_Blocks(OBJArenaAllocator<T*>(allocator)),
+          m_Size(0),
+          m_Capacity(0)
+    {
+
+    }
+
+    OBJSegmentedVector(OBJSegmentedVector const& other)
+        : m_Allocator(other.m_Allocator.select_on_container_copy_construction()),
+          m_Blocks(OBJArenaAllocator<T*>(m_Allocator)),
+          m_Size(0),
+          m_Capacity(0)
+    {
+        append(other);
+    }
+
+    /**
+     * Takes the blocks (and allocator) of the other container, which is left empty.
+     */
+    OBJSegmentedVector(OBJSegmentedVector&& other)
+        : m_Allocator(other.m_Allocator),
+          m_Blocks(OBJArenaAllocator<T*>(other.m_Allocator)),
+          m_Size(0),
+          m_Capacity(0)
+    {
+        swap(other);
+    }
+
+    ~OBJSegmentedVector()
+    {
+        deallocateBlocks();
+    }
+
+    OBJSegmentedVector& operator=(OBJSegmentedVector const& rhs)
+    {
+        if(this != &rhs)
+        {
+            clear();
+            append(rhs);
+        }
+
+        return *this;
+    }
+
+    /**
+     * Releases the current blocks and takes those (and the allocator) of the other container, which is left empty.
+     */
+    OBJSegmentedVector& operator=(OBJSegmentedVector&& rhs)
+    {
+        if(this != &rhs)
+        {
+            deallocateBlocks();
+            swap(rhs);
+        }
+
+        return *this;
+    }
+
+    //--------------------------------------------------------------------
+
+    T& operator[](std::size_t const index)
+    {
+        return m_Blocks[index >> BlockShift][index & BlockMask];
+    }
+
+    T const& operator[](std::size_t const index) const
+    {
+        return m_Blocks[index >> BlockShift][index & BlockMask];
+    }
+
+    T& back()
+    {
+        return (*this)[m_Size - 1];
+    }
+
+    T const& back() const
+    {
+        return (*this)[m_Size - 1];
+    }
+
+    iterator begin() { return iterator(this, 0); }
+    iterator end() { return iterator(this, m_Size); }
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, m_Size); }
+
+    std::size_t size() const
+    {
+        return m_Size;
+    }
+
+    bool empty() const
+    {
+        return (m_Size == 0);
+    }
+
+    std::size_t capacity() const
+    {
+        return m_Capacity;
+    }
+
+    allocator_type get_allocator() const
+    {
+        return m_Allocator;
+    }
+
+    //--------------------------------------------------------------------
+
+    void push_back(T const& value)
+    {
+        emplace_back(value);
+    }
+
+    template<typename... Args>
+    void emplace_back(Args&&... args)
+    {
+        if(m_Size == m_Capacity)
+        {
+            // Growing the first block frees it, and the arguments may refer to one of its elements
+
+            T element(std::forward<Args>(args)...);
+            grow(m_Size + 1);
+
+            new (&(*this)[m_Size]) T(std::move(element));
+        }
+        else
+        {
+            new (&(*this)[m_Size]) T(std::forward<Args>(args)...);
+        }
+
+        m_Size++;
+    }
+
+    /**
+     * Ensures room for at least count elements. Unlike std::vector, reserving 
+     * beyond the first block never moves existing elements.
+     */
+    void reserve(std::size_t const count)
+    {
+        if(count > m_Capacity)
+        {
+            grow(count);
+        }
+    }
+
+    /**
+     * Removes all elements. All blocks are retained.
+     */
+    void clear()
+    {
+        for(std::size_t i = 0; i < m_Size; ++i)
+        {
+            (*this)[i].~T();
+        }
+
+        m_Size = 0;
+    }
+
+    void swap(OBJSegmentedVector& other)
+    {
+        std::swap(m_Allocator, other.m_Allocator);
+        m_Blocks.swap(other.m_Blocks);
+        std::swap(m_Size, other.m_Size);
+        std::swap(m_Capacity, other.m_Capacity);
+    }
+
+    //--------------------------------------------------------------------
+
+    /**
+     * \return Number of blocks that contain at least one element.
+     */
+    std::size_t getBlockCount() const
+    {
+        return ((m_Size + BlockMask) >> BlockShift);
+    }
+
+    /**
+     * \param[in]  index Block index in the range [0, getBlockCount()).
+     * \param[out] count Number of elements within the block.
+     * \return Pointer to the first element of the block.
+     */
+    T const* getBlock(std::size_t const index, std::size_t& count) const
+    {
+        const std::size_t first = (index << BlockShift);
+        count = ((first + BlockSize) <= m_Size) ? BlockSize : (m_Size - first);
+
+        return m_Blocks[index];
+    }
+
+    /**
+     * Copies all elements, in order, to the destination.
+     * The elements are copy constructed, so the destination may be uninitialized memory.
+     * \param[out] destination Must have room for size() elements.
+     */
+    void copyTo(T* destination) const
+    {
+        const std::size_t blockCount = getBlockCount();
+
+        for(std::size_t i = 0; i < blockCount; ++i)
+        {
+            std::size_t count = 0;
+            T const* block = getBlock(i, count);
+
+            destination = std::uninitialized_copy(block, (block + count), destination);
+        }
+    }
+
+protected:
+
+    /**
+     * Adds capacity for at least the specified number of elements.
+     *
+     * While there is only a single block it is grown (doubling, as a vector would) up to 
+     * the block size. Past that point, whole blocks are added and nothing is relocated.
+     */
+    void grow(std::size_t const count)
+    {
+        if(m_Capacity < BlockSize)
+        {
+            std::size_t firstCapacity = (m_Capacity < 8) ? 8 : (m_Capacity * 2);
+
+            while(firstCapacity < count)
+            {
+                firstCapacity *= 2;
+            }
+
+            if(firstCapacity > BlockSize)
+            {
+                firstCapacity = BlockSize;
+            }
+
+            T* block = m_Allocator.allocate(firstCapacity);
+
+            if(m_Blocks.empty())
+            {
+                m_Blocks.push_back(block);
+            }
+            else
+            {
+                relocate(m_Blocks[0], block, m_Size);
+                m_Allocator.deallocate(m_Blocks[0], m_Capacity);
+                m_Blocks[0] = block;
+            }
+
+            m_Capacity = firstCapacity;
+        }
+
+        while(m_Capacity < count)
+        {
+            m_Blocks.push_back(m_Allocator.allocate(BlockSize));
+            m_Capacity += BlockSize;
+        }
+    }
+
+    /**
+     * Move constructs count elements from source into the uninitialized destination, destroying the originals.
+     */
+    static void relocate(T* source, T* destination, std::size_t const count)
+    {
+        for(std::size_t i = 0; i < count; ++i)
+        {
+            new (&destination[i]) T(std::move(source[i]));
+            source[i].~T();
+        }
+    }
+
+    void append(OBJSegmentedVector const& other)
+    {
+        reserve(m_Size + other.m_Size);
+
+        for(std::size_t i = 0; i < other.m_Size; ++i)
+        {
+            push_back(other[i]);
+        }
+    }
+
+    void deallocateBlocks()
+    {
+        clear();
+
+        for(std::size_t i = 0; i < m_Blocks.size(); ++i)
+        {
+            m_Allocator.deallocate(m_Blocks[i], (i == 0) && (m_Capacity < BlockSize) ? m_Capacity : BlockSize);
+        }
+
+        m_Blocks.clear();
+        m_Capacity = 0;
+    }
+
+    //--------------------------------------------------------------------
+
+    allocator_type m_Allocator;
+    OBJArenaVector<T*> m_Blocks;
+
+    std::size_t m_Size;
+    std::size_t m_Capacity;
+
+private:
+};
+
+//------------------------------------------------------------------------------------------
+
+#endif
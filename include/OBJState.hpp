@@ -17,15 +17,253 @@
 #ifndef __H__OBJ_PARSER_STATE__H__
 #define __H__OBJ_PARSER_STATE__H__
 
+#include "OBJArena.hpp"
 #include "OBJFreeFormState.hpp"
 #include "OBJGroup.hpp"
+#include "OBJMappedRegion.hpp"
+#include "OBJVertexEncoding.hpp"
 #include "OBJRenderState.hpp"
 #include "OBJMaterial.hpp"
+#include "OBJTextureTable.hpp"
 
+#include <memory>
 #include <unordered_map>
 
 //------------------------------------------------------------------------------------------
 
+/**
+ * \struct OBJStateStatistics
+ *
+ * Element counts of a parsed state. Used to size the containers of following parses.
+ */
+struct OBJStateStatistics
+{
+    OBJStateStatistics();
+
+    OBJCount spatialCount;      ///< Number of spatial vertices
+    OBJCount textureCount;      ///< Number of texture vertices
+    OBJCount normalCount;       ///< Number of normal vertices
+    OBJCount faceCount;         ///< Number of faces, summed over all groups
+    uint32_t groupCount;        ///< Number of groups
+    uint32_t renderStateCount;  ///< Number of unique render states
+};
+
+//------------------------------------------------------------------------------------------
+
+/**
+ * \struct OBJFlattenedGroup
+ */
+struct OBJFlattenedGroup
+{
+    OBJFlattenedGroup();
+
+    OBJGroup const* group;      ///< Source group
+    OBJFace const* faces;       ///< Contiguous copy of the faces of the group
+    OBJCount faceCount;
+
+    OBJRenderStateRange const* renderStateRanges;   ///< Copy of OBJGroup::renderStateRanges
+    OBJCount renderStateRangeCount;
+
+    OBJVertexGroup const* lineVertices;             ///< Copy of OBJGroup::lineVertices
+    OBJCount lineVertexCount;
+    OBJCount const* lineOffsets;                    ///< Copy of OBJGroup::lineOffsets
+    OBJCount lineCount;
+
+    OBJVertexGroup const* pointVertices;            ///< Copy of OBJGroup::pointVertices
+    OBJCount pointVertexCount;
+    OBJCount const* pointOffsets;                   ///< Copy of OBJGroup::pointOffsets
+    OBJCount pointCollectionCount;
+};
+
+/**
+ * \struct OBJFlattenedData
+ *
+ * Contiguous copy of the vertex and face streams of an OBJState, all placed
+ * within a single memory-mapped region. See OBJState::flatten.
+ *
+ * The data remains valid until the structure is destroyed or flattened into again,
+ * regardless of what happens to the state it was flattened from (with the exception 
+ * of the group pointers, which are invalidated when the state is cleared).
+ */
+struct OBJFlattenedData
+{
+    OBJFlattenedData();
+
+    OBJMappedRegion region;                     ///< Owns the memory of all streams
+
+    OBJSpatialVector4 const* homogeneousSpatialData; ///< Positions with their w component. Only used if a vertex specified a w other than 1.0 (otherwise nullptr)
+    OBJCount spatialCount;                      ///< Number of spatial vertices in either homogeneousSpatialData, packedSpatialData, or quantizedSpatialData
+
+    OBJSpatialVector3 const* packedSpatialData; ///< Used instead of homogeneousSpatialData (which is then nullptr) if no vertex specified a w component other than 1.0
+
+    OBJVector2 const* textureData;
+    OBJCount textureCount;                      ///< Number of texture coordinates in either textureData or encodedTextureData
+
+    OBJVector3 const* normalData;
+    OBJCount normalCount;                       ///< Number of normals in either normalData or encodedNormalData
+
+    OBJOctahedralNormal const* encodedNormalData;   ///< Used instead of normalData (which is then nullptr) if the normals are encoded
+    OBJPackedVector2 const* encodedTextureData;     ///< Used instead of textureData (which is then nullptr) if the texture coordinates are encoded
+    OBJTextureEncoding textureEncoding;
+
+    OBJQuantizedVector3 const* quantizedSpatialData;    ///< Used instead of spatialData (which is then nullptr) if the state is quantized
+    OBJQuantization spatialQuantization;
+
+    std::vector<OBJFlattenedGroup> groups;      ///< Flattened faces of each group, in the same order as OBJState::getGroups
+};
+
+//------------------------------------------------------------------------------------------
+
+/**
+ * \class OBJSnapshot
+ *
+ * Immutable, compacted copy of a parsed state. See OBJState::freeze.
+ *
+ * The vertex streams and group elements are stored in a single read-only region, and 
+ * all other containers are sized exactly to their contents. A snapshot never changes 
+ * after creation and holds no references to the state, so any number of threads may 
+ * read it concurrently without synchronization.
+ *
+ * \note Free-form geometry is not included.
+ */
+class OBJSnapshot
+{
+    friend class OBJState;
+
+public:
+
+    ~OBJSnapshot();
+
+    /**
+     * \return The flattened streams. The group member of each flattened group is nullptr; use getGroupName instead.
+     */
+    OBJFlattenedData const& getData() const;
+
+    uint32_t getGroupCount() const;
+
+    /**
+     * \param[in] index Group index in the range [0, getGroupCount()).
+     */
+    OBJFlattenedGroup const& getGroup(uint32_t index) const;
+
+    /**
+     * \param[in] index Group index in the range [0, getGroupCount()).
+     */
+    std::string const& getGroupName(uint32_t index) const;
+
+    uint32_t getRenderStateCount() const;
+
+    /**
+     * \param[in] index Render state index in the range [0, getRenderStateCount()), as referenced by OBJFace::renderState.
+     */
+    OBJRenderState const& getRenderState(uint32_t index) const;
+
+    std::vector<OBJMaterial> const& getMaterials() const;
+
+    /**
+     * \param[in] id Texture id, as returned by OBJMaterial::getTexture.
+     */
+    OBJTextureDescriptor const& getTextureDescriptor(OBJTextureId id) const;
+
+    std::vector<std::string> const& getMaterialLibraries() const;
+    std::vector<std::string> const& getTextureMapLibraries() const;
+
+protected:
+
+    OBJSnapshot();
+
+    //--------------------------------------------------------------------
+
+    OBJFlattenedData m_Data;
+    std::vector<std::string> m_GroupNames;
+    std::vector<OBJRenderState> m_RenderStates;
+    std::vector<OBJMaterial> m_Materials;
+    OBJTextureTable m_TextureTable;
+    std::vector<std::string> m_MaterialLibraries;
+    std::vector<std::string> m_TextureMapLibraries;
+
+private:
+
+    OBJSnapshot(OBJSnapshot const&) = delete;
+    OBJSnapshot& operator=(OBJSnapshot const&) = delete;
+};
+
+//------------------------------------------------------------------------------------------
+
+/**
+ * \class OBJStateResult
+ *
+ * Self-contained parse result, holding the containers moved out of an OBJState.
+ * See OBJState::takeResult.
+ *
+ * The members mirror the corresponding OBJState accessors. Faces and free-forms
+ * reference render states and attribute states by index into the containers of 
+ * the same result, so the result remains valid for as long as it exists.
+ */
+class OBJStateResult
+{
+public:
+
+    typedef std::unordered_map<OBJArenaString, OBJGroup, boost::hash<OBJArenaString>, std::equal_to<OBJArenaString>, OBJArenaAllocator<std::pair<OBJArenaString const, OBJGroup>>> GroupMap;
+    typedef std::unordered_map<OBJArenaString, OBJMaterial, boost::hash<OBJArenaString>, std::equal_to<OBJArenaString>, OBJArenaAllocator<std::pair<OBJArenaString const, OBJMaterial>>> MaterialMap;
+
+    OBJStateResult();
+    ~OBJStateResult();
+
+    /**
+     * Exchanges all containers (and their storage) of two results.
+     * \param[in] other
+     */
+    void swap(OBJStateResult& other);
+
+    /**
+     * Fills a vector with pointers to all groups of the result.
+     * \note The provided vector is cleared prior to filling with groups.
+     * \param[out] groups
+     */
+    void getGroups(std::vector<OBJGroup const*>& groups) const;
+
+    /**
+     * Fills a vector with pointers to all materials of the result.
+     * \note The provided vector is cleared prior to filling with materials.
+     * \param[out] materials
+     */
+    void getMaterials(std::vector<OBJMaterial const*>& materials) const;
+
+    //--------------------------------------------------------------------
+
+    OBJSegmentedVector<OBJSpatialVector4> homogeneousSpatialData; ///< See OBJState::getHomogeneousSpatialData
+    OBJSegmentedVector<OBJSpatialVector3> packedSpatialData;      ///< See OBJState::getPackedSpatialData
+    bool spatialHasW;                                             ///< See OBJState::hasSpatialW
+
+    OBJSegmentedVector<OBJQuantizedVector3> quantizedSpatialData;
+    OBJQuantization spatialQuantization;
+
+    OBJSegmentedVector<OBJVector2> textureData;
+    OBJSegmentedVector<OBJVector3> normalData;
+
+    OBJSegmentedVector<OBJOctahedralNormal> encodedNormalData;  ///< Used instead of normalData if normalEncoding is not Float
+    OBJSegmentedVector<OBJPackedVector2> encodedTextureData;    ///< Used instead of textureData if textureEncoding is not Float
+    OBJNormalEncoding normalEncoding;
+    OBJTextureEncoding textureEncoding;
+    OBJEncodingReport encodingReport;
+
+    GroupMap groups;
+    MaterialMap materials;
+    OBJTextureTable textureTable;                               ///< Resolves the texture ids of materials
+    OBJArenaVector<OBJRenderState> renderStates;                ///< Indexed by OBJFace::renderState and OBJRenderStateRange::renderState
+    OBJFreeFormState freeFormState;
+
+    OBJArenaVector<OBJArenaString> materialLibraries;
+    OBJArenaVector<OBJArenaString> textureMapLibraries;
+
+protected:
+
+private:
+};
+
+//------------------------------------------------------------------------------------------
+
 /**
  * \class OBJState
  *
@@ -39,6 +277,15 @@ class OBJState
 public:
 
     OBJState();
+
+    /**
+     * \param[in] arena Arena to allocate the state's containers from. May be nullptr,
+     *                  in which case the global allocator is used. The arena must outlive 
+     *                  the state and may not be shared with other states, as it is reset 
+     *                  every time the state is cleared.
+     */
+    explicit OBJState(OBJArena* arena);
+
     ~OBJState();
     
     //--------------------------------------------------------------------
@@ -46,9 +293,28 @@ public:
     /**
      * Resets the state back to a default setting.
      * Typically called automatically prior to starting a new parse.
+     *
+     * If the state was created with an arena, every arena-backed container is dropped
+     * without destroying its elements (see OBJAbandonContainer) and the arena is then reset.
+     * This includes the groups, materials, render states, and library paths, whose strings
+     * are allocated from the arena as well, so the clear takes constant time regardless of
+     * how much was parsed. Only the texture table, which is not arena-backed, is cleared as usual.
      */
     void clearState();
 
+    /**
+     * \return The arena the state was created with, or nullptr if none.
+     */
+    OBJArena* getArena() const;
+
+    /**
+     * Completes any processing that requires the entire file to have been parsed,
+     * such as quantizing the spatial vertices (see setSpatialQuantization).
+     *
+     * Typically called automatically after a successful parse.
+     */
+    void finalize();
+
     /**
      * Allows the ability to specify the amount of space to reserve for the
      * various containers used by the state. If one knows in advance the general
@@ -65,7 +331,52 @@ public:
      * \param[in] groupFaces     Number of faces to reserve in each new group.
      * \param[in] groupFreeForms Number of free-forms to reserve in each new group.
      */
-    void reserve(uint32_t spatial, uint32_t texture = 0, uint32_t normal = 0, uint32_t groupFaces = 0, uint32_t groupFreeForms = 0);
+    void reserve(OBJCount spatial, OBJCount texture = 0, OBJCount normal = 0, uint32_t groupFaces = 0, uint32_t groupFreeForms = 0);
+
+    /**
+     * Sets how many recent parses are remembered for adaptive reservation.
+     *
+     * When the state is cleared, the element counts of the cleared data are recorded.
+     * The containers are then reserved to the largest counts among the remembered parses,
+     * so that a state reused for similar files rarely needs to grow its containers.
+     *
+     * By default the last 8 parses are remembered. A size of 0 disables adaptive reservation.
+     *
+     * \param[in] size Number of parses to remember.
+     */
+    void setReserveHistorySize(uint32_t size);
+
+    /**
+     * Sets the maximum number of bytes that a single container (or group) may hold on to between parses.
+     *
+     * When the state is cleared, element storage is normally retained for reuse by the next parse.
+     * Storage larger than this limit is instead freed, and adaptive reservation will not reserve 
+     * beyond it, so that one unusually large file does not keep its memory for good.
+     *
+     * By default there is no limit (0).
+     *
+     * \param[in] bytes Limit in bytes, or 0 for no limit.
+     */
+    void setRetainedCapacityLimit(std::size_t bytes);
+
+    /**
+     * Enables storing spatial vertices as fixed point values relative to the bounding box of the model.
+     *
+     * Upon finalize, the parsed positions are quantized to the specified number of bits per
+     * component (6 bytes per vertex, instead of 16) and the floating point data is freed. 
+     * The quantized data may then be retrieved via getQuantizedSpatialData and getSpatialQuantization,
+     * or dequantized per vertex via getSpatial. The w component is not retained.
+     *
+     * By default quantization is disabled (0).
+     *
+     * \param[in] bits Bits per component, clamped to [0, 16]. 0 disables quantization.
+     */
+    void setSpatialQuantization(uint32_t bits);
+
+    /**
+     * \return Element counts of the current state.
+     */
+    OBJStateStatistics getStatistics() const;
 
     /**
      * Returns a pointer to the internal OBJFreeForm state. 
@@ -86,6 +397,14 @@ public:
      */
     OBJRenderState getRenderState(uint32_t index) const;
 
+    /**
+     * Returns the number of unique render attribute states.
+     *
+     * Identical states are shared, so this is typically much smaller than the
+     * number of render state statements in the parsed file.
+     */
+    uint32_t getRenderStateCount() const;
+
     /**
      * Fills a vector with pointers to all OBJGroups stored in the state.
      *
@@ -99,30 +418,214 @@ public:
     void getGroups(std::vector<OBJGroup const*>& groups) const;
 
     /**
-     * Returns a pointer to the container of all parsed spatial vertex data.
+     * Returns a pointer to the container of spatial vertices stored with their w component.
+     *
+     * Only used if at least one vertex specified a w component other than 1.0 (see hasSpatialW).
+     * Otherwise it is empty and the positions are stored in getPackedSpatialData. To access the
+     * positions regardless of how they are stored, use getSpatialCount and getSpatial.
+     *
+     * \note Keep in mind that OBJ indices are 1-based while the data container indices are 0-based.
+     */
+    OBJSegmentedVector<OBJSpatialVector4> const* getHomogeneousSpatialData() const;
+
+    /**
+     * Returns a pointer to the container of spatial vertex positions, stored without 
+     * their (implicitly 1.0) w component. Empty if hasSpatialW returns true.
+     *
      * \note Keep in mind that OBJ indices are 1-based while the data container indices are 0-based.
      */
-    std::vector<OBJVector4> const* getSpatialData() const;
+    OBJSegmentedVector<OBJSpatialVector3> const* getPackedSpatialData() const;
+
+    /**
+     * \return True if any spatial vertex specified a w component other than 1.0, in which case all
+     *         spatial vertices are stored in getHomogeneousSpatialData instead of getPackedSpatialData.
+     */
+    bool hasSpatialW() const;
+
+    /**
+     * Returns a pointer to the container of all quantized spatial vertex data.
+     * Empty unless quantization was enabled prior to the parse. See setSpatialQuantization.
+     */
+    OBJSegmentedVector<OBJQuantizedVector3> const* getQuantizedSpatialData() const;
+
+    /**
+     * Returns the parameters needed to dequantize the data of getQuantizedSpatialData.
+     * If the spatial data is not quantized, then the bits member is 0.
+     */
+    OBJQuantization const& getSpatialQuantization() const;
+
+    /**
+     * \return Number of spatial vertices, whether quantized or not.
+     */
+    OBJCount getSpatialCount() const;
+
+    /**
+     * Retrieves a single spatial vertex, dequantizing it if needed.
+     *
+     * \param[in] index Spatial vertex index in the range [0, getSpatialCount()).
+     * \return The spatial vertex. For quantized and packed data, w is always 1.0.
+     */
+    OBJVector4 getSpatial(OBJCount index) const;
 
     /**
      * Returns a pointer to the container of all parsed texture coordinate vertex data.
      * \note Keep in mind that OBJ indices are 1-based while the data container indices are 0-based.
      */
-    std::vector<OBJVector2> const* getTextureData() const;
+    OBJSegmentedVector<OBJVector2> const* getTextureData() const;
 
     /**
      * Returns a pointer to the container of all parsed normal vertex data.
      * \note Keep in mind that OBJ indices are 1-based while the data container indices are 0-based.
      */
-    std::vector<OBJVector3> const* getNormalData() const;
+    OBJSegmentedVector<OBJVector3> const* getNormalData() const;
+
+    /**
+     * Sets how normals are stored. Takes effect the next time the state is cleared (i.e. the next parse).
+     *
+     * With OBJNormalEncoding::Octahedral16, normals are encoded in batches as they are parsed and 
+     * stored in getEncodedNormalData; getNormalData will then be empty. Use getNormal to decode.
+     *
+     * \param[in] encoding Default is OBJNormalEncoding::Float.
+     */
+    void setNormalEncoding(OBJNormalEncoding encoding);
+
+    /**
+     * Sets how texture coordinates are stored. Takes effect the next time the state is cleared (i.e. the next parse).
+     *
+     * With a compact encoding, coordinates are encoded in batches as they are parsed and 
+     * stored in getEncodedTextureData; getTextureData will then be empty. Use getTexture to decode.
+     *
+     * \param[in] encoding Default is OBJTextureEncoding::Float.
+     */
+    void setTextureEncoding(OBJTextureEncoding encoding);
+
+    OBJNormalEncoding getNormalEncoding() const;
+    OBJTextureEncoding getTextureEncoding() const;
+
+    /**
+     * \return Container of encoded normals. Empty unless the normal encoding is OBJNormalEncoding::Octahedral16.
+     */
+    OBJSegmentedVector<OBJOctahedralNormal> const* getEncodedNormalData() const;
+
+    /**
+     * \return Container of encoded texture coordinates, interpreted according to getTextureEncoding. Empty if the encoding is OBJTextureEncoding::Float.
+     */
+    OBJSegmentedVector<OBJPackedVector2> const* getEncodedTextureData() const;
+
+    /**
+     * \return Worst-case error introduced by the normal and texture encodings of the current state.
+     */
+    OBJEncodingReport const& getEncodingReport() const;
+
+    /**
+     * \return Number of normals, whether encoded or not.
+     */
+    OBJCount getNormalCount() const;
+
+    /**
+     * \return Number of texture coordinates, whether encoded or not.
+     */
+    OBJCount getTextureCount() const;
+
+    /**
+     * Retrieves a single normal, decoding it if needed.
+     * \param[in] index Normal index in the range [0, getNormalCount()).
+     */
+    OBJVector3 getNormal(OBJCount index) const;
+
+    /**
+     * Retrieves a single texture coordinate, decoding it if needed.
+     * \param[in] index Texture coordinate index in the range [0, getTextureCount()).
+     */
+    OBJVector2 getTexture(OBJCount index) const;
+
+    /**
+     * Appends normals to the normal stream. Unlike addVertexNormal, encoded normals (see setNormalEncoding)
+     * are encoded before returning, so that they may be referenced immediately. Used by OBJNormalGenerator.
+     *
+     * \param[in] normals
+     */
+    void appendNormals(std::vector<OBJVector3> const& normals);
+
+    /**
+     * \param[in] group Group as returned by getGroups.
+     * \param[in] first Index of the first face within the group.
+     * \param[in] count Number of faces.
+     * \return True if the group is owned by this state and has the faces [first, first + count).
+     */
+    bool hasFaces(OBJGroup const* group, std::size_t first, std::size_t count) const;
+
+    /**
+     * Replaces the normal indices of a run of consecutive faces, leaving the rest of each face unchanged. 
+     * Used by OBJNormalGenerator. May be called concurrently for different faces.
+     *
+     * \param[in] group   Group of this state, as returned by getGroups.
+     * \param[in] first   Index of the first face within the group.
+     * \param[in] count   Number of faces.
+     * \param[in] normals Four normal indices per face, one for each corner, in the range [0, getNormalCount()).
+     *                    The fourth is ignored for triangles.
+     * \return False (leaving every face unchanged) if the group is not owned by this state, or if a face or normal index is out of range.
+     */
+    bool setFaceNormals(OBJGroup const* group, std::size_t first, std::size_t count, OBJCount const* normals);
 
     /**
      * Returns a pointer to the container of all material libraries (accompanying .mtl files).
      */
-    std::vector<std::string> const* getMaterialLibraries() const;
+    OBJArenaVector<OBJArenaString> const* getMaterialLibraries() const;
 
     void getMaterials(std::vector<OBJMaterial const*>& materials) const;
 
+    /**
+     * Retrieves a texture descriptor referenced by a material.
+     *
+     * \param[in] id Texture id, as returned by OBJMaterial::getTexture.
+     * \return The descriptor. If the id is 0 (no texture), a default descriptor with an empty path.
+     */
+    OBJTextureDescriptor const& getTextureDescriptor(OBJTextureId id) const;
+
+    /**
+     * Returns a pointer to the table of all unique texture descriptors of the parsed materials.
+     */
+    OBJTextureTable const* getTextureTable() const;
+
+    /**
+     * Places the vertex streams and the elements (faces, lines, and points) of all groups 
+     * contiguously into a single memory-mapped region, in one pass.
+     *
+     * The vertex and face streams are stored internally as a series of blocks, so that they
+     * never have to be relocated while parsing. Those blocks may be walked directly (see 
+     * OBJSegmentedVector::getBlock); this method is for when one contiguous buffer is required.
+     *
+     * \param[out] result     Receives the flattened data. Any previously flattened data is released.
+     * \param[in]  hugePages  If true, huge pages are requested for the region.
+     * \return False if the region could not be mapped.
+     */
+    bool flatten(OBJFlattenedData& result, bool hugePages = false) const;
+
+    /**
+     * Moves all parsed data (vertex streams, groups, materials, render states, and free-forms) 
+     * out of the state and into the result, without copying any elements. The state is then 
+     * cleared, and the next parse starts with fresh storage.
+     *
+     * Not supported by states created with an arena, as the arena is reset upon the next clear.
+     *
+     * \param[out] result Receives the parsed data. Any data previously held by it is released.
+     * \return False if the state was created with an arena, in which case nothing is moved.
+     */
+    bool takeResult(OBJStateResult& result);
+
+    /**
+     * Creates an immutable snapshot of the state, to be shared between threads.
+     *
+     * The streams are flattened (as with flatten) into a region that is then made read-only,
+     * and the render states, materials, and group names are copied into exactly sized containers.
+     * The snapshot is independent of the state, which may be cleared or reused immediately.
+     *
+     * \param[in] hugePages If true, huge pages are requested for the region.
+     * \return The snapshot, or nullptr if the region could not be mapped.
+     */
+    std::shared_ptr<OBJSnapshot const> freeze(bool hugePages = false) const;
+
     //--------------------------------------------------------------------
     // OBJ Parser/Grammar Methods
     //--------------------------------------------------------------------
@@ -151,11 +654,14 @@ public:
     /**
      * Adds a new spatial (x, y, z, w) vertex element.
      *
+     * The vertex is stored without its w component if w is 1.0 and no prior vertex 
+     * had a different w. The first vertex to do so moves all positions to getHomogeneousSpatialData.
+     *
      * \note Typically should only be used by the OBJGrammar class.
      *
      * \param[in] vector Spatial vertex to add.
      */
-    void addVertexSpatial(OBJVector4 const& vector);
+    void addVertexSpatial(OBJParsedSpatialVector const& vector);
 
     /**
      * Adds a new texture (u, v) vertex element.
@@ -194,8 +700,9 @@ public:
      * \note Typically should only be used by the OBJGrammar class.
      *
      * \param[in] face Face to add.
+     * \return False if an index can not be held by the index type of OBJStorage, in which case nothing is added.
      */
-    void addFace(OBJFace face);
+    bool addFace(OBJParsedFace const& face);
 
     /**
      * Adds a new line element.
@@ -203,8 +710,9 @@ public:
      * \note Typically should only be used by the OBJGrammar class.
      *
      * \param[in] line Line to add.
+     * \return False if an index can not be held by the index type of OBJStorage, in which case nothing is added.
      */
-    void addLine(std::vector<OBJVertexGroup>& line);
+    bool addLine(std::vector<OBJParsedVertexGroup> const& line);
 
     /**
      * Adds a new point element.
@@ -212,26 +720,85 @@ public:
      * \note Typically should only be used by the OBJGrammar class.
      *
      * \param[in] points Points to add.
+     * \return False if an index can not be held by the index type of OBJStorage, in which case nothing is added.
+     */
+    bool addPointCollection(std::vector<OBJParsedVertexGroup> const& points);
+
+    /**
+     * Starts a new, empty, line element in each active group.
+     * Vertices are then appended one at a time via addLineVertex, which avoids
+     * building a temporary container for every line statement.
+     *
+     * \note Typically should only be used by the OBJGrammar class.
+     */
+    void beginLine();
+
+    /**
+     * Appends a vertex to the line most recently started with beginLine.
+     *
+     * \note Typically should only be used by the OBJGrammar class.
+     *
+     * \param[in] vertex Vertex to add.
+     * \return False if an index can not be held by the index type of OBJStorage, in which case nothing is added.
+     */
+    bool addLineVertex(OBJParsedVertexGroup const& vertex);
+
+    /**
+     * Starts a new, empty, point element in each active group.
+     * Vertices are then appended one at a time via addPointVertex.
+     *
+     * \note Typically should only be used by the OBJGrammar class.
+     */
+    void beginPointCollection();
+
+    /**
+     * Appends a vertex to the point collection most recently started with beginPointCollection.
+     *
+     * \note Typically should only be used by the OBJGrammar class.
+     *
+     * \param[in] vertex Vertex to add.
+     * \return False if an index can not be held by the index type of OBJStorage, in which case nothing is added.
      */
-    void addPointCollection(std::vector<OBJVertexGroup>& points);
+    bool addPointVertex(OBJParsedVertexGroup const& vertex);
 
     /**
      * Adds a new OBJCurve to the internal OBJFreeFormState.
-     * \param[in] curve
+     * Control points are then appended via addFreeFormControlPoint.
+     *
+     * \param[in] startParam
+     * \param[in] endParam
      */
-    void addFreeFormCurve(OBJCurve const& curve);
+    void beginFreeFormCurve(float startParam, float endParam);
 
     /**
      * Adds a new OBJCurve2D to the internal OBJFreeFormState.
-     * \param[in] points
+     * Parameter vertex indices are then appended via addFreeFormCurve2DPoint.
      */
-    void addFreeFormCurve2D(std::vector<int32_t> const& points);
+    void beginFreeFormCurve2D();
 
     /**
      * Adds a new OBJSurface to the internal OBJFreeFormState.
-     * \param[in] surface
+     * Control points are then appended via addFreeFormControlPoint.
+     *
+     * \param[in] startU
+     * \param[in] endU
+     * \param[in] startV
+     * \param[in] endV
+     */
+    void beginFreeFormSurface(float startU, float endU, float startV, float endV);
+
+    /**
+     * Adds a control point to the newest OBJCurve or OBJSurface in the internal OBJFreeFormState.
+     * \param[in] point
+     * \return False if an index can not be held by the index type of OBJStorage, in which case nothing is added.
+     */
+    bool addFreeFormControlPoint(OBJParsedVertexGroup const& point);
+
+    /**
+     * Adds a parameter vertex index to the newest OBJCurve2D in the internal OBJFreeFormState.
+     * \param[in] point
      */
-    void addFreeFormSurface(OBJSurface const& surface);
+    void addFreeFormCurve2DPoint(OBJIndex point);
 
     /**
      * Adds a new OBJSurfaceConnection to the internal OBJFreeFormState.
@@ -244,16 +811,16 @@ public:
     //--------------------------------------------------------------------
 
     /**
-     * Adds parameter u values to the newest OBJFreeForm in the internal OBJFreeFormState.
-     * \param[in] parameters
+     * Adds a parameter u value to the newest OBJFreeForm in the internal OBJFreeFormState.
+     * \param[in] parameter
      */
-    void addFreeFormParameterU(std::vector<float> const& parameters);
+    void addFreeFormParameterU(float parameter);
 
     /**
-     * Adds parameter v values to the newest OBJFreeForm in the internal OBJFreeFormState.
-     * \param[in] parameters
+     * Adds a parameter v value to the newest OBJFreeForm in the internal OBJFreeFormState.
+     * \param[in] parameter
      */
-    void addFreeFormParameterV(std::vector<float> const& parameters);
+    void addFreeFormParameterV(float parameter);
 
     /**
      * Adds trim values to the newest OBJFreeForm in the internal OBJFreeFormState.
@@ -274,10 +841,10 @@ public:
     void addFreeFormSpecialCurve(OBJSimpleCurve const& scurve);
 
     /**
-     * Adds points values to the newest OBJFreeForm in the internal OBJFreeFormState.
-     * \param[in] points
+     * Adds a special point to the newest OBJFreeForm in the internal OBJFreeFormState.
+     * \param[in] point
      */
-    void addFreeFormSpecialPoints(std::vector<int32_t> const& points);
+    void addFreeFormSpecialPoint(OBJIndex point);
 
     //--------------------------------------------------------------------
     // Render State Setting Methods
@@ -342,10 +909,20 @@ public:
      *
      * \note Typically should only be used by the MTLGrammar class.
      *
-     * \param[in] name
-     * \param[in] material
+     * \param[in]     name
+     * \param[in,out] material Swapped into storage rather than copied. Left with the previous material of the same name, if any.
      */
-    void setMaterial(std::string const& name, OBJMaterial const& material);
+    void setMaterial(OBJArenaString const& name, OBJMaterial& material);
+
+    /**
+     * Adds a texture descriptor to the texture table, if an identical one is not already present.
+     *
+     * \note Typically should only be used by the MTLGrammar class.
+     *
+     * \param[in] descriptor
+     * \return Id to assign to the material. See OBJMaterial::setTexture.
+     */
+    OBJTextureId addTextureDescriptor(OBJTextureDescriptor const& descriptor);
     
     /**
      * Adds a new material library to create materials from.
@@ -521,8 +1098,25 @@ public:
 
 protected:
 
+    typedef OBJStateResult::GroupMap GroupMap;
+    typedef OBJStateResult::MaterialMap MaterialMap;
+    typedef std::unordered_map<OBJRenderState, uint32_t, OBJRenderStateHash, std::equal_to<OBJRenderState>, OBJArenaAllocator<std::pair<OBJRenderState const, uint32_t>>> RenderStateMap;
+
     void resetAuxiliaryStates();
-    void transformVertexGroup(OBJVertexGroup& source) const;
+    void quantizeSpatialData();
+    void unpackSpatialData();
+    void flushNormalStaging();
+    void flushTextureStaging();
+    void recordStatistics();
+    void reserveFromStatistics();
+    void recycleGroups();
+    bool transformVertexGroup(OBJParsedVertexGroup const& source, OBJVertexGroup& result) const;
+
+    /**
+     * Makes the provided state the active render state.
+     * If an identical state already exists, then it is reused instead of being stored again.
+     */
+    void applyRenderState(OBJRenderState const& state);
     
     //--------------------------------------------------------------------
 
@@ -532,19 +1126,49 @@ protected:
     OBJFreeFormState m_FreeFormState;
     bool m_FreeFormRational;
 
-    std::unordered_map<std::string, OBJGroup> m_GroupMap;
-    std::unordered_map<std::string, OBJMaterial> m_MaterialMap;
+    OBJArena* m_pArena;                 ///< Optional arena backing all containers. May be nullptr.
+
+    GroupMap m_GroupMap;
+    MaterialMap m_MaterialMap;
+    OBJTextureTable m_TextureTable;
 
     std::vector<OBJGroup*> m_ActiveGroups;
 
-    std::vector<OBJVector4> m_VertexSpatialData;
-    std::vector<OBJVector2> m_VertexTextureData;    
-    std::vector<OBJVector3> m_VertexNormalData;  
+    OBJSegmentedVector<OBJSpatialVector4> m_VertexSpatialData;         ///< Used instead of m_PackedSpatialData once any vertex has a w other than 1.0
+    OBJSegmentedVector<OBJSpatialVector3> m_PackedSpatialData;
+    bool m_SpatialHasW;
+    OBJSegmentedVector<OBJVector2> m_VertexTextureData;    
+    OBJSegmentedVector<OBJVector3> m_VertexNormalData;  
+
+    OBJSegmentedVector<OBJQuantizedVector3> m_QuantizedSpatialData;    ///< Replaces m_VertexSpatialData upon finalize if quantization is enabled
+    OBJQuantization m_SpatialQuantization;                              ///< Parameters of m_QuantizedSpatialData
+    uint32_t m_SpatialQuantizationBits;                                 ///< Requested bits per component. See setSpatialQuantization.
+
+    OBJSegmentedVector<OBJOctahedralNormal> m_EncodedNormalData;       ///< Replaces m_VertexNormalData if m_NormalEncoding is not Float
+    OBJSegmentedVector<OBJPackedVector2> m_EncodedTextureData;         ///< Replaces m_VertexTextureData if m_TextureEncoding is not Float
+    std::vector<OBJVector3> m_NormalStaging;                            ///< Parsed normals waiting to be encoded as a batch
+    std::vector<OBJVector2> m_TextureStaging;                           ///< Parsed texture coordinates waiting to be encoded as a batch
+    OBJNormalEncoding m_NormalEncoding;                                 ///< Encoding of the current state
+    OBJNormalEncoding m_RequestedNormalEncoding;                        ///< Encoding to use upon the next clear
+    OBJTextureEncoding m_TextureEncoding;
+    OBJTextureEncoding m_RequestedTextureEncoding;
+    OBJEncodingReport m_EncodingReport;
     
-    std::vector<std::string> m_MaterialLibraries;
-    std::vector<std::string> m_TextureMapLibraries;
+    OBJArenaVector<OBJArenaString> m_MaterialLibraries;
+    OBJArenaVector<OBJArenaString> m_TextureMapLibraries;
 
-    std::vector<OBJRenderState> m_RenderStates;
+    OBJArenaVector<OBJRenderState> m_RenderStates;
+    RenderStateMap m_RenderStateMap;
+
+    uint32_t m_CurrentRenderState;      ///< Index of the active render state in m_RenderStates
+
+    std::vector<OBJStateStatistics> m_StatisticsHistory;    ///< Ring buffer of the statistics of recent parses
+    uint32_t m_StatisticsHistorySize;                       ///< Maximum number of entries in m_StatisticsHistory
+    uint32_t m_StatisticsHistoryNext;                       ///< Next entry to overwrite once m_StatisticsHistory is full
+    std::size_t m_RetainedCapacityLimit;                    ///< See setRetainedCapacityLimit. 0 if unlimited.
+    uint32_t m_GroupFacesAdaptiveSize;                      ///< Faces to reserve in each new group, as determined from m_StatisticsHistory
+
+    std::vector<OBJGroup> m_RecycledGroups;                 ///< Cleared groups whose storage is reused by new groups
 
 private:
 };
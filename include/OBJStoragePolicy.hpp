@@ -0,0 +1,210 @@
+/*
+ * Copyright 2016 Steven T Sell (ssell@vertexfragment.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef __H__OBJ_PARSER_STORAGE_POLICY__H__
+#define __H__OBJ_PARSER_STORAGE_POLICY__H__
+
+#include <cstdint>
+
+//------------------------------------------------------------------------------------------
+// Optional Defines
+//------------------------------------------------------------------------------------------
+
+// OBJ_PARSER_USE_64BIT_INDICES (see OBJParser.hpp) widens the parsed indices and the default storage policy.
+//
+// OBJ_PARSER_STORAGE_POLICY may be defined as one of the policies below (or any other instantiation of 
+// OBJStoragePolicy) to change how spatial vertices and face indices are stored. For example:
+//
+//     -DOBJ_PARSER_STORAGE_POLICY=OBJCompactStorage
+//
+// As with the other optional defines, this must be defined for every translation unit.
+// Translation units built with a different policy than the library fail to link (see OBJStorageLinkCheck).
+
+//------------------------------------------------------------------------------------------
+
+#ifdef OBJ_PARSER_USE_64BIT_INDICES
+using OBJIndex = int64_t;           ///< Vertex index as parsed from the file. Signed, as relative indices are negative.
+using OBJCount = uint64_t;          ///< Number of vertex elements (or faces) in a state
+#else
+using OBJIndex = int32_t;
+using OBJCount = uint32_t;
+#endif
+
+//------------------------------------------------------------------------------------------
+
+/**
+ * \struct OBJHalf
+ * \brief IEEE 754 half-precision float, stored as its raw bits.
+ */
+struct OBJHalf
+{
+    uint16_t bits;
+};
+
+//------------------------------------------------------------------------------------------
+
+/**
+ * \struct OBJScalarTraits
+ * \brief Conversions between a storage scalar type and the type it is parsed as.
+ *
+ * Specialized for float, double, and OBJHalf.
+ */
+template<typename Scalar>
+struct OBJScalarTraits;
+
+template<>
+struct OBJScalarTraits<float>
+{
+    typedef float ParseType;
+
+    static float fromParsed(float const value) { return value; }
+    static float toFloat(float const value) { return value; }
+};
+
+template<>
+struct OBJScalarTraits<double>
+{
+    typedef double ParseType;       ///< Parsed at full precision, rather than widened from float
+
+    static double fromParsed(double const value) { return value; }
+    static float toFloat(double const value) { return static_cast<float>(value); }
+};
+
+template<>
+struct OBJScalarTraits<OBJHalf>
+{
+    typedef float ParseType;
+
+    static OBJHalf fromParsed(float value);
+    static float toFloat(OBJHalf value);
+};
+
+//------------------------------------------------------------------------------------------
+
+/**
+ * \struct OBJIndexTraits
+ * \brief Conversions between resolved (0-based, -1 if unused) indices and a storage index type.
+ *
+ * Signed index types store an unused index as -1, while unsigned types use their maximum value.
+ * Resolved indices that the index type can not hold are rejected by the parser (see isRepresentable).
+ */
+template<typename Index>
+struct OBJIndexTraits
+{
+    static Index unused()
+    {
+        return static_cast<Index>(-1);      // Maximum value for unsigned types
+    }
+
+    static Index fromResolved(OBJIndex const index)
+    {
+        return (index < 0) ? unused() : static_cast<Index>(index);
+    }
+
+    static bool isUsed(Index const index)
+    {
+        return (index != unused());
+    }
+
+    /**
+     * \param index Resolved index. Negative indices are unused, and are always representable.
+     * \return False if the index would be truncated, or would collide with the unused index.
+     */
+    static bool isRepresentable(OBJIndex const index)
+    {
+        return (index < 0) || 
+               ((static_cast<OBJIndex>(static_cast<Index>(index)) == index) && (static_cast<Index>(index) != unused()));
+    }
+};
+
+//------------------------------------------------------------------------------------------
+
+/**
+ * \struct OBJStoragePolicy
+ * \brief Compile-time selection of the scalar type of spatial vertices and the index type of vertex groups.
+ *
+ * The active policy (OBJStorage) determines the types of OBJSpatialVector3, OBJSpatialVector4, 
+ * OBJVertexGroup, and OBJFace. Conversions from the parsed values happen as part of adding
+ * each element to the OBJState, with no runtime selection.
+ *
+ * Texture coordinates and normals are unaffected; see OBJState::setTextureEncoding and setNormalEncoding.
+ */
+template<typename Scalar, typename Index>
+struct OBJStoragePolicy
+{
+    typedef Scalar ScalarType;
+    typedef Index IndexType;
+
+    typedef OBJScalarTraits<Scalar> Scalars;
+    typedef OBJIndexTraits<Index> Indices;
+};
+
+typedef OBJStoragePolicy<float, OBJIndex> OBJDefaultStorage;        ///< Matches the types used prior to storage policies
+typedef OBJStoragePolicy<OBJHalf, uint16_t> OBJCompactStorage;      ///< Half-float positions and up to 65535 vertices per stream (indices 0 to 65534)
+typedef OBJStoragePolicy<double, OBJIndex> OBJPreciseStorage;       ///< Double precision positions, parsed as doubles
+
+#ifdef OBJ_PARSER_STORAGE_POLICY
+typedef OBJ_PARSER_STORAGE_POLICY OBJStorage;
+#else
+typedef OBJDefaultStorage OBJStorage;
+#endif
+
+//------------------------------------------------------------------------------------------
+
+/**
+ * \struct OBJStorageLinkCheck
+ * \brief Link-time check that a translation unit uses the same OBJStorage as the library.
+ *
+ * The value is only defined (in OBJStoragePolicy.cpp) for the policy the library was built with,
+ * and every translation unit that includes this header references the value of its own policy.
+ * A mismatched OBJ_PARSER_STORAGE_POLICY or OBJ_PARSER_USE_64BIT_INDICES then results in an 
+ * undefined reference to OBJStorageLinkCheck<...>::value, instead of silently mismatched layouts.
+ *
+ * MSVC discards unused references, so it instead compares the defines via #pragma detect_mismatch.
+ */
+template<typename Policy>
+struct OBJStorageLinkCheck
+{
+    static int const value;
+};
+
+template<>
+int const OBJStorageLinkCheck<OBJStorage>::value;
+
+#if defined(_MSC_VER)
+#define OBJ_PARSER_STRINGIZE(...) #__VA_ARGS__
+#define OBJ_PARSER_STRINGIZE_VALUE(...) OBJ_PARSER_STRINGIZE(__VA_ARGS__)
+#ifdef OBJ_PARSER_STORAGE_POLICY
+#pragma detect_mismatch("OBJ_PARSER_STORAGE_POLICY", OBJ_PARSER_STRINGIZE_VALUE(OBJ_PARSER_STORAGE_POLICY))
+#else
+#pragma detect_mismatch("OBJ_PARSER_STORAGE_POLICY", "OBJDefaultStorage")
+#endif
+#ifdef OBJ_PARSER_USE_64BIT_INDICES
+#pragma detect_mismatch("OBJ_PARSER_USE_64BIT_INDICES", "1")
+#else
+#pragma detect_mismatch("OBJ_PARSER_USE_64BIT_INDICES", "0")
+#endif
+#elif defined(__GNUC__)
+namespace
+{
+    __attribute__((used)) int const* const OBJStorageLinkReference = &OBJStorageLinkCheck<OBJStorage>::value;
+}
+#endif
+
+//------------------------------------------------------------------------------------------
+
+#endif
@@ -17,6 +17,8 @@
 #ifndef __H__OBJ_PARSER_STRUCTS__H__
 #define __H__OBJ_PARSER_STRUCTS__H__
 
+#include "OBJStoragePolicy.hpp"
+
 #include <boost/fusion/adapted.hpp>
 
 #include <string>
@@ -32,7 +34,6 @@
 struct OBJVector2
 {
     OBJVector2();
-    OBJVector2 const& operator=(OBJVector2 const& rhs);
 
     union { float x, r, u, s; };
     union { float y, g, v, t; };
@@ -43,44 +44,102 @@ BOOST_FUSION_ADAPT_STRUCT(OBJVector2, (float, x), (float, y))
 //------------------------------------------------------------------------------------------
 
 /**
- * \struct OBJVector3
+ * \struct OBJVector3T
  * \brief Simple three-component vector struct
  */
-struct OBJVector3
+template<typename T>
+struct OBJVector3T
 {
-    OBJVector3();
-    OBJVector3 const& operator=(OBJVector3 const& rhs);
+    OBJVector3T()
+        : x(T()),
+          y(T()),
+          z(T())
+    {
 
-    union { float x, r, u, s; };
-    union { float y, g, v, t; };
-    union { float z, b, w; };
+    }
+
+    union { T x, r, u, s; };
+    union { T y, g, v, t; };
+    union { T z, b, w; };
 };
 
-BOOST_FUSION_ADAPT_STRUCT(OBJVector3, (float, x), (float, y), (float, z))
+BOOST_FUSION_ADAPT_TPL_STRUCT((T), (OBJVector3T)(T), (T, x), (T, y), (T, z))
+
+typedef OBJVector3T<float> OBJVector3;
+typedef OBJVector3T<OBJStorage::ScalarType> OBJSpatialVector3;      ///< Spatial vertex as stored, without w. See OBJStoragePolicy.
 
 //------------------------------------------------------------------------------------------
 
 /**
- * \stuct OBJVector4
+ * \stuct OBJVector4T
  * \brief Simple four-component vector struct
  */
- struct OBJVector4
- {
-    OBJVector4();
-    OBJVector4 const& operator=(OBJVector4 const& rhs);
+template<typename T>
+struct OBJVector4T
+{
+    OBJVector4T()
+        : x(T()),
+          y(T()),
+          z(T()),
+          w(T())
+    {
+
+    }
+
+    union { T x, r, u, s; };
+    union { T y, g, v, t; };
+    union { T z, b, p; };
+    union { T w, a, q; };
+};
 
-    union { float x, r, u, s; };
-    union { float y, g, v, t; };
-    union { float z, b, p; };
-    union { float w, a, q; };
- };
+BOOST_FUSION_ADAPT_TPL_STRUCT((T), (OBJVector4T)(T), (T, x), (T, y), (T, z), (T, w))
+
+typedef OBJVector4T<float> OBJVector4;
+typedef OBJVector4T<OBJStorage::ScalarType> OBJSpatialVector4;                  ///< Spatial vertex as stored. See OBJStoragePolicy.
+typedef OBJVector4T<OBJStorage::Scalars::ParseType> OBJParsedSpatialVector;     ///< Spatial vertex as parsed, prior to conversion to OBJSpatialVector4
+
+//------------------------------------------------------------------------------------------
+
+/**
+ * \struct OBJQuantizedVector3
+ * \brief Three-component fixed point vector. See OBJQuantization.
+ */
+struct OBJQuantizedVector3
+{
+    OBJQuantizedVector3();
+
+    uint16_t x;
+    uint16_t y;
+    uint16_t z;
+};
+
+/**
+ * \struct OBJQuantization
+ * \brief Parameters mapping fixed point positions back to floating point.
+ *
+ * Each component is stored as an unsigned integer of the specified number of bits,
+ * spanning the axis-aligned bounding box of the quantized positions:
+ *
+ *     value = minimum + (quantized * step)
+ *
+ * The maximum error introduced by quantization is half of step along each axis.
+ */
+struct OBJQuantization
+{
+    OBJQuantization();
 
-BOOST_FUSION_ADAPT_STRUCT(OBJVector4, (float, x), (float, y), (float, z), (float, w))
+    OBJVector3 dequantize(OBJQuantizedVector3 const& quantized) const;
+
+    OBJVector3 minimum;     ///< Minimum corner of the bounding box
+    OBJVector3 maximum;     ///< Maximum corner of the bounding box
+    OBJVector3 step;        ///< Distance between two consecutive quantized values along each axis
+    uint32_t bits;          ///< Bits per component, in the range [1, 16]. If 0, positions are not quantized.
+};
 
 //------------------------------------------------------------------------------------------
 
 /**
- * \struct OBJVertexGroup
+ * \struct OBJVertexGroupT
  * \brief Index pairing comprising a single vertex of a face.
  *
  * Raw OBJ vertex indices may be negative and are 1-based. However, to keep use of 
@@ -90,23 +149,34 @@ BOOST_FUSION_ADAPT_STRUCT(OBJVector4, (float, x), (float, y), (float, z), (float
  * With these changes, indices may be used directly within vertex data containers
  * to retrieve the associated vertex element.
  *
- * A negative vertex indicates that it is not in use.
+ * An index equal to OBJIndexTraits<Index>::unused() (-1 for the default signed 
+ * indices) indicates that it is not in use.
  */
-struct OBJVertexGroup
+template<typename Index>
+struct OBJVertexGroupT
 { 
-    OBJVertexGroup();
+    OBJVertexGroupT()
+        : indexSpatial(OBJIndexTraits<Index>::unused()),
+          indexTexture(OBJIndexTraits<Index>::unused()),
+          indexNormal(OBJIndexTraits<Index>::unused())
+    {
+
+    }
 
-    int32_t indexSpatial;
-    int32_t indexTexture;
-    int32_t indexNormal;
+    Index indexSpatial;
+    Index indexTexture;
+    Index indexNormal;
 };
 
-BOOST_FUSION_ADAPT_STRUCT(OBJVertexGroup, (int32_t, indexSpatial), (int32_t, indexTexture), (int32_t, indexNormal))
+BOOST_FUSION_ADAPT_TPL_STRUCT((Index), (OBJVertexGroupT)(Index), (Index, indexSpatial), (Index, indexTexture), (Index, indexNormal))
+
+typedef OBJVertexGroupT<OBJStorage::IndexType> OBJVertexGroup;     ///< Vertex group as stored. See OBJStoragePolicy.
+typedef OBJVertexGroupT<OBJIndex> OBJParsedVertexGroup;             ///< Vertex group as parsed: 1-based, possibly relative, and 0 if absent
 
 //------------------------------------------------------------------------------------------
 
 /**
- * \struct OBJFace
+ * \struct OBJFaceT
  * \brief Collection of vertex groups comprising a single face.
  *
  * A face may represent one of the following:
@@ -115,62 +185,55 @@ BOOST_FUSION_ADAPT_STRUCT(OBJVertexGroup, (int32_t, indexSpatial), (int32_t, ind
  *    - Quad
  *
  * You can check what is represented by seeing which vertex groups are in use.
- * A vertex group is in use if it's indexSpatial element is positive.
+ * A vertex group is in use if it's indexSpatial element is not unused (see OBJVertexGroupT).
  * 
  * If all groups are in use, then the face is a quad. <br/>
  * If group3 is not in use, then the face is a triangle.
  */
-struct OBJFace
+template<typename Index>
+struct OBJFaceT
 {
-    OBJFace();
+    OBJFaceT()
+        : renderState(0)
+    {
+
+    }
 
     //--------------------------------------------------------------------
 
-    OBJVertexGroup group0;  ///< First vertex for the face
-    OBJVertexGroup group1;  ///< Second vertex for the face
-    OBJVertexGroup group2;  ///< Third vertex for the face
-    OBJVertexGroup group3;  ///< Fourth vertex for the face. Used only for Quad faces.
+    OBJVertexGroupT<Index> group0;  ///< First vertex for the face
+    OBJVertexGroupT<Index> group1;  ///< Second vertex for the face
+    OBJVertexGroupT<Index> group2;  ///< Third vertex for the face
+    OBJVertexGroupT<Index> group3;  ///< Fourth vertex for the face. Used only for Quad faces.
 
-    uint32_t renderState;   ///< The active render attribute state when this face was specified. See OBJState::getRenderState
+    uint32_t renderState;           ///< The active render attribute state when this face was specified. See OBJState::getRenderState
 };
 
-BOOST_FUSION_ADAPT_STRUCT(OBJFace, (OBJVertexGroup, group0), (OBJVertexGroup, group1), (OBJVertexGroup, group2), (OBJVertexGroup, group3), (uint32_t, renderState))
-
-//------------------------------------------------------------------------------------------
-
-/**
- * \struct OBJLine
- * \brief Collection of vertex groups comprising a line.
- *
- * A line may have a variable number of segments, but will always have a minimum of two.
- */
-struct OBJLine
-{
-    OBJLine();
-    OBJLine(std::vector<OBJVertexGroup> const& vector);
-
-    std::vector<OBJVertexGroup> segments;
-};
+BOOST_FUSION_ADAPT_TPL_STRUCT((Index), (OBJFaceT)(Index), (OBJVertexGroupT<Index>, group0), (OBJVertexGroupT<Index>, group1), (OBJVertexGroupT<Index>, group2), (OBJVertexGroupT<Index>, group3), (uint32_t, renderState))
 
-BOOST_FUSION_ADAPT_STRUCT(OBJLine, (std::vector<OBJVertexGroup>, segments))
+typedef OBJFaceT<OBJStorage::IndexType> OBJFace;    ///< Face as stored. See OBJStoragePolicy.
+typedef OBJFaceT<OBJIndex> OBJParsedFace;           ///< Face as parsed. See OBJParsedVertexGroup.
 
 //------------------------------------------------------------------------------------------
 
 /**
- * \struct OBJPoint
- * \brief Collection of vertex groups comprising a point collection.
+ * \struct OBJRenderStateRange
+ * \brief Run of consecutive faces within a group that all share the same render state.
  *
- * A point collection may have a variable number of points, but will always have a minimum of one.
+ * Each group keeps a list of these ranges alongside its faces, so that faces
+ * may be batched by render state without inspecting each individual face.
  */
-struct OBJPoint
+struct OBJRenderStateRange
 {
-    OBJPoint(); 
-    OBJPoint(std::vector<OBJVertexGroup> const& vector);
+    OBJRenderStateRange();
+    OBJRenderStateRange(OBJCount first, OBJCount count, uint32_t state);
 
-    std::vector<OBJVertexGroup> points;
-};
+    //--------------------------------------------------------------------
 
-BOOST_FUSION_ADAPT_STRUCT(OBJPoint, (std::vector<OBJVertexGroup>, points))
+    OBJCount firstFace;     ///< Index of the first face in the range. See OBJGroup::faces
+    OBJCount faceCount;     ///< Number of consecutive faces in the range
+    uint32_t renderState;   ///< Render state shared by all faces in the range. See OBJState::getRenderState
+};
 
 //------------------------------------------------------------------------------------------
 
@@ -192,9 +255,29 @@ BOOST_FUSION_ADAPT_STRUCT(OBJSimpleCurve, (float, startParam), (float, endParam)
 
 //------------------------------------------------------------------------------------------
 
+/**
+ * \struct OBJPoolRange
+ * \brief Offset/count pair referencing a contiguous run of elements within a shared pool.
+ *
+ * Free-form objects do not own their variable-length data. Instead it is stored
+ * in pools owned by the OBJFreeFormState, and each free-form references its
+ * portion of a pool with one of these ranges.
+ */
+struct OBJPoolRange
+{
+    OBJPoolRange();
+
+    OBJCount offset;              ///< Index of the first element within the pool
+    OBJCount count;               ///< Number of elements in the range
+};
+
+//------------------------------------------------------------------------------------------
+
 /**
  * \struct OBJFreeForm
  * \brief A free-form object in the form of a curve or surface
+ *
+ * All ranges reference pools within the OBJFreeFormState. See OBJFreeFormState::getParameters, etc.
  */
 struct OBJFreeForm
 {
@@ -204,14 +287,14 @@ struct OBJFreeForm
 
     uint32_t attributeState;                    ///< The active free-form attribute state when this object was created. See OBJState::getFreeFormState
 
-    std::vector<float> parametersU;             ///< Parameter values for the U direction
-    std::vector<float> parametersV;             ///< Parameter vlaues for the V direction
+    OBJPoolRange parametersU;                   ///< Parameter values for the U direction. Range within OBJFreeFormState::parameterPool
+    OBJPoolRange parametersV;                   ///< Parameter values for the V direction. Range within OBJFreeFormState::parameterPool
     
-    std::vector<OBJSimpleCurve> trims;          ///< A sequence of curves to build a single outer trimming loop
-    std::vector<OBJSimpleCurve> holes;          ///< A sequence of curves to build a single inner trimming loop (hole)
-    std::vector<OBJSimpleCurve> specialCurves;  ///< A sequence of curves to build a single special curve
+    OBJPoolRange trims;                         ///< A sequence of curves to build a single outer trimming loop. Range within OBJFreeFormState::simpleCurvePool
+    OBJPoolRange holes;                         ///< A sequence of curves to build a single inner trimming loop (hole). Range within OBJFreeFormState::simpleCurvePool
+    OBJPoolRange specialCurves;                 ///< A sequence of curves to build a single special curve. Range within OBJFreeFormState::simpleCurvePool
 
-    std::vector<int32_t> specialPoints;         ///< Special geometric points to be associated with a curve or surface
+    OBJPoolRange specialPoints;                 ///< Special geometric points to be associated with a curve or surface. Range within OBJFreeFormState::indexPool
 };
 
 //------------------------------------------------------------------------------------------
@@ -223,18 +306,16 @@ struct OBJFreeForm
 struct OBJCurve : public OBJFreeForm
 {
     OBJCurve();
-    OBJCurve(float start, float end, std::vector<OBJVertexGroup> const& points);
+    OBJCurve(float start, float end);
 
     //--------------------------------------------------------------------
 
     float startParam;
     float endParam;
 
-    std::vector<OBJVertexGroup> controlPoints;
+    OBJPoolRange controlPoints;                 ///< Range within OBJFreeFormState::controlPointPool
 };
 
-BOOST_FUSION_ADAPT_STRUCT(OBJCurve, (float, startParam), (float, endParam), (std::vector<OBJVertexGroup>, controlPoints))
-
 //------------------------------------------------------------------------------------------
 
 /**
@@ -244,15 +325,12 @@ BOOST_FUSION_ADAPT_STRUCT(OBJCurve, (float, startParam), (float, endParam), (std
 struct OBJCurve2D : public OBJFreeForm
 {
     OBJCurve2D(); 
-    OBJCurve2D(std::vector<int32_t> const& points);
     
     //--------------------------------------------------------------------
 
-    std::vector<int32_t> parameterVertexIndices;
+    OBJPoolRange parameterVertexIndices;        ///< Range within OBJFreeFormState::indexPool
 };
 
-BOOST_FUSION_ADAPT_STRUCT(OBJCurve2D, (std::vector<int32_t>, parameterVertexIndices))
-
 //------------------------------------------------------------------------------------------
 
 /**
@@ -261,7 +339,7 @@ BOOST_FUSION_ADAPT_STRUCT(OBJCurve2D, (std::vector<int32_t>, parameterVertexIndi
 struct OBJSurface : public OBJFreeForm
 {
     OBJSurface(); 
-    OBJSurface(float startU, float endU, float startV, float endV, std::vector<OBJVertexGroup> const& points);
+    OBJSurface(float startU, float endU, float startV, float endV);
 
     //--------------------------------------------------------------------
 
@@ -271,11 +349,9 @@ struct OBJSurface : public OBJFreeForm
     float startParamV;
     float endParamV;
 
-    std::vector<OBJVertexGroup> controlPoints;
+    OBJPoolRange controlPoints;                 ///< Range within OBJFreeFormState::controlPointPool
 };
 
-BOOST_FUSION_ADAPT_STRUCT(OBJSurface, (float, startParamU), (float, endParamU), (float, startParamV), (float, endParamV), (std::vector<OBJVertexGroup>, controlPoints))
-
 //------------------------------------------------------------------------------------------
 
 /**
@@ -0,0 +1,114 @@
+/*
+ * Copyright 2016 Steven T Sell (ssell@vertexfragment.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __H__OBJ_PARSER_TANGENT_GENERATOR__H__
+#define __H__OBJ_PARSER_TANGENT_GENERATOR__H__
+
+#include "OBJStructs.hpp"
+
+#include <cstdint>
+#include <vector>
+
+class OBJState;
+struct OBJMesh;
+struct OBJRenderState;
+
+//------------------------------------------------------------------------------------------
+
+/**
+ * \class OBJTangentGenerator
+ *
+ * Generates per-vertex tangents for the bump-mapped parts of an OBJMesh, following the
+ * conventions of MikkTSpace (as used by most bakers) so that baked normal maps display 
+ * without seams or shading errors.
+ *
+ * By default, only subsets whose render state references a material with a bump texture 
+ * ('bump' or 'map_bump') are processed (see setBumpMappedOnly). For each of their triangles, the texture-space 
+ * directions are projected onto the tangent plane of each corner's normal, normalized, 
+ * and accumulated weighted by the angle of the corner. Triangles with mirrored texture 
+ * coordinates are never accumulated together with unmirrored ones; where both meet at a 
+ * vertex, the vertex is split so that each side receives its own tangent and bitangent sign.
+ *
+ * Unlike MikkTSpace, vertices are identified by the mesh vertices themselves (which are
+ * already unique combinations of position, texture coordinate, and normal) rather than 
+ * by re-welding, and triangles with degenerate texture coordinates take the tangent of 
+ * their vertex rather than one found through adjacency.
+ *
+ * The triangles of each processed material are processed as one unit of work, in parallel.
+ */
+class OBJTangentGenerator
+{
+public:
+
+    OBJTangentGenerator();
+    ~OBJTangentGenerator();
+
+    /**
+     * Sets the maximum number of threads used.
+     * \param[in] count If 0 (the default), the number of hardware threads is used.
+     */
+    void setThreadCount(uint32_t count);
+
+    /**
+     * \param[in] only If true (the default), only subsets with a bump-mapped material are processed.
+     *                 Otherwise all subsets are, such as when normal maps are assigned outside of the MTL files.
+     */
+    void setBumpMappedOnly(bool only);
+
+    /**
+     * Generates the tangents of a mesh.
+     *
+     * The w component of each tangent is the sign of the bitangent: bitangent = cross(normal, tangent) * w.
+     * Vertices that are not used by a processed subset receive (1, 0, 0, 1). Where no
+     * normal is referenced, the normal of the triangle is used instead.
+     *
+     * Split vertices are appended to the mesh (copying their source vertex group and, 
+     * if written, their interleaved data) and the indices of the mirrored triangles are updated.
+     *
+     * If the mesh has short indices (see OBJMeshBuilder::setShortIndices), each split vertex is
+     * instead inserted directly after the last vertex of its subset, moving the later vertices 
+     * along, and OBJMesh::shortIndices and the base vertices are rebuilt. This fails (leaving the
+     * mesh unchanged) if a split vertex is shared by several subsets, or if a subset would then 
+     * span 65,535 or more vertices.
+     *
+     * \param[in]     state    State the mesh was built from.
+     * \param[in,out] mesh     Mesh built by OBJMeshBuilder.
+     * \param[out]    tangents Receives one tangent per vertex of the mesh, suitable for OBJVertexPacker::pack.
+     *
+     * \return False if the mesh is unchanged because splitting would exceed the range of the indices.
+     */
+    bool generate(OBJState const& state, OBJMesh& mesh, std::vector<OBJVector4>& tangents) const;
+
+    /**
+     * \param[in] state
+     * \param[in] renderState
+     * \return True if the render state references a material of the state that has a bump texture.
+     *
+     * Scans the materials of the state, so is intended for single lookups.
+     */
+    static bool isBumpMapped(OBJState const& state, OBJRenderState const& renderState);
+
+protected:
+
+    uint32_t m_ThreadCount;
+    bool m_BumpMappedOnly;
+
+private:
+};
+
+//------------------------------------------------------------------------------------------
+
+#endif
@@ -19,11 +19,16 @@
 
 #include "OBJStructs.hpp"
 
+#include <boost/functional/hash.hpp>
+
 #include <string>
 #include <cstdint>
 
 //------------------------------------------------------------------------------------------
 
+typedef uint32_t OBJTextureId;      ///< Index of a descriptor within an OBJTextureTable. 0 is no texture.
+
+
 enum class OBJTextureChannel
 {
     None = 0,
@@ -51,6 +56,7 @@ public:
     ~OBJTextureDescriptor();
 
     OBJTextureDescriptor& operator=(OBJTextureDescriptor const& rhs);
+    bool operator==(OBJTextureDescriptor const& rhs) const;
 
     void setBlendU(bool on);
     bool getBlendU() const;
@@ -119,6 +125,28 @@ protected:
 private:
 };
 
+/**
+ * \struct OBJTextureDescriptorHash
+ * \brief Hash functor used to look up identical texture descriptors.
+ *
+ * Only the path and the most commonly varied settings are hashed. Full comparison is
+ * left to OBJTextureDescriptor::operator==.
+ */
+struct OBJTextureDescriptorHash
+{
+    std::size_t operator()(OBJTextureDescriptor const& descriptor) const
+    {
+        std::size_t seed = 0;
+
+        boost::hash_combine(seed, descriptor.getPath());
+        boost::hash_combine(seed, descriptor.getClamp());
+        boost::hash_combine(seed, descriptor.getBumpMultiplier());
+        boost::hash_combine(seed, static_cast<uint32_t>(descriptor.getimfchan()));
+
+        return seed;
+    }
+};
+
 //------------------------------------------------------------------------------------------
 
 #endif
\ No newline at end of file
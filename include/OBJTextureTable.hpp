@@ -0,0 +1,85 @@
+/*
+ * Copyright 2016 Steven T Sell (ssell@vertexfragment.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef __H__OBJ_PARSER_TEXTURE_TABLE__H__
+#define __H__OBJ_PARSER_TEXTURE_TABLE__H__
+
+#include "OBJTextureDescriptor.hpp"
+
+#include <unordered_map>
+#include <vector>
+
+//------------------------------------------------------------------------------------------
+
+/**
+ * \class OBJTextureTable
+ *
+ * Deduplicated collection of texture descriptors, referenced by materials via OBJTextureId.
+ *
+ * Materials of a library commonly share the same textures (and even more commonly use
+ * only a few of their texture slots), so each unique descriptor is stored only once.
+ */
+class OBJTextureTable
+{
+public:
+
+    OBJTextureTable();
+    ~OBJTextureTable();
+
+    /**
+     * Adds a descriptor to the table, unless an identical descriptor is already present.
+     *
+     * \param[in] descriptor
+     * \return Id of the stored descriptor. 0 if the descriptor has no path.
+     */
+    OBJTextureId add(OBJTextureDescriptor const& descriptor);
+
+    /**
+     * \param[in] id Descriptor id. 
+     * \return The descriptor, or a default descriptor (with an empty path) if the id is 0 or invalid.
+     */
+    OBJTextureDescriptor const& get(OBJTextureId id) const;
+
+    /**
+     * \return Number of unique descriptors, not including the default descriptor of id 0.
+     */
+    uint32_t getCount() const;
+
+    /**
+     * Removes all descriptors. Previously returned ids become invalid.
+     */
+    void clear();
+
+    /**
+     * Exchanges the descriptors of two tables.
+     * \param[in] other
+     */
+    void swap(OBJTextureTable& other);
+
+protected:
+
+    typedef std::unordered_multimap<std::size_t, OBJTextureId> HashMap;
+
+    std::vector<OBJTextureDescriptor> m_Descriptors;    ///< Indexed by id. Element 0 is the default descriptor.
+    HashMap m_HashMap;                                  ///< Descriptor hash to the ids of all descriptors with that hash
+
+private:
+};
+
+//------------------------------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,148 @@
+/*
+ * Copyright 2016 Steven T Sell (ssell@vertexfragment.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef __H__OBJ_PARSER_VERTEX_CACHE_OPTIMIZER__H__
+#define __H__OBJ_PARSER_VERTEX_CACHE_OPTIMIZER__H__
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+struct OBJMesh;
+
+//------------------------------------------------------------------------------------------
+
+/**
+ * \struct OBJVertexCacheReport
+ * \brief Post-transform vertex cache efficiency of a mesh before and after optimization.
+ *
+ * Measured by simulating a FIFO cache of the optimizer's cache size over the whole index buffer.
+ *
+ *     ACMR (average cache miss ratio): vertex transforms per triangle. Ranges from 0.5 (ideal) to 3.0.
+ *     ATVR (average transform to vertex ratio): vertex transforms per vertex. Ranges from 1.0 (ideal) to 6.0.
+ */
+struct OBJVertexCacheReport
+{
+    OBJVertexCacheReport();
+
+    uint32_t cacheSize;
+    float acmrBefore;
+    float acmrAfter;
+    float atvrBefore;
+    float atvrAfter;
+
+    uint32_t clusterCount;      ///< Number of triangle clusters ordered to reduce overdraw. 0 if that stage did not run.
+};
+
+//------------------------------------------------------------------------------------------
+
+/**
+ * \class OBJVertexCacheOptimizer
+ *
+ * Reorders the triangles of an OBJMesh for post-transform vertex cache reuse, 
+ * using the Tipsify algorithm (Sander, Nehab, and Barczak 2007).
+ *
+ * Each subset is reordered independently and in place, so subset ranges, triangle 
+ * winding, and the vertex buffer are unchanged. Subsets are distributed over threads.
+ *
+ * Optionally, the reordered triangles are then split into clusters which are sorted
+ * to reduce overdraw independently of the view direction. Clusters facing away from 
+ * the center of their subset are likely to occlude the rest of it, and so are drawn first.
+ */
+class OBJVertexCacheOptimizer
+{
+public:
+
+    OBJVertexCacheOptimizer();
+    ~OBJVertexCacheOptimizer();
+
+    /**
+     * Sets the number of vertices the target cache is assumed to hold. Default is 16.
+     * \param[in] size
+     */
+    void setCacheSize(uint32_t size);
+
+    /**
+     * Sets the maximum number of threads used.
+     * \param[in] count If 0 (the default), the number of hardware threads is used.
+     */
+    void setThreadCount(uint32_t count);
+
+    /**
+     * Enables the overdraw ordering stage, bounding the loss of vertex cache efficiency.
+     *
+     * Clusters are split wherever the cache would be empty, and additionally wherever the
+     * ACMR of the triangles so far in the cluster is no more than threshold times the ACMR 
+     * of the whole cluster. Higher values produce more, smaller clusters, trading more 
+     * vertex cache efficiency for better overdraw ordering.
+     *
+     * The stage reads positions from OBJMesh::vertices, and is skipped if they were not written.
+     *
+     * \param[in] threshold If less than 1.0 (the default is 0.0), the stage is disabled. Typically 1.05.
+     */
+    void setOverdrawThreshold(float threshold);
+
+    /**
+     * Reorders the triangles within each subset of the mesh.
+     * OBJMesh::shortIndices, if present, are rewritten to match.
+     *
+     * \param[in,out] mesh   Mesh as built by OBJMeshBuilder.
+     * \param[out]    report Receives the cache efficiency before and after.
+     */
+    void optimize(OBJMesh& mesh, OBJVertexCacheReport& report) const;
+
+    /**
+     * Renumbers the vertices of the mesh in the order they are first referenced by the
+     * index buffer, and remaps the indices. Run after optimize, so that vertex fetches 
+     * (and any CPU loops over the vertices in draw order) walk memory sequentially.
+     *
+     * OBJMesh::vertices and OBJMesh::sources are reordered together, so the original 
+     * spatial vertex of each vertex remains available as sources[i].indexSpatial.
+     * Vertices not referenced by any index are kept, after all referenced vertices.
+     *
+     * If the mesh has OBJMesh::shortIndices, they and the subset base vertices are rebuilt
+     * with OBJMeshBuilder::buildShortIndices (which clears them if a subset no longer fits).
+     *
+     * \param[in,out] mesh            Mesh as built by OBJMeshBuilder.
+     * \param[out]    previousIndices Optional. Receives the index each vertex had prior to the renumbering.
+     */
+    static void optimizeVertexFetch(OBJMesh& mesh, std::vector<uint32_t>* previousIndices = nullptr);
+
+    /**
+     * Simulates a FIFO vertex cache over a triangle list.
+     *
+     * \param[in]  indices     Triangle list.
+     * \param[in]  indexCount  Number of indices.
+     * \param[in]  vertexCount Number of vertices referenced by the indices.
+     * \param[in]  cacheSize   Number of vertices held by the cache.
+     * \param[out] acmr        Receives the average cache miss ratio. 0 if there are no triangles.
+     * \param[out] atvr        Receives the average transform to vertex ratio. 0 if there are no vertices.
+     */
+    static void measure(uint32_t const* indices, std::size_t indexCount, uint32_t vertexCount, uint32_t cacheSize, float& acmr, float& atvr);
+
+protected:
+
+    uint32_t m_CacheSize;
+    uint32_t m_ThreadCount;
+    float m_OverdrawThreshold;
+
+private:
+};
+
+//------------------------------------------------------------------------------------------
+
+#endif
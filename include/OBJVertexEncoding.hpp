@@ -0,0 +1,148 @@
+/*
+ * Copyright 2016 Steven T Sell (ssell@vertexfragment.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef __H__OBJ_PARSER_VERTEX_ENCODING__H__
+#define __H__OBJ_PARSER_VERTEX_ENCODING__H__
+
+#include "OBJStructs.hpp"
+
+//------------------------------------------------------------------------------------------
+
+/**
+ * \enum OBJNormalEncoding
+ */
+enum class OBJNormalEncoding
+{
+    Float = 0,          ///< Three 32-bit floats (12 bytes). Normals are stored as parsed.
+    Octahedral16        ///< Two 16-bit signed normalized values (4 bytes) of the octahedral projection. Normals are normalized.
+};
+
+/**
+ * \enum OBJTextureEncoding
+ */
+enum class OBJTextureEncoding
+{
+    Float = 0,          ///< Two 32-bit floats (8 bytes). Coordinates are stored as parsed.
+    Unorm16,            ///< Two 16-bit unsigned normalized values (4 bytes). Coordinates are clamped to [0, 1].
+    Half                ///< Two 16-bit IEEE half-precision floats (4 bytes). Preserves coordinates outside of [0, 1].
+};
+
+//------------------------------------------------------------------------------------------
+
+/**
+ * \struct OBJOctahedralNormal
+ * \brief Unit normal stored as two 16-bit signed normalized components. See OBJNormalEncoding::Octahedral16.
+ */
+struct OBJOctahedralNormal
+{
+    OBJOctahedralNormal();
+
+    int16_t x;
+    int16_t y;
+};
+
+/**
+ * \struct OBJPackedVector2
+ * \brief Two 16-bit components. Interpreted according to an OBJTextureEncoding.
+ */
+struct OBJPackedVector2
+{
+    OBJPackedVector2();
+
+    uint16_t x;
+    uint16_t y;
+};
+
+/**
+ * \struct OBJEncodingReport
+ * \brief Worst-case error introduced by the compact normal and texture encodings.
+ *
+ * Every encoded element is decoded again and compared against its source, 
+ * so that the effect of the encoding on rendering quality may be verified.
+ */
+struct OBJEncodingReport
+{
+    OBJEncodingReport();
+
+    uint32_t normalCount;           ///< Number of encoded normals
+    float maxNormalError;           ///< Largest angle, in degrees, between a (normalized) source normal and its decoded normal
+
+    uint32_t textureCount;          ///< Number of encoded texture coordinates
+    float maxTextureError;          ///< Largest absolute difference between a source component and its decoded component
+    uint32_t clampedTextureCount;   ///< Number of texture coordinates that were outside of the range representable by the encoding
+};
+
+//------------------------------------------------------------------------------------------
+
+/**
+ * \class OBJVertexEncoder
+ *
+ * Conversion between floating point vertex data and the compact encodings.
+ *
+ * Where SSE2 is available (and OBJ_PARSER_NO_SIMD is not defined), the batch encoders
+ * process four components at a time. Their output is identical to the portable code.
+ */
+class OBJVertexEncoder
+{
+public:
+
+    /**
+     * \param[in]  source      Normals to encode. Need not be unit length.
+     * \param[in]  count       Number of normals.
+     * \param[out] destination Must have room for count elements.
+     */
+    static void encodeNormals(OBJVector3 const* source, std::size_t count, OBJOctahedralNormal* destination);
+
+    /**
+     * \param[in]  source      Texture coordinates to encode.
+     * \param[in]  count       Number of texture coordinates.
+     * \param[in]  encoding    Unorm16 or Half.
+     * \param[out] destination Must have room for count elements.
+     */
+    static void encodeTextures(OBJVector2 const* source, std::size_t count, OBJTextureEncoding encoding, OBJPackedVector2* destination);
+
+    static OBJVector3 decodeNormal(OBJOctahedralNormal const& normal);
+    static OBJVector2 decodeTexture(OBJPackedVector2 const& texture, OBJTextureEncoding encoding);
+
+    /**
+     * Decodes and compares a batch of normals, updating the report with the worst error found.
+     */
+    static void measureNormals(OBJVector3 const* source, OBJOctahedralNormal const* encoded, std::size_t count, OBJEncodingReport& report);
+
+    /**
+     * Decodes and compares a batch of texture coordinates, updating the report with the worst error found.
+     */
+    static void measureTextures(OBJVector2 const* source, OBJPackedVector2 const* encoded, std::size_t count, OBJTextureEncoding encoding, OBJEncodingReport& report);
+
+    static uint16_t floatToHalf(float value);
+    static float halfToFloat(uint16_t value);
+
+    /**
+     * Converts four values at once, with the same results as floatToHalf.
+     * \param[in]  value  Four values to convert.
+     * \param[out] result Receives the four half-precision values.
+     */
+    static void floatToHalf4(float const* value, uint16_t* result);
+
+protected:
+
+private:
+};
+
+//------------------------------------------------------------------------------------------
+
+#endif
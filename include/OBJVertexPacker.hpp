@@ -0,0 +1,142 @@
+/*
+ * Copyright 2016 Steven T Sell (ssell@vertexfragment.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef __H__OBJ_PARSER_VERTEX_PACKER__H__
+#define __H__OBJ_PARSER_VERTEX_PACKER__H__
+
+#include "OBJStructs.hpp"
+
+class OBJState;
+
+//------------------------------------------------------------------------------------------
+
+/**
+ * \enum OBJPositionFormat
+ */
+enum class OBJPositionFormat
+{
+    Float3 = 0,             ///< Three 32-bit floats (12 bytes)
+    Half4                   ///< Four 16-bit half-precision floats (8 bytes). The w component is 1.0.
+};
+
+/**
+ * \enum OBJNormalFormat
+ * \note Also used for tangents, in which case the w (or 2-bit) component holds the bitangent sign.
+ */
+enum class OBJNormalFormat
+{
+    None = 0,               ///< Not included in the vertex
+    Float3,                 ///< Three 32-bit floats (12 bytes). Tangents are four floats (16 bytes).
+    Snorm16x4,              ///< Four 16-bit signed normalized values (8 bytes). The w component is 0 for normals.
+    Snorm10_10_10_2         ///< One 32-bit value of three 10-bit and one 2-bit signed normalized values, x in the low bits (4 bytes)
+};
+
+/**
+ * \enum OBJTexCoordFormat
+ */
+enum class OBJTexCoordFormat
+{
+    None = 0,               ///< Not included in the vertex
+    Float2,                 ///< Two 32-bit floats (8 bytes)
+    Half2,                  ///< Two 16-bit half-precision floats (4 bytes)
+    Unorm16x2               ///< Two 16-bit unsigned normalized values (4 bytes). Coordinates are clamped to [0, 1].
+};
+
+//------------------------------------------------------------------------------------------
+
+/**
+ * \struct OBJVertexLayout
+ * \brief Describes the format and placement of each attribute within a packed vertex.
+ *
+ * The formats are set by the caller, after which computeOffsets places the attributes
+ * tightly in the order position, normal, texture coordinate, tangent. The offsets and
+ * stride may then be adjusted to match a specific vertex declaration.
+ */
+struct OBJVertexLayout
+{
+    OBJVertexLayout();
+
+    /**
+     * Places the included attributes one after another and sets the stride to their total size.
+     */
+    void computeOffsets();
+
+    /**
+     * Returns true if every included attribute fits within the stride.
+     */
+    bool isValid() const;
+
+    static uint32_t getSize(OBJPositionFormat format);
+    static uint32_t getSize(OBJNormalFormat format, bool tangent);
+    static uint32_t getSize(OBJTexCoordFormat format);
+
+    //--------------------------------------------------------------------
+
+    OBJPositionFormat position;
+    OBJNormalFormat normal;
+    OBJTexCoordFormat texture;
+    OBJNormalFormat tangent;
+
+    uint32_t positionOffset;    ///< Byte offsets of each attribute within a vertex
+    uint32_t normalOffset;
+    uint32_t textureOffset;
+    uint32_t tangentOffset;
+    uint32_t stride;            ///< Bytes between consecutive vertices
+};
+
+//------------------------------------------------------------------------------------------
+
+/**
+ * \class OBJVertexPacker
+ *
+ * Writes vertices of a parsed state directly into caller-provided memory (such as a mapped 
+ * staging buffer) in the formats described by an OBJVertexLayout.
+ *
+ * The vertices are given as vertex groups, typically OBJMesh::sources. Each attribute is 
+ * read from the state and converted in registers, so no intermediate float copy of the 
+ * vertex data is made. The conversion kernels use SSE2 where available (unless 
+ * OBJ_PARSER_NO_SIMD is defined), and otherwise portable code with identical results.
+ */
+class OBJVertexPacker
+{
+public:
+
+    /**
+     * Packs a range of vertices.
+     *
+     * Vertex groups without a normal or texture coordinate receive zeroes for that attribute.
+     * Destination memory between attributes (if the stride allows for it) is left untouched.
+     *
+     * \param[in]  state       State to read the vertex data from.
+     * \param[in]  layout      Vertex layout. Must be valid.
+     * \param[in]  sources     Vertex group of each vertex. All indices must be valid for the state.
+     * \param[in]  count       Number of vertices.
+     * \param[in]  tangents    Tangent of each vertex, as from OBJTangentGenerator::generate. Required if the layout includes tangents.
+     * \param[out] destination Must have room for count * layout.stride bytes. Need not be aligned.
+     *
+     * \return False if the layout is invalid, or tangents are required but were not provided.
+     */
+    static bool pack(OBJState const& state, OBJVertexLayout const& layout, OBJVertexGroup const* sources, std::size_t count, OBJVector4 const* tangents, void* destination);
+
+protected:
+
+private:
+};
+
+//------------------------------------------------------------------------------------------
+
+#endif
@@ -14,6 +14,9 @@
  * limitations under the License.
  */
 
+// MTL support is compiled out entirely when OBJ_PARSER_NO_MTL is defined (see OBJParser.hpp)
+#ifndef OBJ_PARSER_NO_MTL
+
 #include "MTLGrammar.hpp"
 #include "OBJState.hpp"
 
@@ -47,6 +50,14 @@ void MTLGrammar::resetCurrentTexture()
     m_CurrentTexture = OBJTextureDescriptor();
 }
 
+void MTLGrammar::finishCurrentTexture(OBJTextureSlot const slot)
+{
+    if(m_pOBJState)
+    {
+        m_CurrentMaterial.setTexture(slot, m_pOBJState->addTextureDescriptor(m_CurrentTexture));
+    }
+}
+
 void MTLGrammar::finishCurrentMaterial()
 {
     if(m_pOBJState)
@@ -287,40 +298,40 @@ void MTLGrammar::setupTextureMapRules()
 
     ruleTextureMapAmbient =
         qi::lit("map_Ka")  >>
-        ruleTextureMapBody [boost::phoenix::bind(&OBJMaterial::setAmbientTexture, &m_CurrentMaterial, &m_CurrentTexture)];
+        ruleTextureMapBody [boost::phoenix::bind(&MTLGrammar::finishCurrentTexture, this, OBJTextureSlot::Ambient)];
 
     ruleTextureMapDiffuse =
         qi::lit("map_Kd") [boost::phoenix::bind(&MTLGrammar::resetCurrentTexture, this)] >>
-        ruleTextureMapBody [boost::phoenix::bind(&OBJMaterial::setDiffuseTexture, &m_CurrentMaterial, &m_CurrentTexture)];
+        ruleTextureMapBody [boost::phoenix::bind(&MTLGrammar::finishCurrentTexture, this, OBJTextureSlot::Diffuse)];
 
     ruleTextureMapSpecular =
         qi::lit("map_Ks") [boost::phoenix::bind(&MTLGrammar::resetCurrentTexture, this)] >>
-        ruleTextureMapBody [boost::phoenix::bind(&OBJMaterial::setSpecularTexture, &m_CurrentMaterial, &m_CurrentTexture)];
+        ruleTextureMapBody [boost::phoenix::bind(&MTLGrammar::finishCurrentTexture, this, OBJTextureSlot::Specular)];
 
     ruleTextureMapSpecularExponent =
         qi::lit("map_Ns") [boost::phoenix::bind(&MTLGrammar::resetCurrentTexture, this)] >>
-        ruleTextureMapBody [boost::phoenix::bind(&OBJMaterial::setSpecularExponentTexture, &m_CurrentMaterial, &m_CurrentTexture)];
+        ruleTextureMapBody [boost::phoenix::bind(&MTLGrammar::finishCurrentTexture, this, OBJTextureSlot::SpecularExponent)];
 
     ruleTextureMapEmissive =
         qi::lit("map_Ke") [boost::phoenix::bind(&MTLGrammar::resetCurrentTexture, this)] >>
-        ruleTextureMapBody [boost::phoenix::bind(&OBJMaterial::setEmissiveTexture, &m_CurrentMaterial, &m_CurrentTexture)];
+        ruleTextureMapBody [boost::phoenix::bind(&MTLGrammar::finishCurrentTexture, this, OBJTextureSlot::Emissive)];
 
     ruleTextureMapDissolve =
         qi::lit("map_d") [boost::phoenix::bind(&MTLGrammar::resetCurrentTexture, this)] >>
-        ruleTextureMapBody [boost::phoenix::bind(&OBJMaterial::setDissolveTexture, &m_CurrentMaterial, &m_CurrentTexture)];
+        ruleTextureMapBody [boost::phoenix::bind(&MTLGrammar::finishCurrentTexture, this, OBJTextureSlot::Dissolve)];
 
     ruleTextureMapDecal =
         qi::lit("decal") [boost::phoenix::bind(&MTLGrammar::resetCurrentTexture, this)] >>
-        ruleTextureMapBody [boost::phoenix::bind(&OBJMaterial::setDecalTexture, &m_CurrentMaterial, &m_CurrentTexture)];
+        ruleTextureMapBody [boost::phoenix::bind(&MTLGrammar::finishCurrentTexture, this, OBJTextureSlot::Decal)];
 
     ruleTextureMapDisplacement =
         qi::lit("disp") [boost::phoenix::bind(&MTLGrammar::resetCurrentTexture, this)] >>
-        ruleTextureMapBody [boost::phoenix::bind(&OBJMaterial::setDisplacementTexture, &m_CurrentMaterial, &m_CurrentTexture)];
+        ruleTextureMapBody [boost::phoenix::bind(&MTLGrammar::finishCurrentTexture, this, OBJTextureSlot::Displacement)];
 
     ruleTextureMapBump =
         (qi::lit("bump") [boost::phoenix::bind(&MTLGrammar::resetCurrentTexture, this)] |
          qi::lit("map_bump") [boost::phoenix::bind(&MTLGrammar::resetCurrentTexture, this)]) >>
-        ruleTextureMapBody [boost::phoenix::bind(&OBJMaterial::setBumpTexture, &m_CurrentMaterial, &m_CurrentTexture)];
+        ruleTextureMapBody [boost::phoenix::bind(&MTLGrammar::finishCurrentTexture, this, OBJTextureSlot::Bump)];
 
     //----------------------------------------------------------------
     // Anti-Aliasing
@@ -430,31 +441,31 @@ void MTLGrammar::setupReflectionMapRules()
 {
     ruleReflectionMapSphere =
         qi::lit("refl -type sphere") [boost::phoenix::bind(&MTLGrammar::resetCurrentTexture, this)] >>
-        ruleTextureMapBody [boost::phoenix::bind(&OBJMaterial::setReflectionMapSphere, &m_CurrentMaterial, &m_CurrentTexture)];
+        ruleTextureMapBody [boost::phoenix::bind(&MTLGrammar::finishCurrentTexture, this, OBJTextureSlot::ReflectionSphere)];
 
     ruleReflectionMapCubeTop =
         qi::lit("refl -type cube_top") [boost::phoenix::bind(&MTLGrammar::resetCurrentTexture, this)] >>
-        ruleTextureMapBody [boost::phoenix::bind(&OBJMaterial::setReflectionMapCubeSide, &m_CurrentMaterial, OBJReflectionMapCubeSide::Top, &m_CurrentTexture)];
+        ruleTextureMapBody [boost::phoenix::bind(&MTLGrammar::finishCurrentTexture, this, OBJTextureSlot::ReflectionCubeTop)];
 
     ruleReflectionMapCubeBottom =
         qi::lit("refl -type cube_bottom") [boost::phoenix::bind(&MTLGrammar::resetCurrentTexture, this)] >>
-        ruleTextureMapBody [boost::phoenix::bind(&OBJMaterial::setReflectionMapCubeSide, &m_CurrentMaterial, OBJReflectionMapCubeSide::Bottom, &m_CurrentTexture)];
+        ruleTextureMapBody [boost::phoenix::bind(&MTLGrammar::finishCurrentTexture, this, OBJTextureSlot::ReflectionCubeBottom)];
 
     ruleReflectionMapCubeFront =
         qi::lit("refl -type cube_front") [boost::phoenix::bind(&MTLGrammar::resetCurrentTexture, this)] >>
-        ruleTextureMapBody [boost::phoenix::bind(&OBJMaterial::setReflectionMapCubeSide, &m_CurrentMaterial, OBJReflectionMapCubeSide::Front, &m_CurrentTexture)];
+        ruleTextureMapBody [boost::phoenix::bind(&MTLGrammar::finishCurrentTexture, this, OBJTextureSlot::ReflectionCubeFront)];
 
     ruleReflectionMapCubeBack =
         qi::lit("refl -type cube_back") [boost::phoenix::bind(&MTLGrammar::resetCurrentTexture, this)] >>
-        ruleTextureMapBody [boost::phoenix::bind(&OBJMaterial::setReflectionMapCubeSide, &m_CurrentMaterial, OBJReflectionMapCubeSide::Back, &m_CurrentTexture)];
+        ruleTextureMapBody [boost::phoenix::bind(&MTLGrammar::finishCurrentTexture, this, OBJTextureSlot::ReflectionCubeBack)];
 
     ruleReflectionMapCubeLeft =
         qi::lit("refl -type cube_left") [boost::phoenix::bind(&MTLGrammar::resetCurrentTexture, this)] >>
-        ruleTextureMapBody [boost::phoenix::bind(&OBJMaterial::setReflectionMapCubeSide, &m_CurrentMaterial, OBJReflectionMapCubeSide::Left, &m_CurrentTexture)];
+        ruleTextureMapBody [boost::phoenix::bind(&MTLGrammar::finishCurrentTexture, this, OBJTextureSlot::ReflectionCubeLeft)];
 
     ruleReflectionMapCubeRight =
         qi::lit("refl -type cube_right") [boost::phoenix::bind(&MTLGrammar::resetCurrentTexture, this)] >>
-        ruleTextureMapBody [boost::phoenix::bind(&OBJMaterial::setReflectionMapCubeSide, &m_CurrentMaterial, OBJReflectionMapCubeSide::Right, &m_CurrentTexture)];
+        ruleTextureMapBody [boost::phoenix::bind(&MTLGrammar::finishCurrentTexture, this, OBJTextureSlot::ReflectionCubeRight)];
 
     ruleReflectionMap =
         (ruleReflectionMapSphere |
@@ -464,4 +475,6 @@ void MTLGrammar::setupReflectionMapRules()
             ruleReflectionMapCubeBack |
             ruleReflectionMapCubeLeft |
             ruleReflectionMapCubeRight);
-}
\ No newline at end of file
+}
+
+#endif
@@ -14,6 +14,9 @@
  * limitations under the License.
  */
 
+// MTL support is compiled out entirely when OBJ_PARSER_NO_MTL is defined (see OBJParser.hpp)
+#ifndef OBJ_PARSER_NO_MTL
+
 #include "MTLGrammarSkipper.hpp"
 
 //------------------------------------------------------------------------------------------
@@ -36,4 +39,6 @@ MTLGrammarSkipper::MTLGrammarSkipper()
 
 //------------------------------------------------------------------------------------------
 // Private Methods
-//------------------------------------------------------------------------------------------
\ No newline at end of file
+//------------------------------------------------------------------------------------------
+
+#endif
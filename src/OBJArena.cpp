@@ -0,0 +1,249 @@
+/*
+ * Copyright 2016 Steven T Sell (ssell@vertexfragment.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "OBJArena.hpp"
+#include "OBJMappedRegion.hpp"
+
+namespace
+{
+    const std::size_t DefaultAlignment = 16;         ///< Alignment guaranteed for all dedicated blocks
+
+    char* AlignPointer(char* ptr, std::size_t alignment)
+    {
+        const std::uintptr_t address = reinterpret_cast<std::uintptr_t>(ptr);
+        return reinterpret_cast<char*>((address + (alignment - 1)) & ~static_cast<std::uintptr_t>(alignment - 1));
+    }
+}
+
+//------------------------------------------------------------------------------------------
+// Constructors
+//------------------------------------------------------------------------------------------
+
+OBJArena::OBJArena(std::size_t const blockSize, bool const hugePages)
+    : m_CurrentBlock(0),
+      m_BlockSize(blockSize < 4096 ? 4096 : blockSize),
+      m_HugePages(hugePages)
+{
+
+}
+
+OBJArena::~OBJArena()
+{
+    release();
+}
+
+//------------------------------------------------------------------------------------------
+// Public Methods
+//------------------------------------------------------------------------------------------
+
+void* OBJArena::allocate(std::size_t const bytes, std::size_t const alignment)
+{
+    if(bytes > (m_BlockSize / 2))
+    {
+        return allocateDedicated(bytes, alignment);
+    }
+
+    while(true)
+    {
+        if(m_CurrentBlock < m_Blocks.size())
+        {
+            Block& block = m_Blocks[m_CurrentBlock];
+
+            char* const ptr = AlignPointer(block.data + block.used, alignment);
+            const std::size_t end = static_cast<std::size_t>(ptr - block.data) + bytes;
+
+            if(end <= block.size)
+            {
+                block.used = end;
+                return ptr;
+            }
+
+            if((m_CurrentBlock + 1) < m_Blocks.size())
+            {
+                m_CurrentBlock++;
+                continue;
+            }
+        }
+
+        m_Blocks.reserve(m_Blocks.size() + 1);
+        m_Blocks.push_back(createBlock(m_BlockSize, DefaultAlignment));
+        m_CurrentBlock = m_Blocks.size() - 1;
+    }
+}
+
+void OBJArena::deallocate(void* ptr, std::size_t const bytes)
+{
+    if(!ptr)
+    {
+        return;
+    }
+
+    char* const cptr = static_cast<char*>(ptr);
+
+    if(bytes > (m_BlockSize / 2))
+    {
+        // Search from the back, as the most recent allocations are the most likely to be freed (vector growth)
+        for(std::size_t i = m_DedicatedBlocks.size(); i > 0; --i)
+        {
+            if(m_DedicatedBlocks[i - 1].data == cptr)
+            {
+                destroyBlock(m_DedicatedBlocks[i - 1]);
+                m_DedicatedBlocks.erase(m_DedicatedBlocks.begin() + (i - 1));
+                break;
+            }
+        }
+    }
+    else if(m_CurrentBlock < m_Blocks.size())
+    {
+        Block& block = m_Blocks[m_CurrentBlock];
+
+        if((cptr >= block.data) && ((cptr + bytes) == (block.data + block.used)))
+        {
+            block.used = static_cast<std::size_t>(cptr - block.data);
+        }
+    }
+}
+
+void OBJArena::reset()
+{
+    for(auto iter = m_DedicatedBlocks.begin(); iter != m_DedicatedBlocks.end(); ++iter)
+    {
+        destroyBlock((*iter));
+    }
+
+    m_DedicatedBlocks.clear();
+
+    for(auto iter = m_Blocks.begin(); iter != m_Blocks.end(); ++iter)
+    {
+        (*iter).used = 0;
+    }
+
+    m_CurrentBlock = 0;
+}
+
+void OBJArena::release()
+{
+    reset();
+
+    for(auto iter = m_Blocks.begin(); iter != m_Blocks.end(); ++iter)
+    {
+        destroyBlock((*iter));
+    }
+
+    m_Blocks.clear();
+}
+
+std::size_t OBJArena::getBytesUsed() const
+{
+    std::size_t result = 0;
+
+    for(auto iter = m_Blocks.begin(); iter != m_Blocks.end(); ++iter)
+    {
+        result += (*iter).used;
+    }
+
+    for(auto iter = m_DedicatedBlocks.begin(); iter != m_DedicatedBlocks.end(); ++iter)
+    {
+        result += (*iter).used;
+    }
+
+    return result;
+}
+
+std::size_t OBJArena::getBytesReserved() const
+{
+    std::size_t result = 0;
+
+    for(auto iter = m_Blocks.begin(); iter != m_Blocks.end(); ++iter)
+    {
+        result += (*iter).size;
+    }
+
+    for(auto iter = m_DedicatedBlocks.begin(); iter != m_DedicatedBlocks.end(); ++iter)
+    {
+        result += (*iter).size;
+    }
+
+    return result;
+}
+
+bool OBJArena::usesHugePages() const
+{
+    return m_HugePages;
+}
+
+//------------------------------------------------------------------------------------------
+// Protected Methods
+//------------------------------------------------------------------------------------------
+
+OBJArena::Block OBJArena::createBlock(std::size_t const size, std::size_t const alignment)
+{
+    Block block;
+
+    block.used = 0;
+    block.size = size;
+    block.mapped = false;
+    block.mappedSize = 0;
+    block.base = nullptr;
+
+    if(m_HugePages && (size >= OBJMappedRegion::HugePageSize) && (alignment <= OBJMappedRegion::HugePageSize))
+    {
+        std::size_t mappedSize = size;
+        block.base = static_cast<char*>(OBJMappedRegion::mapMemory(mappedSize, true));
+
+        if(block.base)
+        {
+            block.mapped = true;
+            block.mappedSize = mappedSize;
+            block.data = block.base;
+        }
+    }
+
+    if(!block.base)
+    {
+        const std::size_t padding = (alignment > DefaultAlignment) ? alignment : 0;
+
+        block.base = static_cast<char*>(::operator new(size + padding));
+        block.data = AlignPointer(block.base, (padding > 0) ? alignment : 1);
+    }
+
+    return block;
+}
+
+void OBJArena::destroyBlock(Block const& block)
+{
+    if(block.mapped)
+    {
+        OBJMappedRegion::unmapMemory(block.base, block.mappedSize);
+    }
+    else
+    {
+        ::operator delete(block.base);
+    }
+}
+
+void* OBJArena::allocateDedicated(std::size_t const bytes, std::size_t const alignment)
+{
+    m_DedicatedBlocks.reserve(m_DedicatedBlocks.size() + 1);
+
+    Block block = createBlock(bytes, alignment);
+    block.used = bytes;
+
+    m_DedicatedBlocks.push_back(block);
+
+    return block.data;
+}
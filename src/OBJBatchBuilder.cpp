@@ -0,0 +1,283 @@
+/*
+ * Copyright 2016 Steven T Sell (ssell@vertexfragment.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "OBJBatchBuilder.hpp"
+#include "OBJParallel.hpp"
+#include "OBJState.hpp"
+
+#include <algorithm>
+
+namespace
+{
+    const uint64_t MinimumChunkFaces = 1 << 16;     ///< Smaller chunks are not worth a thread of their own
+
+    bool CompareMaterialNames(OBJMaterial const* lhs, OBJMaterial const* rhs)
+    {
+        return lhs->getName() < rhs->getName();
+    }
+
+    bool CompareMaterialName(OBJMaterial const* lhs, OBJArenaString const& rhs)
+    {
+        return lhs->getName() < rhs;
+    }
+}
+
+const uint32_t OBJDrawBatches::NoMaterial;
+
+//------------------------------------------------------------------------------------------
+// Constructors
+//------------------------------------------------------------------------------------------
+
+OBJDrawBatch::OBJDrawBatch()
+    : material(OBJDrawBatches::NoMaterial),
+      smoothing(0),
+      firstFace(0),
+      faceCount(0)
+{
+
+}
+
+OBJBatchBuilder::OBJBatchBuilder()
+    : m_SplitSmoothing(false),
+      m_ThreadCount(0)
+{
+
+}
+
+OBJBatchBuilder::~OBJBatchBuilder()
+{
+
+}
+
+//------------------------------------------------------------------------------------------
+// Public Methods
+//------------------------------------------------------------------------------------------
+
+uint32_t OBJDrawBatches::findMaterial(OBJArenaString const& name) const
+{
+    uint32_t result = NoMaterial;
+    auto find = std::lower_bound(materials.begin(), materials.end(), name, CompareMaterialName);
+
+    if((find != materials.end()) && ((*find)->getName() == name))
+    {
+        result = static_cast<uint32_t>(find - materials.begin());
+    }
+
+    return result;
+}
+
+void OBJBatchBuilder::setSplitSmoothing(bool const split)
+{
+    m_SplitSmoothing = split;
+}
+
+void OBJBatchBuilder::setThreadCount(uint32_t const count)
+{
+    m_ThreadCount = count;
+}
+
+bool OBJBatchBuilder::build(OBJState const& state, OBJDrawBatches& batches)
+{
+    batches.materials.clear();
+    batches.batches.clear();
+    batches.faces.clear();
+
+    state.getGroups(m_Groups);
+    resolveRenderStates(state, batches);
+
+    uint64_t faceCount = 0;
+
+    for(auto group = m_Groups.begin(); group != m_Groups.end(); ++group)
+    {
+        for(auto range = (*group)->renderStateRanges.begin(); range != (*group)->renderStateRanges.end(); ++range)
+        {
+            faceCount += (*range).faceCount;
+        }
+    }
+
+    if(faceCount > 0xFFFFFFFF)
+    {
+        return false;
+    }
+
+    //--------------------------------------------------------------------
+    // Count the faces of each batch within each chunk
+    //--------------------------------------------------------------------
+
+    const std::size_t batchCount = batches.batches.size();
+
+    splitChunks(faceCount, batchCount);
+
+    // There is one chunk per thread
+
+    const uint32_t chunkThreads = static_cast<uint32_t>(m_Chunks.size());
+    OBJParallelFor(m_Chunks.size(), chunkThreads, [this](std::size_t const c) { countChunk(m_Chunks[c]); });
+
+    //--------------------------------------------------------------------
+    // Turn the counts into write offsets. Chunks are in group order, so
+    // each chunk writes after all earlier chunks within every batch.
+    //--------------------------------------------------------------------
+
+    uint32_t offset = 0;
+
+    for(std::size_t b = 0; b < batchCount; ++b)
+    {
+        OBJDrawBatch& batch = batches.batches[b];
+        batch.firstFace = offset;
+
+        for(auto chunk = m_Chunks.begin(); chunk != m_Chunks.end(); ++chunk)
+        {
+            const uint32_t count = (*chunk).offsets[b];
+
+            (*chunk).offsets[b] = offset;
+            offset += count;
+        }
+
+        batch.faceCount = offset - batch.firstFace;
+    }
+
+    batches.faces.resize(static_cast<std::size_t>(faceCount));
+    OBJParallelFor(m_Chunks.size(), chunkThreads, [this, &batches](std::size_t const c) { scatterChunk(m_Chunks[c], batches); });
+
+    // Render states are resolved up front, so some of their batches may not have any faces
+
+    batches.batches.erase(std::remove_if(batches.batches.begin(), batches.batches.end(), [](OBJDrawBatch const& batch) { return (batch.faceCount == 0); }), batches.batches.end());
+
+    return true;
+}
+
+//------------------------------------------------------------------------------------------
+// Protected Methods
+//------------------------------------------------------------------------------------------
+
+void OBJBatchBuilder::resolveRenderStates(OBJState const& state, OBJDrawBatches& batches)
+{
+    state.getMaterials(batches.materials);
+    std::sort(batches.materials.begin(), batches.materials.end(), CompareMaterialNames);
+
+    // The final entry is for faces referencing a render state that does not exist, which use the default state
+
+    const uint32_t renderStateCount = state.getRenderStateCount();
+    std::vector<uint64_t> keys(renderStateCount + 1);
+
+    for(uint32_t i = 0; i <= renderStateCount; ++i)
+    {
+        const OBJRenderState renderState = state.getRenderState(i);
+        const uint64_t material = renderState.material.empty() ? OBJDrawBatches::NoMaterial : batches.findMaterial(renderState.material);
+        const uint64_t smoothing = m_SplitSmoothing ? renderState.smoothing : 0;
+
+        keys[i] = (material << 32) | smoothing;
+    }
+
+    std::vector<uint64_t> unique(keys);
+    std::sort(unique.begin(), unique.end());
+    unique.erase(std::unique(unique.begin(), unique.end()), unique.end());
+
+    batches.batches.resize(unique.size());
+
+    for(std::size_t i = 0; i < unique.size(); ++i)
+    {
+        batches.batches[i].material = static_cast<uint32_t>(unique[i] >> 32);
+        batches.batches[i].smoothing = static_cast<uint32_t>(unique[i] & 0xFFFFFFFF);
+    }
+
+    m_RenderStateBatches.resize(keys.size());
+
+    for(std::size_t i = 0; i < keys.size(); ++i)
+    {
+        m_RenderStateBatches[i] = static_cast<uint32_t>(std::lower_bound(unique.begin(), unique.end(), keys[i]) - unique.begin());
+    }
+}
+
+void OBJBatchBuilder::splitChunks(uint64_t const faceCount, std::size_t const batchCount)
+{
+    const uint64_t threads = OBJGetThreadCount(m_ThreadCount, static_cast<std::size_t>(faceCount / MinimumChunkFaces));
+
+    const uint64_t target = (faceCount + threads - 1) / threads;
+
+    m_Chunks.clear();
+    m_Chunks.reserve(static_cast<std::size_t>(threads));
+
+    Chunk chunk;
+    chunk.firstGroup = 0;
+    uint64_t chunkFaces = 0;
+
+    for(std::size_t i = 0; i < m_Groups.size(); ++i)
+    {
+        chunkFaces += m_Groups[i]->faces.size();
+
+        if((chunkFaces >= target) && (m_Chunks.size() + 1 < threads))
+        {
+            chunk.endGroup = i + 1;
+            m_Chunks.push_back(chunk);
+
+            chunk.firstGroup = i + 1;
+            chunkFaces = 0;
+        }
+    }
+
+    chunk.endGroup = m_Groups.size();
+    m_Chunks.push_back(chunk);
+
+    for(auto iter = m_Chunks.begin(); iter != m_Chunks.end(); ++iter)
+    {
+        (*iter).offsets.assign(batchCount, 0);
+    }
+}
+
+void OBJBatchBuilder::countChunk(Chunk& chunk) const
+{
+    const std::size_t lastRenderState = m_RenderStateBatches.size() - 1;
+
+    for(std::size_t i = chunk.firstGroup; i < chunk.endGroup; ++i)
+    {
+        OBJGroup const* group = m_Groups[i];
+
+        for(auto range = group->renderStateRanges.begin(); range != group->renderStateRanges.end(); ++range)
+        {
+            const uint32_t batch = m_RenderStateBatches[std::min(static_cast<std::size_t>((*range).renderState), lastRenderState)];
+            chunk.offsets[batch] += (*range).faceCount;
+        }
+    }
+}
+
+void OBJBatchBuilder::scatterChunk(Chunk& chunk, OBJDrawBatches& batches) const
+{
+    const std::size_t lastRenderState = m_RenderStateBatches.size() - 1;
+
+    for(std::size_t i = chunk.firstGroup; i < chunk.endGroup; ++i)
+    {
+        OBJGroup const* group = m_Groups[i];
+
+        for(auto range = group->renderStateRanges.begin(); range != group->renderStateRanges.end(); ++range)
+        {
+            const uint32_t batch = m_RenderStateBatches[std::min(static_cast<std::size_t>((*range).renderState), lastRenderState)];
+            const std::size_t end = static_cast<std::size_t>((*range).firstFace) + (*range).faceCount;
+
+            uint32_t& offset = chunk.offsets[batch];
+
+            for(std::size_t face = (*range).firstFace; face < end; ++face)
+            {
+                batches.faces[offset++] = &group->faces[face];
+            }
+        }
+    }
+}
+
+//------------------------------------------------------------------------------------------
+// Private Methods
+//------------------------------------------------------------------------------------------
@@ -16,6 +16,56 @@
 
 #include "OBJFreeFormState.hpp"
 
+#include <utility>
+
+namespace
+{
+    /**
+     * Appends a value to the end of a range within a pool.
+     *
+     * If the range is no longer at the end of its pool (another statement has appended 
+     * to the same pool since the range was started) then the existing elements of the 
+     * range are first moved to the end of the pool so that the range remains contiguous.
+     */
+    template<typename T, typename A>
+    void AppendToPool(std::vector<T, A>& pool, OBJPoolRange& range, T const& value)
+    {
+        const OBJCount poolSize = static_cast<OBJCount>(pool.size());
+
+        if(range.count == 0)
+        {
+            range.offset = poolSize;
+        }
+        else if((range.offset + range.count) != poolSize)
+        {
+            pool.reserve(pool.size() + range.count + 1);
+
+            for(OBJCount i = 0; i < range.count; ++i)
+            {
+                pool.push_back(pool[range.offset + i]);
+            }
+
+            range.offset = poolSize;
+        }
+
+        pool.push_back(value);
+        range.count++;
+    }
+
+    template<typename T, typename A>
+    T const* ResolvePoolRange(std::vector<T, A> const& pool, OBJPoolRange const& range)
+    {
+        T const* result = nullptr;
+
+        if((range.count > 0) && ((range.offset + range.count) <= pool.size()))
+        {
+            result = pool.data() + range.offset;
+        }
+
+        return result;
+    }
+}
+
 //------------------------------------------------------------------------------------------
 // Constructors
 //------------------------------------------------------------------------------------------
@@ -26,6 +76,22 @@ OBJFreeFormState::OBJFreeFormState()
 
 }
 
+OBJFreeFormState::OBJFreeFormState(OBJArena* arena)
+    : attributeStates(OBJArenaAllocator<OBJFreeFormAttributeState>(arena)),
+      vertexParameterData(OBJArenaAllocator<OBJVector3>(arena)),
+      curves(OBJArenaAllocator<OBJCurve>(arena)),
+      curves2D(OBJArenaAllocator<OBJCurve2D>(arena)),
+      surfaces(OBJArenaAllocator<OBJSurface>(arena)),
+      connections(OBJArenaAllocator<OBJSurfaceConnection>(arena)),
+      controlPointPool(OBJArenaAllocator<OBJVertexGroup>(arena)),
+      parameterPool(OBJArenaAllocator<float>(arena)),
+      simpleCurvePool(OBJArenaAllocator<OBJSimpleCurve>(arena)),
+      indexPool(OBJArenaAllocator<OBJIndex>(arena)),
+      m_LatestFreeForm(FreeFormType::None)
+{
+
+}
+
 OBJFreeFormState::~OBJFreeFormState()
 {
 
@@ -35,46 +101,134 @@ OBJFreeFormState::~OBJFreeFormState()
 // Public Methods
 //------------------------------------------------------------------------------------------
 
-void OBJFreeFormState::addCurve(uint32_t const state, float const startParam, float const endParam, std::vector<OBJVertexGroup> const& controlPoints)
+void OBJFreeFormState::clear()
+{
+    attributeStates.clear();
+    vertexParameterData.clear();
+
+    curves.clear();
+    curves2D.clear();
+    surfaces.clear();
+    connections.clear();
+
+    controlPointPool.clear();
+    parameterPool.clear();
+    simpleCurvePool.clear();
+    indexPool.clear();
+
+    m_LatestFreeForm = FreeFormType::None;
+}
+
+void OBJFreeFormState::release()
+{
+    OBJReleaseContainer(attributeStates);
+    OBJReleaseContainer(vertexParameterData);
+
+    OBJReleaseContainer(curves);
+    OBJReleaseContainer(curves2D);
+    OBJReleaseContainer(surfaces);
+    OBJReleaseContainer(connections);
+
+    OBJReleaseContainer(controlPointPool);
+    OBJReleaseContainer(parameterPool);
+    OBJReleaseContainer(simpleCurvePool);
+    OBJReleaseContainer(indexPool);
+
+    m_LatestFreeForm = FreeFormType::None;
+}
+
+void OBJFreeFormState::abandon()
+{
+    OBJAbandonContainer(attributeStates);
+    OBJAbandonContainer(vertexParameterData);
+
+    OBJAbandonContainer(curves);
+    OBJAbandonContainer(curves2D);
+    OBJAbandonContainer(surfaces);
+    OBJAbandonContainer(connections);
+
+    OBJAbandonContainer(controlPointPool);
+    OBJAbandonContainer(parameterPool);
+    OBJAbandonContainer(simpleCurvePool);
+    OBJAbandonContainer(indexPool);
+
+    m_LatestFreeForm = FreeFormType::None;
+}
+
+void OBJFreeFormState::swap(OBJFreeFormState& other)
+{
+    attributeStates.swap(other.attributeStates);
+    vertexParameterData.swap(other.vertexParameterData);
+
+    curves.swap(other.curves);
+    curves2D.swap(other.curves2D);
+    surfaces.swap(other.surfaces);
+    connections.swap(other.connections);
+
+    controlPointPool.swap(other.controlPointPool);
+    parameterPool.swap(other.parameterPool);
+    simpleCurvePool.swap(other.simpleCurvePool);
+    indexPool.swap(other.indexPool);
+
+    std::swap(m_LatestFreeForm, other.m_LatestFreeForm);
+}
+
+void OBJFreeFormState::addCurve(uint32_t const state, float const startParam, float const endParam)
 {
     m_LatestFreeForm = FreeFormType::Curve;
-    curves.emplace_back(startParam, endParam, controlPoints);
+    curves.emplace_back(startParam, endParam);
     curves.back().attributeState = state;
 }
 
-void OBJFreeFormState::addCurve2D(uint32_t const state, std::vector<int32_t> const& controlPoints)
+void OBJFreeFormState::addCurve2D(uint32_t const state)
 {
     m_LatestFreeForm = FreeFormType::Curve2D;
-    curves2D.emplace_back(controlPoints);
+    curves2D.emplace_back();
     curves2D.back().attributeState = state;
 }
 
-void OBJFreeFormState::addSurface(uint32_t const state, float const startU, float const endU, float const startV, float const endV, std::vector<OBJVertexGroup> const& controlPoints)
+void OBJFreeFormState::addSurface(uint32_t const state, float const startU, float const endU, float const startV, float const endV)
 {
     m_LatestFreeForm = FreeFormType::Surface;
-    surfaces.emplace_back(startU, endU, startV, endV, controlPoints);
+    surfaces.emplace_back(startU, endU, startV, endV);
     surfaces.back().attributeState = state;
 }
 
-void OBJFreeFormState::addParameterU(std::vector<float> const& parameters)
+void OBJFreeFormState::addControlPoint(OBJVertexGroup const& point)
+{
+    OBJPoolRange* range = getLatestControlPoints();
+
+    if(range)
+    {
+        AppendToPool(controlPointPool, *range, point);
+    }
+}
+
+void OBJFreeFormState::addCurve2DPoint(OBJIndex const point)
+{
+    if((m_LatestFreeForm == FreeFormType::Curve2D) && curves2D.size())
+    {
+        AppendToPool(indexPool, curves2D.back().parameterVertexIndices, point);
+    }
+}
+
+void OBJFreeFormState::addParameterU(float const parameter)
 {
     OBJFreeForm* freeform = getLatestFreeForm();
 
     if(freeform)
     {
-        freeform->parametersU.reserve(freeform->parametersU.size() + parameters.size());
-        freeform->parametersU.insert(freeform->parametersU.end(), parameters.begin(), parameters.end());
+        AppendToPool(parameterPool, freeform->parametersU, parameter);
     }
 }
 
-void OBJFreeFormState::addParameterV(std::vector<float> const& parameters)
+void OBJFreeFormState::addParameterV(float const parameter)
 {
     OBJFreeForm* freeform = getLatestFreeForm();
 
     if(freeform)
     {
-        freeform->parametersV.reserve(freeform->parametersV.size() + parameters.size());
-        freeform->parametersV.insert(freeform->parametersV.end(), parameters.begin(), parameters.end());
+        AppendToPool(parameterPool, freeform->parametersV, parameter);
     }
 }
 
@@ -84,7 +238,7 @@ void OBJFreeFormState::addTrim(OBJSimpleCurve const& trim)
 
     if(freeform)
     {
-        freeform->trims.push_back(trim);
+        AppendToPool(simpleCurvePool, freeform->trims, trim);
     }
 }
 
@@ -94,7 +248,7 @@ void OBJFreeFormState::addHole(OBJSimpleCurve const& hole)
 
     if(freeform)
     {
-        freeform->holes.push_back(hole);
+        AppendToPool(simpleCurvePool, freeform->holes, hole);
     }
 }
 
@@ -104,21 +258,40 @@ void OBJFreeFormState::addSpecialCurve(OBJSimpleCurve const& scurve)
 
     if(freeform)
     {
-        freeform->specialCurves.push_back(scurve);
+        AppendToPool(simpleCurvePool, freeform->specialCurves, scurve);
     }
 }
 
-void OBJFreeFormState::addSpecialPoints(std::vector<int32_t> const& points)
+void OBJFreeFormState::addSpecialPoint(OBJIndex const point)
 {
     OBJFreeForm* freeform = getLatestFreeForm();
 
     if(freeform)
     {
-        freeform->specialPoints.reserve(freeform->specialPoints.size() + points.size());
-        freeform->specialPoints.insert(freeform->specialPoints.end(), points.begin(), points.end());
+        AppendToPool(indexPool, freeform->specialPoints, point);
     }
 }
 
+OBJVertexGroup const* OBJFreeFormState::getControlPoints(OBJPoolRange const& range) const
+{
+    return ResolvePoolRange(controlPointPool, range);
+}
+
+float const* OBJFreeFormState::getParameters(OBJPoolRange const& range) const
+{
+    return ResolvePoolRange(parameterPool, range);
+}
+
+OBJSimpleCurve const* OBJFreeFormState::getSimpleCurves(OBJPoolRange const& range) const
+{
+    return ResolvePoolRange(simpleCurvePool, range);
+}
+
+OBJIndex const* OBJFreeFormState::getIndices(OBJPoolRange const& range) const
+{
+    return ResolvePoolRange(indexPool, range);
+}
+
 //------------------------------------------------------------------------------------------
 // Protected Methods
 //------------------------------------------------------------------------------------------
@@ -157,6 +330,33 @@ OBJFreeForm* OBJFreeFormState::getLatestFreeForm()
     return result;
 }
 
+OBJPoolRange* OBJFreeFormState::getLatestControlPoints()
+{
+    OBJPoolRange* result = nullptr;
+
+    switch(m_LatestFreeForm)
+    {
+    case FreeFormType::Curve:
+        if(curves.size())
+        {
+            result = &(curves.back().controlPoints);
+        }
+        break;
+
+    case FreeFormType::Surface:
+        if(surfaces.size())
+        {
+            result = &(surfaces.back().controlPoints);
+        }
+        break;
+
+    default:
+        break;
+    }
+
+    return result;
+}
+
 //------------------------------------------------------------------------------------------
 // Private Methods
 //------------------------------------------------------------------------------------------
\ No newline at end of file
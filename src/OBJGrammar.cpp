@@ -17,6 +17,16 @@
 #include "OBJGrammar.hpp"
 #include "OBJState.hpp"
 
+namespace
+{
+    // qi::int_ overflows beyond 2^31, so indices are parsed at the full width of OBJIndex
+    const qi::int_parser<OBJIndex> IndexParser = qi::int_parser<OBJIndex>();
+
+    // Spatial vertices are parsed at the precision of the storage policy (see OBJScalarTraits)
+    typedef OBJStorage::Scalars::ParseType SpatialParseType;
+    const qi::real_parser<SpatialParseType> SpatialParser = qi::real_parser<SpatialParseType>();
+}
+
 //------------------------------------------------------------------------------------------
 // Constructors
 //------------------------------------------------------------------------------------------
@@ -31,6 +41,8 @@ OBJGrammar::OBJGrammar(OBJState* state)
     setupFaceRules();
     setupMaterialRules();
     setupRenderStateRules();
+
+#ifndef OBJ_PARSER_NO_FREE_FORMS
     setupFreeFormRules();
 
     ruleStart = +(ruleGroup       |
@@ -40,6 +52,17 @@ OBJGrammar::OBJGrammar(OBJState* state)
                   ruleMaterials   |
                   ruleRenderState |
                   qi::eol);
+#else
+    setupFreeFormSkipRule();
+
+    ruleStart = +(ruleGroup        |
+                  ruleVertices     |
+                  ruleFaces        | 
+                  ruleMaterials    |
+                  ruleRenderState  |
+                  ruleFreeFormSkip |      // Last, so that it is only tried once every other statement has failed
+                  qi::eol);
+#endif
 }
 
 //------------------------------------------------------------------------------------------
@@ -59,11 +82,14 @@ void OBJGrammar::setupDataRules()
     // At the end of the vector rules we consume any unexcepted characters to account for certain obj writers
     ruleVector2Data = qi::float_ >> qi::float_ >> *(qi::char_ - qi::eol);
     ruleVector3Data = qi::float_ >> qi::float_ >> qi::float_ >> *(qi::char_ - qi::eol);
-    ruleVector4Data = qi::float_ >> qi::float_ >> qi::float_ >> -(qi::float_) >> *(qi::char_ - qi::eol);
+    ruleVector4Data = SpatialParser >> SpatialParser >> SpatialParser >> (SpatialParser | qi::attr(SpatialParseType(1))) >> *(qi::char_ - qi::eol);
+#ifndef OBJ_PARSER_NO_FREE_FORMS
+    ruleVertexParameterData = qi::float_ >> (qi::float_ | qi::attr(0.0f)) >> (qi::float_ | qi::attr(1.0f)) >> *(qi::char_ - qi::eol);
+#endif
 
-    ruleIndexValue = qi::int_ | qi::attr(0);
-    ruleVertexGroupData = ruleIndexValue >> (qi::omit[qi::char_('/')] >> ruleIndexValue | qi::attr(0)) >> (qi::omit[qi::char_('/')] >> ruleIndexValue | qi::attr(0));
-    ruleIndexList = +(ruleVertexGroupData);
+    ruleIndexValue = IndexParser | qi::attr(OBJIndex(0));
+    ruleVertexGroupData = ruleIndexValue >> (qi::omit[qi::char_('/')] >> ruleIndexValue | qi::attr(OBJIndex(0))) >> (qi::omit[qi::char_('/')] >> ruleIndexValue | qi::attr(OBJIndex(0)));
+    ruleListVertexGroupData = &(IndexParser) >> ruleVertexGroupData;    // Without a leading index, a list of groups would match nothing forever
 
     ruleName = qi::lexeme[+(qi::graph)];
 }
@@ -102,15 +128,23 @@ void OBJGrammar::setupVertexRules()
         ruleVector3Data [boost::phoenix::bind(&OBJState::addVertexNormal, m_pOBJState, qi::_1)] >>
         qi::eol;
 
+#ifndef OBJ_PARSER_NO_FREE_FORMS
     ruleVertexParameter =
         qi::lit("vp") >>
-        ruleVector3Data [boost::phoenix::bind(&OBJState::addVertexParameter, m_pOBJState, qi::_1)] >>
+        ruleVertexParameterData [boost::phoenix::bind(&OBJState::addVertexParameter, m_pOBJState, qi::_1)] >>
         qi::eol;
         
     ruleVertices = 
         +(ruleVertexSpatial) |         // We check for multiple instances of a vertex in a row, as
         +(ruleVertexTexture) |         // the most likely followup to a 'vn' is another 'vn', etc.
+        +(ruleVertexNormal) |
+        +(ruleVertexParameter);
+#else
+    ruleVertices = 
+        +(ruleVertexSpatial) |
+        +(ruleVertexTexture) |
         +(ruleVertexNormal);
+#endif
 }
 
 void OBJGrammar::setupFaceRules()
@@ -130,7 +164,7 @@ void OBJGrammar::setupFaceRules()
 
     ruleFace =
         qi::lit("f") >>
-        ruleFaceData [boost::phoenix::bind(&OBJState::addFace, m_pOBJState, qi::_1)] >>
+        ruleFaceData [qi::_pass = boost::phoenix::bind(&OBJState::addFace, m_pOBJState, qi::_1)] >>      // Fails on indices that OBJStorage can not hold
         qi::eol;
         
     //----------------------------------------------------------------
@@ -142,7 +176,8 @@ void OBJGrammar::setupFaceRules()
 
     ruleLine =
         qi::lit("l") >>
-        ruleIndexList [boost::phoenix::bind(&OBJState::addLine, m_pOBJState, qi::_1)] >>
+        (&IndexParser) [boost::phoenix::bind(&OBJState::beginLine, m_pOBJState)] >>       // Check for an index first so that 'lod' does not begin a line
+        +(ruleListVertexGroupData [qi::_pass = boost::phoenix::bind(&OBJState::addLineVertex, m_pOBJState, qi::_1)]) >>
         qi::eol;
         
     //----------------------------------------------------------------
@@ -154,7 +189,8 @@ void OBJGrammar::setupFaceRules()
         
     rulePoint =
         qi::lit("p") >>
-        ruleIndexList [boost::phoenix::bind(&OBJState::addPointCollection, m_pOBJState, qi::_1)] >>
+        (&IndexParser) [boost::phoenix::bind(&OBJState::beginPointCollection, m_pOBJState)] >>
+        +(ruleListVertexGroupData [qi::_pass = boost::phoenix::bind(&OBJState::addPointVertex, m_pOBJState, qi::_1)]) >>
         qi::eol;
         
     ruleFaces = 
@@ -163,6 +199,8 @@ void OBJGrammar::setupFaceRules()
         +(rulePoint);
 }
 
+#ifndef OBJ_PARSER_NO_FREE_FORMS
+
 void OBJGrammar::setupFreeFormRules()
 {
     setupFreeFormStart();
@@ -170,6 +208,7 @@ void OBJGrammar::setupFreeFormRules()
     setupFreeFormEnd();
     setupFreeFormAttributes();
     setupFreeFormConnections();
+    setupFreeFormTechniqueRules();
 
     ruleFreeForms =
         ruleFreeFormAttributes | 
@@ -181,53 +220,45 @@ void OBJGrammar::setupFreeFormRules()
 
 void OBJGrammar::setupFreeFormStart()
 {
+    // Control points are appended to the new free-form one at a time, as they are parsed
+
+    ruleFreeFormControlPoints =
+        +(ruleListVertexGroupData [qi::_pass = boost::phoenix::bind(&OBJState::addFreeFormControlPoint, m_pOBJState, qi::_1)]);
+
     //----------------------------------------------------------------
     // Curve
     //----------------------------------------------------------------
 
-    ruleFreeFormCurveData =
-        qi::float_ >>
-        qi::float_ >>
-        ruleIndexList;
-
     ruleFreeFormCurve =
         qi::lit("curv") >>
-        ruleFreeFormCurveData [boost::phoenix::bind(&OBJState::addFreeFormCurve, m_pOBJState, qi::_1)] >>
+        (qi::float_ >> qi::float_) [boost::phoenix::bind(&OBJState::beginFreeFormCurve, m_pOBJState, qi::_1, qi::_2)] >>
+        ruleFreeFormControlPoints >>
         qi::eol;
 
     //----------------------------------------------------------------
     // Curve2D
     //----------------------------------------------------------------
 
-    ruleFreeFormCurve2DData =
-        +(qi::int_);
-
     ruleFreeFormCurve2D =
-        qi::lit("curv2") >>
-        ruleFreeFormCurve2DData [boost::phoenix::bind(&OBJState::addFreeFormCurve2D, m_pOBJState, qi::_1)] >>
+        qi::lit("curv2") [boost::phoenix::bind(&OBJState::beginFreeFormCurve2D, m_pOBJState)] >>
+        +(IndexParser [boost::phoenix::bind(&OBJState::addFreeFormCurve2DPoint, m_pOBJState, qi::_1)]) >>
         qi::eol;
 
     //----------------------------------------------------------------
     // Surface
     //----------------------------------------------------------------
 
-    ruleFreeFormSurfaceData =
-        qi::float_ >>
-        qi::float_ >>
-        qi::float_ >>
-        qi::float_ >>
-        ruleVertexGroupData;
-
     ruleFreeFormSurface =
         qi::lit("surf") >>
-        ruleFreeFormSurfaceData [boost::phoenix::bind(&OBJState::addFreeFormSurface, m_pOBJState, qi::_1)] >>
+        (qi::float_ >> qi::float_ >> qi::float_ >> qi::float_) [boost::phoenix::bind(&OBJState::beginFreeFormSurface, m_pOBJState, qi::_1, qi::_2, qi::_3, qi::_4)] >>
+        ruleFreeFormControlPoints >>
         qi::eol;
             
     //----------------------------------------------------------------
 
     ruleFreeFormStart =
-        (ruleFreeFormCurve |
-         ruleFreeFormCurve2D |
+        (ruleFreeFormCurve2D |         // 'curv2' must be checked before 'curv'
+         ruleFreeFormCurve |
          ruleFreeFormSurface);
 }
 
@@ -237,35 +268,32 @@ void OBJGrammar::setupFreeFormBody()
     // Parameters
     //----------------------------------------------------------------
 
-    qi::rule<OBJIterator, std::vector<float>(), OBJSkipper> ruleParameterData =
-        +(qi::float_);
-
-    qi::rule<OBJIterator, OBJSkipper> ruleParameterU =
+    ruleFreeFormParameterU =
         qi::lit("u") >>
-        ruleParameterData [boost::phoenix::bind(&OBJState::addFreeFormParameterU, m_pOBJState, qi::_1)] >>
+        +(qi::float_ [boost::phoenix::bind(&OBJState::addFreeFormParameterU, m_pOBJState, qi::_1)]) >>
         qi::eol;
 
-    qi::rule<OBJIterator, OBJSkipper> ruleParameterV =
+    ruleFreeFormParameterV =
         qi::lit("v") >>
-        ruleParameterData [boost::phoenix::bind(&OBJState::addFreeFormParameterU, m_pOBJState, qi::_1)] >>
+        +(qi::float_ [boost::phoenix::bind(&OBJState::addFreeFormParameterV, m_pOBJState, qi::_1)]) >>
         qi::eol;
 
     ruleFreeFormParameter =
         qi::lit("parm") >>
-        (ruleParameterU | ruleParameterV);
+        (ruleFreeFormParameterU | ruleFreeFormParameterV);
         
     //----------------------------------------------------------------
     // Trim
     //----------------------------------------------------------------
 
-    qi::rule<OBJIterator, OBJSimpleCurve(), OBJSkipper> ruleSimpleCurve =
+    ruleSimpleCurveData =
         qi::float_ >>
         qi::float_ >>
         qi::int_;
 
     ruleFreeFormTrim =
         qi::lit("trim") >>
-        +(ruleSimpleCurve [boost::phoenix::bind(&OBJState::addFreeFormTrim, m_pOBJState, qi::_1)]) >>
+        +(ruleSimpleCurveData [boost::phoenix::bind(&OBJState::addFreeFormTrim, m_pOBJState, qi::_1)]) >>
         qi::eol;
         
     //----------------------------------------------------------------
@@ -274,28 +302,25 @@ void OBJGrammar::setupFreeFormBody()
 
     ruleFreeFormHole =
         qi::lit("hole") >>
-        +(ruleSimpleCurve [boost::phoenix::bind(&OBJState::addFreeFormHole, m_pOBJState, qi::_1)]) >>
+        +(ruleSimpleCurveData [boost::phoenix::bind(&OBJState::addFreeFormHole, m_pOBJState, qi::_1)]) >>
         qi::eol;
         
     //----------------------------------------------------------------
     // Special Curve
     //----------------------------------------------------------------
 
-    ruleFreeFormTrim =
+    ruleFreeFormSpecialCurve =
         qi::lit("scrv") >>
-        +(ruleSimpleCurve [boost::phoenix::bind(&OBJState::addFreeFormSpecialCurve, m_pOBJState, qi::_1)]) >>
+        +(ruleSimpleCurveData [boost::phoenix::bind(&OBJState::addFreeFormSpecialCurve, m_pOBJState, qi::_1)]) >>
         qi::eol;
         
     //----------------------------------------------------------------
     // Special Point
     //----------------------------------------------------------------
-        
-    qi::rule<OBJIterator, std::vector<int32_t>(), OBJSkipper> ruleSpecialPointsData =
-        +(qi::int_);
 
     ruleFreeFormSpecialPoint = 
         qi::lit("sp") >>
-        ruleSpecialPointsData [boost::phoenix::bind(&OBJState::addFreeFormSpecialPoints, m_pOBJState, qi::_1)] >>
+        +(IndexParser [boost::phoenix::bind(&OBJState::addFreeFormSpecialPoint, m_pOBJState, qi::_1)]) >>
         qi::eol;
 
     //----------------------------------------------------------------
@@ -321,11 +346,11 @@ void OBJGrammar::setupFreeFormAttributes()
     // Type
     //----------------------------------------------------------------
 
-    qi::rule<OBJIterator, bool(), OBJSkipper> ruleFreeFormRational =
+    ruleFreeFormRational =
         (qi::omit[qi::lit("rat")] [qi::_val = true] |
         (qi::attr(false)));
 
-    qi::rule<OBJIterator, OBJSkipper> ruleTypes =
+    ruleFreeFormTypes =
         (qi::lit("bmatrix")  [boost::phoenix::bind(&OBJState::setFreeFormType, m_pOBJState, OBJFreeFormType::BasisMatrix)] |
          qi::lit("bezier")   [boost::phoenix::bind(&OBJState::setFreeFormType, m_pOBJState, OBJFreeFormType::Bezier)]      |
          qi::lit("bspline")  [boost::phoenix::bind(&OBJState::setFreeFormType, m_pOBJState, OBJFreeFormType::BSpline)]     |
@@ -335,7 +360,7 @@ void OBJGrammar::setupFreeFormAttributes()
     ruleFreeFormType =
         qi::lit("cstype") >>
         ruleFreeFormRational [boost::phoenix::bind(&OBJState::setFreeFormRational, m_pOBJState, qi::_1)] >>
-        ruleTypes >>
+        ruleFreeFormTypes >>
         qi::eol;
 
     //----------------------------------------------------------------
@@ -362,23 +387,23 @@ void OBJGrammar::setupFreeFormAttributes()
     // Basis Matrix
     //----------------------------------------------------------------
 
-    qi::rule<OBJIterator, std::vector<float>(), OBJSkipper> ruleMatrixData =
+    ruleFreeFormMatrixData =
         +(qi::float_);
 
-    qi::rule<OBJIterator, OBJSkipper> ruleBasisU =
+    ruleFreeFormBasisU =
         qi::lit("u") >>
-        ruleMatrixData [boost::phoenix::bind(&OBJState::setFreeFormBasisMatrixU, m_pOBJState, qi::_1)] >>
+        ruleFreeFormMatrixData [boost::phoenix::bind(&OBJState::setFreeFormBasisMatrixU, m_pOBJState, qi::_1)] >>
         qi::eol;
 
-    qi::rule<OBJIterator, OBJSkipper> ruleBasisV =
+    ruleFreeFormBasisV =
         qi::lit("v") >>
-        ruleMatrixData [boost::phoenix::bind(&OBJState::setFreeFormBasisMatrixV, m_pOBJState, qi::_1)] >>
+        ruleFreeFormMatrixData [boost::phoenix::bind(&OBJState::setFreeFormBasisMatrixV, m_pOBJState, qi::_1)] >>
         qi::eol;
         
     ruleFreeFormBasisMatrix = 
         qi::lit("bmat") >>
-        (ruleBasisU | 
-         ruleBasisV);
+        (ruleFreeFormBasisU | 
+         ruleFreeFormBasisV);
 
     //----------------------------------------------------------------
     // Merge Group
@@ -402,7 +427,7 @@ void OBJGrammar::setupFreeFormAttributes()
 
 void OBJGrammar::setupFreeFormConnections()
 {
-    qi::rule<OBJIterator, OBJSurfaceConnection(), OBJSkipper> ruleConnectionData =
+    ruleFreeFormConnectionData =
         qi::int_ >>                // surface1
         qi::float_ >>              // startParam1
         qi::float_ >>              // endParam1
@@ -414,10 +439,89 @@ void OBJGrammar::setupFreeFormConnections()
 
     ruleFreeFormConnection = 
         qi::lit("con") >>
-        ruleConnectionData [boost::phoenix::bind(&OBJState::addFreeFormConnection, m_pOBJState, qi::_1)] >>
+        ruleFreeFormConnectionData [boost::phoenix::bind(&OBJState::addFreeFormConnection, m_pOBJState, qi::_1)] >>
+        qi::eol;
+}
+
+void OBJGrammar::setupFreeFormTechniqueRules()
+{
+    // The techniques are render state, and are matched by ruleRenderState rather than ruleFreeForms.
+    // They are members so that they outlive this method, as rules are referenced and not copied.
+
+    // Curve Technique
+
+    ruleCurveParametric =
+        qi::lit("cparm") >>
+        qi::float_ [boost::phoenix::bind(&OBJState::setTechniqueParametric, m_pOBJState, qi::_1)] >>
+        qi::eol;
+
+    ruleCurveSpatial = 
+        qi::lit("cspace") >>
+        qi::float_ [boost::phoenix::bind(&OBJState::setTechniqueSpatialCurve, m_pOBJState, qi::_1)] >>
+        qi::eol;
+
+    ruleCurveCurvature =
+        qi::lit("curv") >>
+        ruleVector2Data [boost::phoenix::bind(&OBJState::setTechniqueCurvatureCurve, m_pOBJState, qi::_1)] >>
+        qi::eol;
+
+    ruleFreeFormCurveTech =
+        qi::lit("ctech") >>
+        (ruleCurveParametric |
+         ruleCurveSpatial |
+         ruleCurveCurvature);
+
+    // Surface Technique
+
+    ruleSurfaceParametricA =
+        qi::lit("cparma") >>
+        ruleVector2Data [boost::phoenix::bind(&OBJState::setTechniqueParametricA, m_pOBJState, qi::_1)] >>
+        qi::eol;
+
+    ruleSurfaceParametricB =
+        qi::lit("cparmb") >>
+        qi::float_ [boost::phoenix::bind(&OBJState::setTechniqueParametricB, m_pOBJState, qi::_1)] >>
+        qi::eol;
+
+    ruleSurfaceSpatial = 
+        qi::lit("cspace") >>
+        qi::float_ [boost::phoenix::bind(&OBJState::setTechniqueSpatialSurface, m_pOBJState, qi::_1)] >>
+        qi::eol;
+
+    ruleSurfaceCurvature =
+        qi::lit("curv") >>
+        ruleVector2Data [boost::phoenix::bind(&OBJState::setTechniqueCurvatureSurface, m_pOBJState, qi::_1)] >>
+        qi::eol;
+
+    ruleFreeFormSurfaceTech =
+        qi::lit("stech") >>
+        (ruleSurfaceParametricA |
+         ruleSurfaceParametricB |
+         ruleSurfaceSpatial |
+         ruleSurfaceCurvature);
+}
+
+#else
+
+void OBJGrammar::setupFreeFormSkipRule()
+{
+    // Skips the free-form statements that the full grammar parses, so that files 
+    // containing free-form geometry still load (without it). Example:
+    // curv 0.0 1.0 1 2 3 4
+
+    // 'curv2' must be tested before 'curv', as the keyword has to be followed by 
+    // a blank (or the end of the line) to match.
+
+    ruleFreeFormSkip =
+        qi::lexeme[(qi::lit("vp") | "cstype" | "deg" | "bmat" | "step" | "curv2" | "curv" | "surf" | 
+                    "parm" | "trim" | "hole" | "scrv" | "sp" | "end" | "con" | "mg" | "ctech" | "stech") >> 
+                   &(qi::blank | qi::eol)] >>
+        qi::lexeme[*(qi::char_ - qi::eol)] >>      // lexeme, so that a trailing comment does not consume the eol
         qi::eol;
 }
 
+#endif
+
 void OBJGrammar::setupMaterialRules()
 {
     // Parses material lines. Example:
@@ -497,64 +601,9 @@ void OBJGrammar::setupRenderStateRules()
         ruleName [boost::phoenix::bind(&OBJState::setTracingObject, m_pOBJState, qi::_1)] >>
         qi::eol;
         
-    //----------------------------------------------------------------
-    // Free-Form Only
-    //----------------------------------------------------------------
-
-    // Curve Technique
-
-    qi::rule<OBJIterator, OBJSkipper> ruleCurveParametric =
-        qi::lit("cparm") >>
-        qi::float_ [boost::phoenix::bind(&OBJState::setTechniqueParametric, m_pOBJState, qi::_1)] >>
-        qi::eol;
-
-    qi::rule<OBJIterator, OBJSkipper> ruleCurveSpatial = 
-        qi::lit("cspace") >>
-        qi::float_ [boost::phoenix::bind(&OBJState::setTechniqueSpatialCurve, m_pOBJState, qi::_1)] >>
-        qi::eol;
-
-    qi::rule<OBJIterator, OBJSkipper> ruleCurveCurvature =
-        qi::lit("curv") >>
-        ruleVector2Data [boost::phoenix::bind(&OBJState::setTechniqueCurvatureCurve, m_pOBJState, qi::_1)] >>
-        qi::eol;
-
-    ruleFreeFormCurveTech =
-        qi::lit("ctech") >>
-        (ruleCurveParametric |
-         ruleCurveSpatial |
-         ruleCurveCurvature);
-
-    // Surface Technique
-
-    qi::rule<OBJIterator, OBJSkipper> ruleSurfaceParametricA =
-        qi::lit("cparma") >>
-        ruleVector2Data [boost::phoenix::bind(&OBJState::setTechniqueParametricA, m_pOBJState, qi::_1)] >>
-        qi::eol;
-
-    qi::rule<OBJIterator, OBJSkipper> ruleSurfaceParametricB =
-        qi::lit("cparmb") >>
-        qi::float_ [boost::phoenix::bind(&OBJState::setTechniqueParametricB, m_pOBJState, qi::_1)] >>
-        qi::eol;
-
-    qi::rule<OBJIterator, OBJSkipper> ruleSurfaceSpatial = 
-        qi::lit("cspace") >>
-        qi::float_ [boost::phoenix::bind(&OBJState::setTechniqueSpatialSurface, m_pOBJState, qi::_1)] >>
-        qi::eol;
-
-    qi::rule<OBJIterator, OBJSkipper> ruleSurfaceCurvature =
-        qi::lit("curv") >>
-        ruleVector2Data [boost::phoenix::bind(&OBJState::setTechniqueCurvatureSurface, m_pOBJState, qi::_1)] >>
-        qi::eol;
-
-    ruleFreeFormSurfaceTech =
-        qi::lit("ctech") >>
-        (ruleSurfaceParametricA |
-         ruleSurfaceParametricB |
-         ruleSurfaceSpatial |
-         ruleSurfaceCurvature);
-
     //----------------------------------------------------------------
 
+#ifndef OBJ_PARSER_NO_FREE_FORMS
     ruleRenderState = ruleSmoothing |
                       ruleLOD |
                       ruleBevelInterp |
@@ -566,4 +615,15 @@ void OBJGrammar::setupRenderStateRules()
                       ruleTraceObj | 
                       ruleFreeFormCurveTech |
                       ruleFreeFormSurfaceTech;
+#else
+    ruleRenderState = ruleSmoothing |
+                      ruleLOD |
+                      ruleBevelInterp |
+                      ruleColorInterp |
+                      ruleDissolveInterp |
+                      ruleTextureMapLibrary |
+                      ruleTextureMap |
+                      ruleShadowObj |
+                      ruleTraceObj;
+#endif
 }
@@ -16,11 +16,27 @@
 
 #include "OBJGroup.hpp"
 
+#include <utility>
+
 //------------------------------------------------------------------------------------------
 // Constructors
 //------------------------------------------------------------------------------------------
 
 OBJGroup::OBJGroup()
+    : active(false)
+{
+
+}
+
+OBJGroup::OBJGroup(OBJArena* arena)
+    : name(OBJArenaAllocator<char>(arena)),
+      faces(OBJSegmentedVector<OBJFace>::allocator_type(arena)),
+      renderStateRanges(OBJArenaAllocator<OBJRenderStateRange>(arena)),
+      lineVertices(OBJArenaAllocator<OBJVertexGroup>(arena)),
+      lineOffsets(OBJArenaAllocator<OBJCount>(arena)),
+      pointVertices(OBJArenaAllocator<OBJVertexGroup>(arena)),
+      pointOffsets(OBJArenaAllocator<OBJCount>(arena)),
+      active(false)
 {
 
 }
@@ -34,14 +50,127 @@ OBJGroup::~OBJGroup()
 // Public Methods
 //------------------------------------------------------------------------------------------
 
+void OBJGroup::clear()
+{
+    name.clear();
+
+    faces.clear();
+    renderStateRanges.clear();
+    lineVertices.clear();
+    lineOffsets.clear();
+    pointVertices.clear();
+    pointOffsets.clear();
+
+    active = false;
+}
+
+void OBJGroup::swap(OBJGroup& other)
+{
+    name.swap(other.name);
+
+    faces.swap(other.faces);
+    renderStateRanges.swap(other.renderStateRanges);
+    lineVertices.swap(other.lineVertices);
+    lineOffsets.swap(other.lineOffsets);
+    pointVertices.swap(other.pointVertices);
+    pointOffsets.swap(other.pointOffsets);
+
+    std::swap(active, other.active);
+}
+
+std::size_t OBJGroup::getCapacityBytes() const
+{
+    return (faces.capacity() * sizeof(OBJFace)) +
+           (renderStateRanges.capacity() * sizeof(OBJRenderStateRange)) +
+           (lineVertices.capacity() * sizeof(OBJVertexGroup)) +
+           (lineOffsets.capacity() * sizeof(OBJCount)) +
+           (pointVertices.capacity() * sizeof(OBJVertexGroup)) +
+           (pointOffsets.capacity() * sizeof(OBJCount));
+}
+
+void OBJGroup::addFace(OBJFace const& face)
+{
+    if(renderStateRanges.empty() || (renderStateRanges.back().renderState != face.renderState))
+    {
+        renderStateRanges.emplace_back(static_cast<OBJCount>(faces.size()), 0, face.renderState);
+    }
+
+    renderStateRanges.back().faceCount++;
+    faces.emplace_back(face);
+}
+
 void OBJGroup::addLine(std::vector<OBJVertexGroup> const& line)
 {
-    lines.emplace_back(line);
+    beginLine();
+    lineVertices.insert(lineVertices.end(), line.begin(), line.end());
 }
 
 void OBJGroup::addPointCollection(std::vector<OBJVertexGroup> const& points)
 {
-    this->points.emplace_back(points);
+    beginPointCollection();
+    pointVertices.insert(pointVertices.end(), points.begin(), points.end());
+}
+
+void OBJGroup::beginLine()
+{
+    lineOffsets.push_back(static_cast<OBJCount>(lineVertices.size()));
+}
+
+void OBJGroup::addLineVertex(OBJVertexGroup const& vertex)
+{
+    lineVertices.push_back(vertex);
+}
+
+void OBJGroup::beginPointCollection()
+{
+    pointOffsets.push_back(static_cast<OBJCount>(pointVertices.size()));
+}
+
+void OBJGroup::addPointVertex(OBJVertexGroup const& vertex)
+{
+    pointVertices.push_back(vertex);
+}
+
+OBJCount OBJGroup::getLineCount() const
+{
+    return static_cast<OBJCount>(lineOffsets.size());
+}
+
+OBJVertexGroup const* OBJGroup::getLine(OBJCount const index, OBJCount& count) const
+{
+    OBJVertexGroup const* result = nullptr;
+    count = 0;
+
+    if(index < lineOffsets.size())
+    {
+        const OBJCount end = ((index + 1) < lineOffsets.size()) ? lineOffsets[index + 1] : static_cast<OBJCount>(lineVertices.size());
+
+        count = end - lineOffsets[index];
+        result = lineVertices.data() + lineOffsets[index];
+    }
+
+    return result;
+}
+
+OBJCount OBJGroup::getPointCollectionCount() const
+{
+    return static_cast<OBJCount>(pointOffsets.size());
+}
+
+OBJVertexGroup const* OBJGroup::getPointCollection(OBJCount const index, OBJCount& count) const
+{
+    OBJVertexGroup const* result = nullptr;
+    count = 0;
+
+    if(index < pointOffsets.size())
+    {
+        const OBJCount end = ((index + 1) < pointOffsets.size()) ? pointOffsets[index + 1] : static_cast<OBJCount>(pointVertices.size());
+
+        count = end - pointOffsets[index];
+        result = pointVertices.data() + pointOffsets[index];
+    }
+
+    return result;
 }
 
 //------------------------------------------------------------------------------------------
@@ -0,0 +1,197 @@
+/*
+ * Copyright 2016 Steven T Sell (ssell@vertexfragment.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "OBJMappedRegion.hpp"
+
+#include <cstdint>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+namespace
+{
+    std::size_t RoundUp(std::size_t value, std::size_t multiple)
+    {
+        return ((value + (multiple - 1)) / multiple) * multiple;
+    }
+}
+
+//------------------------------------------------------------------------------------------
+// Constructors
+//------------------------------------------------------------------------------------------
+
+OBJMappedRegion::OBJMappedRegion()
+    : m_pData(nullptr),
+      m_Size(0)
+{
+
+}
+
+OBJMappedRegion::~OBJMappedRegion()
+{
+    release();
+}
+
+//------------------------------------------------------------------------------------------
+// Public Methods
+//------------------------------------------------------------------------------------------
+
+bool OBJMappedRegion::create(std::size_t const bytes, bool const hugePages)
+{
+    release();
+
+    std::size_t size = (bytes > 0) ? bytes : 1;
+    m_pData = mapMemory(size, hugePages);
+
+    if(m_pData)
+    {
+        m_Size = size;
+    }
+
+    return (m_pData != nullptr);
+}
+
+void OBJMappedRegion::release()
+{
+    if(m_pData)
+    {
+        unmapMemory(m_pData, m_Size);
+
+        m_pData = nullptr;
+        m_Size = 0;
+    }
+}
+
+bool OBJMappedRegion::protect()
+{
+    if(!m_pData)
+    {
+        return false;
+    }
+
+#ifdef _WIN32
+    DWORD previous = 0;
+    return (VirtualProtect(m_pData, m_Size, PAGE_READONLY, &previous) != 0);
+#else
+    return (mprotect(m_pData, m_Size, PROT_READ) == 0);
+#endif
+}
+
+void* OBJMappedRegion::getData() const
+{
+    return m_pData;
+}
+
+std::size_t OBJMappedRegion::getSize() const
+{
+    return m_Size;
+}
+
+void* OBJMappedRegion::mapMemory(std::size_t& bytes, bool const hugePages)
+{
+    char* result = nullptr;
+
+#ifdef _WIN32
+    if(hugePages)
+    {
+        // Large pages require the SeLockMemoryPrivilege; without it we fall back to regular pages.
+        const std::size_t largePageSize = GetLargePageMinimum();
+
+        if(largePageSize > 0)
+        {
+            const std::size_t largeSize = RoundUp(bytes, largePageSize);
+            result = static_cast<char*>(VirtualAlloc(nullptr, largeSize, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE));
+
+            if(result)
+            {
+                bytes = largeSize;
+            }
+        }
+    }
+
+    if(!result)
+    {
+        result = static_cast<char*>(VirtualAlloc(nullptr, bytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+    }
+#else
+    if(hugePages)
+    {
+        // Over-map so that the region can start on a huge page boundary, then trim the excess.
+        const std::size_t size = RoundUp(bytes, HugePageSize);
+        const std::size_t mapSize = size + HugePageSize;
+        void* mapping = mmap(nullptr, mapSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+        if(mapping != MAP_FAILED)
+        {
+            char* start = static_cast<char*>(mapping);
+            char* end = start + mapSize;
+            
+            const std::uintptr_t address = reinterpret_cast<std::uintptr_t>(start);
+            char* aligned = reinterpret_cast<char*>((address + (HugePageSize - 1)) & ~static_cast<std::uintptr_t>(HugePageSize - 1));
+
+            if(aligned != start)
+            {
+                munmap(start, static_cast<std::size_t>(aligned - start));
+            }
+
+            if((aligned + size) != end)
+            {
+                munmap(aligned + size, static_cast<std::size_t>(end - (aligned + size)));
+            }
+
+#ifdef MADV_HUGEPAGE
+            madvise(aligned, size, MADV_HUGEPAGE);
+#endif
+            result = aligned;
+            bytes = size;
+        }
+    }
+    else
+    {
+        void* mapping = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+        if(mapping != MAP_FAILED)
+        {
+            result = static_cast<char*>(mapping);
+        }
+    }
+#endif
+
+    return result;
+}
+
+void OBJMappedRegion::unmapMemory(void* ptr, std::size_t const bytes)
+{
+#ifdef _WIN32
+    (void)bytes;
+    VirtualFree(ptr, 0, MEM_RELEASE);
+#else
+    munmap(ptr, bytes);
+#endif
+}
+
+//------------------------------------------------------------------------------------------
+// Protected Methods
+//------------------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------------------
+// Private Methods
+//------------------------------------------------------------------------------------------
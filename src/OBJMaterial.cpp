@@ -16,6 +16,8 @@
 
 #include "OBJMaterial.hpp"
 
+#include <utility>
+
 //------------------------------------------------------------------------------------------
 // OBJMaterialPropertyRFL
 //------------------------------------------------------------------------------------------
@@ -26,6 +28,13 @@ OBJMaterialPropertyRFL::OBJMaterialPropertyRFL()
 
 }
 
+OBJMaterialPropertyRFL::OBJMaterialPropertyRFL(OBJArena* arena)
+    : path(OBJArenaAllocator<char>(arena)),
+      factor(1.0f)
+{
+
+}
+
 //------------------------------------------------------------------------------------------
 // OBJMaterialProperty
 //------------------------------------------------------------------------------------------
@@ -39,15 +48,14 @@ OBJMaterialProperty::OBJMaterialProperty()
 
 }
 
-OBJMaterialProperty const& OBJMaterialProperty::operator=(OBJMaterialProperty const& rhs)
+OBJMaterialProperty::OBJMaterialProperty(OBJArena* arena)
+    : type(OBJMaterialPropertyType::None),
+      r(0.0f),
+      g(0.0f),
+      b(0.0f),
+      rfl(arena)
 {
-    type = rhs.type;
-    r = rhs.r;
-    g = rhs.g;
-    b = rhs.b;
-    rfl = rhs.rfl;
 
-    return (*this);
 }
 
 //------------------------------------------------------------------------------------------
@@ -68,14 +76,32 @@ OBJMaterialDissolve::OBJMaterialDissolve()
 OBJMaterial::OBJMaterial()
     : m_Name(""),
       m_IlluminationModel(1),
+      m_Sharpness(60),
       m_Transparency(0.0f),
       m_SpecularExponent(1.0f),
-      m_Sharpness(60),
       m_OpticalDensity(1.0f),
       m_TextureAntiAliasing(false),
       m_ReflectionMapType(OBJReflectionMapType::None)
 {
+    m_Textures.fill(0);
+}
 
+OBJMaterial::OBJMaterial(OBJArena* arena)
+    : m_Name(OBJArenaAllocator<char>(arena)),
+      m_AmbientReflectivity(arena),
+      m_DiffuseReflectivity(arena),
+      m_SpecularReflectivity(arena),
+      m_EmissiveReflectivity(arena),
+      m_TransmissionFilter(arena),
+      m_IlluminationModel(1),
+      m_Sharpness(60),
+      m_Transparency(0.0f),
+      m_SpecularExponent(1.0f),
+      m_OpticalDensity(1.0f),
+      m_TextureAntiAliasing(false),
+      m_ReflectionMapType(OBJReflectionMapType::None)
+{
+    m_Textures.fill(0);
 }
 
 OBJMaterial::~OBJMaterial()
@@ -89,10 +115,10 @@ OBJMaterial::~OBJMaterial()
 
 void OBJMaterial::setName(std::string const& name)
 {
-    m_Name = name;
+    m_Name.assign(name.data(), name.size());
 }
 
-std::string const& OBJMaterial::getName() const
+OBJArenaString const& OBJMaterial::getName() const
 {
     return m_Name;
 }
@@ -342,130 +368,153 @@ float OBJMaterial::getOpticalDensity() const
     return m_OpticalDensity;
 }
 
+//------------------------------------------------------------------------
+// Textures
+//------------------------------------------------------------------------
+
+void OBJMaterial::setTexture(OBJTextureSlot const slot, OBJTextureId const id)
+{
+    m_Textures[static_cast<std::size_t>(slot)] = id;
+
+    if(slot == OBJTextureSlot::ReflectionSphere)
+    {
+        m_ReflectionMapType = OBJReflectionMapType::Sphere;
+    }
+    else if(slot >= OBJTextureSlot::ReflectionCubeFront)
+    {
+        m_ReflectionMapType = OBJReflectionMapType::Cube;
+    }
+}
+
+OBJTextureId OBJMaterial::getTexture(OBJTextureSlot const slot) const
+{
+    return m_Textures[static_cast<std::size_t>(slot)];
+}
+
 //------------------------------------------------------------------------
 // Ambient Texture
 //------------------------------------------------------------------------
 
-void OBJMaterial::setAmbientTexture(OBJTextureDescriptor const* descriptor)
+void OBJMaterial::setAmbientTexture(OBJTextureId const id)
 {
-    m_TextureAmbient = *descriptor;
+    setTexture(OBJTextureSlot::Ambient, id);
 }
 
-OBJTextureDescriptor const& OBJMaterial::getAmbientTexture() const
+OBJTextureId OBJMaterial::getAmbientTexture() const
 {
-    return m_TextureAmbient;
+    return getTexture(OBJTextureSlot::Ambient);
 }
 
 //------------------------------------------------------------------------
 // Diffuse Texture
 //------------------------------------------------------------------------
 
-void OBJMaterial::setDiffuseTexture(OBJTextureDescriptor const* descriptor)
+void OBJMaterial::setDiffuseTexture(OBJTextureId const id)
 {
-    m_TextureDiffuse = *descriptor;
+    setTexture(OBJTextureSlot::Diffuse, id);
 }
 
-OBJTextureDescriptor const& OBJMaterial::getDiffuseTexture() const
+OBJTextureId OBJMaterial::getDiffuseTexture() const
 {
-    return m_TextureDiffuse;
+    return getTexture(OBJTextureSlot::Diffuse);
 }
 
 //------------------------------------------------------------------------
 // Specular Texture
 //------------------------------------------------------------------------
 
-void OBJMaterial::setSpecularTexture(OBJTextureDescriptor const* descriptor)
+void OBJMaterial::setSpecularTexture(OBJTextureId const id)
 {
-    m_TextureSpecular = *descriptor;
+    setTexture(OBJTextureSlot::Specular, id);
 }
 
-OBJTextureDescriptor const& OBJMaterial::getSpecularTexture() const
+OBJTextureId OBJMaterial::getSpecularTexture() const
 {
-    return m_TextureSpecular;
+    return getTexture(OBJTextureSlot::Specular);
 }
 
 //------------------------------------------------------------------------
 // SpecularExponent Texture
 //------------------------------------------------------------------------
 
-void OBJMaterial::setSpecularExponentTexture(OBJTextureDescriptor const* descriptor)
+void OBJMaterial::setSpecularExponentTexture(OBJTextureId const id)
 {
-    m_TextureSpecularExponent = *descriptor;
+    setTexture(OBJTextureSlot::SpecularExponent, id);
 }
 
-OBJTextureDescriptor const& OBJMaterial::getSpecularExponentTexture() const
+OBJTextureId OBJMaterial::getSpecularExponentTexture() const
 {
-    return m_TextureSpecularExponent;
+    return getTexture(OBJTextureSlot::SpecularExponent);
 }
 
 //------------------------------------------------------------------------
 // Emissive Texture
 //------------------------------------------------------------------------
 
-void OBJMaterial::setEmissiveTexture(OBJTextureDescriptor const* descriptor)
+void OBJMaterial::setEmissiveTexture(OBJTextureId const id)
 {
-    m_TextureEmissive = *descriptor;
+    setTexture(OBJTextureSlot::Emissive, id);
 }
 
-OBJTextureDescriptor const& OBJMaterial::getEmissiveTexture() const
+OBJTextureId OBJMaterial::getEmissiveTexture() const
 {
-    return m_TextureEmissive;
+    return getTexture(OBJTextureSlot::Emissive);
 }
 
 //------------------------------------------------------------------------
 // Dissolve Texture
 //------------------------------------------------------------------------
 
-void OBJMaterial::setDissolveTexture(OBJTextureDescriptor const* descriptor)
+void OBJMaterial::setDissolveTexture(OBJTextureId const id)
 {
-    m_TextureDissolve = *descriptor;
+    setTexture(OBJTextureSlot::Dissolve, id);
 }
 
-OBJTextureDescriptor const& OBJMaterial::getDissolveTexture() const
+OBJTextureId OBJMaterial::getDissolveTexture() const
 {
-    return m_TextureDissolve;
+    return getTexture(OBJTextureSlot::Dissolve);
 }
 
 //------------------------------------------------------------------------
 // Decal Texture
 //------------------------------------------------------------------------
 
-void OBJMaterial::setDecalTexture(OBJTextureDescriptor const* descriptor)
+void OBJMaterial::setDecalTexture(OBJTextureId const id)
 {
-    m_TextureDecal = *descriptor;
+    setTexture(OBJTextureSlot::Decal, id);
 }
 
-OBJTextureDescriptor const& OBJMaterial::getDecalTexture() const
+OBJTextureId OBJMaterial::getDecalTexture() const
 {
-    return m_TextureDecal;
+    return getTexture(OBJTextureSlot::Decal);
 }
 
 //------------------------------------------------------------------------
 // Displacement Texture
 //------------------------------------------------------------------------
 
-void OBJMaterial::setDisplacementTexture(OBJTextureDescriptor const* descriptor)
+void OBJMaterial::setDisplacementTexture(OBJTextureId const id)
 {
-    m_TextureDisplacement = *descriptor;
+    setTexture(OBJTextureSlot::Displacement, id);
 }
 
-OBJTextureDescriptor const& OBJMaterial::getDisplacementTexture() const
+OBJTextureId OBJMaterial::getDisplacementTexture() const
 {
-    return m_TextureDisplacement;
+    return getTexture(OBJTextureSlot::Displacement);
 }
 
 //------------------------------------------------------------------------
 // Bump Texture
 //------------------------------------------------------------------------
 
-void OBJMaterial::setBumpTexture(OBJTextureDescriptor const* descriptor)
+void OBJMaterial::setBumpTexture(OBJTextureId const id)
 {
-    m_TextureBump = *descriptor;
+    setTexture(OBJTextureSlot::Bump, id);
 }
 
-OBJTextureDescriptor const& OBJMaterial::getBumpTexture() const
+OBJTextureId OBJMaterial::getBumpTexture() const
 {
-    return m_TextureBump;
+    return getTexture(OBJTextureSlot::Bump);
 }
 
 //------------------------------------------------------------------------
@@ -491,26 +540,56 @@ OBJReflectionMapType OBJMaterial::getReflectionMapType() const
     return m_ReflectionMapType;
 }
 
-void OBJMaterial::setReflectionMapSphere(OBJTextureDescriptor const* descriptor)
+void OBJMaterial::setReflectionMapSphere(OBJTextureId const id)
 {
-    m_ReflectionMapType = OBJReflectionMapType::Sphere;
-    m_ReflectionMapSphere = *descriptor;
+    setTexture(OBJTextureSlot::ReflectionSphere, id);
 }
 
-OBJTextureDescriptor const& OBJMaterial::getReflectionMapSphere() const
+OBJTextureId OBJMaterial::getReflectionMapSphere() const
 {
-    return m_ReflectionMapSphere;
+    return getTexture(OBJTextureSlot::ReflectionSphere);
 }
 
-void OBJMaterial::setReflectionMapCubeSide(OBJReflectionMapCubeSide side, OBJTextureDescriptor const* descriptor)
+void OBJMaterial::setReflectionMapCubeSide(OBJReflectionMapCubeSide const side, OBJTextureId const id)
 {
-    m_ReflectionMapType = OBJReflectionMapType::Cube;
-    m_ReflectionMapCube[static_cast<uint32_t>(side)] = *descriptor;
+    setTexture(static_cast<OBJTextureSlot>(static_cast<std::size_t>(OBJTextureSlot::ReflectionCubeFront) + static_cast<std::size_t>(side)), id);
 }
 
-OBJTextureDescriptor const& OBJMaterial::getReflectionMapCubeSide(OBJReflectionMapCubeSide side) const
+OBJTextureId OBJMaterial::getReflectionMapCubeSide(OBJReflectionMapCubeSide const side) const
 {
-    return m_ReflectionMapCube[static_cast<uint32_t>(side)];
+    return m_Textures[static_cast<std::size_t>(OBJTextureSlot::ReflectionCubeFront) + static_cast<std::size_t>(side)];
+}
+
+//------------------------------------------------------------------------
+// Swap
+//------------------------------------------------------------------------
+
+void OBJMaterial::swap(OBJMaterial& other)
+{
+    // Member swap of strings would also exchange their storage, which is only allowed if
+    // both use the same arena. Moving copies between allocators instead, as std::swap does
+    // for the properties below.
+
+    OBJArenaString name(std::move(m_Name));
+    m_Name = std::move(other.m_Name);
+    other.m_Name = std::move(name);
+
+    std::swap(m_AmbientReflectivity, other.m_AmbientReflectivity);
+    std::swap(m_DiffuseReflectivity, other.m_DiffuseReflectivity);
+    std::swap(m_SpecularReflectivity, other.m_SpecularReflectivity);
+    std::swap(m_EmissiveReflectivity, other.m_EmissiveReflectivity);
+    std::swap(m_TransmissionFilter, other.m_TransmissionFilter);
+    std::swap(m_Dissolve, other.m_Dissolve);
+
+    std::swap(m_IlluminationModel, other.m_IlluminationModel);
+    std::swap(m_Sharpness, other.m_Sharpness);
+    std::swap(m_Transparency, other.m_Transparency);
+    std::swap(m_SpecularExponent, other.m_SpecularExponent);
+    std::swap(m_OpticalDensity, other.m_OpticalDensity);
+
+    m_Textures.swap(other.m_Textures);
+    std::swap(m_TextureAntiAliasing, other.m_TextureAntiAliasing);
+    std::swap(m_ReflectionMapType, other.m_ReflectionMapType);
 }
 
 //------------------------------------------------------------------------------------------
@@ -0,0 +1,701 @@
+/*
+ * Copyright 2016 Steven T Sell (ssell@vertexfragment.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "OBJMeshBuilder.hpp"
+#include "OBJState.hpp"
+
+#include <algorithm>
+#include <limits>
+
+namespace
+{
+    const uint32_t EmptySlot = 0xFFFFFFFF;
+    const std::size_t MinimumSlots = 1024;
+    const uint32_t ShortIndexLimit = 0xFFFF;        ///< Vertices per subset with short indices. 0xFFFF itself is reserved for primitive restart.
+    const uint32_t MortonAxisBits = 10;
+
+    /**
+     * Mixes a vertex group into a well distributed hash, so that the consecutive 
+     * indices typical of OBJ faces do not cluster within the table.
+     */
+    std::size_t HashVertexGroup(OBJVertexGroup const& group)
+    {
+        uint64_t hash = static_cast<uint64_t>(group.indexSpatial) * 0x9E3779B97F4A7C15ULL;
+        hash ^= (static_cast<uint64_t>(group.indexTexture) + 0x632BE59BD9B4E019ULL) * 0xBF58476D1CE4E5B9ULL;
+        hash ^= (static_cast<uint64_t>(group.indexNormal) + 0x85157AF5ULL) * 0x94D049BB133111EBULL;
+        hash ^= (hash >> 31);
+
+        return static_cast<std::size_t>(hash);
+    }
+
+    bool operator==(OBJVertexGroup const& lhs, OBJVertexGroup const& rhs)
+    {
+        return (lhs.indexSpatial == rhs.indexSpatial) && (lhs.indexTexture == rhs.indexTexture) && (lhs.indexNormal == rhs.indexNormal);
+    }
+
+    bool LessVertexGroup(OBJVertexGroup const& lhs, OBJVertexGroup const& rhs)
+    {
+        if(lhs.indexSpatial != rhs.indexSpatial)
+        {
+            return (lhs.indexSpatial < rhs.indexSpatial);
+        }
+
+        if(lhs.indexTexture != rhs.indexTexture)
+        {
+            return (lhs.indexTexture < rhs.indexTexture);
+        }
+
+        return (lhs.indexNormal < rhs.indexNormal);
+    }
+
+    bool EqualVertexGroup(OBJVertexGroup const& lhs, OBJVertexGroup const& rhs)
+    {
+        return (lhs == rhs);
+    }
+
+    bool IsIndexValid(OBJStorage::IndexType const index, OBJCount const count)
+    {
+        return (static_cast<uint64_t>(index) < static_cast<uint64_t>(count));
+    }
+
+    /**
+     * Spreads the low 10 bits of the value so that there are two zero bits between each.
+     */
+    uint32_t SpreadBits(uint32_t value)
+    {
+        value &= 0x000003FF;
+        value = (value | (value << 16)) & 0xFF0000FF;
+        value = (value | (value << 8)) & 0x0300F00F;
+        value = (value | (value << 4)) & 0x030C30C3;
+        value = (value | (value << 2)) & 0x09249249;
+
+        return value;
+    }
+
+    uint32_t Quantize(float const value, float const minimum, float const scale)
+    {
+        const float result = (value - minimum) * scale;
+        const float maximum = static_cast<float>((1 << MortonAxisBits) - 1);
+
+        return static_cast<uint32_t>(std::max(0.0f, std::min(maximum, result)));
+    }
+}
+
+//------------------------------------------------------------------------------------------
+// Constructors
+//------------------------------------------------------------------------------------------
+
+OBJMeshSubset::OBJMeshSubset()
+    : group(nullptr),
+      renderState(0),
+      firstIndex(0),
+      indexCount(0),
+      baseVertex(0)
+{
+
+}
+
+OBJMesh::OBJMesh()
+    : vertexCount(0),
+      vertexStride(0),
+      textureOffset(0),
+      normalOffset(0),
+      skippedFaces(0)
+{
+
+}
+
+OBJMeshBuilder::OBJMeshBuilder()
+    : m_IncludeTexture(true),
+      m_IncludeNormal(true),
+      m_WriteVertices(true),
+      m_ShortIndices(false),
+      m_SubsetVertexLimit(0),
+      m_UseTexture(false),
+      m_UseNormal(false),
+      m_SpatialCount(0),
+      m_TextureCount(0),
+      m_NormalCount(0),
+      m_SlotMask(0),
+      m_SlotsUsed(0)
+{
+
+}
+
+OBJMeshBuilder::~OBJMeshBuilder()
+{
+
+}
+
+//------------------------------------------------------------------------------------------
+// Public Methods
+//------------------------------------------------------------------------------------------
+
+void OBJMeshBuilder::setIncludeTexture(bool const include)
+{
+    m_IncludeTexture = include;
+}
+
+void OBJMeshBuilder::setIncludeNormal(bool const include)
+{
+    m_IncludeNormal = include;
+}
+
+void OBJMeshBuilder::setWriteVertices(bool const write)
+{
+    m_WriteVertices = write;
+}
+
+void OBJMeshBuilder::setSubsetVertexLimit(uint32_t const limit)
+{
+    m_SubsetVertexLimit = ((limit > 0) && (limit < 3)) ? 3 : limit;
+}
+
+void OBJMeshBuilder::setShortIndices(bool const write)
+{
+    m_ShortIndices = write;
+}
+
+bool OBJMeshBuilder::build(OBJState const& state, OBJMesh& mesh)
+{
+    m_SpatialCount = state.getSpatialCount();
+    m_TextureCount = state.getTextureCount();
+    m_NormalCount = state.getNormalCount();
+
+    m_UseTexture = m_IncludeTexture && (m_TextureCount > 0);
+    m_UseNormal = m_IncludeNormal && (m_NormalCount > 0);
+
+    mesh.vertices.clear();
+    mesh.sources.clear();
+    mesh.indices.clear();
+    mesh.shortIndices.clear();
+    mesh.subsets.clear();
+
+    mesh.vertexCount = 0;
+    mesh.vertexStride = 3;
+    mesh.textureOffset = 0;
+    mesh.normalOffset = 0;
+    mesh.skippedFaces = 0;
+
+    if(m_UseTexture)
+    {
+        mesh.textureOffset = mesh.vertexStride;
+        mesh.vertexStride += 2;
+    }
+
+    if(m_UseNormal)
+    {
+        mesh.normalOffset = mesh.vertexStride;
+        mesh.vertexStride += 3;
+    }
+
+    std::vector<OBJGroup const*> groups;
+    state.getGroups(groups);
+
+    std::size_t faceCount = 0;
+
+    for(auto iter = groups.begin(); iter != groups.end(); ++iter)
+    {
+        faceCount += (*iter)->faces.size();
+    }
+
+    // Most vertices are shared by several faces, so the number of positions is a good estimate of the output size
+
+    const std::size_t expected = std::max(static_cast<std::size_t>(m_SpatialCount), static_cast<std::size_t>(1));
+
+    resetTable(expected);
+    mesh.sources.reserve(expected);
+
+    if(m_WriteVertices)
+    {
+        mesh.vertices.reserve(expected * mesh.vertexStride);
+    }
+    mesh.indices.reserve(faceCount * 3);
+
+    uint32_t limit = m_SubsetVertexLimit;
+
+    if(m_ShortIndices && ((limit == 0) || (limit > ShortIndexLimit)))
+    {
+        limit = ShortIndexLimit;
+    }
+
+    OBJVertexGroup corners[4];
+
+    for(auto iter = groups.begin(); iter != groups.end(); ++iter)
+    {
+        OBJGroup const* group = (*iter);
+
+        for(auto range = group->renderStateRanges.begin(); range != group->renderStateRanges.end(); ++range)
+        {
+            OBJMeshSubset subset;
+            subset.group = group;
+            subset.renderState = (*range).renderState;
+            subset.firstIndex = static_cast<uint32_t>(mesh.indices.size());
+
+            if(limit == 0)
+            {
+                const std::size_t end = static_cast<std::size_t>((*range).firstFace) + (*range).faceCount;
+
+                for(std::size_t i = (*range).firstFace; i < end; ++i)
+                {
+                    const uint32_t cornerCount = readFace(group->faces[i], corners);
+
+                    if(cornerCount == 0)
+                    {
+                        mesh.skippedFaces++;
+                        continue;
+                    }
+
+                    uint32_t vertices[4];
+
+                    for(uint32_t c = 0; c < cornerCount; ++c)
+                    {
+                        Slot& slot = findSlot(corners[c]);
+
+                        if(slot.vertex == EmptySlot)
+                        {
+                            if(mesh.vertexCount == EmptySlot)
+                            {
+                                return false;
+                            }
+
+                            slot.key = corners[c];
+                            slot.vertex = mesh.vertexCount++;
+                            vertices[c] = slot.vertex;
+                            appendVertex(corners[c], state, mesh);
+
+                            if(++m_SlotsUsed > (m_Slots.size() >> 1))
+                            {
+                                growTable();
+                            }
+                        }
+                        else
+                        {
+                            vertices[c] = slot.vertex;
+                        }
+                    }
+
+                    mesh.indices.push_back(vertices[0]);
+                    mesh.indices.push_back(vertices[1]);
+                    mesh.indices.push_back(vertices[2]);
+
+                    if(cornerCount == 4)
+                    {
+                        mesh.indices.push_back(vertices[0]);
+                        mesh.indices.push_back(vertices[2]);
+                        mesh.indices.push_back(vertices[3]);
+                    }
+                }
+            }
+            else
+            {
+                // Each subset has its own vertices: those of earlier subsets are not reused,
+                // and are replaced in the table as their vertex groups recur.
+
+                gatherTriangles(group, (*range), mesh);
+
+                const std::size_t triangleCount = m_Corners.size() / 3;
+                m_Order.clear();
+
+                if((m_Corners.size() > limit) && (countUniqueCorners() > limit))
+                {
+                    sortTrianglesSpatially(state);
+                }
+
+                subset.baseVertex = mesh.vertexCount;
+
+                for(std::size_t t = 0; t < triangleCount; ++t)
+                {
+                    OBJVertexGroup const* triangle = &m_Corners[(m_Order.empty() ? t : m_Order[t]) * 3];
+
+                    if((mesh.vertexCount - subset.baseVertex + countNewVertices(triangle, subset.baseVertex)) > limit)
+                    {
+                        subset.indexCount = static_cast<uint32_t>(mesh.indices.size()) - subset.firstIndex;
+                        mesh.subsets.push_back(subset);
+
+                        subset.firstIndex = static_cast<uint32_t>(mesh.indices.size());
+                        subset.baseVertex = mesh.vertexCount;
+                    }
+
+                    if(!addTriangle(triangle[0], triangle[1], triangle[2], subset.baseVertex, state, mesh))
+                    {
+                        return false;
+                    }
+                }
+            }
+
+            subset.indexCount = static_cast<uint32_t>(mesh.indices.size()) - subset.firstIndex;
+
+            if(subset.indexCount > 0)
+            {
+                mesh.subsets.push_back(subset);
+            }
+        }
+    }
+
+    if(m_ShortIndices)
+    {
+        return buildShortIndices(mesh);
+    }
+
+    return true;
+}
+
+bool OBJMeshBuilder::buildShortIndices(OBJMesh& mesh)
+{
+    mesh.shortIndices.resize(mesh.indices.size());
+
+    for(auto iter = mesh.subsets.begin(); iter != mesh.subsets.end(); ++iter)
+    {
+        OBJMeshSubset& subset = (*iter);
+
+        const auto first = mesh.indices.begin() + subset.firstIndex;
+        const auto last = first + subset.indexCount;
+
+        if(first == last)
+        {
+            continue;
+        }
+
+        const auto bounds = std::minmax_element(first, last);
+
+        if((*bounds.second - *bounds.first) >= ShortIndexLimit)
+        {
+            mesh.shortIndices.clear();
+            return false;
+        }
+
+        subset.baseVertex = *bounds.first;
+
+        for(uint32_t i = subset.firstIndex; i < (subset.firstIndex + subset.indexCount); ++i)
+        {
+            mesh.shortIndices[i] = static_cast<uint16_t>(mesh.indices[i] - subset.baseVertex);
+        }
+    }
+
+    return true;
+}
+
+//------------------------------------------------------------------------------------------
+// Protected Methods
+//------------------------------------------------------------------------------------------
+
+void OBJMeshBuilder::resetTable(std::size_t const expected)
+{
+    // Kept at most half full, so that probe sequences stay short
+
+    std::size_t size = MinimumSlots;
+
+    while(size < (expected * 2))
+    {
+        size <<= 1;
+    }
+
+    Slot empty;
+    empty.vertex = EmptySlot;
+
+    m_Slots.assign(size, empty);
+    m_SlotMask = size - 1;
+    m_SlotsUsed = 0;
+}
+
+void OBJMeshBuilder::growTable()
+{
+    std::vector<Slot> previous(m_Slots.size() * 2);
+    previous.swap(m_Slots);
+
+    for(auto iter = m_Slots.begin(); iter != m_Slots.end(); ++iter)
+    {
+        (*iter).vertex = EmptySlot;
+    }
+
+    m_SlotMask = m_Slots.size() - 1;
+
+    for(auto iter = previous.begin(); iter != previous.end(); ++iter)
+    {
+        if((*iter).vertex != EmptySlot)
+        {
+            findSlot((*iter).key) = (*iter);
+        }
+    }
+}
+
+OBJMeshBuilder::Slot& OBJMeshBuilder::findSlot(OBJVertexGroup const& key)
+{
+    std::size_t index = HashVertexGroup(key) & m_SlotMask;
+
+    while(true)
+    {
+        Slot& slot = m_Slots[index];
+
+        if((slot.vertex == EmptySlot) || (slot.key == key))
+        {
+            return slot;
+        }
+
+        index = (index + 1) & m_SlotMask;
+    }
+}
+
+bool OBJMeshBuilder::isValid(OBJVertexGroup const& group) const
+{
+    if(!IsIndexValid(group.indexSpatial, m_SpatialCount))
+    {
+        return false;
+    }
+
+    // Absent texture coordinates and normals are allowed, but present ones must exist
+
+    if(m_UseTexture && OBJStorage::Indices::isUsed(group.indexTexture) && !IsIndexValid(group.indexTexture, m_TextureCount))
+    {
+        return false;
+    }
+
+    if(m_UseNormal && OBJStorage::Indices::isUsed(group.indexNormal) && !IsIndexValid(group.indexNormal, m_NormalCount))
+    {
+        return false;
+    }
+
+    return true;
+}
+
+void OBJMeshBuilder::appendVertex(OBJVertexGroup const& key, OBJState const& state, OBJMesh& mesh) const
+{
+    mesh.sources.push_back(key);
+
+    if(!m_WriteVertices)
+    {
+        return;
+    }
+
+    const OBJVector4 position = state.getSpatial(static_cast<OBJCount>(key.indexSpatial));
+
+    mesh.vertices.push_back(position.x);
+    mesh.vertices.push_back(position.y);
+    mesh.vertices.push_back(position.z);
+
+    if(m_UseTexture)
+    {
+        const OBJVector2 texture = OBJStorage::Indices::isUsed(key.indexTexture) ? state.getTexture(static_cast<OBJCount>(key.indexTexture)) : OBJVector2();
+
+        mesh.vertices.push_back(texture.x);
+        mesh.vertices.push_back(texture.y);
+    }
+
+    if(m_UseNormal)
+    {
+        const OBJVector3 normal = OBJStorage::Indices::isUsed(key.indexNormal) ? state.getNormal(static_cast<OBJCount>(key.indexNormal)) : OBJVector3();
+
+        mesh.vertices.push_back(normal.x);
+        mesh.vertices.push_back(normal.y);
+        mesh.vertices.push_back(normal.z);
+    }
+}
+
+uint32_t OBJMeshBuilder::readFace(OBJFace const& face, OBJVertexGroup* corners) const
+{
+    corners[0] = face.group0;
+    corners[1] = face.group1;
+    corners[2] = face.group2;
+    corners[3] = face.group3;
+
+    const uint32_t cornerCount = OBJStorage::Indices::isUsed(face.group3.indexSpatial) ? 4 : 3;
+    bool valid = true;
+
+    for(uint32_t c = 0; c < cornerCount; ++c)
+    {
+        valid = valid && isValid(corners[c]);
+
+        // Excluded attributes do not distinguish vertices
+
+        if(!m_UseTexture)
+        {
+            corners[c].indexTexture = OBJStorage::Indices::unused();
+        }
+
+        if(!m_UseNormal)
+        {
+            corners[c].indexNormal = OBJStorage::Indices::unused();
+        }
+    }
+
+    return valid ? cornerCount : 0;
+}
+
+bool OBJMeshBuilder::addTriangle(OBJVertexGroup const& a, OBJVertexGroup const& b, OBJVertexGroup const& c, uint32_t const baseVertex, OBJState const& state, OBJMesh& mesh)
+{
+    OBJVertexGroup const* corners[3] = { &a, &b, &c };
+    uint32_t vertices[3];
+
+    for(uint32_t i = 0; i < 3; ++i)
+    {
+        Slot& slot = findSlot(*corners[i]);
+
+        if((slot.vertex == EmptySlot) || (slot.vertex < baseVertex))
+        {
+            if(mesh.vertexCount == EmptySlot)
+            {
+                return false;
+            }
+
+            const bool inserted = (slot.vertex == EmptySlot);
+
+            slot.key = *corners[i];
+            slot.vertex = mesh.vertexCount++;
+            vertices[i] = slot.vertex;
+            appendVertex(*corners[i], state, mesh);
+
+            if(inserted && (++m_SlotsUsed > (m_Slots.size() >> 1)))
+            {
+                growTable();
+            }
+        }
+        else
+        {
+            vertices[i] = slot.vertex;
+        }
+    }
+
+    mesh.indices.push_back(vertices[0]);
+    mesh.indices.push_back(vertices[1]);
+    mesh.indices.push_back(vertices[2]);
+
+    return true;
+}
+
+void OBJMeshBuilder::gatherTriangles(OBJGroup const* group, OBJRenderStateRange const& range, OBJMesh& mesh)
+{
+    m_Corners.clear();
+
+    OBJVertexGroup corners[4];
+    const std::size_t end = static_cast<std::size_t>(range.firstFace) + range.faceCount;
+
+    for(std::size_t i = range.firstFace; i < end; ++i)
+    {
+        const uint32_t cornerCount = readFace(group->faces[i], corners);
+
+        if(cornerCount == 0)
+        {
+            mesh.skippedFaces++;
+            continue;
+        }
+
+        m_Corners.push_back(corners[0]);
+        m_Corners.push_back(corners[1]);
+        m_Corners.push_back(corners[2]);
+
+        if(cornerCount == 4)
+        {
+            m_Corners.push_back(corners[0]);
+            m_Corners.push_back(corners[2]);
+            m_Corners.push_back(corners[3]);
+        }
+    }
+}
+
+uint32_t OBJMeshBuilder::countNewVertices(OBJVertexGroup const* triangle, uint32_t const baseVertex)
+{
+    uint32_t result = 0;
+
+    for(uint32_t c = 0; c < 3; ++c)
+    {
+        const bool repeated = ((c > 0) && (triangle[c] == triangle[0])) || ((c > 1) && (triangle[c] == triangle[1]));
+        const uint32_t vertex = findSlot(triangle[c]).vertex;
+
+        if(!repeated && ((vertex == EmptySlot) || (vertex < baseVertex)))
+        {
+            result++;
+        }
+    }
+
+    return result;
+}
+
+std::size_t OBJMeshBuilder::countUniqueCorners()
+{
+    m_Unique.assign(m_Corners.begin(), m_Corners.end());
+    std::sort(m_Unique.begin(), m_Unique.end(), LessVertexGroup);
+
+    return static_cast<std::size_t>(std::unique(m_Unique.begin(), m_Unique.end(), EqualVertexGroup) - m_Unique.begin());
+}
+
+void OBJMeshBuilder::sortTrianglesSpatially(OBJState const& state)
+{
+    // Orders the triangles by the Morton code of their centers within the bounds of the range
+
+    const std::size_t triangleCount = m_Corners.size() / 3;
+    std::vector<OBJVector3> centers(triangleCount);
+
+    OBJVector3 minimum;
+    minimum.x = minimum.y = minimum.z = std::numeric_limits<float>::max();
+
+    OBJVector3 maximum;
+    maximum.x = maximum.y = maximum.z = -std::numeric_limits<float>::max();
+
+    for(std::size_t t = 0; t < triangleCount; ++t)
+    {
+        OBJVector3 center;
+
+        for(std::size_t c = 0; c < 3; ++c)
+        {
+            const OBJVector4 position = state.getSpatial(static_cast<OBJCount>(m_Corners[(t * 3) + c].indexSpatial));
+
+            center.x += position.x / 3.0f;
+            center.y += position.y / 3.0f;
+            center.z += position.z / 3.0f;
+        }
+
+        minimum.x = std::min(minimum.x, center.x);
+        minimum.y = std::min(minimum.y, center.y);
+        minimum.z = std::min(minimum.z, center.z);
+
+        maximum.x = std::max(maximum.x, center.x);
+        maximum.y = std::max(maximum.y, center.y);
+        maximum.z = std::max(maximum.z, center.z);
+
+        centers[t] = center;
+    }
+
+    // A single scale for all axes keeps the cells cubic, so that flat ranges are not stretched
+
+    const float extent = std::max(maximum.x - minimum.x, std::max(maximum.y - minimum.y, maximum.z - minimum.z));
+    const float scale = (extent > 0.0f) ? (static_cast<float>(1 << MortonAxisBits) / extent) : 0.0f;
+
+    m_SortKeys.resize(triangleCount);
+
+    for(std::size_t t = 0; t < triangleCount; ++t)
+    {
+        const uint32_t code = SpreadBits(Quantize(centers[t].x, minimum.x, scale)) |
+                              (SpreadBits(Quantize(centers[t].y, minimum.y, scale)) << 1) |
+                              (SpreadBits(Quantize(centers[t].z, minimum.z, scale)) << 2);
+
+        m_SortKeys[t] = (static_cast<uint64_t>(code) << 32) | static_cast<uint64_t>(t);
+    }
+
+    std::sort(m_SortKeys.begin(), m_SortKeys.end());
+
+    m_Order.resize(triangleCount);
+
+    for(std::size_t t = 0; t < triangleCount; ++t)
+    {
+        m_Order[t] = static_cast<uint32_t>(m_SortKeys[t] & 0xFFFFFFFF);
+    }
+}
+
+//------------------------------------------------------------------------------------------
+// Private Methods
+//------------------------------------------------------------------------------------------
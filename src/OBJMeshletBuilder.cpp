@@ -0,0 +1,388 @@
+/*
+ * Copyright 2016 Steven T Sell (ssell@vertexfragment.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "OBJMeshletBuilder.hpp"
+#include "OBJMeshBuilder.hpp"
+#include "OBJParallel.hpp"
+#include "OBJState.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    const uint32_t Unmapped = 0xFFFFFFFF;
+
+    /**
+     * Meshlets of a single subset, with offsets relative to the subset.
+     */
+    struct SubsetMeshlets
+    {
+        std::vector<OBJMeshlet> meshlets;
+        std::vector<uint32_t> vertices;
+        std::vector<uint8_t> triangles;
+    };
+
+    OBJVector3 Subtract(OBJVector3 const& lhs, OBJVector3 const& rhs)
+    {
+        OBJVector3 result;
+
+        result.x = lhs.x - rhs.x;
+        result.y = lhs.y - rhs.y;
+        result.z = lhs.z - rhs.z;
+
+        return result;
+    }
+
+    float Dot(OBJVector3 const& lhs, OBJVector3 const& rhs)
+    {
+        return (lhs.x * rhs.x) + (lhs.y * rhs.y) + (lhs.z * rhs.z);
+    }
+
+    OBJVector3 Cross(OBJVector3 const& lhs, OBJVector3 const& rhs)
+    {
+        OBJVector3 result;
+
+        result.x = (lhs.y * rhs.z) - (lhs.z * rhs.y);
+        result.y = (lhs.z * rhs.x) - (lhs.x * rhs.z);
+        result.z = (lhs.x * rhs.y) - (lhs.y * rhs.x);
+
+        return result;
+    }
+
+    /**
+     * Scales the vector to unit length. Returns false (and leaves it unchanged) if it is degenerate.
+     */
+    bool Normalize(OBJVector3& vector)
+    {
+        const float length = std::sqrt(Dot(vector, vector));
+
+        if(length <= 0.0f)
+        {
+            return false;
+        }
+
+        vector.x /= length;
+        vector.y /= length;
+        vector.z /= length;
+
+        return true;
+    }
+
+    /**
+     * Ritter's bounding sphere: an initial sphere spanning two distant points, 
+     * grown to include any point outside of it.
+     */
+    void ComputeSphere(std::vector<OBJVector3> const& positions, OBJMeshlet& meshlet)
+    {
+        std::size_t farthest = 0;
+        float farthestDistance = -1.0f;
+
+        for(std::size_t i = 0; i < positions.size(); ++i)
+        {
+            const OBJVector3 offset = Subtract(positions[i], positions[0]);
+            const float distance = Dot(offset, offset);
+
+            if(distance > farthestDistance)
+            {
+                farthestDistance = distance;
+                farthest = i;
+            }
+        }
+
+        OBJVector3 const& first = positions[farthest];
+
+        farthestDistance = -1.0f;
+
+        for(std::size_t i = 0; i < positions.size(); ++i)
+        {
+            const OBJVector3 offset = Subtract(positions[i], first);
+            const float distance = Dot(offset, offset);
+
+            if(distance > farthestDistance)
+            {
+                farthestDistance = distance;
+                farthest = i;
+            }
+        }
+
+        OBJVector3 const& second = positions[farthest];
+
+        meshlet.center.x = (first.x + second.x) * 0.5f;
+        meshlet.center.y = (first.y + second.y) * 0.5f;
+        meshlet.center.z = (first.z + second.z) * 0.5f;
+        meshlet.radius = std::sqrt(farthestDistance) * 0.5f;
+
+        for(std::size_t i = 0; i < positions.size(); ++i)
+        {
+            const OBJVector3 offset = Subtract(positions[i], meshlet.center);
+            const float distance = std::sqrt(Dot(offset, offset));
+
+            if(distance > meshlet.radius)
+            {
+                // Move the center towards the point just enough to reach it
+
+                const float radius = (meshlet.radius + distance) * 0.5f;
+                const float shift = (radius - meshlet.radius) / distance;
+
+                meshlet.center.x += offset.x * shift;
+                meshlet.center.y += offset.y * shift;
+                meshlet.center.z += offset.z * shift;
+                meshlet.radius = radius;
+            }
+        }
+    }
+
+    /**
+     * Normal cone of the triangles, with the apex placed such that every triangle plane
+     * is behind it (as in meshoptimizer), so that the cone test is conservative for perspective.
+     */
+    void ComputeCone(std::vector<OBJVector3> const& positions, uint8_t const* triangles, uint32_t const triangleCount, OBJMeshlet& meshlet)
+    {
+        const float MinimumSpread = 0.1f;      // Cones wider than ~84 degrees cull too rarely to be worth testing
+
+        // Degenerate triangles keep a zero normal, and so do not affect the cone
+
+        std::vector<OBJVector3> normals(triangleCount);
+        OBJVector3 axis;
+
+        for(uint32_t t = 0; t < triangleCount; ++t)
+        {
+            OBJVector3 const& p0 = positions[triangles[(t * 3) + 0]];
+            OBJVector3 normal = Cross(Subtract(positions[triangles[(t * 3) + 1]], p0), Subtract(positions[triangles[(t * 3) + 2]], p0));
+
+            if(Normalize(normal))
+            {
+                axis.x += normal.x;
+                axis.y += normal.y;
+                axis.z += normal.z;
+
+                normals[t] = normal;
+            }
+        }
+
+        meshlet.coneApex = meshlet.center;
+        meshlet.coneAxis = OBJVector3();
+        meshlet.coneCutoff = 1.0f;
+
+        if(!Normalize(axis))
+        {
+            return;
+        }
+
+        float minimumDot = 1.0f;
+
+        for(auto iter = normals.begin(); iter != normals.end(); ++iter)
+        {
+            if(Dot((*iter), (*iter)) > 0.0f)
+            {
+                minimumDot = std::min(minimumDot, Dot((*iter), axis));
+            }
+        }
+
+        if(minimumDot <= MinimumSpread)
+        {
+            return;
+        }
+
+        // Furthest distance along the axis to any triangle plane
+
+        float maximumT = 0.0f;
+
+        for(uint32_t t = 0; t < triangleCount; ++t)
+        {
+            OBJVector3 const& normal = normals[t];
+
+            if(Dot(normal, normal) > 0.0f)
+            {
+                const float distance = Dot(Subtract(meshlet.center, positions[triangles[t * 3]]), normal) / Dot(axis, normal);
+                maximumT = std::max(maximumT, distance);
+            }
+        }
+
+        meshlet.coneApex.x = meshlet.center.x - (axis.x * maximumT);
+        meshlet.coneApex.y = meshlet.center.y - (axis.y * maximumT);
+        meshlet.coneApex.z = meshlet.center.z - (axis.z * maximumT);
+        meshlet.coneAxis = axis;
+        meshlet.coneCutoff = std::sqrt(1.0f - (minimumDot * minimumDot));
+    }
+}
+
+//------------------------------------------------------------------------------------------
+// Constructors
+//------------------------------------------------------------------------------------------
+
+OBJMeshlet::OBJMeshlet()
+    : vertexOffset(0),
+      triangleOffset(0),
+      vertexCount(0),
+      triangleCount(0),
+      subset(0),
+      radius(0.0f),
+      coneCutoff(1.0f)
+{
+
+}
+
+OBJMeshletBuilder::OBJMeshletBuilder()
+    : m_MaxVertices(64),
+      m_MaxTriangles(124),
+      m_ThreadCount(0)
+{
+
+}
+
+OBJMeshletBuilder::~OBJMeshletBuilder()
+{
+
+}
+
+//------------------------------------------------------------------------------------------
+// Public Methods
+//------------------------------------------------------------------------------------------
+
+void OBJMeshletBuilder::setLimits(uint32_t const maxVertices, uint32_t const maxTriangles)
+{
+    m_MaxVertices = std::min(std::max(maxVertices, static_cast<uint32_t>(3)), static_cast<uint32_t>(255));
+    m_MaxTriangles = std::max(maxTriangles, static_cast<uint32_t>(1));
+}
+
+void OBJMeshletBuilder::setThreadCount(uint32_t const count)
+{
+    m_ThreadCount = count;
+}
+
+void OBJMeshletBuilder::build(OBJState const& state, OBJMesh const& mesh, OBJMeshlets& meshlets) const
+{
+    meshlets.meshlets.clear();
+    meshlets.vertices.clear();
+    meshlets.triangles.clear();
+
+    std::vector<SubsetMeshlets> subsets(mesh.subsets.size());
+    std::atomic<std::size_t> next(0);
+
+    const uint32_t maxVertices = m_MaxVertices;
+    const uint32_t maxTriangles = m_MaxTriangles;
+
+    auto worker = [&state, &mesh, &subsets, &next, maxVertices, maxTriangles]()
+    {
+        std::vector<uint32_t> localIndices(mesh.vertexCount, Unmapped);
+        std::vector<OBJVector3> positions;
+
+        for(std::size_t s = next++; s < subsets.size(); s = next++)
+        {
+            OBJMeshSubset const& subset = mesh.subsets[s];
+            SubsetMeshlets& output = subsets[s];
+
+            OBJMeshlet meshlet;
+            meshlet.subset = static_cast<uint32_t>(s);
+
+            // Completes the current meshlet and begins the next one after it
+
+            auto finish = [&]()
+            {
+                positions.resize(meshlet.vertexCount);
+
+                for(uint32_t v = 0; v < meshlet.vertexCount; ++v)
+                {
+                    const uint32_t vertex = output.vertices[meshlet.vertexOffset + v];
+                    const OBJVector4 position = state.getSpatial(static_cast<OBJCount>(mesh.sources[vertex].indexSpatial));
+
+                    positions[v].x = position.x;
+                    positions[v].y = position.y;
+                    positions[v].z = position.z;
+
+                    localIndices[vertex] = Unmapped;
+                }
+
+                ComputeSphere(positions, meshlet);
+                ComputeCone(positions, &output.triangles[meshlet.triangleOffset * 3], meshlet.triangleCount, meshlet);
+
+                output.meshlets.push_back(meshlet);
+
+                meshlet.vertexOffset += meshlet.vertexCount;
+                meshlet.triangleOffset += meshlet.triangleCount;
+                meshlet.vertexCount = 0;
+                meshlet.triangleCount = 0;
+            };
+
+            for(uint32_t i = 0; (i + 2) < subset.indexCount; i += 3)
+            {
+                uint32_t const* triangle = &mesh.indices[subset.firstIndex + i];
+
+                const uint32_t added = ((localIndices[triangle[0]] == Unmapped) ? 1 : 0) + 
+                                       (((localIndices[triangle[1]] == Unmapped) && (triangle[1] != triangle[0])) ? 1 : 0) + 
+                                       (((localIndices[triangle[2]] == Unmapped) && (triangle[2] != triangle[0]) && (triangle[2] != triangle[1])) ? 1 : 0);
+
+                if(((meshlet.vertexCount + added) > maxVertices) || (meshlet.triangleCount == maxTriangles))
+                {
+                    finish();
+                }
+
+                for(uint32_t c = 0; c < 3; ++c)
+                {
+                    uint32_t& local = localIndices[triangle[c]];
+
+                    if(local == Unmapped)
+                    {
+                        local = meshlet.vertexCount++;
+                        output.vertices.push_back(triangle[c]);
+                    }
+
+                    output.triangles.push_back(static_cast<uint8_t>(local));
+                }
+
+                meshlet.triangleCount++;
+            }
+
+            if(meshlet.triangleCount > 0)
+            {
+                finish();
+            }
+        }
+    };
+
+    OBJRunWorkers(OBJGetThreadCount(m_ThreadCount, subsets.size()), worker);
+
+    //--------------------------------------------------------------------
+    // Concatenate the subsets, in order
+    //--------------------------------------------------------------------
+
+    for(auto iter = subsets.begin(); iter != subsets.end(); ++iter)
+    {
+        const uint32_t vertexOffset = static_cast<uint32_t>(meshlets.vertices.size());
+        const uint32_t triangleOffset = static_cast<uint32_t>(meshlets.triangles.size() / 3);
+
+        for(auto meshlet = (*iter).meshlets.begin(); meshlet != (*iter).meshlets.end(); ++meshlet)
+        {
+            meshlets.meshlets.push_back((*meshlet));
+            meshlets.meshlets.back().vertexOffset += vertexOffset;
+            meshlets.meshlets.back().triangleOffset += triangleOffset;
+        }
+
+        meshlets.vertices.insert(meshlets.vertices.end(), (*iter).vertices.begin(), (*iter).vertices.end());
+        meshlets.triangles.insert(meshlets.triangles.end(), (*iter).triangles.begin(), (*iter).triangles.end());
+    }
+}
+
+//------------------------------------------------------------------------------------------
+// Protected Methods
+//------------------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------------------
+// Private Methods
+//------------------------------------------------------------------------------------------
@@ -0,0 +1,529 @@
+/*
+ * Copyright 2016 Steven T Sell (ssell@vertexfragment.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "OBJNormalGenerator.hpp"
+#include "OBJParallel.hpp"
+#include "OBJState.hpp"
+
+#include <cmath>
+#include <limits>
+#include <memory>
+
+namespace
+{
+    const std::size_t FacesPerChunk = 1 << 16;
+    const std::size_t VerticesPerChunk = 1 << 16;
+    const uint32_t ExcludedFace = 0xFFFFFFFF;      ///< Smoothing key of faces that keep their normals
+    const float DegreesToRadians = 0.0174532925f;
+
+    /**
+     * Consecutive faces of a single group, processed as one unit of work.
+     */
+    struct FaceRange
+    {
+        OBJGroup const* group;
+        std::size_t first;      ///< Index of the first face within the group
+        std::size_t count;
+        std::size_t base;       ///< Global index of the first face, across all groups
+    };
+
+    OBJVector3 Subtract(OBJVector3 const& lhs, OBJVector3 const& rhs)
+    {
+        OBJVector3 result;
+
+        result.x = lhs.x - rhs.x;
+        result.y = lhs.y - rhs.y;
+        result.z = lhs.z - rhs.z;
+
+        return result;
+    }
+
+    float Dot(OBJVector3 const& lhs, OBJVector3 const& rhs)
+    {
+        return (lhs.x * rhs.x) + (lhs.y * rhs.y) + (lhs.z * rhs.z);
+    }
+
+    OBJVector3 Cross(OBJVector3 const& lhs, OBJVector3 const& rhs)
+    {
+        OBJVector3 result;
+
+        result.x = (lhs.y * rhs.z) - (lhs.z * rhs.y);
+        result.y = (lhs.z * rhs.x) - (lhs.x * rhs.z);
+        result.z = (lhs.x * rhs.y) - (lhs.y * rhs.x);
+
+        return result;
+    }
+
+    OBJVector3 GetPosition(OBJState const& state, OBJStorage::IndexType const index)
+    {
+        const OBJVector4 position = state.getSpatial(static_cast<OBJCount>(index));
+
+        OBJVector3 result;
+        result.x = position.x;
+        result.y = position.y;
+        result.z = position.z;
+
+        return result;
+    }
+
+    float CornerAngle(OBJVector3 const& corner, OBJVector3 const& previous, OBJVector3 const& next)
+    {
+        const OBJVector3 a = Subtract(next, corner);
+        const OBJVector3 b = Subtract(previous, corner);
+
+        const float lengths = std::sqrt(Dot(a, a) * Dot(b, b));
+
+        return (lengths > 0.0f) ? std::acos(std::max(-1.0f, std::min(1.0f, Dot(a, b) / lengths))) : 0.0f;
+    }
+}
+
+//------------------------------------------------------------------------------------------
+// Constructors
+//------------------------------------------------------------------------------------------
+
+OBJNormalGenerator::OBJNormalGenerator()
+    : m_CreaseAngle(180.0f),
+      m_Weighting(OBJNormalWeighting::Angle),
+      m_IgnoreSmoothingGroups(false),
+      m_ReplaceExisting(false),
+      m_ThreadCount(0)
+{
+
+}
+
+OBJNormalGenerator::~OBJNormalGenerator()
+{
+
+}
+
+//------------------------------------------------------------------------------------------
+// Public Methods
+//------------------------------------------------------------------------------------------
+
+void OBJNormalGenerator::setCreaseAngle(float const degrees)
+{
+    m_CreaseAngle = degrees;
+}
+
+void OBJNormalGenerator::setWeighting(OBJNormalWeighting const weighting)
+{
+    m_Weighting = weighting;
+}
+
+void OBJNormalGenerator::setIgnoreSmoothingGroups(bool const ignore)
+{
+    m_IgnoreSmoothingGroups = ignore;
+}
+
+void OBJNormalGenerator::setReplaceExisting(bool const replace)
+{
+    m_ReplaceExisting = replace;
+}
+
+void OBJNormalGenerator::setThreadCount(uint32_t const count)
+{
+    m_ThreadCount = count;
+}
+
+bool OBJNormalGenerator::generate(OBJState& state) const
+{
+    //--------------------------------------------------------------------
+    // Divide the faces of all groups into ranges
+    //--------------------------------------------------------------------
+
+    std::vector<OBJGroup const*> groups;
+    state.getGroups(groups);
+
+    std::vector<FaceRange> ranges;
+    std::size_t faceCount = 0;
+
+    for(auto iter = groups.begin(); iter != groups.end(); ++iter)
+    {
+        const std::size_t groupFaces = (*iter)->faces.size();
+
+        for(std::size_t first = 0; first < groupFaces; first += FacesPerChunk)
+        {
+            FaceRange range;
+            range.group = (*iter);
+            range.first = first;
+            range.count = std::min(FacesPerChunk, groupFaces - first);
+            range.base = faceCount + first;
+
+            ranges.push_back(range);
+        }
+
+        faceCount += groupFaces;
+    }
+
+    // Every face is checked up front, so that the faces can not be rejected once the normals are appended
+
+    for(auto iter = ranges.begin(); iter != ranges.end(); ++iter)
+    {
+        if(!state.hasFaces((*iter).group, (*iter).first, (*iter).count))
+        {
+            return false;
+        }
+    }
+
+    // Corners are identified by face * 4 + corner
+
+    if(static_cast<uint64_t>(faceCount) * 4 > 0xFFFFFFFF)
+    {
+        return false;
+    }
+
+    const OBJCount spatialCount = state.getSpatialCount();
+    const uint32_t renderStateCount = state.getRenderStateCount();
+
+    std::vector<uint32_t> smoothingGroups(renderStateCount + 1, 0);
+
+    for(uint32_t i = 0; i < renderStateCount; ++i)
+    {
+        smoothingGroups[i] = m_IgnoreSmoothingGroups ? 1 : state.getRenderState(i).smoothing;
+    }
+
+    smoothingGroups[renderStateCount] = m_IgnoreSmoothingGroups ? 1 : 0;
+
+    //--------------------------------------------------------------------
+    // Pass 1: Face normals and corner weights, and the number of corners
+    // at each spatial vertex
+    //--------------------------------------------------------------------
+
+    std::vector<uint32_t> faceKeys(faceCount);
+    std::vector<OBJVector3> faceNormals(faceCount);
+    std::vector<float> cornerWeights(faceCount * 4);
+
+    std::unique_ptr<std::atomic<uint32_t>[]> vertexCorners(new std::atomic<uint32_t>[spatialCount + 1]);
+
+    for(OBJCount v = 0; v <= spatialCount; ++v)
+    {
+        vertexCorners[v] = 0;
+    }
+
+    const bool replaceExisting = m_ReplaceExisting;
+    const bool angleWeighted = (m_Weighting == OBJNormalWeighting::Angle);
+
+    OBJParallelFor(ranges.size(), m_ThreadCount, [&](std::size_t const r)
+    {
+        FaceRange const& range = ranges[r];
+
+        for(std::size_t i = 0; i < range.count; ++i)
+        {
+            OBJFace const& face = range.group->faces[range.first + i];
+            const std::size_t f = range.base + i;
+
+            OBJVertexGroup const* corners[4] = { &face.group0, &face.group1, &face.group2, &face.group3 };
+            const uint32_t cornerCount = OBJStorage::Indices::isUsed(face.group3.indexSpatial) ? 4 : 3;
+
+            bool include = replaceExisting;
+            bool valid = true;
+
+            for(uint32_t c = 0; c < cornerCount; ++c)
+            {
+                include = include || !OBJStorage::Indices::isUsed(corners[c]->indexNormal);
+                valid = valid && (static_cast<uint64_t>(corners[c]->indexSpatial) < static_cast<uint64_t>(spatialCount));
+            }
+
+            if(!include || !valid)
+            {
+                faceKeys[f] = ExcludedFace;
+                continue;
+            }
+
+            OBJVector3 positions[4];
+
+            for(uint32_t c = 0; c < cornerCount; ++c)
+            {
+                positions[c] = GetPosition(state, corners[c]->indexSpatial);
+            }
+
+            // The length of either cross product is twice the area of the (planar) face
+
+            OBJVector3 normal = (cornerCount == 4) ? Cross(Subtract(positions[2], positions[0]), Subtract(positions[3], positions[1])) : 
+                                                     Cross(Subtract(positions[1], positions[0]), Subtract(positions[2], positions[0]));
+
+            const float area = std::sqrt(Dot(normal, normal)) * 0.5f;
+            const float inverse = (area > 0.0f) ? (0.5f / area) : 0.0f;
+
+            normal.x *= inverse;
+            normal.y *= inverse;
+            normal.z *= inverse;
+
+            faceNormals[f] = normal;
+            faceKeys[f] = smoothingGroups[std::min(face.renderState, renderStateCount)];
+
+            for(uint32_t c = 0; c < cornerCount; ++c)
+            {
+                cornerWeights[(f * 4) + c] = angleWeighted ? CornerAngle(positions[c], positions[(c + cornerCount - 1) % cornerCount], positions[(c + 1) % cornerCount]) : area;
+                vertexCorners[static_cast<std::size_t>(corners[c]->indexSpatial)]++;
+            }
+        }
+    });
+
+    //--------------------------------------------------------------------
+    // Pass 2: Lists of the corners at each spatial vertex
+    //--------------------------------------------------------------------
+
+    std::vector<uint32_t> cornerOffsets(spatialCount + 1);
+    uint32_t cornerTotal = 0;
+
+    for(OBJCount v = 0; v < spatialCount; ++v)
+    {
+        cornerOffsets[v] = cornerTotal;
+        cornerTotal += vertexCorners[v];
+        vertexCorners[v] = cornerOffsets[v];
+    }
+
+    cornerOffsets[spatialCount] = cornerTotal;
+
+    std::vector<uint32_t> vertexCornerList(cornerTotal);
+
+    OBJParallelFor(ranges.size(), m_ThreadCount, [&](std::size_t const r)
+    {
+        FaceRange const& range = ranges[r];
+
+        for(std::size_t i = 0; i < range.count; ++i)
+        {
+            const std::size_t f = range.base + i;
+
+            if(faceKeys[f] == ExcludedFace)
+            {
+                continue;
+            }
+
+            OBJFace const& face = range.group->faces[range.first + i];
+            OBJVertexGroup const* corners[4] = { &face.group0, &face.group1, &face.group2, &face.group3 };
+            const uint32_t cornerCount = OBJStorage::Indices::isUsed(face.group3.indexSpatial) ? 4 : 3;
+
+            for(uint32_t c = 0; c < cornerCount; ++c)
+            {
+                vertexCornerList[vertexCorners[static_cast<std::size_t>(corners[c]->indexSpatial)]++] = static_cast<uint32_t>((f * 4) + c);
+            }
+        }
+    });
+
+    vertexCorners.reset();
+
+    //--------------------------------------------------------------------
+    // Pass 3: Smooth the corners at each vertex, and keep one normal per
+    // unique result. Indices are relative to the vertex chunk until the
+    // size of each chunk is known.
+    //--------------------------------------------------------------------
+
+    const std::size_t vertexChunkCount = (static_cast<std::size_t>(spatialCount) + VerticesPerChunk - 1) / VerticesPerChunk;
+    const float creaseCosine = std::cos(std::min(m_CreaseAngle, 180.0f) * DegreesToRadians);
+    const bool creased = (m_CreaseAngle < 180.0f);
+
+    std::vector<std::vector<OBJVector3>> chunkNormals(vertexChunkCount);
+    std::vector<uint32_t> cornerNormals(faceCount * 4);
+
+    OBJParallelFor(vertexChunkCount, m_ThreadCount, [&](std::size_t const chunk)
+    {
+        std::vector<OBJVector3>& normals = chunkNormals[chunk];
+        const std::size_t end = std::min(static_cast<std::size_t>(spatialCount), (chunk + 1) * VerticesPerChunk);
+
+        for(std::size_t v = chunk * VerticesPerChunk; v < end; ++v)
+        {
+            uint32_t* first = vertexCornerList.data() + cornerOffsets[v];
+            uint32_t* last = vertexCornerList.data() + cornerOffsets[v + 1];
+
+            // Sorted so that the result does not depend on the order corners were listed in
+
+            std::sort(first, last, [&faceKeys](uint32_t lhs, uint32_t rhs) 
+            { 
+                return (faceKeys[lhs / 4] < faceKeys[rhs / 4]) || ((faceKeys[lhs / 4] == faceKeys[rhs / 4]) && (lhs < rhs)); 
+            });
+
+            const std::size_t vertexFirstNormal = normals.size();
+
+            for(uint32_t* run = first; run != last; )
+            {
+                const uint32_t key = faceKeys[(*run) / 4];
+                uint32_t* runEnd = run;
+
+                while((runEnd != last) && (faceKeys[(*runEnd) / 4] == key))
+                {
+                    ++runEnd;
+                }
+
+                OBJVector3 runSum;
+
+                if((key != 0) && !creased)
+                {
+                    for(uint32_t* other = run; other != runEnd; ++other)
+                    {
+                        OBJVector3 const& faceNormal = faceNormals[(*other) / 4];
+                        const float weight = cornerWeights[(*other)];
+
+                        runSum.x += faceNormal.x * weight;
+                        runSum.y += faceNormal.y * weight;
+                        runSum.z += faceNormal.z * weight;
+                    }
+                }
+
+                for(uint32_t* corner = run; corner != runEnd; ++corner)
+                {
+                    OBJVector3 const& faceNormal = faceNormals[(*corner) / 4];
+                    OBJVector3 normal = runSum;
+
+                    if(key == 0)
+                    {
+                        normal = faceNormal;
+                    }
+                    else if(creased)
+                    {
+                        for(uint32_t* other = run; other != runEnd; ++other)
+                        {
+                            OBJVector3 const& otherNormal = faceNormals[(*other) / 4];
+
+                            if((other == corner) || (Dot(faceNormal, otherNormal) >= creaseCosine))
+                            {
+                                const float weight = cornerWeights[(*other)];
+
+                                normal.x += otherNormal.x * weight;
+                                normal.y += otherNormal.y * weight;
+                                normal.z += otherNormal.z * weight;
+                            }
+                        }
+                    }
+
+                    const float length = std::sqrt(Dot(normal, normal));
+
+                    if(length > 0.0f)
+                    {
+                        normal.x /= length;
+                        normal.y /= length;
+                        normal.z /= length;
+                    }
+                    else
+                    {
+                        normal = faceNormal;
+                    }
+
+                    // Share the normal with any identical one already at this vertex
+
+                    std::size_t index = vertexFirstNormal;
+
+                    while((index < normals.size()) && ((normals[index].x != normal.x) || (normals[index].y != normal.y) || (normals[index].z != normal.z)))
+                    {
+                        ++index;
+                    }
+
+                    if(index == normals.size())
+                    {
+                        normals.push_back(normal);
+                    }
+
+                    cornerNormals[(*corner)] = static_cast<uint32_t>(index);
+                }
+
+                run = runEnd;
+            }
+        }
+    });
+
+    //--------------------------------------------------------------------
+    // Pass 4: Store the normals, once they are known to be addressable
+    //--------------------------------------------------------------------
+
+    std::vector<uint64_t> chunkBases(vertexChunkCount);
+    uint64_t normalIndex = state.getNormalCount();
+
+    for(std::size_t chunk = 0; chunk < vertexChunkCount; ++chunk)
+    {
+        chunkBases[chunk] = normalIndex;
+        normalIndex += chunkNormals[chunk].size();
+    }
+
+    typedef OBJStorage::IndexType IndexType;
+
+    const uint64_t maximumIndex = std::numeric_limits<IndexType>::is_signed ? static_cast<uint64_t>(std::numeric_limits<IndexType>::max()) : 
+                                                                              static_cast<uint64_t>(std::numeric_limits<IndexType>::max()) - 1;
+
+    if((normalIndex > 0) && (((normalIndex - 1) > maximumIndex) || ((normalIndex - 1) > static_cast<uint64_t>(std::numeric_limits<OBJIndex>::max()))))
+    {
+        return false;
+    }
+
+    for(auto chunk = chunkNormals.begin(); chunk != chunkNormals.end(); ++chunk)
+    {
+        state.appendNormals((*chunk));
+        std::vector<OBJVector3>().swap((*chunk));
+    }
+
+    //--------------------------------------------------------------------
+    // Pass 5: Point the faces at their normals
+    //--------------------------------------------------------------------
+
+    // Faces are written in runs, skipping the excluded faces (which keep their normals). The runs
+    // lie within the ranges checked in advance, and the normals were all appended above, so no run is rejected.
+
+    OBJParallelFor(ranges.size(), m_ThreadCount, [&](std::size_t const r)
+    {
+        FaceRange const& range = ranges[r];
+
+        std::vector<OBJCount> normals;
+        normals.reserve(range.count * 4);
+
+        std::size_t runFirst = 0;
+
+        for(std::size_t i = 0; i <= range.count; ++i)
+        {
+            if((i == range.count) || (faceKeys[range.base + i] == ExcludedFace))
+            {
+                if(!normals.empty())
+                {
+                    state.setFaceNormals(range.group, range.first + runFirst, normals.size() / 4, normals.data());
+                }
+
+                normals.clear();
+                runFirst = i + 1;
+
+                continue;
+            }
+
+            const std::size_t f = range.base + i;
+
+            OBJFace const& face = range.group->faces[range.first + i];
+            OBJVertexGroup const* corners[4] = { &face.group0, &face.group1, &face.group2, &face.group3 };
+            const uint32_t cornerCount = OBJStorage::Indices::isUsed(face.group3.indexSpatial) ? 4 : 3;
+
+            for(uint32_t c = 0; c < 4; ++c)
+            {
+                if(c < cornerCount)
+                {
+                    const std::size_t chunk = static_cast<std::size_t>(corners[c]->indexSpatial) / VerticesPerChunk;
+                    normals.push_back(static_cast<OBJCount>(chunkBases[chunk] + cornerNormals[(f * 4) + c]));
+                }
+                else
+                {
+                    normals.push_back(0);
+                }
+            }
+        }
+    });
+
+    return true;
+}
+
+//------------------------------------------------------------------------------------------
+// Protected Methods
+//------------------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------------------
+// Private Methods
+//------------------------------------------------------------------------------------------
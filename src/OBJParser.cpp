@@ -16,12 +16,15 @@
 
 #include "OBJParser.hpp"
 #include "OBJGrammar.hpp"
+#ifndef OBJ_PARSER_NO_MTL
 #include "MTLGrammar.hpp"
+#endif
 
 #ifdef OBJ_PARSER_USE_MEM_MAP
 #include <boost/iostreams/device/mapped_file.hpp>
 #endif
 
+#include <algorithm>
 #include <fstream>
 
 //------------------------------------------------------------------------------------------
@@ -34,6 +37,13 @@ OBJParser::OBJParser()
 
 }
 
+OBJParser::OBJParser(OBJArena* arena)
+    : m_OBJState(arena),
+      m_LastError("No Error")
+{
+
+}
+
 OBJParser::~OBJParser()
 {
 
@@ -55,6 +65,11 @@ OBJParser::Result OBJParser::parseOBJFile(std::string const& path)
     result = parseOBJFilefstream(path);
 #endif
 
+    if(result == OBJParser::Result::Success)
+    {
+        m_OBJState.finalize();
+    }
+
     return result;
 }
 
@@ -113,13 +128,17 @@ OBJParser::Result OBJParser::parseOBJFilefstream(std::string const& path)
                 if(first != last)
                 {
                     result = OBJParser::Result::FailedOBJParseError;
-                    m_LastError = "Failed to parse line '" + extractLastLine(stream) + "' in file '" + path + "'";
+                    uint64_t offset = 0;
+                    const std::string line = extractLastLine(stream, offset);
+                    m_LastError = buildParseError(line, offset, path);
                 }
             }
             else
             {
                 result = OBJParser::Result::FailedOBJParseError;
-                m_LastError = "Failed to parse line '" + extractLastLine(stream) + "' in file '" + path + "'";
+                uint64_t offset = 0;
+                const std::string line = extractLastLine(stream, offset);
+                m_LastError = buildParseError(line, offset, path);
             }
 
             stream.close();
@@ -134,13 +153,14 @@ OBJParser::Result OBJParser::parseOBJFilefstream(std::string const& path)
         // Parse the MTL file (if any specified)
         //--------------------------------------------------------------------
 
+#ifndef OBJ_PARSER_NO_MTL
         if(result == OBJParser::Result::Success)
         {
             auto materialLibraries = m_OBJState.getMaterialLibraries();
 
-            for(auto mtlPath : *materialLibraries)
+            for(auto const& mtlPath : *materialLibraries)
             {
-                result = parseMTLFilefstream(buildRelativeMTLPath(path, mtlPath));
+                result = parseMTLFilefstream(buildRelativeMTLPath(path, std::string(mtlPath.data(), mtlPath.size())));
 
                 if(result != OBJParser::Result::Success)
                 {
@@ -148,7 +168,10 @@ OBJParser::Result OBJParser::parseOBJFilefstream(std::string const& path)
                 }
             }
         }
+#endif
     }
+#else
+    (void)path;
 #endif
 
     return result;
@@ -158,7 +181,7 @@ OBJParser::Result OBJParser::parseMTLFilefstream(std::string const& path)
 {
     OBJParser::Result result = OBJParser::Result::Success;
 
-#ifndef OBJ_PARSER_USE_MEM_MAP
+#if !defined(OBJ_PARSER_USE_MEM_MAP) && !defined(OBJ_PARSER_NO_MTL)
 
     std::ifstream stream;
     
@@ -195,13 +218,17 @@ OBJParser::Result OBJParser::parseMTLFilefstream(std::string const& path)
                 else
                 {
                     result = OBJParser::Result::FailedOBJParseError;
-                    m_LastError = "Failed to parse line '" + extractLastLine(stream) + "' in file '" + path + "'";
+                    uint64_t offset = 0;
+                    const std::string line = extractLastLine(stream, offset);
+                    m_LastError = buildParseError(line, offset, path);
                 }
             }
             else
             {
                 result = OBJParser::Result::FailedOBJParseError;
-                m_LastError = "Failed to parse line '" + extractLastLine(stream) + "' in file '" + path + "'";
+                uint64_t offset = 0;
+                const std::string line = extractLastLine(stream, offset);
+                m_LastError = buildParseError(line, offset, path);
             }
 
             stream.close();
@@ -212,6 +239,8 @@ OBJParser::Result OBJParser::parseMTLFilefstream(std::string const& path)
             m_LastError = "Failed to open file '" + path + "'";
         }
     }
+#else
+    (void)path;
 #endif
 
     return result;
@@ -247,7 +276,6 @@ OBJParser::Result OBJParser::parseOBJFileMemMap(std::string const& path)
             auto first = mappedFile.const_data();
             auto last = first + mappedFile.size();
 
-            using Iterator = decltype(first);
             OBJGrammar grammar(&m_OBJState);
             OBJGrammarSkipper skipper;
 
@@ -256,13 +284,17 @@ OBJParser::Result OBJParser::parseOBJFileMemMap(std::string const& path)
                 if(first != last)
                 {
                     result = OBJParser::Result::FailedOBJParseError;
-                    m_LastError = "Failed to parse line '" + extractLastLine(first) + "' in file '" + path + "'";
+                    uint64_t offset = 0;
+                    const std::string line = extractLastLine(mappedFile.const_data(), first, last, offset);
+                    m_LastError = buildParseError(line, offset, path);
                 }
             }
             else
             {
                 result = OBJParser::Result::FailedOBJParseError;
-                m_LastError = "Failed to parse line '" + extractLastLine(first) + "' in file '" + path + "'";
+                uint64_t offset = 0;
+                const std::string line = extractLastLine(mappedFile.const_data(), first, last, offset);
+                m_LastError = buildParseError(line, offset, path);
             }
 
             mappedFile.close();
@@ -277,13 +309,14 @@ OBJParser::Result OBJParser::parseOBJFileMemMap(std::string const& path)
         // Parse the MTL file (if any specified)
         //--------------------------------------------------------------------
 
+#ifndef OBJ_PARSER_NO_MTL
         if(result == OBJParser::Result::Success)
         {
             auto materialLibraries = m_OBJState.getMaterialLibraries();
 
-            for(auto mtlPath : *materialLibraries)
+            for(auto const& mtlPath : *materialLibraries)
             {
-                result = parseMTLFileMemMap(buildRelativeMTLPath(path, mtlPath));
+                result = parseMTLFileMemMap(buildRelativeMTLPath(path, std::string(mtlPath.data(), mtlPath.size())));
 
                 if(result != OBJParser::Result::Success)
                 {
@@ -291,7 +324,10 @@ OBJParser::Result OBJParser::parseOBJFileMemMap(std::string const& path)
                 }
             }
         }
+#endif
     }
+#else
+    (void)path;
 #endif
 
     return result;
@@ -301,7 +337,7 @@ OBJParser::Result OBJParser::parseMTLFileMemMap(std::string const& path)
 {
     OBJParser::Result result = OBJParser::Result::Success;
 
-#ifdef OBJ_PARSER_USE_MEM_MAP
+#if defined(OBJ_PARSER_USE_MEM_MAP) && !defined(OBJ_PARSER_NO_MTL)
 
     boost::iostreams::mapped_file mappedFile;
 
@@ -334,13 +370,17 @@ OBJParser::Result OBJParser::parseMTLFileMemMap(std::string const& path)
                 else
                 {
                     result = OBJParser::Result::FailedOBJParseError;
-                    m_LastError = "Failed to parse line '" + extractLastLine(first) + "' in file '" + path + "'";
+                    uint64_t offset = 0;
+                    const std::string line = extractLastLine(mappedFile.const_data(), first, last, offset);
+                    m_LastError = buildParseError(line, offset, path);
                 }
             }
             else
             {
                 result = OBJParser::Result::FailedOBJParseError;
-                m_LastError = "Failed to parse line '" + extractLastLine(first) + "' in file '" + path + "'";
+                uint64_t offset = 0;
+                const std::string line = extractLastLine(mappedFile.const_data(), first, last, offset);
+                m_LastError = buildParseError(line, offset, path);
             }
 
             mappedFile.close();
@@ -352,6 +392,8 @@ OBJParser::Result OBJParser::parseMTLFileMemMap(std::string const& path)
         }
     }
 
+#else
+    (void)path;
 #endif
 
     return result;
@@ -385,44 +427,65 @@ std::string OBJParser::buildRelativeMTLPath(std::string const& objPath, std::str
     return result;
 }
 
-std::string OBJParser::extractLastLine(const char* str)
+std::string OBJParser::extractLastLine(const char* start, const char* current, const char* last, uint64_t& offset)
 {
-    // Extract the next line and remove any pesky carriage returns
+    // Step back to the last newline (or file start), as the stream version does, and extract the
+    // line from there, removing any pesky carriage returns. The mapped file is not null-terminated, 
+    // so the search is bounded by the end of the file.
 
-    std::string result = str;
-    auto find = result.find_first_of('\n');
-
-    if(find != std::string::npos)
+    while((current > start) && (*(current - 1) != '\n'))
     {
-        result = result.substr(0, find);
-        result.erase(std::remove(result.begin(), result.end(), '\r'), result.end());
+        --current;
     }
 
+    offset = static_cast<uint64_t>(current - start);
+
+    const char* end = std::find(current, last, '\n');
+
+    std::string result(current, end);
+    result.erase(std::remove(result.begin(), result.end(), '\r'), result.end());
+
     return result;
 }
 
-std::string OBJParser::extractLastLine(std::ifstream& stream)
+std::string OBJParser::extractLastLine(std::ifstream& stream, uint64_t& offset)
 {
     // Seek backwards to the last newline (or file start) and then read in the following line
 
     std::string result;
+    offset = 0;
 
-    const uint32_t start = static_cast<uint32_t>(stream.tellg());
-    uint32_t current = start;
+    stream.clear();     // The parse may have left the stream at eof
 
-    char c = ' ';
+    std::streamoff current = static_cast<std::streamoff>(stream.tellg());
 
-    while((current > 0) && (c != '\n'))
+    if(current >= 0)
     {
-        stream.seekg(--current, stream.beg);
-        stream.get(c);
-    }
+        char c = ' ';
+
+        while((current > 0) && (c != '\n'))
+        {
+            stream.seekg(--current, stream.beg);
+            stream.get(c);
+        }
+
+        if(c != '\n')
+        {
+            stream.seekg(0, stream.beg);    // Reached the start of the file
+        }
 
-    std::getline(stream, result);
+        offset = static_cast<uint64_t>(stream.tellg());
+        std::getline(stream, result);
+    }
     
     return result;
 }
 
+std::string OBJParser::buildParseError(std::string const& line, uint64_t const offset, std::string const& path) const
+{
+    return "Failed to parse line '" + line + "' at byte offset " + std::to_string(offset) + " in file '" + path + "'";
+}
+
 //------------------------------------------------------------------------------------------
 // Private Methods
 //------------------------------------------------------------------------------------------
\ No newline at end of file
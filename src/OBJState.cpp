@@ -16,6 +16,162 @@
 
 #include "OBJState.hpp"
 
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <tuple>
+#include <utility>
+
+namespace
+{
+    const std::size_t EncodingBatchSize = 256;      ///< Number of normals/texture coordinates encoded at once
+
+    /**
+     * Clears a container, retaining its storage unless it exceeds the provided limit (in bytes).
+     */
+    template<typename T>
+    void ClearContainer(T& container, std::size_t const limit)
+    {
+        if((limit > 0) && ((container.capacity() * sizeof(typename T::value_type)) > limit))
+        {
+            OBJReleaseContainer(container);
+        }
+        else
+        {
+            container.clear();
+        }
+    }
+
+    std::size_t AlignSize(std::size_t const size, std::size_t const alignment)
+    {
+        return ((size + (alignment - 1)) / alignment) * alignment;
+    }
+
+    /**
+     * Returns the size of the contents of a vector, rounded up to the provided alignment.
+     */
+    template<typename T>
+    std::size_t AlignedBytes(T const& container, std::size_t const alignment)
+    {
+        return AlignSize(container.size() * sizeof(typename T::value_type), alignment);
+    }
+
+    /**
+     * Copies the contents of a vector to the provided memory, returning the (typed) destination.
+     */
+    template<typename T>
+    typename T::value_type const* CopyElements(T const& container, char* destination)
+    {
+        if(!container.empty())
+        {
+            std::memcpy(destination, container.data(), container.size() * sizeof(typename T::value_type));
+        }
+
+        return reinterpret_cast<typename T::value_type const*>(destination);
+    }
+
+    /**
+     * Returns the requested element count, clamped so that it does not exceed the provided limit (in bytes).
+     */
+    template<typename T>
+    std::size_t ClampReserve(std::size_t const count, std::size_t const limit)
+    {
+        return (limit > 0) ? std::min(count, limit / sizeof(T)) : count;
+    }
+
+    /**
+     * Converts a parsed (1-based, possibly relative) index to a 0-based index of the storage policy.
+     * An absent index (0) becomes the unused index.
+     *
+     * Returns false if the index type of the storage policy can not hold the resolved index.
+     */
+    bool ResolveIndex(OBJIndex const index, std::size_t const count, OBJStorage::IndexType& result)
+    {
+        const OBJIndex resolved = (index < 0) ? (index + static_cast<OBJIndex>(count)) : (index - 1);
+        result = OBJStorage::Indices::fromResolved(resolved);
+
+        return OBJStorage::Indices::isRepresentable(resolved);
+    }
+
+    template<typename T>
+    T ConvertSpatial(OBJParsedSpatialVector const& vector);
+
+    template<>
+    OBJSpatialVector3 ConvertSpatial<OBJSpatialVector3>(OBJParsedSpatialVector const& vector)
+    {
+        OBJSpatialVector3 result;
+
+        result.x = OBJStorage::Scalars::fromParsed(vector.x);
+        result.y = OBJStorage::Scalars::fromParsed(vector.y);
+        result.z = OBJStorage::Scalars::fromParsed(vector.z);
+
+        return result;
+    }
+
+    template<>
+    OBJSpatialVector4 ConvertSpatial<OBJSpatialVector4>(OBJParsedSpatialVector const& vector)
+    {
+        OBJSpatialVector4 result;
+
+        result.x = OBJStorage::Scalars::fromParsed(vector.x);
+        result.y = OBJStorage::Scalars::fromParsed(vector.y);
+        result.z = OBJStorage::Scalars::fromParsed(vector.z);
+        result.w = OBJStorage::Scalars::fromParsed(vector.w);
+
+        return result;
+    }
+
+    /**
+     * Expands the provided bounds to contain every position in the container. 
+     * Works for both the packed (OBJSpatialVector3) and full (OBJSpatialVector4) spatial streams.
+     */
+    template<typename T>
+    void ExpandBounds(OBJSegmentedVector<T> const& positions, OBJVector3& minimum, OBJVector3& maximum)
+    {
+        for(std::size_t block = 0; block < positions.getBlockCount(); ++block)
+        {
+            std::size_t blockCount = 0;
+            T const* vertices = positions.getBlock(block, blockCount);
+
+            for(std::size_t i = 0; i < blockCount; ++i)
+            {
+                const float x = OBJStorage::Scalars::toFloat(vertices[i].x);
+                const float y = OBJStorage::Scalars::toFloat(vertices[i].y);
+                const float z = OBJStorage::Scalars::toFloat(vertices[i].z);
+
+                minimum.x = std::min(minimum.x, x);
+                minimum.y = std::min(minimum.y, y);
+                minimum.z = std::min(minimum.z, z);
+
+                maximum.x = std::max(maximum.x, x);
+                maximum.y = std::max(maximum.y, y);
+                maximum.z = std::max(maximum.z, z);
+            }
+        }
+    }
+
+    template<typename T>
+    void QuantizePositions(OBJSegmentedVector<T> const& positions, OBJVector3 const& minimum, OBJVector3 const& scale, OBJSegmentedVector<OBJQuantizedVector3>& result)
+    {
+        OBJQuantizedVector3 quantized;
+
+        for(std::size_t block = 0; block < positions.getBlockCount(); ++block)
+        {
+            std::size_t blockCount = 0;
+            T const* vertices = positions.getBlock(block, blockCount);
+
+            for(std::size_t i = 0; i < blockCount; ++i)
+            {
+                quantized.x = static_cast<uint16_t>(((OBJStorage::Scalars::toFloat(vertices[i].x) - minimum.x) * scale.x) + 0.5f);
+                quantized.y = static_cast<uint16_t>(((OBJStorage::Scalars::toFloat(vertices[i].y) - minimum.y) * scale.y) + 0.5f);
+                quantized.z = static_cast<uint16_t>(((OBJStorage::Scalars::toFloat(vertices[i].z) - minimum.z) * scale.z) + 0.5f);
+
+                result.push_back(quantized);
+            }
+        }
+    }
+}
+
 //------------------------------------------------------------------------------------------
 // Constructors
 //------------------------------------------------------------------------------------------
@@ -23,46 +179,363 @@
 OBJState::OBJState()
     : m_GroupFacesReservedSize(0),
       m_GroupFreeFormReservedSize(0),
-      m_FreeFormRational(false)
+      m_FreeFormRational(false),
+      m_pArena(nullptr),
+      m_SpatialHasW(false),
+      m_SpatialQuantizationBits(0),
+      m_NormalEncoding(OBJNormalEncoding::Float),
+      m_RequestedNormalEncoding(OBJNormalEncoding::Float),
+      m_TextureEncoding(OBJTextureEncoding::Float),
+      m_RequestedTextureEncoding(OBJTextureEncoding::Float),
+      m_CurrentRenderState(0),
+      m_StatisticsHistorySize(8),
+      m_StatisticsHistoryNext(0),
+      m_RetainedCapacityLimit(0),
+      m_GroupFacesAdaptiveSize(0)
+{
+
+}
+
+OBJState::OBJState(OBJArena* arena)
+    : m_GroupFacesReservedSize(0),
+      m_GroupFreeFormReservedSize(0),
+      m_FreeFormState(arena),
+      m_FreeFormRational(false),
+      m_pArena(arena),
+      m_GroupMap(0, GroupMap::hasher(), GroupMap::key_equal(), GroupMap::allocator_type(arena)),
+      m_MaterialMap(0, MaterialMap::hasher(), MaterialMap::key_equal(), MaterialMap::allocator_type(arena)),
+      m_VertexSpatialData(OBJSegmentedVector<OBJSpatialVector4>::allocator_type(arena)),
+      m_PackedSpatialData(OBJSegmentedVector<OBJSpatialVector3>::allocator_type(arena)),
+      m_SpatialHasW(false),
+      m_VertexTextureData(OBJSegmentedVector<OBJVector2>::allocator_type(arena)),
+      m_VertexNormalData(OBJSegmentedVector<OBJVector3>::allocator_type(arena)),
+      m_QuantizedSpatialData(OBJSegmentedVector<OBJQuantizedVector3>::allocator_type(arena)),
+      m_SpatialQuantizationBits(0),
+      m_EncodedNormalData(OBJSegmentedVector<OBJOctahedralNormal>::allocator_type(arena)),
+      m_EncodedTextureData(OBJSegmentedVector<OBJPackedVector2>::allocator_type(arena)),
+      m_NormalEncoding(OBJNormalEncoding::Float),
+      m_RequestedNormalEncoding(OBJNormalEncoding::Float),
+      m_TextureEncoding(OBJTextureEncoding::Float),
+      m_RequestedTextureEncoding(OBJTextureEncoding::Float),
+      m_MaterialLibraries(OBJArenaAllocator<OBJArenaString>(arena)),
+      m_TextureMapLibraries(OBJArenaAllocator<OBJArenaString>(arena)),
+      m_RenderStates(OBJArenaAllocator<OBJRenderState>(arena)),
+      m_RenderStateMap(0, RenderStateMap::hasher(), RenderStateMap::key_equal(), RenderStateMap::allocator_type(arena)),
+      m_CurrentRenderState(0),
+      m_StatisticsHistorySize(8),
+      m_StatisticsHistoryNext(0),
+      m_RetainedCapacityLimit(0),
+      m_GroupFacesAdaptiveSize(0)
 {
 
 }
 
 OBJState::~OBJState()
 {
-    clearState();
+
+}
+
+OBJFlattenedGroup::OBJFlattenedGroup()
+    : group(nullptr),
+      faces(nullptr),
+      faceCount(0),
+      renderStateRanges(nullptr),
+      renderStateRangeCount(0),
+      lineVertices(nullptr),
+      lineVertexCount(0),
+      lineOffsets(nullptr),
+      lineCount(0),
+      pointVertices(nullptr),
+      pointVertexCount(0),
+      pointOffsets(nullptr),
+      pointCollectionCount(0)
+{
+
+}
+
+OBJFlattenedData::OBJFlattenedData()
+    : homogeneousSpatialData(nullptr),
+      spatialCount(0),
+      packedSpatialData(nullptr),
+      textureData(nullptr),
+      textureCount(0),
+      normalData(nullptr),
+      normalCount(0),
+      encodedNormalData(nullptr),
+      encodedTextureData(nullptr),
+      textureEncoding(OBJTextureEncoding::Float),
+      quantizedSpatialData(nullptr)
+{
+
+}
+
+OBJSnapshot::OBJSnapshot()
+{
+
+}
+
+OBJSnapshot::~OBJSnapshot()
+{
+
+}
+
+OBJStateResult::OBJStateResult()
+    : spatialHasW(false),
+      normalEncoding(OBJNormalEncoding::Float),
+      textureEncoding(OBJTextureEncoding::Float)
+{
+
+}
+
+OBJStateResult::~OBJStateResult()
+{
+
+}
+
+OBJStateStatistics::OBJStateStatistics()
+    : spatialCount(0),
+      textureCount(0),
+      normalCount(0),
+      faceCount(0),
+      groupCount(0),
+      renderStateCount(0)
+{
+
 }
 
 //------------------------------------------------------------------------------------------
 // Public Methods
 //------------------------------------------------------------------------------------------
 
+OBJFlattenedData const& OBJSnapshot::getData() const
+{
+    return m_Data;
+}
+
+uint32_t OBJSnapshot::getGroupCount() const
+{
+    return static_cast<uint32_t>(m_Data.groups.size());
+}
+
+OBJFlattenedGroup const& OBJSnapshot::getGroup(uint32_t const index) const
+{
+    return m_Data.groups[index];
+}
+
+std::string const& OBJSnapshot::getGroupName(uint32_t const index) const
+{
+    return m_GroupNames[index];
+}
+
+uint32_t OBJSnapshot::getRenderStateCount() const
+{
+    return static_cast<uint32_t>(m_RenderStates.size());
+}
+
+OBJRenderState const& OBJSnapshot::getRenderState(uint32_t const index) const
+{
+    return m_RenderStates[index];
+}
+
+std::vector<OBJMaterial> const& OBJSnapshot::getMaterials() const
+{
+    return m_Materials;
+}
+
+OBJTextureDescriptor const& OBJSnapshot::getTextureDescriptor(OBJTextureId const id) const
+{
+    return m_TextureTable.get(id);
+}
+
+std::vector<std::string> const& OBJSnapshot::getMaterialLibraries() const
+{
+    return m_MaterialLibraries;
+}
+
+std::vector<std::string> const& OBJSnapshot::getTextureMapLibraries() const
+{
+    return m_TextureMapLibraries;
+}
+
+void OBJStateResult::swap(OBJStateResult& other)
+{
+    homogeneousSpatialData.swap(other.homogeneousSpatialData);
+    packedSpatialData.swap(other.packedSpatialData);
+    std::swap(spatialHasW, other.spatialHasW);
+
+    quantizedSpatialData.swap(other.quantizedSpatialData);
+    std::swap(spatialQuantization, other.spatialQuantization);
+
+    textureData.swap(other.textureData);
+    normalData.swap(other.normalData);
+
+    encodedNormalData.swap(other.encodedNormalData);
+    encodedTextureData.swap(other.encodedTextureData);
+    std::swap(normalEncoding, other.normalEncoding);
+    std::swap(textureEncoding, other.textureEncoding);
+    std::swap(encodingReport, other.encodingReport);
+
+    groups.swap(other.groups);
+    materials.swap(other.materials);
+    textureTable.swap(other.textureTable);
+    renderStates.swap(other.renderStates);
+    freeFormState.swap(other.freeFormState);
+
+    materialLibraries.swap(other.materialLibraries);
+    textureMapLibraries.swap(other.textureMapLibraries);
+}
+
+void OBJStateResult::getGroups(std::vector<OBJGroup const*>& result) const
+{
+    result.clear();
+    result.reserve(groups.size());
+
+    for(auto iter = groups.begin(); iter != groups.end(); ++iter)
+    {
+        result.emplace_back(&(*iter).second);
+    }
+}
+
+void OBJStateResult::getMaterials(std::vector<OBJMaterial const*>& result) const
+{
+    result.clear();
+    result.reserve(materials.size());
+
+    for(auto iter = materials.begin(); iter != materials.end(); ++iter)
+    {
+        result.push_back(&(*iter).second);
+    }
+}
+
 void OBJState::clearState()
 {
-    m_VertexSpatialData.clear();
-    m_VertexTextureData.clear();
-    m_VertexNormalData.clear();
-    m_FreeFormState.vertexParameterData.clear();
+    recordStatistics();
 
     m_ActiveGroups.clear();
-    m_GroupMap.clear();
-    m_MaterialMap.clear();
-    m_MaterialLibraries.clear();
-    m_TextureMapLibraries.clear();
+    m_TextureTable.clear();
+
+    if(m_pArena)
+    {
+        // Everything held by these containers, strings included, was allocated from the arena.
+        // So rather than destroying (and freeing) them, they are simply forgotten and reset with it.
+
+        OBJAbandonContainer(m_VertexSpatialData);
+        OBJAbandonContainer(m_PackedSpatialData);
+        OBJAbandonContainer(m_VertexTextureData);
+        OBJAbandonContainer(m_VertexNormalData);
+        OBJAbandonContainer(m_QuantizedSpatialData);
+        OBJAbandonContainer(m_EncodedNormalData);
+        OBJAbandonContainer(m_EncodedTextureData);
+        m_FreeFormState.abandon();
+
+        OBJAbandonContainer(m_GroupMap);
+        OBJAbandonContainer(m_MaterialMap);
+        OBJAbandonContainer(m_RenderStates);
+        OBJAbandonContainer(m_RenderStateMap);
+        OBJAbandonContainer(m_MaterialLibraries);
+        OBJAbandonContainer(m_TextureMapLibraries);
+
+        m_pArena->reset();
+    }
+    else
+    {
+        m_MaterialLibraries.clear();
+        m_TextureMapLibraries.clear();
+
+        ClearContainer(m_VertexSpatialData, m_RetainedCapacityLimit);
+        ClearContainer(m_PackedSpatialData, m_RetainedCapacityLimit);
+        ClearContainer(m_VertexTextureData, m_RetainedCapacityLimit);
+        ClearContainer(m_VertexNormalData, m_RetainedCapacityLimit);
+        ClearContainer(m_QuantizedSpatialData, m_RetainedCapacityLimit);
+        ClearContainer(m_EncodedNormalData, m_RetainedCapacityLimit);
+        ClearContainer(m_EncodedTextureData, m_RetainedCapacityLimit);
+        m_FreeFormState.clear();
+
+        recycleGroups();
+        m_MaterialMap.clear();
+    }
+
+    m_SpatialQuantization = OBJQuantization();
+    m_SpatialHasW = false;
+
+    m_NormalStaging.clear();
+    m_TextureStaging.clear();
+    m_NormalStaging.reserve(EncodingBatchSize);
+    m_TextureStaging.reserve(EncodingBatchSize);
+
+    m_NormalEncoding = m_RequestedNormalEncoding;
+    m_TextureEncoding = m_RequestedTextureEncoding;
+    m_EncodingReport = OBJEncodingReport();
 
     resetAuxiliaryStates();
+    reserveFromStatistics();
+}
+
+OBJArena* OBJState::getArena() const
+{
+    return m_pArena;
 }
 
-void OBJState::reserve(uint32_t const spatial, uint32_t const texture, uint32_t const normal, uint32_t const groupIndices, uint32_t const groupFreeForms)
+void OBJState::finalize()
 {
-    m_VertexSpatialData.reserve(static_cast<std::vector<OBJVector3>::size_type>(spatial));
-    m_VertexTextureData.reserve(static_cast<std::vector<OBJVector3>::size_type>(texture));
-    m_VertexNormalData.reserve(static_cast<std::vector<OBJVector3>::size_type>(normal));
+    flushNormalStaging();
+    flushTextureStaging();
+
+    if((m_SpatialQuantizationBits > 0) && (m_SpatialQuantization.bits == 0))
+    {
+        quantizeSpatialData();
+    }
+}
+
+void OBJState::setSpatialQuantization(uint32_t const bits)
+{
+    m_SpatialQuantizationBits = std::min(bits, static_cast<uint32_t>(16));
+}
+
+void OBJState::reserve(OBJCount const spatial, OBJCount const texture, OBJCount const normal, uint32_t const groupIndices, uint32_t const groupFreeForms)
+{
+    m_PackedSpatialData.reserve(static_cast<OBJSegmentedVector<OBJSpatialVector3>::size_type>(spatial));
+    m_VertexTextureData.reserve(static_cast<OBJSegmentedVector<OBJVector2>::size_type>(texture));
+    m_VertexNormalData.reserve(static_cast<OBJSegmentedVector<OBJVector3>::size_type>(normal));
 
     m_GroupFacesReservedSize = groupIndices;
     m_GroupFreeFormReservedSize = groupFreeForms;
 }
 
+void OBJState::setReserveHistorySize(uint32_t const size)
+{
+    m_StatisticsHistorySize = size;
+
+    if(m_StatisticsHistory.size() > size)
+    {
+        m_StatisticsHistory.resize(size);
+        m_StatisticsHistoryNext = 0;
+    }
+}
+
+void OBJState::setRetainedCapacityLimit(std::size_t const bytes)
+{
+    m_RetainedCapacityLimit = bytes;
+}
+
+OBJStateStatistics OBJState::getStatistics() const
+{
+    OBJStateStatistics result;
+
+    result.spatialCount = getSpatialCount();
+    result.textureCount = getTextureCount();
+    result.normalCount = getNormalCount();
+    result.groupCount = static_cast<uint32_t>(m_GroupMap.size());
+    result.renderStateCount = static_cast<uint32_t>(m_RenderStates.size());
+
+    for(auto iter = m_GroupMap.begin(); iter != m_GroupMap.end(); ++iter)
+    {
+        result.faceCount += static_cast<OBJCount>((*iter).second.faces.size());
+    }
+
+    return result;
+}
+
 OBJFreeFormState* OBJState::getFreeFormState()
 {
     return &m_FreeFormState;
@@ -72,54 +545,502 @@ OBJRenderState OBJState::getRenderState(uint32_t index) const
 {
     OBJRenderState result;
 
-    if(index < m_RenderStates.size())
+    if(index < m_RenderStates.size())
+    {
+        result = m_RenderStates[index];
+    }
+
+    return result;
+}
+
+uint32_t OBJState::getRenderStateCount() const
+{
+    return static_cast<uint32_t>(m_RenderStates.size());
+}
+
+void OBJState::getGroups(std::vector<OBJGroup const*>& groups) const
+{
+    groups.clear();
+    groups.reserve(m_GroupMap.size());
+
+    for(auto iter = m_GroupMap.begin(); iter != m_GroupMap.end(); ++iter)
+    {
+        groups.emplace_back(&(*iter).second);
+    }
+}
+
+OBJSegmentedVector<OBJSpatialVector4> const* OBJState::getHomogeneousSpatialData() const
+{
+    return &m_VertexSpatialData;
+}
+
+OBJSegmentedVector<OBJSpatialVector3> const* OBJState::getPackedSpatialData() const
+{
+    return &m_PackedSpatialData;
+}
+
+bool OBJState::hasSpatialW() const
+{
+    return m_SpatialHasW;
+}
+
+OBJSegmentedVector<OBJQuantizedVector3> const* OBJState::getQuantizedSpatialData() const
+{
+    return &m_QuantizedSpatialData;
+}
+
+OBJQuantization const& OBJState::getSpatialQuantization() const
+{
+    return m_SpatialQuantization;
+}
+
+OBJCount OBJState::getSpatialCount() const
+{
+    return static_cast<OBJCount>(m_QuantizedSpatialData.size() + m_PackedSpatialData.size() + m_VertexSpatialData.size());
+}
+
+OBJVector4 OBJState::getSpatial(OBJCount const index) const
+{
+    OBJVector4 result;
+
+    if(m_SpatialQuantization.bits > 0)
+    {
+        const OBJVector3 position = m_SpatialQuantization.dequantize(m_QuantizedSpatialData[index]);
+
+        result.x = position.x;
+        result.y = position.y;
+        result.z = position.z;
+        result.w = 1.0f;
+    }
+    else if(m_SpatialHasW)
+    {
+        OBJSpatialVector4 const& vertex = m_VertexSpatialData[index];
+
+        result.x = OBJStorage::Scalars::toFloat(vertex.x);
+        result.y = OBJStorage::Scalars::toFloat(vertex.y);
+        result.z = OBJStorage::Scalars::toFloat(vertex.z);
+        result.w = OBJStorage::Scalars::toFloat(vertex.w);
+    }
+    else
+    {
+        OBJSpatialVector3 const& position = m_PackedSpatialData[index];
+
+        result.x = OBJStorage::Scalars::toFloat(position.x);
+        result.y = OBJStorage::Scalars::toFloat(position.y);
+        result.z = OBJStorage::Scalars::toFloat(position.z);
+        result.w = 1.0f;
+    }
+
+    return result;
+}
+
+OBJSegmentedVector<OBJVector2> const* OBJState::getTextureData() const
+{
+    return &m_VertexTextureData;
+}
+
+OBJSegmentedVector<OBJVector3> const* OBJState::getNormalData() const
+{
+    return &m_VertexNormalData;
+}
+
+void OBJState::setNormalEncoding(OBJNormalEncoding const encoding)
+{
+    m_RequestedNormalEncoding = encoding;
+}
+
+void OBJState::setTextureEncoding(OBJTextureEncoding const encoding)
+{
+    m_RequestedTextureEncoding = encoding;
+}
+
+OBJNormalEncoding OBJState::getNormalEncoding() const
+{
+    return m_NormalEncoding;
+}
+
+OBJTextureEncoding OBJState::getTextureEncoding() const
+{
+    return m_TextureEncoding;
+}
+
+OBJSegmentedVector<OBJOctahedralNormal> const* OBJState::getEncodedNormalData() const
+{
+    return &m_EncodedNormalData;
+}
+
+OBJSegmentedVector<OBJPackedVector2> const* OBJState::getEncodedTextureData() const
+{
+    return &m_EncodedTextureData;
+}
+
+OBJEncodingReport const& OBJState::getEncodingReport() const
+{
+    return m_EncodingReport;
+}
+
+OBJCount OBJState::getNormalCount() const
+{
+    return static_cast<OBJCount>(m_VertexNormalData.size() + m_EncodedNormalData.size());
+}
+
+OBJCount OBJState::getTextureCount() const
+{
+    return static_cast<OBJCount>(m_VertexTextureData.size() + m_EncodedTextureData.size());
+}
+
+OBJVector3 OBJState::getNormal(OBJCount const index) const
+{
+    OBJVector3 result;
+
+    if(m_NormalEncoding == OBJNormalEncoding::Octahedral16)
+    {
+        result = OBJVertexEncoder::decodeNormal(m_EncodedNormalData[index]);
+    }
+    else
+    {
+        result = m_VertexNormalData[index];
+    }
+
+    return result;
+}
+
+void OBJState::appendNormals(std::vector<OBJVector3> const& normals)
+{
+    for(auto iter = normals.begin(); iter != normals.end(); ++iter)
+    {
+        addVertexNormal((*iter));
+    }
+
+    flushNormalStaging();
+}
+
+bool OBJState::hasFaces(OBJGroup const* group, std::size_t const first, std::size_t const count) const
+{
+    auto findGroup = (group ? m_GroupMap.find(group->name) : m_GroupMap.end());
+
+    return (findGroup != m_GroupMap.end()) && (&(*findGroup).second == group) && 
+           (first <= group->faces.size()) && (count <= (group->faces.size() - first));
+}
+
+bool OBJState::setFaceNormals(OBJGroup const* group, std::size_t const first, std::size_t const count, OBJCount const* normals)
+{
+    // The group map is only ever looked up (never inserted into) here, so concurrent calls are safe
+
+    if(!hasFaces(group, first, count))
+    {
+        return false;
+    }
+
+    OBJGroup& target = (*m_GroupMap.find(group->name)).second;
+
+    const OBJCount normalCount = getNormalCount();
+
+    for(std::size_t i = 0; i < count; ++i)
+    {
+        const uint32_t cornerCount = OBJStorage::Indices::isUsed(target.faces[first + i].group3.indexSpatial) ? 4 : 3;
+
+        for(uint32_t c = 0; c < cornerCount; ++c)
+        {
+            if(normals[(i * 4) + c] >= normalCount)
+            {
+                return false;
+            }
+        }
+    }
+
+    for(std::size_t i = 0; i < count; ++i)
+    {
+        OBJFace& face = target.faces[first + i];
+        OBJCount const* faceNormals = normals + (i * 4);
+
+        face.group0.indexNormal = OBJStorage::Indices::fromResolved(static_cast<OBJIndex>(faceNormals[0]));
+        face.group1.indexNormal = OBJStorage::Indices::fromResolved(static_cast<OBJIndex>(faceNormals[1]));
+        face.group2.indexNormal = OBJStorage::Indices::fromResolved(static_cast<OBJIndex>(faceNormals[2]));
+
+        if(OBJStorage::Indices::isUsed(face.group3.indexSpatial))
+        {
+            face.group3.indexNormal = OBJStorage::Indices::fromResolved(static_cast<OBJIndex>(faceNormals[3]));
+        }
+    }
+
+    return true;
+}
+
+OBJVector2 OBJState::getTexture(OBJCount const index) const
+{
+    OBJVector2 result;
+
+    if(m_TextureEncoding != OBJTextureEncoding::Float)
+    {
+        result = OBJVertexEncoder::decodeTexture(m_EncodedTextureData[index], m_TextureEncoding);
+    }
+    else
+    {
+        result = m_VertexTextureData[index];
+    }
+
+    return result;
+}
+
+OBJArenaVector<OBJArenaString> const* OBJState::getMaterialLibraries() const
+{
+    return &m_MaterialLibraries;
+}
+
+void OBJState::getMaterials(std::vector<OBJMaterial const*>& materials) const
+{
+    materials.clear();
+    materials.reserve(m_MaterialMap.size());
+
+    for(auto iter = m_MaterialMap.begin(); iter != m_MaterialMap.end(); ++iter)
+    {
+        materials.push_back(&(*iter).second);
+    }
+}
+
+OBJTextureDescriptor const& OBJState::getTextureDescriptor(OBJTextureId const id) const
+{
+    return m_TextureTable.get(id);
+}
+
+OBJTextureTable const* OBJState::getTextureTable() const
+{
+    return &m_TextureTable;
+}
+
+bool OBJState::flatten(OBJFlattenedData& result, bool const hugePages) const
+{
+    std::vector<OBJGroup const*> groups;
+    getGroups(groups);
+
+    // Lay out each stream on its own cache line
+
+    const std::size_t alignment = 64;
+    std::size_t size = 0;
+
+    const std::size_t spatialOffset = size;
+    size += AlignSize(m_VertexSpatialData.size() * sizeof(OBJSpatialVector4), alignment);
+
+    const std::size_t packedOffset = size;
+    size += AlignSize(m_PackedSpatialData.size() * sizeof(OBJSpatialVector3), alignment);
+
+    const std::size_t quantizedOffset = size;
+    size += AlignSize(m_QuantizedSpatialData.size() * sizeof(OBJQuantizedVector3), alignment);
+
+    const std::size_t textureOffset = size;
+    size += AlignSize(m_VertexTextureData.size() * sizeof(OBJVector2), alignment);
+
+    const std::size_t normalOffset = size;
+    size += AlignSize(m_VertexNormalData.size() * sizeof(OBJVector3), alignment);
+
+    const std::size_t encodedNormalOffset = size;
+    size += AlignSize(m_EncodedNormalData.size() * sizeof(OBJOctahedralNormal), alignment);
+
+    const std::size_t encodedTextureOffset = size;
+    size += AlignSize(m_EncodedTextureData.size() * sizeof(OBJPackedVector2), alignment);
+
+    const std::size_t facesOffset = size;
+
+    for(auto iter = groups.begin(); iter != groups.end(); ++iter)
+    {
+        size += AlignSize((*iter)->faces.size() * sizeof(OBJFace), alignment);
+    }
+
+    // Followed by the (much smaller) render state ranges, lines, and points of each group
+
+    const std::size_t elementsOffset = size;
+
+    for(auto iter = groups.begin(); iter != groups.end(); ++iter)
+    {
+        size += AlignedBytes((*iter)->renderStateRanges, alignment);
+        size += AlignedBytes((*iter)->lineVertices, alignment);
+        size += AlignedBytes((*iter)->lineOffsets, alignment);
+        size += AlignedBytes((*iter)->pointVertices, alignment);
+        size += AlignedBytes((*iter)->pointOffsets, alignment);
+    }
+
+    result.groups.clear();
+
+    if(!result.region.create(size, hugePages))
+    {
+        return false;
+    }
+
+    char* data = static_cast<char*>(result.region.getData());
+
+    m_VertexSpatialData.copyTo(reinterpret_cast<OBJSpatialVector4*>(data + spatialOffset));
+    m_PackedSpatialData.copyTo(reinterpret_cast<OBJSpatialVector3*>(data + packedOffset));
+    m_QuantizedSpatialData.copyTo(reinterpret_cast<OBJQuantizedVector3*>(data + quantizedOffset));
+    m_VertexTextureData.copyTo(reinterpret_cast<OBJVector2*>(data + textureOffset));
+    m_VertexNormalData.copyTo(reinterpret_cast<OBJVector3*>(data + normalOffset));
+    m_EncodedNormalData.copyTo(reinterpret_cast<OBJOctahedralNormal*>(data + encodedNormalOffset));
+    m_EncodedTextureData.copyTo(reinterpret_cast<OBJPackedVector2*>(data + encodedTextureOffset));
+
+    const bool quantized = (m_SpatialQuantization.bits > 0);
+
+    result.homogeneousSpatialData = (!quantized && m_SpatialHasW) ? reinterpret_cast<OBJSpatialVector4 const*>(data + spatialOffset) : nullptr;
+    result.packedSpatialData = (!quantized && !m_SpatialHasW) ? reinterpret_cast<OBJSpatialVector3 const*>(data + packedOffset) : nullptr;
+    result.quantizedSpatialData = quantized ? reinterpret_cast<OBJQuantizedVector3 const*>(data + quantizedOffset) : nullptr;
+    result.spatialQuantization = m_SpatialQuantization;
+    result.spatialCount = getSpatialCount();
+
+    const bool encodedTexture = (m_TextureEncoding != OBJTextureEncoding::Float);
+    const bool encodedNormal = (m_NormalEncoding != OBJNormalEncoding::Float);
+
+    result.textureData = encodedTexture ? nullptr : reinterpret_cast<OBJVector2 const*>(data + textureOffset);
+    result.encodedTextureData = encodedTexture ? reinterpret_cast<OBJPackedVector2 const*>(data + encodedTextureOffset) : nullptr;
+    result.textureEncoding = m_TextureEncoding;
+    result.textureCount = getTextureCount();
+
+    result.normalData = encodedNormal ? nullptr : reinterpret_cast<OBJVector3 const*>(data + normalOffset);
+    result.encodedNormalData = encodedNormal ? reinterpret_cast<OBJOctahedralNormal const*>(data + encodedNormalOffset) : nullptr;
+    result.normalCount = getNormalCount();
+
+    result.groups.reserve(groups.size());
+    std::size_t offset = facesOffset;
+    std::size_t elementOffset = elementsOffset;
+
+    for(auto iter = groups.begin(); iter != groups.end(); ++iter)
+    {
+        OBJGroup const* group = (*iter);
+        OBJFace* faces = reinterpret_cast<OBJFace*>(data + offset);
+        group->faces.copyTo(faces);
+
+        result.groups.push_back(OBJFlattenedGroup());
+        OBJFlattenedGroup& flattened = result.groups.back();
+
+        flattened.group = group;
+        flattened.faces = faces;
+        flattened.faceCount = static_cast<OBJCount>(group->faces.size());
+
+        offset += AlignSize(group->faces.size() * sizeof(OBJFace), alignment);
+
+        flattened.renderStateRanges = CopyElements(group->renderStateRanges, data + elementOffset);
+        flattened.renderStateRangeCount = static_cast<OBJCount>(group->renderStateRanges.size());
+        elementOffset += AlignedBytes(group->renderStateRanges, alignment);
+
+        flattened.lineVertices = CopyElements(group->lineVertices, data + elementOffset);
+        flattened.lineVertexCount = static_cast<OBJCount>(group->lineVertices.size());
+        elementOffset += AlignedBytes(group->lineVertices, alignment);
+
+        flattened.lineOffsets = CopyElements(group->lineOffsets, data + elementOffset);
+        flattened.lineCount = static_cast<OBJCount>(group->lineOffsets.size());
+        elementOffset += AlignedBytes(group->lineOffsets, alignment);
+
+        flattened.pointVertices = CopyElements(group->pointVertices, data + elementOffset);
+        flattened.pointVertexCount = static_cast<OBJCount>(group->pointVertices.size());
+        elementOffset += AlignedBytes(group->pointVertices, alignment);
+
+        flattened.pointOffsets = CopyElements(group->pointOffsets, data + elementOffset);
+        flattened.pointCollectionCount = static_cast<OBJCount>(group->pointOffsets.size());
+        elementOffset += AlignedBytes(group->pointOffsets, alignment);
+    }
+
+    return true;
+}
+
+std::shared_ptr<OBJSnapshot const> OBJState::freeze(bool const hugePages) const
+{
+    std::shared_ptr<OBJSnapshot> snapshot(new OBJSnapshot());
+
+    if(!flatten(snapshot->m_Data, hugePages))
+    {
+        return nullptr;
+    }
+
+    // The snapshot may outlive the groups, so only their names are kept
+
+    snapshot->m_GroupNames.reserve(snapshot->m_Data.groups.size());
+
+    for(auto iter = snapshot->m_Data.groups.begin(); iter != snapshot->m_Data.groups.end(); ++iter)
     {
-        result = m_RenderStates[index];
+        snapshot->m_GroupNames.emplace_back((*iter).group->name.data(), (*iter).group->name.size());
+        (*iter).group = nullptr;
     }
 
-    return result;
-}
+    // Assigning from a range (rather than appending) sizes each container exactly.
+    // The copied render states allocate their strings from the heap rather than the arena.
 
-void OBJState::getGroups(std::vector<OBJGroup const*>& groups) const
-{
-    groups.clear();
-    groups.reserve(m_GroupMap.size());
+    snapshot->m_RenderStates.assign(m_RenderStates.begin(), m_RenderStates.end());
 
-    for(auto iter = m_GroupMap.begin(); iter != m_GroupMap.end(); ++iter)
+    snapshot->m_MaterialLibraries.reserve(m_MaterialLibraries.size());
+    snapshot->m_TextureMapLibraries.reserve(m_TextureMapLibraries.size());
+
+    for(auto iter = m_MaterialLibraries.begin(); iter != m_MaterialLibraries.end(); ++iter)
     {
-        groups.emplace_back(&(*iter).second);
+        snapshot->m_MaterialLibraries.emplace_back((*iter).data(), (*iter).size());
     }
-}
 
-std::vector<OBJVector4> const* OBJState::getSpatialData() const
-{
-    return &m_VertexSpatialData;
-}
+    for(auto iter = m_TextureMapLibraries.begin(); iter != m_TextureMapLibraries.end(); ++iter)
+    {
+        snapshot->m_TextureMapLibraries.emplace_back((*iter).data(), (*iter).size());
+    }
 
-std::vector<OBJVector2> const* OBJState::getTextureData() const
-{
-    return &m_VertexTextureData;
-}
+    snapshot->m_Materials.reserve(m_MaterialMap.size());
 
-std::vector<OBJVector3> const* OBJState::getNormalData() const
-{
-    return &m_VertexNormalData;
-}
+    for(auto iter = m_MaterialMap.begin(); iter != m_MaterialMap.end(); ++iter)
+    {
+        snapshot->m_Materials.push_back((*iter).second);
+    }
 
-std::vector<std::string> const* OBJState::getMaterialLibraries() const
-{
-    return &m_MaterialLibraries;
+    snapshot->m_TextureTable = m_TextureTable;
+
+    snapshot->m_Data.region.protect();
+
+    return snapshot;
 }
 
-void OBJState::getMaterials(std::vector<OBJMaterial const*>& materials) const
+bool OBJState::takeResult(OBJStateResult& result)
 {
-    materials.clear();
-    materials.reserve(m_MaterialMap.size());
-
-    for(auto iter = m_MaterialMap.begin(); iter != m_MaterialMap.end(); ++iter)
+    if(m_pArena)
     {
-        materials.push_back(&(*iter).second);
+        return false;
     }
+
+    // Encode anything still staged, and record the statistics now as the state will be empty upon the clear
+
+    flushNormalStaging();
+    flushTextureStaging();
+    recordStatistics();
+
+    // Every container is swapped with an empty one, so no elements are copied.
+    // The previous contents of result are freed when taken goes out of scope.
+
+    OBJStateResult taken;
+
+    taken.homogeneousSpatialData.swap(m_VertexSpatialData);
+    taken.packedSpatialData.swap(m_PackedSpatialData);
+    taken.spatialHasW = m_SpatialHasW;
+
+    taken.quantizedSpatialData.swap(m_QuantizedSpatialData);
+    taken.spatialQuantization = m_SpatialQuantization;
+
+    taken.textureData.swap(m_VertexTextureData);
+    taken.normalData.swap(m_VertexNormalData);
+
+    taken.encodedNormalData.swap(m_EncodedNormalData);
+    taken.encodedTextureData.swap(m_EncodedTextureData);
+    taken.normalEncoding = m_NormalEncoding;
+    taken.textureEncoding = m_TextureEncoding;
+    taken.encodingReport = m_EncodingReport;
+
+    taken.groups.swap(m_GroupMap);
+    taken.materials.swap(m_MaterialMap);
+    taken.textureTable.swap(m_TextureTable);
+    taken.renderStates.swap(m_RenderStates);
+    taken.freeFormState.swap(m_FreeFormState);
+
+    taken.materialLibraries.swap(m_MaterialLibraries);
+    taken.textureMapLibraries.swap(m_TextureMapLibraries);
+
+    result.swap(taken);
+
+    // Active group pointers refer to the groups just moved out, and are dropped by the clear
+
+    clearState();
+
+    return true;
 }
 
 void OBJState::clearActiveGroups()
@@ -135,7 +1056,7 @@ void OBJState::clearActiveGroups()
 void OBJState::addActiveGroup(std::string const& name)
 {
     OBJGroup* groupPtr = nullptr;
-    auto findGroup = m_GroupMap.find(name);
+    auto findGroup = m_GroupMap.find(OBJArenaString(name.data(), name.size()));
 
     if(findGroup != m_GroupMap.end())
     {
@@ -149,10 +1070,22 @@ void OBJState::addActiveGroup(std::string const& name)
     }
     else
     {
-        m_GroupMap[name] = OBJGroup();
-        groupPtr = &(*m_GroupMap.find(name)).second;
-        groupPtr->name = name;
-        groupPtr->faces.reserve(m_GroupFacesReservedSize);
+        // Both the key and the group are constructed in place, so that they keep the arena
+
+        findGroup = m_GroupMap.emplace(std::piecewise_construct, 
+            std::forward_as_tuple(name.data(), name.size(), OBJArenaAllocator<char>(m_pArena)), 
+            std::forward_as_tuple(m_pArena)).first;
+
+        groupPtr = &(*findGroup).second;
+
+        if(!m_RecycledGroups.empty())
+        {
+            groupPtr->swap(m_RecycledGroups.back());
+            m_RecycledGroups.pop_back();
+        }
+
+        groupPtr->name = (*findGroup).first;
+        groupPtr->faces.reserve(std::max(m_GroupFacesReservedSize, m_GroupFacesAdaptiveSize));
     }
 
     if(groupPtr)
@@ -166,19 +1099,55 @@ void OBJState::addActiveGroup(std::string const& name)
 // Vertex Data Methods
 //------------------------------------------------------------------------------------------
 
-void OBJState::addVertexSpatial(OBJVector4 const& vector)
+void OBJState::addVertexSpatial(OBJParsedSpatialVector const& vector)
 {
-    m_VertexSpatialData.emplace_back(vector);
+    if(!m_SpatialHasW && (vector.w != 1.0f))
+    {
+        unpackSpatialData();
+    }
+
+    if(m_SpatialHasW)
+    {
+        m_VertexSpatialData.push_back(ConvertSpatial<OBJSpatialVector4>(vector));
+    }
+    else
+    {
+        m_PackedSpatialData.push_back(ConvertSpatial<OBJSpatialVector3>(vector));
+    }
 }
 
 void OBJState::addVertexTexture(OBJVector2 const& vector)
 {
-    m_VertexTextureData.emplace_back(vector);
+    if(m_TextureEncoding == OBJTextureEncoding::Float)
+    {
+        m_VertexTextureData.emplace_back(vector);
+    }
+    else
+    {
+        m_TextureStaging.push_back(vector);
+
+        if(m_TextureStaging.size() == EncodingBatchSize)
+        {
+            flushTextureStaging();
+        }
+    }
 }
 
 void OBJState::addVertexNormal(OBJVector3 const& vector)
 {
-    m_VertexNormalData.emplace_back(vector);
+    if(m_NormalEncoding == OBJNormalEncoding::Float)
+    {
+        m_VertexNormalData.emplace_back(vector);
+    }
+    else
+    {
+        m_NormalStaging.push_back(vector);
+
+        if(m_NormalStaging.size() == EncodingBatchSize)
+        {
+            flushNormalStaging();
+        }
+    }
 }
 
 void OBJState::addVertexParameter(OBJVector3 const& vector)
@@ -190,93 +1159,157 @@ void OBJState::addVertexParameter(OBJVector3 const& vector)
 // Geometry Creation Methods
 //------------------------------------------------------------------------------------------
 
-void OBJState::addFace(OBJFace face)
+bool OBJState::addFace(OBJParsedFace const& parsed)
 {
-    transformVertexGroup(face.group0);
-    transformVertexGroup(face.group1);
-    transformVertexGroup(face.group2);
-    transformVertexGroup(face.group3);
+    OBJFace face;
+
+    if(!transformVertexGroup(parsed.group0, face.group0) ||
+       !transformVertexGroup(parsed.group1, face.group1) ||
+       !transformVertexGroup(parsed.group2, face.group2) ||
+       !transformVertexGroup(parsed.group3, face.group3))
+    {
+        return false;
+    }
 
-    face.renderState = static_cast<uint32_t>(m_RenderStates.size() - 1);
+    face.renderState = m_CurrentRenderState;
 
     for(auto iter = m_ActiveGroups.begin(); iter != m_ActiveGroups.end(); ++iter)
     {
-        (*iter)->faces.emplace_back(face);
+        (*iter)->addFace(face);
     }
+
+    return true;
 }
 
-void OBJState::addLine(std::vector<OBJVertexGroup>& line)
+bool OBJState::addLine(std::vector<OBJParsedVertexGroup> const& parsed)
 {
-    for(auto iter = line.begin(); iter != line.end(); ++iter)
+    std::vector<OBJVertexGroup> line(parsed.size());
+
+    for(std::size_t i = 0; i < parsed.size(); ++i)
     {
-        transformVertexGroup((*iter));
+        if(!transformVertexGroup(parsed[i], line[i]))
+        {
+            return false;
+        }
     }
 
     for(auto iter = m_ActiveGroups.begin(); iter != m_ActiveGroups.end(); ++iter)
     {
         (*iter)->addLine(line);
     }
+
+    return true;
 }
 
-void OBJState::addPointCollection(std::vector<OBJVertexGroup>& points)
+bool OBJState::addPointCollection(std::vector<OBJParsedVertexGroup> const& parsed)
 {
-    for(auto iter = points.begin(); iter != points.end(); ++iter)
+    std::vector<OBJVertexGroup> points(parsed.size());
+
+    for(std::size_t i = 0; i < parsed.size(); ++i)
     {
-        transformVertexGroup((*iter));
+        if(!transformVertexGroup(parsed[i], points[i]))
+        {
+            return false;
+        }
     }
 
     for(auto iter = m_ActiveGroups.begin(); iter != m_ActiveGroups.end(); ++iter)
     {
         (*iter)->addPointCollection(points);
     }
+
+    return true;
+}
+
+void OBJState::beginLine()
+{
+    for(auto iter = m_ActiveGroups.begin(); iter != m_ActiveGroups.end(); ++iter)
+    {
+        (*iter)->beginLine();
+    }
 }
 
-void OBJState::addFreeFormCurve(OBJCurve const& curve)
+bool OBJState::addLineVertex(OBJParsedVertexGroup const& parsed)
 {
-    std::vector<OBJVertexGroup> transformed;
-    transformed.reserve(curve.controlPoints.size());
-    transformed.insert(transformed.begin(), curve.controlPoints.begin(), curve.controlPoints.end());
+    OBJVertexGroup vertex;
 
-    for(auto iter = transformed.begin(); iter != transformed.end(); ++iter)
+    if(!transformVertexGroup(parsed, vertex))
+    {
+        return false;
+    }
+
+    for(auto iter = m_ActiveGroups.begin(); iter != m_ActiveGroups.end(); ++iter)
     {
-        transformVertexGroup((*iter));
+        (*iter)->addLineVertex(vertex);
     }
 
-    const uint32_t state = static_cast<uint32_t>(m_FreeFormState.attributeStates.size());
-    m_FreeFormState.addCurve(state, curve.startParam, curve.endParam, transformed);
+    return true;
 }
 
-void OBJState::addFreeFormCurve2D(std::vector<int32_t> const& points)
+void OBJState::beginPointCollection()
 {
-    std::vector<int32_t> transformed;
-    transformed.reserve(points.size());
-    transformed.insert(transformed.begin(), points.begin(), points.end());
+    for(auto iter = m_ActiveGroups.begin(); iter != m_ActiveGroups.end(); ++iter)
+    {
+        (*iter)->beginPointCollection();
+    }
+}
 
-    for(auto iter = transformed.begin(); iter != transformed.end(); ++iter)
+bool OBJState::addPointVertex(OBJParsedVertexGroup const& parsed)
+{
+    OBJVertexGroup vertex;
+
+    if(!transformVertexGroup(parsed, vertex))
     {
-        if((*iter) < 0)
-        {
-            (*iter) += static_cast<int32_t>(m_FreeFormState.vertexParameterData.size()) + 1;  // +1 to maintain index 1-base
-        }
+        return false;
     }
 
-    const uint32_t state = static_cast<uint32_t>(m_FreeFormState.attributeStates.size());
-    m_FreeFormState.addCurve2D(state, transformed);
+    for(auto iter = m_ActiveGroups.begin(); iter != m_ActiveGroups.end(); ++iter)
+    {
+        (*iter)->addPointVertex(vertex);
+    }
+
+    return true;
+}
+
+void OBJState::beginFreeFormCurve(float const startParam, float const endParam)
+{
+    const uint32_t state = static_cast<uint32_t>(m_FreeFormState.attributeStates.size() - 1);
+    m_FreeFormState.addCurve(state, startParam, endParam);
+}
+
+void OBJState::beginFreeFormCurve2D()
+{
+    const uint32_t state = static_cast<uint32_t>(m_FreeFormState.attributeStates.size() - 1);
+    m_FreeFormState.addCurve2D(state);
+}
+
+void OBJState::beginFreeFormSurface(float const startU, float const endU, float const startV, float const endV)
+{
+    const uint32_t state = static_cast<uint32_t>(m_FreeFormState.attributeStates.size() - 1);
+    m_FreeFormState.addSurface(state, startU, endU, startV, endV);
 }
 
-void OBJState::addFreeFormSurface(OBJSurface const& surface)
+bool OBJState::addFreeFormControlPoint(OBJParsedVertexGroup const& point)
 {
-    std::vector<OBJVertexGroup> transformed;
-    transformed.reserve(surface.controlPoints.size());
-    transformed.insert(transformed.begin(), surface.controlPoints.begin(), surface.controlPoints.end());
+    OBJVertexGroup vertex;
+
+    if(!transformVertexGroup(point, vertex))
+    {
+        return false;
+    }
 
-    for(auto iter = transformed.begin(); iter != transformed.end(); ++iter)
+    m_FreeFormState.addControlPoint(vertex);
+    return true;
+}
+
+void OBJState::addFreeFormCurve2DPoint(OBJIndex point)
+{
+    if(point < 0)
     {
-        transformVertexGroup((*iter));
+        point += static_cast<OBJIndex>(m_FreeFormState.vertexParameterData.size()) + 1;  // +1 to maintain index 1-base
     }
 
-    const uint32_t state = static_cast<uint32_t>(m_FreeFormState.attributeStates.size());
-    m_FreeFormState.addSurface(state, surface.startParamU, surface.endParamU, surface.startParamV, surface.endParamV, transformed);
+    m_FreeFormState.addCurve2DPoint(point);
 }
 
 void OBJState::addFreeFormConnection(OBJSurfaceConnection connection)
@@ -330,15 +1363,16 @@ void OBJState::addFreeFormConnection(OBJSurfaceConnection connection)
 // Free-Form Body Methods
 //------------------------------------------------------------------------------------------
 
-void OBJState::addFreeFormParameterU(std::vector<float> const& parameters)
+void OBJState::addFreeFormParameterU(float const parameter)
 {
-    m_FreeFormState.addParameterU(parameters);
+    m_FreeFormState.addParameterU(parameter);
 }
 
-void OBJState::addFreeFormParameterV(std::vector<float> const& parameters)
+void OBJState::addFreeFormParameterV(float const parameter)
 {
-    m_FreeFormState.addParameterV(parameters);
+    m_FreeFormState.addParameterV(parameter);
 }
+
 void OBJState::addFreeFormTrim(OBJSimpleCurve const& trim)
 {
     m_FreeFormState.addTrim(trim);
@@ -354,9 +1388,9 @@ void OBJState::addFreeFormSpecialCurve(OBJSimpleCurve const& scurve)
     m_FreeFormState.addSpecialCurve(scurve);
 }
 
-void OBJState::addFreeFormSpecialPoints(std::vector<int32_t> const& points)
+void OBJState::addFreeFormSpecialPoint(OBJIndex const point)
 {
-    m_FreeFormState.addSpecialPoints(points);
+    m_FreeFormState.addSpecialPoint(point);
 }
 
 //------------------------------------------------------------------------------------------
@@ -365,7 +1399,7 @@ void OBJState::addFreeFormSpecialPoints(std::vector<int32_t> const& points)
 
 void OBJState::setLevelOfDetail(uint32_t const lod)
 {
-    OBJRenderState renderState = m_RenderStates.back();
+    OBJRenderState renderState = m_RenderStates[m_CurrentRenderState];
     renderState.lod = lod;
 
     if(renderState.lod > 100)
@@ -373,99 +1407,113 @@ void OBJState::setLevelOfDetail(uint32_t const lod)
         renderState.lod = 100;    // "Specifying an integer between 1 and 100 sets the..."
     }
 
-    m_RenderStates.push_back(renderState);
+    applyRenderState(renderState);
 }
 
 void OBJState::setSmoothingGroup(uint32_t const group)
 {
-    OBJRenderState renderState = m_RenderStates.back();
+    OBJRenderState renderState = m_RenderStates[m_CurrentRenderState];
     renderState.smoothing = group;
 
-    m_RenderStates.push_back(renderState);
+    applyRenderState(renderState);
 }
 
 void OBJState::setBevelInterp(bool const on)
 {
-    OBJRenderState renderState = m_RenderStates.back();
+    OBJRenderState renderState = m_RenderStates[m_CurrentRenderState];
     renderState.bevelInterp = on;
 
-    m_RenderStates.push_back(renderState);
+    applyRenderState(renderState);
 }
 
 void OBJState::setColorInterp(bool const on)
 {
-    OBJRenderState renderState = m_RenderStates.back();
+    OBJRenderState renderState = m_RenderStates[m_CurrentRenderState];
     renderState.colorInterp = on;
 
-    m_RenderStates.push_back(renderState);
+    applyRenderState(renderState);
 }
 
 void OBJState::setDissolveInterp(bool const on)
 {
-    OBJRenderState renderState = m_RenderStates.back();
+    OBJRenderState renderState = m_RenderStates[m_CurrentRenderState];
     renderState.dissolveInterp = on;
 
-    m_RenderStates.push_back(renderState);
+    applyRenderState(renderState);
 }
 
 void OBJState::setMaterial(std::string const& name)
 {
-    OBJRenderState renderState = m_RenderStates.back();
-    renderState.material = name;
+    OBJRenderState renderState = m_RenderStates[m_CurrentRenderState];
+    renderState.material.assign(name.data(), name.size());
 
-    m_RenderStates.push_back(renderState);
+    applyRenderState(renderState);
 }
 
-void OBJState::setMaterial(std::string const& name, OBJMaterial const& material)
+void OBJState::setMaterial(OBJArenaString const& name, OBJMaterial& material)
 {
     if(!name.empty())
     {
-        m_MaterialMap[name] = material;
+        auto findMaterial = m_MaterialMap.find(name);
+
+        if(findMaterial == m_MaterialMap.end())
+        {
+            findMaterial = m_MaterialMap.emplace(std::piecewise_construct, 
+                std::forward_as_tuple(name, OBJArenaAllocator<char>(m_pArena)), 
+                std::forward_as_tuple(m_pArena)).first;
+        }
+
+        (*findMaterial).second.swap(material);
     }
 }
 
+OBJTextureId OBJState::addTextureDescriptor(OBJTextureDescriptor const& descriptor)
+{
+    return m_TextureTable.add(descriptor);
+}
+
 void OBJState::addMaterialLibrary(std::string const& path)
 {
-    m_MaterialLibraries.push_back(path);
+    m_MaterialLibraries.emplace_back(path.data(), path.size(), OBJArenaAllocator<char>(m_pArena));
 }
 
 void OBJState::setTextureMap(std::string const& name)
 {
-    OBJRenderState renderState = m_RenderStates.back();
-    renderState.textureMap = name;
+    OBJRenderState renderState = m_RenderStates[m_CurrentRenderState];
+    renderState.textureMap.assign(name.data(), name.size());
 
-    m_RenderStates.push_back(renderState);
+    applyRenderState(renderState);
 }
 
 void OBJState::addTextureMapLibrary(std::string const& path)
 {
-    m_TextureMapLibraries.push_back(path);
+    m_TextureMapLibraries.emplace_back(path.data(), path.size(), OBJArenaAllocator<char>(m_pArena));
 }
 
 void OBJState::setShadowObject(std::string const& name)
 {
-    OBJRenderState renderState = m_RenderStates.back();
-    renderState.shadowObj = name;
+    OBJRenderState renderState = m_RenderStates[m_CurrentRenderState];
+    renderState.shadowObj.assign(name.data(), name.size());
 
     if(renderState.shadowObj.compare("off") == 0)
     {
         renderState.shadowObj = "";
     }
 
-    m_RenderStates.push_back(renderState);
+    applyRenderState(renderState);
 }
 
 void OBJState::setTracingObject(std::string const& name)
 {
-    OBJRenderState renderState = m_RenderStates.back();
-    renderState.traceObj = name;
+    OBJRenderState renderState = m_RenderStates[m_CurrentRenderState];
+    renderState.traceObj.assign(name.data(), name.size());
 
     if(renderState.traceObj.compare("off") == 0)
     {
         renderState.traceObj = "";
     }
 
-    m_RenderStates.push_back(renderState);
+    applyRenderState(renderState);
 }
 
 //------------------------------------------------------------------------------------------
@@ -474,19 +1522,19 @@ void OBJState::setTracingObject(std::string const& name)
 
 void OBJState::setTechniqueParametric(float const res)
 {
-    OBJRenderState renderState = m_RenderStates.back();
+    OBJRenderState renderState = m_RenderStates[m_CurrentRenderState];
 
     renderState.curveTechnique.technique = OBJSubdivision::Parametric;
     renderState.curveTechnique.res = res;
     
     renderState.surfaceTechnique.technique = OBJSubdivision::None;        // Disable surface technique
 
-    m_RenderStates.push_back(renderState);
+    applyRenderState(renderState);
 }
 
 void OBJState::setTechniqueParametricA(OBJVector2 const& vec)
 {
-    OBJRenderState renderState = m_RenderStates.back();
+    OBJRenderState renderState = m_RenderStates[m_CurrentRenderState];
 
     renderState.surfaceTechnique.technique = OBJSubdivision::ParametricA;
     renderState.surfaceTechnique.resU = vec.x;
@@ -494,12 +1542,12 @@ void OBJState::setTechniqueParametricA(OBJVector2 const& vec)
     
     renderState.curveTechnique.technique = OBJSubdivision::None;          // Disable curve technique
 
-    m_RenderStates.push_back(renderState);
+    applyRenderState(renderState);
 }
 
 void OBJState::setTechniqueParametricB(float const res)
 {
-    OBJRenderState renderState = m_RenderStates.back();
+    OBJRenderState renderState = m_RenderStates[m_CurrentRenderState];
 
     renderState.surfaceTechnique.technique = OBJSubdivision::ParametricB;
     renderState.surfaceTechnique.resU = res;
@@ -507,36 +1555,36 @@ void OBJState::setTechniqueParametricB(float const res)
     
     renderState.curveTechnique.technique = OBJSubdivision::None;          // Disable curve technique
 
-    m_RenderStates.push_back(renderState);
+    applyRenderState(renderState);
 }
 
 void OBJState::setTechniqueSpatialCurve(float const length)
 {
-    OBJRenderState renderState = m_RenderStates.back();
+    OBJRenderState renderState = m_RenderStates[m_CurrentRenderState];
 
     renderState.curveTechnique.technique = OBJSubdivision::Spatial;
     renderState.curveTechnique.maxLength = length;
     
     renderState.surfaceTechnique.technique = OBJSubdivision::None;        // Disable surface technique
 
-    m_RenderStates.push_back(renderState);
+    applyRenderState(renderState);
 }
 
 void OBJState::setTechniqueSpatialSurface(float const length)
 {
-    OBJRenderState renderState = m_RenderStates.back();
+    OBJRenderState renderState = m_RenderStates[m_CurrentRenderState];
 
     renderState.surfaceTechnique.technique = OBJSubdivision::Spatial;
     renderState.surfaceTechnique.maxLength = length;
     
     renderState.curveTechnique.technique = OBJSubdivision::None;          // Disable curve technique
 
-    m_RenderStates.push_back(renderState);
+    applyRenderState(renderState);
 }
 
 void OBJState::setTechniqueCurvatureCurve(OBJVector2 const& vec)
 {
-    OBJRenderState renderState = m_RenderStates.back();
+    OBJRenderState renderState = m_RenderStates[m_CurrentRenderState];
 
     renderState.curveTechnique.technique = OBJSubdivision::Curvature;
     renderState.curveTechnique.maxDistance = vec.x;
@@ -544,12 +1592,12 @@ void OBJState::setTechniqueCurvatureCurve(OBJVector2 const& vec)
     
     renderState.surfaceTechnique.technique = OBJSubdivision::None;        // Disable surface technique
 
-    m_RenderStates.push_back(renderState);
+    applyRenderState(renderState);
 }
 
 void OBJState::setTechniqueCurvatureSurface(OBJVector2 const& vec)
 {
-    OBJRenderState renderState = m_RenderStates.back();
+    OBJRenderState renderState = m_RenderStates[m_CurrentRenderState];
 
     renderState.surfaceTechnique.technique = OBJSubdivision::Curvature;
     renderState.surfaceTechnique.maxDistance = vec.x;
@@ -557,7 +1605,7 @@ void OBJState::setTechniqueCurvatureSurface(OBJVector2 const& vec)
     
     renderState.curveTechnique.technique = OBJSubdivision::None;          // Disable curve technique
 
-    m_RenderStates.push_back(renderState);
+    applyRenderState(renderState);
 }
 
 //------------------------------------------------------------------------------------------
@@ -566,12 +1614,12 @@ void OBJState::setTechniqueCurvatureSurface(OBJVector2 const& vec)
 
 void OBJState::setFreeFormType(OBJFreeFormType const type)
 {
-    OBJFreeFormAttributeState state;
+    m_FreeFormState.attributeStates.emplace_back(m_pArena);
+
+    OBJFreeFormAttributeState& state = m_FreeFormState.attributeStates.back();
     state.type = type;
     state.rational = m_FreeFormRational;
 
-    m_FreeFormState.attributeStates.push_back(state);
-
     m_FreeFormRational = false;
 }
 
@@ -633,51 +1681,269 @@ void OBJState::setFreeFormMergeGroupResolution(float const res)
 void OBJState::resetAuxiliaryStates() 
 {
     m_RenderStates.clear();
-    m_RenderStates.reserve(50);                  // Arbitrary reserve
-    m_RenderStates.push_back(OBJRenderState());  // Set initial default state
+    m_RenderStateMap.clear();
+
+    m_CurrentRenderState = 0;
+    applyRenderState(OBJRenderState());          // Set initial default state
 
     m_FreeFormState.attributeStates.clear();
-    m_RenderStates.reserve(50);
-    m_FreeFormState.attributeStates.push_back(OBJFreeFormAttributeState());
+    m_FreeFormState.attributeStates.emplace_back(m_pArena);
 }
 
-void OBJState::transformVertexGroup(OBJVertexGroup& source) const
+void OBJState::quantizeSpatialData()
 {
-    // Incoming indices may be negative.
-    // We want to transform them so they are positive.
+    const std::size_t count = m_PackedSpatialData.size() + m_VertexSpatialData.size();
 
-    // They are also 1-based (no incoming index is 0), but 
-    // all standard containers are 0-based, so we also 
-    // transform them to be 0-base.
+    if(count == 0)
+    {
+        return;
+    }
+
+    // First pass: bounding box. Only one of the two streams is in use.
+
+    OBJVector3 minimum;
+    OBJVector3 maximum;
+
+    minimum.x = minimum.y = minimum.z = std::numeric_limits<float>::max();
+    maximum.x = maximum.y = maximum.z = -std::numeric_limits<float>::max();
+
+    ExpandBounds(m_PackedSpatialData, minimum, maximum);
+    ExpandBounds(m_VertexSpatialData, minimum, maximum);
+
+    const float levels = static_cast<float>((1u << m_SpatialQuantizationBits) - 1);
+
+    m_SpatialQuantization.bits = m_SpatialQuantizationBits;
+    m_SpatialQuantization.minimum = minimum;
+    m_SpatialQuantization.maximum = maximum;
+    m_SpatialQuantization.step.x = (maximum.x - minimum.x) / levels;
+    m_SpatialQuantization.step.y = (maximum.y - minimum.y) / levels;
+    m_SpatialQuantization.step.z = (maximum.z - minimum.z) / levels;
+
+    // Axes with no extent have a step of 0, and so every value quantizes to 0
+
+    OBJVector3 scale;
+
+    scale.x = (maximum.x > minimum.x) ? (levels / (maximum.x - minimum.x)) : 0.0f;
+    scale.y = (maximum.y > minimum.y) ? (levels / (maximum.y - minimum.y)) : 0.0f;
+    scale.z = (maximum.z > minimum.z) ? (levels / (maximum.z - minimum.z)) : 0.0f;
+
+    // Second pass: quantize
+
+    m_QuantizedSpatialData.clear();
+    m_QuantizedSpatialData.reserve(count);
 
-    if(source.indexSpatial < 0)
+    QuantizePositions(m_PackedSpatialData, minimum, scale, m_QuantizedSpatialData);
+    QuantizePositions(m_VertexSpatialData, minimum, scale, m_QuantizedSpatialData);
+
+    OBJReleaseContainer(m_PackedSpatialData);
+    OBJReleaseContainer(m_VertexSpatialData);
+}
+
+void OBJState::unpackSpatialData()
+{
+    // Called once, when the first vertex with a non-default w is encountered
+
+    m_VertexSpatialData.reserve(m_VertexSpatialData.size() + m_PackedSpatialData.size() + 1);
+
+    OBJSpatialVector4 vertex;
+    vertex.w = OBJStorage::Scalars::fromParsed(1.0f);
+
+    for(std::size_t block = 0; block < m_PackedSpatialData.getBlockCount(); ++block)
     {
-        source.indexSpatial += static_cast<int32_t>(m_VertexSpatialData.size());
+        std::size_t blockCount = 0;
+        OBJSpatialVector3 const* positions = m_PackedSpatialData.getBlock(block, blockCount);
+
+        for(std::size_t i = 0; i < blockCount; ++i)
+        {
+            vertex.x = positions[i].x;
+            vertex.y = positions[i].y;
+            vertex.z = positions[i].z;
+
+            m_VertexSpatialData.push_back(vertex);
+        }
     }
-    else
+
+    OBJReleaseContainer(m_PackedSpatialData);
+    m_SpatialHasW = true;
+}
+
+void OBJState::flushNormalStaging()
+{
+    const std::size_t count = m_NormalStaging.size();
+
+    if(count > 0)
+    {
+        OBJOctahedralNormal encoded[EncodingBatchSize];
+
+        OBJVertexEncoder::encodeNormals(m_NormalStaging.data(), count, encoded);
+        OBJVertexEncoder::measureNormals(m_NormalStaging.data(), encoded, count, m_EncodingReport);
+
+        for(std::size_t i = 0; i < count; ++i)
+        {
+            m_EncodedNormalData.push_back(encoded[i]);
+        }
+
+        m_NormalStaging.clear();
+    }
+}
+
+void OBJState::flushTextureStaging()
+{
+    const std::size_t count = m_TextureStaging.size();
+
+    if(count > 0)
+    {
+        OBJPackedVector2 encoded[EncodingBatchSize];
+
+        OBJVertexEncoder::encodeTextures(m_TextureStaging.data(), count, m_TextureEncoding, encoded);
+        OBJVertexEncoder::measureTextures(m_TextureStaging.data(), encoded, count, m_TextureEncoding, m_EncodingReport);
+
+        for(std::size_t i = 0; i < count; ++i)
+        {
+            m_EncodedTextureData.push_back(encoded[i]);
+        }
+
+        m_TextureStaging.clear();
+    }
+}
+
+void OBJState::recordStatistics()
+{
+    if(m_StatisticsHistorySize == 0)
+    {
+        return;
+    }
+
+    const OBJStateStatistics statistics = getStatistics();
+
+    if((statistics.spatialCount == 0) && (statistics.groupCount == 0))
     {
-        source.indexSpatial--;
+        // Nothing was parsed since the last clear
+        return;
     }
 
-    if(source.indexTexture < 0)
+    if(m_StatisticsHistory.size() < m_StatisticsHistorySize)
     {
-        source.indexTexture += static_cast<int32_t>(m_VertexTextureData.size());
+        m_StatisticsHistory.push_back(statistics);
     }
     else
     {
-        source.indexTexture--;
+        m_StatisticsHistory[m_StatisticsHistoryNext] = statistics;
+        m_StatisticsHistoryNext = (m_StatisticsHistoryNext + 1) % m_StatisticsHistorySize;
+    }
+}
+
+void OBJState::reserveFromStatistics()
+{
+    m_GroupFacesAdaptiveSize = 0;
+
+    if((m_StatisticsHistorySize == 0) || m_StatisticsHistory.empty())
+    {
+        return;
+    }
+
+    OBJStateStatistics peak;
+    OBJCount peakGroupFaces = 0;
+
+    for(auto iter = m_StatisticsHistory.begin(); iter != m_StatisticsHistory.end(); ++iter)
+    {
+        peak.spatialCount = std::max(peak.spatialCount, (*iter).spatialCount);
+        peak.textureCount = std::max(peak.textureCount, (*iter).textureCount);
+        peak.normalCount = std::max(peak.normalCount, (*iter).normalCount);
+        peak.groupCount = std::max(peak.groupCount, (*iter).groupCount);
+        peak.renderStateCount = std::max(peak.renderStateCount, (*iter).renderStateCount);
+
+        if((*iter).groupCount > 0)
+        {
+            peakGroupFaces = std::max(peakGroupFaces, (*iter).faceCount / (*iter).groupCount);
+        }
+    }
+
+    m_PackedSpatialData.reserve(ClampReserve<OBJSpatialVector3>(peak.spatialCount, m_RetainedCapacityLimit));
+    m_VertexTextureData.reserve(ClampReserve<OBJVector2>(peak.textureCount, m_RetainedCapacityLimit));
+    m_VertexNormalData.reserve(ClampReserve<OBJVector3>(peak.normalCount, m_RetainedCapacityLimit));
+    m_RenderStates.reserve(ClampReserve<OBJRenderState>(peak.renderStateCount, m_RetainedCapacityLimit));
+    m_GroupMap.reserve(peak.groupCount);
+
+    m_GroupFacesAdaptiveSize = static_cast<uint32_t>(ClampReserve<OBJFace>(peakGroupFaces, m_RetainedCapacityLimit));
+}
+
+void OBJState::recycleGroups()
+{
+    // Rather than destroying the groups (and their storage) we keep them around for
+    // the next parse. Only as many groups are kept as the largest recent parse used.
+
+    std::size_t maxRecycled = m_GroupMap.size();
+
+    for(auto iter = m_StatisticsHistory.begin(); iter != m_StatisticsHistory.end(); ++iter)
+    {
+        maxRecycled = std::max(maxRecycled, static_cast<std::size_t>((*iter).groupCount));
     }
 
-    if(source.indexNormal < 0)
+    // Reserve up front so that growing m_RecycledGroups never copies (and so loses the storage of) a group
+    m_RecycledGroups.reserve(std::max(maxRecycled, m_RecycledGroups.size()));
+
+    for(auto iter = m_GroupMap.begin(); iter != m_GroupMap.end(); ++iter)
+    {
+        OBJGroup& group = (*iter).second;
+
+        if(m_RecycledGroups.size() >= maxRecycled)
+        {
+            break;
+        }
+
+        if((m_RetainedCapacityLimit > 0) && (group.getCapacityBytes() > m_RetainedCapacityLimit))
+        {
+            continue;
+        }
+
+        group.clear();
+
+        m_RecycledGroups.emplace_back();
+        m_RecycledGroups.back().swap(group);
+    }
+
+    m_GroupMap.clear();
+}
+
+void OBJState::applyRenderState(OBJRenderState const& state)
+{
+    auto findState = m_RenderStateMap.find(state);
+
+    if(findState != m_RenderStateMap.end())
     {
-        source.indexNormal += static_cast<int32_t>(m_VertexNormalData.size());
+        m_CurrentRenderState = (*findState).second;
     }
     else
     {
-        source.indexNormal--;
+        m_CurrentRenderState = static_cast<uint32_t>(m_RenderStates.size());
+
+        // The stored copies allocate their strings from the arena (a plain copy would use the heap)
+
+        m_RenderStates.emplace_back(state, m_pArena);
+        m_RenderStateMap.emplace(OBJRenderState(state, m_pArena), m_CurrentRenderState);
     }
 }
 
+bool OBJState::transformVertexGroup(OBJParsedVertexGroup const& source, OBJVertexGroup& result) const
+{
+    // Incoming indices may be negative.
+    // We want to transform them so they are positive.
+
+    // They are also 1-based (no incoming index is 0), but 
+    // all standard containers are 0-based, so we also 
+    // transform them to be 0-base.
+
+    // Finally they are converted to the index type of the storage policy,
+    // which may not be able to hold them (such as 16-bit indices).
+
+    const bool spatial = ResolveIndex(source.indexSpatial, m_PackedSpatialData.size() + m_VertexSpatialData.size(), result.indexSpatial);
+    const bool texture = ResolveIndex(source.indexTexture, m_VertexTextureData.size() + m_EncodedTextureData.size() + m_TextureStaging.size(), result.indexTexture);
+    const bool normal = ResolveIndex(source.indexNormal, m_VertexNormalData.size() + m_EncodedNormalData.size() + m_NormalStaging.size(), result.indexNormal);
+
+    return (spatial && texture && normal);
+}
+
 //------------------------------------------------------------------------------------------
 // Private Methods
 //------------------------------------------------------------------------------------------
\ No newline at end of file
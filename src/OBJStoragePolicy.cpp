@@ -0,0 +1,43 @@
+/*
+ * Copyright 2016 Steven T Sell (ssell@vertexfragment.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "OBJStoragePolicy.hpp"
+#include "OBJVertexEncoding.hpp"
+
+//------------------------------------------------------------------------------------------
+// OBJStorageLinkCheck
+//------------------------------------------------------------------------------------------
+
+template<>
+int const OBJStorageLinkCheck<OBJStorage>::value = 1;
+
+//------------------------------------------------------------------------------------------
+// OBJScalarTraits<OBJHalf>
+//------------------------------------------------------------------------------------------
+
+OBJHalf OBJScalarTraits<OBJHalf>::fromParsed(float const value)
+{
+    OBJHalf result;
+    result.bits = OBJVertexEncoder::floatToHalf(value);
+
+    return result;
+}
+
+float OBJScalarTraits<OBJHalf>::toFloat(OBJHalf const value)
+{
+    return OBJVertexEncoder::halfToFloat(value.bits);
+}
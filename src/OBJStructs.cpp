@@ -27,118 +27,78 @@ OBJVector2::OBJVector2()
 
 }
 
-OBJVector2 const& OBJVector2::operator=(OBJVector2 const& rhs) 
-{ 
-    x = rhs.x; 
-    y = rhs.y; 
-    
-    return (*this); 
-}
-
 //------------------------------------------------------------------------------------------
-// OBJVector3
+// OBJQuantizedVector3
 //------------------------------------------------------------------------------------------
 
-OBJVector3::OBJVector3() 
-    : x(0.0f), 
-      y(0.0f),
-      z(0.0f)
-{ 
-
-}
-
-OBJVector3 const& OBJVector3::operator=(OBJVector3 const& rhs) 
-{ 
-    x = rhs.x; 
-    y = rhs.y; 
-    z = rhs.z;
+OBJQuantizedVector3::OBJQuantizedVector3()
+    : x(0),
+      y(0),
+      z(0)
+{
 
-    return (*this); 
 }
 
 //------------------------------------------------------------------------------------------
-// OBJVector4
+// OBJQuantization
 //------------------------------------------------------------------------------------------
 
-OBJVector4::OBJVector4() 
-    : x(0.0f), 
-      y(0.0f),
-      z(0.0f),
-      w(0.0f)
-{ 
-
-}
-
-OBJVector4 const& OBJVector4::operator=(OBJVector4 const& rhs) 
-{ 
-    x = rhs.x; 
-    y = rhs.y; 
-    z = rhs.z;
-    w = rhs.w;
+OBJQuantization::OBJQuantization()
+    : bits(0)
+{
 
-    return (*this); 
 }
 
-//------------------------------------------------------------------------------------------
-// OBJVertexGroup
-//------------------------------------------------------------------------------------------
-
-OBJVertexGroup::OBJVertexGroup()
-    : indexSpatial(-1), 
-      indexTexture(-1), 
-      indexNormal(-1)
+OBJVector3 OBJQuantization::dequantize(OBJQuantizedVector3 const& quantized) const
 {
+    OBJVector3 result;
 
-}
+    result.x = minimum.x + (static_cast<float>(quantized.x) * step.x);
+    result.y = minimum.y + (static_cast<float>(quantized.y) * step.y);
+    result.z = minimum.z + (static_cast<float>(quantized.z) * step.z);
 
-//------------------------------------------------------------------------------------------
-// OBJFace
-//------------------------------------------------------------------------------------------
-
-OBJFace::OBJFace()
-    : renderState(0)
-{
-    
+    return result;
 }
 
 //------------------------------------------------------------------------------------------
-// OBJLine
+// OBJRenderStateRange
 //------------------------------------------------------------------------------------------
 
-OBJLine::OBJLine()
+OBJRenderStateRange::OBJRenderStateRange()
+    : firstFace(0),
+      faceCount(0),
+      renderState(0)
 {
 
 }
 
-OBJLine::OBJLine(std::vector<OBJVertexGroup> const& vector)
+OBJRenderStateRange::OBJRenderStateRange(OBJCount const first, OBJCount const count, uint32_t const state)
+    : firstFace(first),
+      faceCount(count),
+      renderState(state)
 {
-    segments.reserve(segments.size() + vector.size());
-    segments.insert(segments.end(), vector.begin(), vector.end());
+
 }
 
 //------------------------------------------------------------------------------------------
-// OBJPoint
+// OBJSimpleCurve
 //------------------------------------------------------------------------------------------
 
-OBJPoint::OBJPoint()
+OBJSimpleCurve::OBJSimpleCurve()
+    : startParam(0.0f),
+      endParam(0.0f),
+      curve2DIndex(-1)
 {
 
 }
 
-OBJPoint::OBJPoint(std::vector<OBJVertexGroup> const& vector)
-{
-    points.reserve(points.size() + vector.size());
-    points.insert(points.end(), vector.begin(), vector.end());
-}
-
 //------------------------------------------------------------------------------------------
-// OBJSimpleCurve
+// OBJPoolRange
 //------------------------------------------------------------------------------------------
 
-OBJSimpleCurve::OBJSimpleCurve()
-    : startParam(0.0f),
-      endParam(0.0f),
-      curve2DIndex(-1)
+OBJPoolRange::OBJPoolRange()
+    : offset(0),
+      count(0)
 {
 
 }
@@ -165,13 +125,12 @@ OBJCurve::OBJCurve()
 
 }
 
-OBJCurve::OBJCurve(float const start, float const end, std::vector<OBJVertexGroup> const& points)
+OBJCurve::OBJCurve(float const start, float const end)
     : OBJFreeForm(),
       startParam(start),
       endParam(end)
 {
-    controlPoints.reserve(points.size());
-    controlPoints.insert(controlPoints.begin(), points.begin(), points.end());
+
 }
 
 //------------------------------------------------------------------------------------------
@@ -184,13 +143,6 @@ OBJCurve2D::OBJCurve2D()
 
 }
 
-OBJCurve2D::OBJCurve2D(std::vector<int32_t> const& points)
-    : OBJFreeForm()
-{
-    parameterVertexIndices.reserve(points.size());
-    parameterVertexIndices.insert(parameterVertexIndices.begin(), points.begin(), points.end());
-}
-
 //------------------------------------------------------------------------------------------
 // OBJSurface
 //------------------------------------------------------------------------------------------
@@ -205,15 +157,14 @@ OBJSurface::OBJSurface()
 
 }
 
-OBJSurface::OBJSurface(float const startU, float const endU, float const startV, float const endV, std::vector<OBJVertexGroup> const& points)
+OBJSurface::OBJSurface(float const startU, float const endU, float const startV, float const endV)
     : OBJFreeForm(),
       startParamU(startU),
       endParamU(endU),
       startParamV(startV),
       endParamV(endV)
 {
-    controlPoints.reserve(points.size());
-    controlPoints.insert(controlPoints.begin(), points.begin(), points.end());
+
 }
 
 //------------------------------------------------------------------------------------------
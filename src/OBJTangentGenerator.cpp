@@ -0,0 +1,696 @@
+/*
+ * Copyright 2016 Steven T Sell (ssell@vertexfragment.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "OBJTangentGenerator.hpp"
+#include "OBJMeshBuilder.hpp"
+#include "OBJParallel.hpp"
+#include "OBJState.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <map>
+
+namespace
+{
+    const std::size_t VerticesPerChunk = 1 << 16;
+
+    const uint8_t UsedPreserving = 1;       ///< Vertex is used by a triangle with unmirrored texture coordinates
+    const uint8_t UsedMirrored = 2;         ///< Vertex is used by a triangle with mirrored texture coordinates
+    const uint32_t ShortIndexLimit = 0xFFFF;  ///< As in OBJMeshBuilder. 0xFFFF itself is reserved for primitive restart.
+    const uint32_t NoSubset = 0xFFFFFFFF;
+
+    bool CompareMaterialNames(OBJMaterial const* lhs, OBJMaterial const* rhs)
+    {
+        return lhs->getName() < rhs->getName();
+    }
+
+    bool CompareMaterialName(OBJMaterial const* lhs, OBJArenaString const& rhs)
+    {
+        return lhs->getName() < rhs;
+    }
+
+    /**
+     * \param[in] materials Materials of the state, sorted by name.
+     * \param[in] name      Material name of a render state.
+     */
+    bool HasBumpTexture(std::vector<OBJMaterial const*> const& materials, OBJArenaString const& name)
+    {
+        bool result = false;
+        auto find = std::lower_bound(materials.begin(), materials.end(), name, CompareMaterialName);
+
+        if((find != materials.end()) && ((*find)->getName() == name))
+        {
+            result = ((*find)->getBumpTexture() != 0);
+        }
+
+        return result;
+    }
+
+    OBJVector3 ToVector3(OBJVector4 const& vector)
+    {
+        OBJVector3 result;
+
+        result.x = vector.x;
+        result.y = vector.y;
+        result.z = vector.z;
+
+        return result;
+    }
+
+    OBJVector3 Subtract(OBJVector3 const& lhs, OBJVector3 const& rhs)
+    {
+        OBJVector3 result;
+
+        result.x = lhs.x - rhs.x;
+        result.y = lhs.y - rhs.y;
+        result.z = lhs.z - rhs.z;
+
+        return result;
+    }
+
+    float Dot(OBJVector3 const& lhs, OBJVector3 const& rhs)
+    {
+        return (lhs.x * rhs.x) + (lhs.y * rhs.y) + (lhs.z * rhs.z);
+    }
+
+    OBJVector3 Cross(OBJVector3 const& lhs, OBJVector3 const& rhs)
+    {
+        OBJVector3 result;
+
+        result.x = (lhs.y * rhs.z) - (lhs.z * rhs.y);
+        result.y = (lhs.z * rhs.x) - (lhs.x * rhs.z);
+        result.z = (lhs.x * rhs.y) - (lhs.y * rhs.x);
+
+        return result;
+    }
+
+    /**
+     * Normalizes the vector in place. Returns false (leaving it unchanged) if it has no length.
+     */
+    bool Normalize(OBJVector3& vector)
+    {
+        const float length = std::sqrt(Dot(vector, vector));
+
+        if(length > std::numeric_limits<float>::min())
+        {
+            vector.x /= length;
+            vector.y /= length;
+            vector.z /= length;
+
+            return true;
+        }
+
+        return false;
+    }
+
+    /**
+     * Removes the component of the vector along the (unit) normal and normalizes the remainder.
+     */
+    bool ProjectNormalized(OBJVector3& vector, OBJVector3 const& normal)
+    {
+        const float projection = Dot(vector, normal);
+
+        vector.x -= normal.x * projection;
+        vector.y -= normal.y * projection;
+        vector.z -= normal.z * projection;
+
+        return Normalize(vector);
+    }
+
+    /**
+     * Per-corner results of a single triangle. Orientation is 1 for unmirrored texture
+     * coordinates, -1 for mirrored, and 0 if the triangle does not contribute.
+     */
+    struct TriangleTangents
+    {
+        OBJVector3 corners[3];      ///< Angle-weighted tangent of each corner
+        int8_t orientation;
+    };
+
+    void EvaluateTriangle(OBJState const& state, OBJMesh const& mesh, uint32_t const* triangle, TriangleTangents& result)
+    {
+        result.orientation = 0;
+
+        const std::size_t vertexCount = mesh.sources.size();
+
+        if((triangle[0] >= vertexCount) || (triangle[1] >= vertexCount) || (triangle[2] >= vertexCount))
+        {
+            return;
+        }
+
+        OBJVertexGroup const* groups[3] = { &mesh.sources[triangle[0]], &mesh.sources[triangle[1]], &mesh.sources[triangle[2]] };
+        OBJVector3 positions[3];
+        OBJVector2 coords[3];
+
+        for(int c = 0; c < 3; ++c)
+        {
+            if(!OBJStorage::Indices::isUsed(groups[c]->indexTexture))
+            {
+                return;
+            }
+
+            positions[c] = ToVector3(state.getSpatial(static_cast<OBJCount>(groups[c]->indexSpatial)));
+            coords[c] = state.getTexture(static_cast<OBJCount>(groups[c]->indexTexture));
+        }
+
+        // Texture-space direction of the triangle, scaled by its signed texture area (as in MikkTSpace)
+
+        const OBJVector3 edge1 = Subtract(positions[1], positions[0]);
+        const OBJVector3 edge2 = Subtract(positions[2], positions[0]);
+
+        const float du1 = coords[1].x - coords[0].x;
+        const float dv1 = coords[1].y - coords[0].y;
+        const float du2 = coords[2].x - coords[0].x;
+        const float dv2 = coords[2].y - coords[0].y;
+
+        const float area = (du1 * dv2) - (dv1 * du2);
+
+        if(std::fabs(area) <= std::numeric_limits<float>::min())
+        {
+            return;
+        }
+
+        const float sign = (area > 0.0f) ? 1.0f : -1.0f;
+
+        OBJVector3 direction;
+        direction.x = ((edge1.x * dv2) - (edge2.x * dv1)) * sign;
+        direction.y = ((edge1.y * dv2) - (edge2.y * dv1)) * sign;
+        direction.z = ((edge1.z * dv2) - (edge2.z * dv1)) * sign;
+
+        OBJVector3 faceNormal = Cross(edge1, edge2);
+        Normalize(faceNormal);
+
+        for(int c = 0; c < 3; ++c)
+        {
+            OBJVector3 normal = faceNormal;
+
+            if(OBJStorage::Indices::isUsed(groups[c]->indexNormal))
+            {
+                OBJVector3 vertexNormal = state.getNormal(static_cast<OBJCount>(groups[c]->indexNormal));
+
+                if(Normalize(vertexNormal))
+                {
+                    normal = vertexNormal;
+                }
+            }
+
+            // Angle of the corner, measured within the tangent plane
+
+            OBJVector3 toPrevious = Subtract(positions[(c + 2) % 3], positions[c]);
+            OBJVector3 toNext = Subtract(positions[(c + 1) % 3], positions[c]);
+            OBJVector3 tangent = direction;
+
+            float angle = 0.0f;
+
+            if(ProjectNormalized(toPrevious, normal) && ProjectNormalized(toNext, normal) && ProjectNormalized(tangent, normal))
+            {
+                angle = std::acos(std::max(-1.0f, std::min(1.0f, Dot(toPrevious, toNext))));
+            }
+
+            result.corners[c].x = tangent.x * angle;
+            result.corners[c].y = tangent.y * angle;
+            result.corners[c].z = tangent.z * angle;
+        }
+
+        result.orientation = static_cast<int8_t>(sign);
+    }
+
+    /**
+     * Determines the final position of every vertex of a mesh with short indices, once the split 
+     * vertices (appended after the vertexCount original vertices, see remap) are moved to directly 
+     * after the last vertex of the subset that uses them.
+     *
+     * Returns false if a split vertex is used by more than one subset, or if a subset would then
+     * span ShortIndexLimit or more vertices. The mesh is not modified.
+     */
+    bool PlaceSplitVertices(OBJMesh const& mesh, std::vector<bool> const& processed, std::vector<TriangleTangents> const& triangles,
+                            std::vector<uint8_t> const& usage, std::vector<uint32_t> const& remap, std::size_t const splitCount,
+                            std::vector<uint32_t>& position)
+    {
+        const std::size_t vertexCount = usage.size();
+
+        //----------------------------------------------------------------
+        // Find the subset of each split, and the last vertex of each subset
+        //----------------------------------------------------------------
+
+        std::vector<uint32_t> owners(splitCount, NoSubset);
+        std::vector<uint32_t> lastVertices(mesh.subsets.size(), 0);
+
+        for(std::size_t s = 0; s < mesh.subsets.size(); ++s)
+        {
+            OBJMeshSubset const& subset = mesh.subsets[s];
+
+            for(uint32_t i = subset.firstIndex; i < (subset.firstIndex + subset.indexCount); ++i)
+            {
+                const uint32_t vertex = mesh.indices[i];
+                lastVertices[s] = std::max(lastVertices[s], vertex);
+
+                if((vertex < vertexCount) && (usage[vertex] == (UsedPreserving | UsedMirrored)))
+                {
+                    uint32_t& owner = owners[remap[vertex] - vertexCount];
+
+                    if((owner != NoSubset) && (owner != s))
+                    {
+                        return false;
+                    }
+
+                    owner = static_cast<uint32_t>(s);
+                }
+            }
+        }
+
+        //----------------------------------------------------------------
+        // Insert the splits after the last vertex of their subset
+        //----------------------------------------------------------------
+
+        std::vector<uint32_t> sorted(splitCount);
+
+        for(std::size_t i = 0; i < splitCount; ++i)
+        {
+            sorted[i] = static_cast<uint32_t>(i);
+        }
+
+        std::stable_sort(sorted.begin(), sorted.end(), [&](uint32_t const lhs, uint32_t const rhs) { return (lastVertices[owners[lhs]] < lastVertices[owners[rhs]]); });
+
+        position.resize(vertexCount + splitCount);
+
+        uint32_t next = 0;
+        std::size_t split = 0;
+
+        for(std::size_t v = 0; v < vertexCount; ++v)
+        {
+            position[v] = next++;
+
+            for(; (split < splitCount) && (lastVertices[owners[sorted[split]]] == v); ++split)
+            {
+                position[vertexCount + sorted[split]] = next++;
+            }
+        }
+
+        //----------------------------------------------------------------
+        // Check the span of each subset, as indexed once the mirrored 
+        // triangles use the splits
+        //----------------------------------------------------------------
+
+        for(std::size_t s = 0; s < mesh.subsets.size(); ++s)
+        {
+            OBJMeshSubset const& subset = mesh.subsets[s];
+
+            if(subset.indexCount == 0)
+            {
+                continue;
+            }
+
+            uint32_t low = std::numeric_limits<uint32_t>::max();
+            uint32_t high = 0;
+
+            for(uint32_t i = subset.firstIndex; i < (subset.firstIndex + subset.indexCount); ++i)
+            {
+                uint32_t vertex = mesh.indices[i];
+
+                if(processed[s] && (vertex < vertexCount) && (usage[vertex] == (UsedPreserving | UsedMirrored)) && (triangles[i / 3].orientation < 0))
+                {
+                    vertex = remap[vertex];
+                }
+
+                low = std::min(low, position[vertex]);
+                high = std::max(high, position[vertex]);
+            }
+
+            if((high - low) >= ShortIndexLimit)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+}
+
+//------------------------------------------------------------------------------------------
+// Constructors
+//------------------------------------------------------------------------------------------
+
+OBJTangentGenerator::OBJTangentGenerator()
+    : m_ThreadCount(0),
+      m_BumpMappedOnly(true)
+{
+
+}
+
+OBJTangentGenerator::~OBJTangentGenerator()
+{
+
+}
+
+//------------------------------------------------------------------------------------------
+// Public Methods
+//------------------------------------------------------------------------------------------
+
+void OBJTangentGenerator::setThreadCount(uint32_t const count)
+{
+    m_ThreadCount = count;
+}
+
+void OBJTangentGenerator::setBumpMappedOnly(bool const only)
+{
+    m_BumpMappedOnly = only;
+}
+
+bool OBJTangentGenerator::generate(OBJState const& state, OBJMesh& mesh, std::vector<OBJVector4>& tangents) const
+{
+    //--------------------------------------------------------------------
+    // Gather the processed (by default bump-mapped) subsets into one batch per material
+    //--------------------------------------------------------------------
+
+    std::vector<int8_t> bumpMapped(state.getRenderStateCount(), -1);     // Per render state, -1 until looked up
+    std::vector<bool> subsetBumpMapped(mesh.subsets.size(), false);
+    std::map<OBJArenaString, std::vector<std::size_t>> materialBatches;
+
+    std::vector<OBJMaterial const*> materials;
+
+    if(m_BumpMappedOnly)
+    {
+        state.getMaterials(materials);
+        std::sort(materials.begin(), materials.end(), CompareMaterialNames);
+    }
+
+    for(std::size_t i = 0; i < mesh.subsets.size(); ++i)
+    {
+        const uint32_t index = mesh.subsets[i].renderState;
+        const OBJRenderState renderState = state.getRenderState(index);
+
+        bool isBump = !m_BumpMappedOnly;
+
+        if(m_BumpMappedOnly && (index < bumpMapped.size()))
+        {
+            if(bumpMapped[index] < 0)
+            {
+                bumpMapped[index] = HasBumpTexture(materials, renderState.material) ? 1 : 0;
+            }
+
+            isBump = (bumpMapped[index] == 1);
+        }
+
+        if(isBump)
+        {
+            subsetBumpMapped[i] = true;
+            materialBatches[renderState.material].push_back(i);
+        }
+    }
+
+    std::vector<std::vector<std::size_t> const*> batches;
+    batches.reserve(materialBatches.size());
+
+    for(auto iter = materialBatches.begin(); iter != materialBatches.end(); ++iter)
+    {
+        batches.push_back(&(iter->second));
+    }
+
+    //--------------------------------------------------------------------
+    // Evaluate the triangles of each material in parallel
+    //--------------------------------------------------------------------
+
+    std::vector<TriangleTangents> triangles(mesh.indices.size() / 3);
+
+    OBJParallelFor(batches.size(), m_ThreadCount, [&](std::size_t const b)
+    {
+        for(auto iter = batches[b]->begin(); iter != batches[b]->end(); ++iter)
+        {
+            OBJMeshSubset const& subset = mesh.subsets[*iter];
+
+            for(uint32_t i = 0; (i + 2) < subset.indexCount; i += 3)
+            {
+                const uint32_t offset = subset.firstIndex + i;
+                EvaluateTriangle(state, mesh, &mesh.indices[offset], triangles[offset / 3]);
+            }
+        }
+    });
+
+    //--------------------------------------------------------------------
+    // Accumulate onto the vertices, keeping mirrored triangles apart.
+    // This is done in index order so that the sums do not depend on the thread count.
+    //--------------------------------------------------------------------
+
+    const std::size_t vertexCount = mesh.sources.size();
+
+    std::vector<OBJVector3> preserving(vertexCount);
+    std::vector<OBJVector3> mirrored(vertexCount);
+    std::vector<uint8_t> usage(vertexCount, 0);
+
+    for(std::size_t s = 0; s < mesh.subsets.size(); ++s)
+    {
+        if(!subsetBumpMapped[s])
+        {
+            continue;
+        }
+
+        OBJMeshSubset const& subset = mesh.subsets[s];
+
+        for(uint32_t i = 0; (i + 2) < subset.indexCount; i += 3)
+        {
+            const uint32_t offset = subset.firstIndex + i;
+            TriangleTangents const& triangle = triangles[offset / 3];
+
+            if(triangle.orientation == 0)
+            {
+                continue;
+            }
+
+            for(int c = 0; c < 3; ++c)
+            {
+                const uint32_t vertex = mesh.indices[offset + c];
+                OBJVector3& sum = (triangle.orientation > 0) ? preserving[vertex] : mirrored[vertex];
+
+                sum.x += triangle.corners[c].x;
+                sum.y += triangle.corners[c].y;
+                sum.z += triangle.corners[c].z;
+
+                usage[vertex] |= (triangle.orientation > 0) ? UsedPreserving : UsedMirrored;
+            }
+        }
+    }
+
+    //--------------------------------------------------------------------
+    // Split vertices used by both mirrored and unmirrored triangles
+    //--------------------------------------------------------------------
+
+    std::vector<uint32_t> splits;
+
+    for(std::size_t i = 0; i < vertexCount; ++i)
+    {
+        if(usage[i] == (UsedPreserving | UsedMirrored))
+        {
+            splits.push_back(static_cast<uint32_t>(i));
+        }
+    }
+
+    if((vertexCount + splits.size()) > static_cast<std::size_t>(std::numeric_limits<uint32_t>::max()))
+    {
+        return false;
+    }
+
+    std::vector<uint32_t> remap(vertexCount, 0);
+
+    for(std::size_t i = 0; i < splits.size(); ++i)
+    {
+        remap[splits[i]] = static_cast<uint32_t>(vertexCount + i);
+    }
+
+    // Splits are appended to the mesh. With short indices they are then moved next to their subset,
+    // so that it can still be drawn from its base vertex. This is checked before the mesh is modified.
+
+    const bool shortIndices = (!mesh.shortIndices.empty() && !splits.empty());
+    std::vector<uint32_t> position;
+
+    if(shortIndices && !PlaceSplitVertices(mesh, subsetBumpMapped, triangles, usage, remap, splits.size(), position))
+    {
+        return false;
+    }
+
+    const bool hasVertices = !mesh.vertices.empty();
+
+    mesh.sources.reserve(vertexCount + splits.size());
+
+    if(hasVertices)
+    {
+        mesh.vertices.reserve((vertexCount + splits.size()) * mesh.vertexStride);
+    }
+
+    for(std::size_t i = 0; i < splits.size(); ++i)
+    {
+        const uint32_t vertex = splits[i];
+
+        mesh.sources.push_back(mesh.sources[vertex]);
+
+        if(hasVertices)
+        {
+            for(uint32_t f = 0; f < mesh.vertexStride; ++f)
+            {
+                mesh.vertices.push_back(mesh.vertices[(static_cast<std::size_t>(vertex) * mesh.vertexStride) + f]);
+            }
+        }
+    }
+
+    if(!splits.empty())
+    {
+        for(std::size_t s = 0; s < mesh.subsets.size(); ++s)
+        {
+            if(!subsetBumpMapped[s])
+            {
+                continue;
+            }
+
+            OBJMeshSubset const& subset = mesh.subsets[s];
+
+            for(uint32_t i = 0; (i + 2) < subset.indexCount; i += 3)
+            {
+                const uint32_t offset = subset.firstIndex + i;
+
+                if(triangles[offset / 3].orientation < 0)
+                {
+                    for(uint32_t c = offset; c < (offset + 3); ++c)
+                    {
+                        if(usage[mesh.indices[c]] == (UsedPreserving | UsedMirrored))
+                        {
+                            mesh.indices[c] = remap[mesh.indices[c]];
+                        }
+                    }
+                }
+            }
+        }
+
+        mesh.vertexCount = static_cast<uint32_t>(mesh.sources.size());
+    }
+
+    //--------------------------------------------------------------------
+    // Normalize
+    //--------------------------------------------------------------------
+
+    tangents.resize(mesh.sources.size());
+
+    const std::size_t chunks = (tangents.size() + VerticesPerChunk - 1) / VerticesPerChunk;
+
+    OBJParallelFor(chunks, m_ThreadCount, [&](std::size_t const chunk)
+    {
+        const std::size_t first = chunk * VerticesPerChunk;
+        const std::size_t last = std::min(first + VerticesPerChunk, tangents.size());
+
+        for(std::size_t i = first; i < last; ++i)
+        {
+            // Split vertices carry the mirrored side; the original keeps the unmirrored side
+
+            const bool isSplit = (i >= vertexCount);
+            const std::size_t vertex = isSplit ? splits[i - vertexCount] : i;
+
+            OBJVector3 tangent;
+            float sign = 1.0f;
+
+            if(isSplit || (usage[vertex] == UsedMirrored))
+            {
+                tangent = mirrored[vertex];
+                sign = -1.0f;
+            }
+            else
+            {
+                tangent = preserving[vertex];
+            }
+
+            if(!Normalize(tangent))
+            {
+                tangent.x = 1.0f;
+                tangent.y = 0.0f;
+                tangent.z = 0.0f;
+            }
+
+            tangents[i].x = tangent.x;
+            tangents[i].y = tangent.y;
+            tangents[i].z = tangent.z;
+            tangents[i].w = sign;
+        }
+    });
+
+    //--------------------------------------------------------------------
+    // Move the splits next to their subsets (short indices only)
+    //--------------------------------------------------------------------
+
+    if(shortIndices)
+    {
+        std::vector<OBJVertexGroup> sources(mesh.sources.size());
+        std::vector<OBJVector4> ordered(tangents.size());
+
+        for(std::size_t i = 0; i < position.size(); ++i)
+        {
+            sources[position[i]] = mesh.sources[i];
+            ordered[position[i]] = tangents[i];
+        }
+
+        mesh.sources.swap(sources);
+        tangents.swap(ordered);
+
+        if(hasVertices)
+        {
+            std::vector<float> vertices(mesh.vertices.size());
+
+            for(std::size_t i = 0; i < position.size(); ++i)
+            {
+                std::copy_n(mesh.vertices.begin() + (i * mesh.vertexStride), mesh.vertexStride, vertices.begin() + (static_cast<std::size_t>(position[i]) * mesh.vertexStride));
+            }
+
+            mesh.vertices.swap(vertices);
+        }
+
+        for(auto iter = mesh.indices.begin(); iter != mesh.indices.end(); ++iter)
+        {
+            (*iter) = position[(*iter)];
+        }
+
+        return OBJMeshBuilder::buildShortIndices(mesh);
+    }
+
+    return true;
+}
+
+bool OBJTangentGenerator::isBumpMapped(OBJState const& state, OBJRenderState const& renderState)
+{
+    bool result = false;
+
+    if(!renderState.material.empty())
+    {
+        std::vector<OBJMaterial const*> materials;
+        state.getMaterials(materials);
+
+        for(auto iter = materials.begin(); iter != materials.end(); ++iter)
+        {
+            if((*iter)->getName() == renderState.material)
+            {
+                result = ((*iter)->getBumpTexture() != 0);
+                break;
+            }
+        }
+    }
+
+    return result;
+}
+
+//------------------------------------------------------------------------------------------
+// Protected Methods
+//------------------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------------------
+// Private Methods
+//------------------------------------------------------------------------------------------
@@ -60,6 +60,17 @@ OBJTextureDescriptor& OBJTextureDescriptor::operator=(OBJTextureDescriptor const
     return (*this);
 }
 
+bool OBJTextureDescriptor::operator==(OBJTextureDescriptor const& rhs) const
+{
+    return (m_BlendU == rhs.m_BlendU) && (m_BlendV == rhs.m_BlendV) && (m_Clamp == rhs.m_Clamp) && (m_ColorCorrection == rhs.m_ColorCorrection) &&
+           (m_Resolution == rhs.m_Resolution) && (m_BumpMultiplier == rhs.m_BumpMultiplier) && (m_Boost == rhs.m_Boost) &&
+           (m_RangeModBase == rhs.m_RangeModBase) && (m_RangeModGain == rhs.m_RangeModGain) &&
+           (m_Offset.x == rhs.m_Offset.x) && (m_Offset.y == rhs.m_Offset.y) && (m_Offset.z == rhs.m_Offset.z) &&
+           (m_Scale.x == rhs.m_Scale.x) && (m_Scale.y == rhs.m_Scale.y) && (m_Scale.z == rhs.m_Scale.z) &&
+           (m_Turbulence.x == rhs.m_Turbulence.x) && (m_Turbulence.y == rhs.m_Turbulence.y) && (m_Turbulence.z == rhs.m_Turbulence.z) &&
+           (m_imfchan == rhs.m_imfchan) && (m_Path == rhs.m_Path);
+}
+
 //------------------------------------------------------------------------------------------
 // Public Methods
 //------------------------------------------------------------------------------------------
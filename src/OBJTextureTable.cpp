@@ -0,0 +1,93 @@
+/*
+ * Copyright 2016 Steven T Sell (ssell@vertexfragment.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "OBJTextureTable.hpp"
+
+//------------------------------------------------------------------------------------------
+// Constructors
+//------------------------------------------------------------------------------------------
+
+OBJTextureTable::OBJTextureTable()
+    : m_Descriptors(1)
+{
+
+}
+
+OBJTextureTable::~OBJTextureTable()
+{
+
+}
+
+//------------------------------------------------------------------------------------------
+// Public Methods
+//------------------------------------------------------------------------------------------
+
+OBJTextureId OBJTextureTable::add(OBJTextureDescriptor const& descriptor)
+{
+    if(descriptor.getPath().empty())
+    {
+        return 0;
+    }
+
+    const std::size_t hash = OBJTextureDescriptorHash()(descriptor);
+    auto range = m_HashMap.equal_range(hash);
+
+    for(auto iter = range.first; iter != range.second; ++iter)
+    {
+        if(m_Descriptors[(*iter).second] == descriptor)
+        {
+            return (*iter).second;
+        }
+    }
+
+    const OBJTextureId id = static_cast<OBJTextureId>(m_Descriptors.size());
+
+    m_Descriptors.push_back(descriptor);
+    m_HashMap.insert(HashMap::value_type(hash, id));
+
+    return id;
+}
+
+OBJTextureDescriptor const& OBJTextureTable::get(OBJTextureId const id) const
+{
+    return (id < m_Descriptors.size()) ? m_Descriptors[id] : m_Descriptors[0];
+}
+
+uint32_t OBJTextureTable::getCount() const
+{
+    return static_cast<uint32_t>(m_Descriptors.size() - 1);
+}
+
+void OBJTextureTable::clear()
+{
+    m_Descriptors.resize(1);
+    m_HashMap.clear();
+}
+
+void OBJTextureTable::swap(OBJTextureTable& other)
+{
+    m_Descriptors.swap(other.m_Descriptors);
+    m_HashMap.swap(other.m_HashMap);
+}
+
+//------------------------------------------------------------------------------------------
+// Protected Methods
+//------------------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------------------
+// Private Methods
+//------------------------------------------------------------------------------------------
@@ -0,0 +1,683 @@
+/*
+ * Copyright 2016 Steven T Sell (ssell@vertexfragment.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "OBJVertexCacheOptimizer.hpp"
+#include "OBJMeshBuilder.hpp"
+#include "OBJParallel.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+    const uint32_t Unmapped = 0xFFFFFFFF;
+
+    /**
+     * Scratch memory of a single thread, reused across subsets.
+     * Vertices are renumbered per subset so that the per-vertex arrays only span the subset.
+     */
+    struct Workspace
+    {
+        std::vector<uint32_t> localIndices;         ///< Mesh vertex to subset vertex, or Unmapped. Spans the whole mesh.
+        std::vector<uint32_t> meshIndices;          ///< Subset vertex to mesh vertex
+        std::vector<uint32_t> triangles;            ///< Subset vertices of each triangle
+        std::vector<uint32_t> adjacencyOffsets;     ///< Per subset vertex (plus one), offsets into adjacency
+        std::vector<uint32_t> adjacency;            ///< Triangles using each vertex
+        std::vector<uint32_t> liveCounts;           ///< Number of triangles using each vertex not yet emitted
+        std::vector<uint32_t> timestamps;           ///< Time each vertex last entered the simulated cache
+        std::vector<uint8_t> emitted;               ///< Per triangle
+        std::vector<uint32_t> deadEnds;             ///< Recently used vertices, to resume from when fanning ends
+        std::vector<uint32_t> candidates;           ///< Vertices of the triangles emitted for the current fanning vertex
+        std::vector<uint32_t> output;
+
+        std::vector<uint64_t> loadedAt;             ///< Simulated cache; see CountMisses. Spans the whole mesh.
+        uint64_t cacheTime;
+        std::vector<uint32_t> hardClusters;         ///< First triangle of each cluster starting with an empty cache
+        std::vector<uint32_t> clusters;             ///< First triangle of each cluster, plus the triangle count
+        std::vector<OBJVector3> clusterCenters;
+        std::vector<OBJVector3> clusterNormals;
+        std::vector<std::pair<float, uint32_t>> clusterOrder;
+    };
+
+    uint32_t SkipDeadEnd(Workspace& workspace, uint32_t& cursor)
+    {
+        while(!workspace.deadEnds.empty())
+        {
+            const uint32_t vertex = workspace.deadEnds.back();
+            workspace.deadEnds.pop_back();
+
+            if(workspace.liveCounts[vertex] > 0)
+            {
+                return vertex;
+            }
+        }
+
+        const uint32_t vertexCount = static_cast<uint32_t>(workspace.meshIndices.size());
+
+        while(cursor < vertexCount)
+        {
+            if(workspace.liveCounts[cursor] > 0)
+            {
+                return cursor;
+            }
+
+            cursor++;
+        }
+
+        return Unmapped;
+    }
+
+    /**
+     * Chooses the candidate vertex that will remain in the cache the longest while it 
+     * is being fanned around, preferring vertices that are already in the cache.
+     */
+    uint32_t NextFanningVertex(Workspace& workspace, uint32_t const time, uint32_t const cacheSize, uint32_t& cursor)
+    {
+        uint32_t result = Unmapped;
+        int64_t bestPriority = -1;
+
+        for(auto iter = workspace.candidates.begin(); iter != workspace.candidates.end(); ++iter)
+        {
+            const uint32_t vertex = (*iter);
+            const uint32_t live = workspace.liveCounts[vertex];
+
+            if(live > 0)
+            {
+                const int64_t age = static_cast<int64_t>(time) - workspace.timestamps[vertex];
+                const int64_t priority = ((age + (2 * static_cast<int64_t>(live))) <= cacheSize) ? age : 0;
+
+                if(priority > bestPriority)
+                {
+                    bestPriority = priority;
+                    result = vertex;
+                }
+            }
+        }
+
+        if(result == Unmapped)
+        {
+            result = SkipDeadEnd(workspace, cursor);
+        }
+
+        return result;
+    }
+
+    void Tipsify(uint32_t* indices, std::size_t const indexCount, uint32_t const cacheSize, Workspace& workspace)
+    {
+        const std::size_t triangleCount = indexCount / 3;
+
+        if(triangleCount < 2)
+        {
+            return;
+        }
+
+        //----------------------------------------------------------------
+        // Renumber the vertices of the subset
+        //----------------------------------------------------------------
+
+        workspace.meshIndices.clear();
+        workspace.triangles.resize(triangleCount * 3);
+
+        for(std::size_t i = 0; i < (triangleCount * 3); ++i)
+        {
+            uint32_t& local = workspace.localIndices[indices[i]];
+
+            if(local == Unmapped)
+            {
+                local = static_cast<uint32_t>(workspace.meshIndices.size());
+                workspace.meshIndices.push_back(indices[i]);
+            }
+
+            workspace.triangles[i] = local;
+        }
+
+        const uint32_t vertexCount = static_cast<uint32_t>(workspace.meshIndices.size());
+
+        //----------------------------------------------------------------
+        // Build the vertex to triangle adjacency
+        //----------------------------------------------------------------
+
+        workspace.liveCounts.assign(vertexCount, 0);
+
+        for(std::size_t i = 0; i < workspace.triangles.size(); ++i)
+        {
+            workspace.liveCounts[workspace.triangles[i]]++;
+        }
+
+        workspace.adjacencyOffsets.resize(vertexCount + 1);
+        workspace.adjacencyOffsets[0] = 0;
+
+        for(uint32_t v = 0; v < vertexCount; ++v)
+        {
+            workspace.adjacencyOffsets[v + 1] = workspace.adjacencyOffsets[v] + workspace.liveCounts[v];
+        }
+
+        // The timestamps serve as fill cursors until the simulation starts
+
+        workspace.timestamps.assign(workspace.adjacencyOffsets.begin(), workspace.adjacencyOffsets.end() - 1);
+        workspace.adjacency.resize(workspace.triangles.size());
+
+        for(std::size_t i = 0; i < workspace.triangles.size(); ++i)
+        {
+            workspace.adjacency[workspace.timestamps[workspace.triangles[i]]++] = static_cast<uint32_t>(i / 3);
+        }
+
+        //----------------------------------------------------------------
+        // Fan around vertices, emitting all of their remaining triangles
+        //----------------------------------------------------------------
+
+        workspace.timestamps.assign(vertexCount, 0);
+        workspace.emitted.assign(triangleCount, 0);
+        workspace.deadEnds.clear();
+        workspace.output.clear();
+
+        uint32_t time = cacheSize + 1;
+        uint32_t cursor = 1;
+        uint32_t fanning = 0;
+
+        while(fanning != Unmapped)
+        {
+            workspace.candidates.clear();
+
+            for(uint32_t a = workspace.adjacencyOffsets[fanning]; a < workspace.adjacencyOffsets[fanning + 1]; ++a)
+            {
+                const uint32_t triangle = workspace.adjacency[a];
+
+                if(workspace.emitted[triangle])
+                {
+                    continue;
+                }
+
+                for(uint32_t c = 0; c < 3; ++c)
+                {
+                    const uint32_t vertex = workspace.triangles[(triangle * 3) + c];
+
+                    workspace.output.push_back(vertex);
+                    workspace.deadEnds.push_back(vertex);
+                    workspace.candidates.push_back(vertex);
+                    workspace.liveCounts[vertex]--;
+
+                    if((time - workspace.timestamps[vertex]) > cacheSize)
+                    {
+                        workspace.timestamps[vertex] = time++;
+                    }
+                }
+
+                workspace.emitted[triangle] = 1;
+            }
+
+            fanning = NextFanningVertex(workspace, time, cacheSize, cursor);
+        }
+
+        //----------------------------------------------------------------
+        // Write back as mesh vertices, and reset the renumbering
+        //----------------------------------------------------------------
+
+        for(std::size_t i = 0; i < workspace.output.size(); ++i)
+        {
+            indices[i] = workspace.meshIndices[workspace.output[i]];
+        }
+
+        for(auto iter = workspace.meshIndices.begin(); iter != workspace.meshIndices.end(); ++iter)
+        {
+            workspace.localIndices[(*iter)] = Unmapped;
+        }
+    }
+
+    //--------------------------------------------------------------------------------------
+
+    /**
+     * Empties the simulated FIFO cache. A vertex is cached if fewer than 
+     * cacheSize misses occurred since it was loaded.
+     */
+    void ResetCache(Workspace& workspace, uint32_t const cacheSize)
+    {
+        workspace.cacheTime += cacheSize;
+    }
+
+    uint32_t CountMisses(uint32_t const* triangle, uint32_t const cacheSize, Workspace& workspace)
+    {
+        uint32_t result = 0;
+
+        for(uint32_t c = 0; c < 3; ++c)
+        {
+            uint64_t& loaded = workspace.loadedAt[triangle[c]];
+
+            if((workspace.cacheTime - loaded) >= cacheSize)
+            {
+                loaded = ++workspace.cacheTime;
+                result++;
+            }
+        }
+
+        return result;
+    }
+
+    OBJVector3 GetPosition(float const* vertices, uint32_t const stride, uint32_t const vertex)
+    {
+        float const* position = vertices + (static_cast<std::size_t>(vertex) * stride);
+
+        OBJVector3 result;
+        result.x = position[0];
+        result.y = position[1];
+        result.z = position[2];
+
+        return result;
+    }
+
+    /**
+     * Splits the triangles into clusters and sorts them to reduce overdraw, as described by 
+     * Sander, Nehab, and Barczak (2007). Returns the number of clusters.
+     */
+    uint32_t OrderClusters(uint32_t* indices, std::size_t const indexCount, float const* vertices, uint32_t const stride, uint32_t const cacheSize, float const threshold, Workspace& workspace)
+    {
+        const uint32_t triangleCount = static_cast<uint32_t>(indexCount / 3);
+
+        if(triangleCount == 0)
+        {
+            return 0;
+        }
+
+        //----------------------------------------------------------------
+        // Hard boundaries, where the cache is (effectively) flushed
+        //----------------------------------------------------------------
+
+        workspace.hardClusters.clear();
+        ResetCache(workspace, cacheSize);
+
+        for(uint32_t t = 0; t < triangleCount; ++t)
+        {
+            if((CountMisses(indices + (t * 3), cacheSize, workspace) == 3) || (t == 0))
+            {
+                workspace.hardClusters.push_back(t);
+            }
+        }
+
+        workspace.hardClusters.push_back(triangleCount);
+
+        //----------------------------------------------------------------
+        // Soft boundaries, once the cluster is already about as efficient
+        // as the whole hard cluster
+        //----------------------------------------------------------------
+
+        workspace.clusters.clear();
+
+        for(std::size_t h = 0; (h + 1) < workspace.hardClusters.size(); ++h)
+        {
+            const uint32_t start = workspace.hardClusters[h];
+            const uint32_t end = workspace.hardClusters[h + 1];
+
+            uint64_t clusterMisses = 0;
+            ResetCache(workspace, cacheSize);
+
+            for(uint32_t t = start; t < end; ++t)
+            {
+                clusterMisses += CountMisses(indices + (t * 3), cacheSize, workspace);
+            }
+
+            const double clusterThreshold = threshold * (static_cast<double>(clusterMisses) / (end - start));
+
+            uint64_t misses = 0;
+            uint64_t faces = 0;
+
+            workspace.clusters.push_back(start);
+            ResetCache(workspace, cacheSize);
+
+            for(uint32_t t = start; t < end; ++t)
+            {
+                misses += CountMisses(indices + (t * 3), cacheSize, workspace);
+                faces++;
+
+                if(((t + 1) < end) && (static_cast<double>(misses) <= (clusterThreshold * faces)))
+                {
+                    workspace.clusters.push_back(t + 1);
+                    ResetCache(workspace, cacheSize);
+
+                    misses = 0;
+                    faces = 0;
+                }
+            }
+        }
+
+        const uint32_t clusterCount = static_cast<uint32_t>(workspace.clusters.size());
+        workspace.clusters.push_back(triangleCount);
+
+        //----------------------------------------------------------------
+        // Sort by how far each cluster faces away from the subset center
+        //----------------------------------------------------------------
+
+        // Centers are area-weighted triangle centroids, so that dense tessellation does not skew them
+
+        OBJVector3 center;
+        double totalArea = 0.0;
+
+        std::vector<OBJVector3>& clusterCenters = workspace.clusterCenters;
+        std::vector<OBJVector3>& clusterNormals = workspace.clusterNormals;
+
+        clusterCenters.resize(clusterCount);
+        clusterNormals.resize(clusterCount);
+        workspace.clusterOrder.resize(clusterCount);
+
+        for(uint32_t c = 0; c < clusterCount; ++c)
+        {
+            OBJVector3 clusterCenter;
+            OBJVector3 clusterNormal;
+            double clusterArea = 0.0;
+
+            for(uint32_t t = workspace.clusters[c]; t < workspace.clusters[c + 1]; ++t)
+            {
+                const OBJVector3 p0 = GetPosition(vertices, stride, indices[(t * 3) + 0]);
+                const OBJVector3 p1 = GetPosition(vertices, stride, indices[(t * 3) + 1]);
+                const OBJVector3 p2 = GetPosition(vertices, stride, indices[(t * 3) + 2]);
+
+                // Cross product of the edges; its length is twice the triangle area
+
+                const float e1x = p1.x - p0.x, e1y = p1.y - p0.y, e1z = p1.z - p0.z;
+                const float e2x = p2.x - p0.x, e2y = p2.y - p0.y, e2z = p2.z - p0.z;
+
+                const float nx = (e1y * e2z) - (e1z * e2y);
+                const float ny = (e1z * e2x) - (e1x * e2z);
+                const float nz = (e1x * e2y) - (e1y * e2x);
+
+                const float area = std::sqrt((nx * nx) + (ny * ny) + (nz * nz)) * 0.5f;
+
+                clusterNormal.x += nx;
+                clusterNormal.y += ny;
+                clusterNormal.z += nz;
+
+                clusterCenter.x += ((p0.x + p1.x + p2.x) / 3.0f) * area;
+                clusterCenter.y += ((p0.y + p1.y + p2.y) / 3.0f) * area;
+                clusterCenter.z += ((p0.z + p1.z + p2.z) / 3.0f) * area;
+
+                clusterArea += area;
+            }
+
+            center.x += clusterCenter.x;
+            center.y += clusterCenter.y;
+            center.z += clusterCenter.z;
+            totalArea += clusterArea;
+
+            const float inverseArea = (clusterArea > 0.0) ? static_cast<float>(1.0 / clusterArea) : 0.0f;
+
+            clusterCenters[c].x = clusterCenter.x * inverseArea;
+            clusterCenters[c].y = clusterCenter.y * inverseArea;
+            clusterCenters[c].z = clusterCenter.z * inverseArea;
+
+            const float length = std::sqrt((clusterNormal.x * clusterNormal.x) + (clusterNormal.y * clusterNormal.y) + (clusterNormal.z * clusterNormal.z));
+            const float inverseLength = (length > 0.0f) ? (1.0f / length) : 0.0f;
+
+            clusterNormals[c].x = clusterNormal.x * inverseLength;
+            clusterNormals[c].y = clusterNormal.y * inverseLength;
+            clusterNormals[c].z = clusterNormal.z * inverseLength;
+        }
+
+        const float inverseTotalArea = (totalArea > 0.0) ? static_cast<float>(1.0 / totalArea) : 0.0f;
+
+        center.x *= inverseTotalArea;
+        center.y *= inverseTotalArea;
+        center.z *= inverseTotalArea;
+
+        for(uint32_t c = 0; c < clusterCount; ++c)
+        {
+            const float dot = ((clusterCenters[c].x - center.x) * clusterNormals[c].x) + 
+                              ((clusterCenters[c].y - center.y) * clusterNormals[c].y) + 
+                              ((clusterCenters[c].z - center.z) * clusterNormals[c].z);
+
+            workspace.clusterOrder[c] = std::make_pair(-dot, c);
+        }
+
+        std::stable_sort(workspace.clusterOrder.begin(), workspace.clusterOrder.end(), 
+            [](std::pair<float, uint32_t> const& lhs, std::pair<float, uint32_t> const& rhs) { return lhs.first < rhs.first; });
+
+        //----------------------------------------------------------------
+        // Write the clusters back in their new order
+        //----------------------------------------------------------------
+
+        workspace.output.clear();
+
+        for(auto iter = workspace.clusterOrder.begin(); iter != workspace.clusterOrder.end(); ++iter)
+        {
+            const uint32_t cluster = (*iter).second;
+            workspace.output.insert(workspace.output.end(), indices + (workspace.clusters[cluster] * 3), indices + (workspace.clusters[cluster + 1] * 3));
+        }
+
+        std::copy(workspace.output.begin(), workspace.output.end(), indices);
+
+        return clusterCount;
+    }
+}
+
+//------------------------------------------------------------------------------------------
+// Constructors
+//------------------------------------------------------------------------------------------
+
+OBJVertexCacheReport::OBJVertexCacheReport()
+    : cacheSize(0),
+      acmrBefore(0.0f),
+      acmrAfter(0.0f),
+      atvrBefore(0.0f),
+      atvrAfter(0.0f),
+      clusterCount(0)
+{
+
+}
+
+OBJVertexCacheOptimizer::OBJVertexCacheOptimizer()
+    : m_CacheSize(16),
+      m_ThreadCount(0),
+      m_OverdrawThreshold(0.0f)
+{
+
+}
+
+OBJVertexCacheOptimizer::~OBJVertexCacheOptimizer()
+{
+
+}
+
+//------------------------------------------------------------------------------------------
+// Public Methods
+//------------------------------------------------------------------------------------------
+
+void OBJVertexCacheOptimizer::setCacheSize(uint32_t const size)
+{
+    m_CacheSize = std::max(size, static_cast<uint32_t>(3));
+}
+
+void OBJVertexCacheOptimizer::setThreadCount(uint32_t const count)
+{
+    m_ThreadCount = count;
+}
+
+void OBJVertexCacheOptimizer::setOverdrawThreshold(float const threshold)
+{
+    m_OverdrawThreshold = threshold;
+}
+
+void OBJVertexCacheOptimizer::optimize(OBJMesh& mesh, OBJVertexCacheReport& report) const
+{
+    report.cacheSize = m_CacheSize;
+    measure(mesh.indices.data(), mesh.indices.size(), mesh.vertexCount, m_CacheSize, report.acmrBefore, report.atvrBefore);
+
+    // Largest subsets first, so that one large subset does not hold up the last thread
+
+    std::vector<std::size_t> order(mesh.subsets.size());
+
+    for(std::size_t i = 0; i < order.size(); ++i)
+    {
+        order[i] = i;
+    }
+
+    std::stable_sort(order.begin(), order.end(), [&mesh](std::size_t lhs, std::size_t rhs) { return mesh.subsets[lhs].indexCount > mesh.subsets[rhs].indexCount; });
+
+    std::atomic<std::size_t> next(0);
+    std::atomic<uint32_t> clusterCount(0);
+
+    const uint32_t cacheSize = m_CacheSize;
+    const float threshold = m_OverdrawThreshold;
+    const bool orderClusters = (threshold >= 1.0f) && !mesh.vertices.empty();
+
+    auto worker = [&mesh, &order, &next, &clusterCount, cacheSize, threshold, orderClusters]()
+    {
+        Workspace workspace;
+        workspace.localIndices.assign(mesh.vertexCount, Unmapped);
+        workspace.cacheTime = cacheSize;
+
+        if(orderClusters)
+        {
+            workspace.loadedAt.assign(mesh.vertexCount, 0);
+        }
+
+        for(std::size_t i = next++; i < order.size(); i = next++)
+        {
+            OBJMeshSubset const& subset = mesh.subsets[order[i]];
+            uint32_t* indices = mesh.indices.data() + subset.firstIndex;
+
+            Tipsify(indices, subset.indexCount, cacheSize, workspace);
+
+            if(orderClusters)
+            {
+                clusterCount += OrderClusters(indices, subset.indexCount, mesh.vertices.data(), mesh.vertexStride, cacheSize, threshold, workspace);
+            }
+        }
+    };
+
+    OBJRunWorkers(OBJGetThreadCount(m_ThreadCount, order.size()), worker);
+
+    measure(mesh.indices.data(), mesh.indices.size(), mesh.vertexCount, m_CacheSize, report.acmrAfter, report.atvrAfter);
+    report.clusterCount = clusterCount;
+    if(!mesh.shortIndices.empty())
+    {
+        OBJMeshBuilder::buildShortIndices(mesh);
+    }
+}
+
+void OBJVertexCacheOptimizer::optimizeVertexFetch(OBJMesh& mesh, std::vector<uint32_t>* previousIndices)
+{
+    const uint32_t vertexCount = mesh.vertexCount;
+
+    std::vector<uint32_t> newIndices(vertexCount, Unmapped);
+    std::vector<uint32_t> oldIndices;
+    oldIndices.reserve(vertexCount);
+
+    for(auto iter = mesh.indices.begin(); iter != mesh.indices.end(); ++iter)
+    {
+        uint32_t& index = newIndices[(*iter)];
+
+        if(index == Unmapped)
+        {
+            index = static_cast<uint32_t>(oldIndices.size());
+            oldIndices.push_back((*iter));
+        }
+
+        (*iter) = index;
+    }
+
+    for(uint32_t v = 0; v < vertexCount; ++v)
+    {
+        if(newIndices[v] == Unmapped)
+        {
+            newIndices[v] = static_cast<uint32_t>(oldIndices.size());
+            oldIndices.push_back(v);
+        }
+    }
+
+    //--------------------------------------------------------------------
+    // Gather the vertices in their new order
+    //--------------------------------------------------------------------
+
+    if(!mesh.vertices.empty())
+    {
+        const std::size_t stride = mesh.vertexStride;
+        std::vector<float> vertices(mesh.vertices.size());
+
+        for(uint32_t v = 0; v < vertexCount; ++v)
+        {
+            std::copy(mesh.vertices.begin() + (oldIndices[v] * stride), mesh.vertices.begin() + ((oldIndices[v] + 1) * stride), vertices.begin() + (v * stride));
+        }
+
+        mesh.vertices.swap(vertices);
+    }
+
+    if(!mesh.sources.empty())
+    {
+        std::vector<OBJVertexGroup> sources(mesh.sources.size());
+
+        for(uint32_t v = 0; v < vertexCount; ++v)
+        {
+            sources[v] = mesh.sources[oldIndices[v]];
+        }
+
+        mesh.sources.swap(sources);
+    }
+
+    if(!mesh.shortIndices.empty())
+    {
+        OBJMeshBuilder::buildShortIndices(mesh);
+    }
+
+    if(previousIndices)
+    {
+        previousIndices->swap(oldIndices);
+    }
+}
+
+void OBJVertexCacheOptimizer::measure(uint32_t const* indices, std::size_t const indexCount, uint32_t const vertexCount, uint32_t const cacheSize, float& acmr, float& atvr)
+{
+    // A vertex is cached if fewer than cacheSize misses occurred since it was last loaded
+
+    std::vector<uint64_t> loadedAt(vertexCount, 0);
+
+    uint64_t misses = 0;
+    uint64_t referenced = 0;
+
+    for(std::size_t i = 0; i < indexCount; ++i)
+    {
+        const uint32_t vertex = indices[i];
+
+        if(vertex >= vertexCount)
+        {
+            continue;
+        }
+
+        uint64_t& loaded = loadedAt[vertex];
+
+        if(loaded == 0)
+        {
+            referenced++;
+        }
+
+        if((loaded == 0) || ((misses - loaded) >= cacheSize))
+        {
+            loaded = ++misses;
+        }
+    }
+
+    const std::size_t triangleCount = indexCount / 3;
+
+    acmr = (triangleCount > 0) ? static_cast<float>(static_cast<double>(misses) / triangleCount) : 0.0f;
+    atvr = (referenced > 0) ? static_cast<float>(static_cast<double>(misses) / referenced) : 0.0f;
+}
+
+//------------------------------------------------------------------------------------------
+// Protected Methods
+//------------------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------------------
+// Private Methods
+//------------------------------------------------------------------------------------------
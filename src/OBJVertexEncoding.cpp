@@ -0,0 +1,462 @@
+/*
+ * Copyright 2016 Steven T Sell (ssell@vertexfragment.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "OBJVertexEncoding.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if !defined(OBJ_PARSER_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2)))
+#define OBJ_PARSER_SSE2_KERNELS
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+    const float SnormScale = 32767.0f;
+    const float UnormScale = 65535.0f;
+    const float RadiansToDegrees = 57.2957795f;
+    const float MinimumNormalLength = 1e-20f;
+
+    float SignNotZero(float const value)
+    {
+        return (value >= 0.0f) ? 1.0f : -1.0f;
+    }
+
+    /**
+     * Clamps to [low, high]. NaN becomes low, as with the SSE2 kernels (the operand order matches minps/maxps).
+     */
+    float Clamp(float const value, float const low, float const high)
+    {
+        const float result = (value > low) ? value : low;
+        return (result < high) ? result : high;
+    }
+
+#ifdef OBJ_PARSER_SSE2_KERNELS
+
+    // The kernels below produce results identical to the scalar code. The operand order of
+    // every min/max matches the scalar code, so that NaN is handled the same on both paths.
+
+    __m128 Abs(__m128 const value)
+    {
+        return _mm_andnot_ps(_mm_set1_ps(-0.0f), value);
+    }
+
+    __m128 Select(__m128 const mask, __m128 const whenTrue, __m128 const whenFalse)
+    {
+        return _mm_or_ps(_mm_and_ps(mask, whenTrue), _mm_andnot_ps(mask, whenFalse));
+    }
+
+    __m128 Clamp(__m128 const value, float const low, float const high)
+    {
+        return _mm_min_ps(_mm_max_ps(value, _mm_set1_ps(low)), _mm_set1_ps(high));
+    }
+
+    /**
+     * As std::floor, for values within the range of int32.
+     */
+    __m128i Floor(__m128 const value)
+    {
+        const __m128i truncated = _mm_cvttps_epi32(value);
+        const __m128 roundedUp = _mm_cmpgt_ps(_mm_cvtepi32_ps(truncated), value);
+
+        return _mm_add_epi32(truncated, _mm_castps_si128(roundedUp));      // Mask is -1 where truncation rounded up
+    }
+
+    /**
+     * Encodes four normals. See OBJVertexEncoder::encodeNormals.
+     */
+    void EncodeNormals4(OBJVector3 const* source, OBJOctahedralNormal* destination)
+    {
+        const __m128 x = _mm_setr_ps(source[0].x, source[1].x, source[2].x, source[3].x);
+        const __m128 y = _mm_setr_ps(source[0].y, source[1].y, source[2].y, source[3].y);
+        const __m128 z = _mm_setr_ps(source[0].z, source[1].z, source[2].z, source[3].z);
+
+        const __m128 one = _mm_set1_ps(1.0f);
+        const __m128 zero = _mm_setzero_ps();
+
+        const __m128 length = _mm_add_ps(_mm_add_ps(Abs(x), Abs(y)), Abs(z));
+        const __m128 inverse = _mm_div_ps(one, _mm_max_ps(_mm_set1_ps(MinimumNormalLength), length));
+
+        const __m128 px = _mm_mul_ps(x, inverse);
+        const __m128 py = _mm_mul_ps(y, inverse);
+
+        const __m128 signX = Select(_mm_cmpge_ps(px, zero), one, _mm_set1_ps(-1.0f));
+        const __m128 signY = Select(_mm_cmpge_ps(py, zero), one, _mm_set1_ps(-1.0f));
+
+        const __m128 foldX = _mm_mul_ps(_mm_sub_ps(one, Abs(py)), signX);
+        const __m128 foldY = _mm_mul_ps(_mm_sub_ps(one, Abs(px)), signY);
+
+        const __m128 lower = _mm_cmplt_ps(z, zero);
+        const __m128 half = _mm_set1_ps(0.5f);
+        const __m128 scale = _mm_set1_ps(SnormScale);
+
+        const __m128i ox = Floor(_mm_add_ps(_mm_mul_ps(Clamp(Select(lower, foldX, px), -1.0f, 1.0f), scale), half));
+        const __m128i oy = Floor(_mm_add_ps(_mm_mul_ps(Clamp(Select(lower, foldY, py), -1.0f, 1.0f), scale), half));
+
+        // Interleave to x0 y0 x1 y1 ... and narrow. All values are within [-32767, 32767].
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(destination), _mm_packs_epi32(_mm_unpacklo_epi32(ox, oy), _mm_unpackhi_epi32(ox, oy)));
+    }
+
+    /**
+     * Encodes two texture coordinates as Unorm16. See OBJVertexEncoder::encodeTextures.
+     */
+    void EncodeUnorm16x2(OBJVector2 const* source, OBJPackedVector2* destination)
+    {
+        const __m128 value = _mm_setr_ps(source[0].x, source[0].y, source[1].x, source[1].y);
+        const __m128i quantized = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(Clamp(value, 0.0f, 1.0f), _mm_set1_ps(UnormScale)), _mm_set1_ps(0.5f)));
+
+        // SSE2 has no unsigned saturating pack, so bias into the signed range and back
+        const __m128i bias = _mm_set1_epi32(32768);
+        const __m128i packed = _mm_packs_epi32(_mm_sub_epi32(quantized, bias), _mm_setzero_si128());
+
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(destination), _mm_xor_si128(packed, _mm_set1_epi16(-32768)));
+    }
+
+#endif
+}
+
+//------------------------------------------------------------------------------------------
+// Structs
+//------------------------------------------------------------------------------------------
+
+OBJOctahedralNormal::OBJOctahedralNormal()
+    : x(0),
+      y(0)
+{
+
+}
+
+OBJPackedVector2::OBJPackedVector2()
+    : x(0),
+      y(0)
+{
+
+}
+
+OBJEncodingReport::OBJEncodingReport()
+    : normalCount(0),
+      maxNormalError(0.0f),
+      textureCount(0),
+      maxTextureError(0.0f),
+      clampedTextureCount(0)
+{
+
+}
+
+//------------------------------------------------------------------------------------------
+// Public Methods
+//------------------------------------------------------------------------------------------
+
+void OBJVertexEncoder::encodeNormals(OBJVector3 const* source, std::size_t const count, OBJOctahedralNormal* destination)
+{
+    std::size_t i = 0;
+
+#ifdef OBJ_PARSER_SSE2_KERNELS
+    for(; (i + 4) <= count; i += 4)
+    {
+        EncodeNormals4(&source[i], &destination[i]);
+    }
+#endif
+
+    for(; i < count; ++i)
+    {
+        const float x = source[i].x;
+        const float y = source[i].y;
+        const float z = source[i].z;
+
+        // Project onto the octahedron |x| + |y| + |z| = 1. Degenerate normals map to +z.
+
+        const float inverse = 1.0f / std::max(std::fabs(x) + std::fabs(y) + std::fabs(z), MinimumNormalLength);
+
+        const float px = x * inverse;
+        const float py = y * inverse;
+
+        // Fold the lower hemisphere over the diagonals
+
+        const float foldX = (1.0f - std::fabs(py)) * SignNotZero(px);
+        const float foldY = (1.0f - std::fabs(px)) * SignNotZero(py);
+
+        const float ox = (z < 0.0f) ? foldX : px;
+        const float oy = (z < 0.0f) ? foldY : py;
+
+        destination[i].x = static_cast<int16_t>(std::floor((Clamp(ox, -1.0f, 1.0f) * SnormScale) + 0.5f));
+        destination[i].y = static_cast<int16_t>(std::floor((Clamp(oy, -1.0f, 1.0f) * SnormScale) + 0.5f));
+    }
+}
+
+void OBJVertexEncoder::encodeTextures(OBJVector2 const* source, std::size_t const count, OBJTextureEncoding const encoding, OBJPackedVector2* destination)
+{
+    std::size_t i = 0;
+
+    if(encoding == OBJTextureEncoding::Unorm16)
+    {
+#ifdef OBJ_PARSER_SSE2_KERNELS
+        for(; (i + 2) <= count; i += 2)
+        {
+            EncodeUnorm16x2(&source[i], &destination[i]);
+        }
+#endif
+
+        for(; i < count; ++i)
+        {
+            destination[i].x = static_cast<uint16_t>((Clamp(source[i].x, 0.0f, 1.0f) * UnormScale) + 0.5f);
+            destination[i].y = static_cast<uint16_t>((Clamp(source[i].y, 0.0f, 1.0f) * UnormScale) + 0.5f);
+        }
+    }
+    else if(encoding == OBJTextureEncoding::Half)
+    {
+        for(; (i + 2) <= count; i += 2)
+        {
+            const float values[4] = { source[i].x, source[i].y, source[i + 1].x, source[i + 1].y };
+            uint16_t halves[4];
+
+            floatToHalf4(values, halves);
+
+            destination[i].x = halves[0];
+            destination[i].y = halves[1];
+            destination[i + 1].x = halves[2];
+            destination[i + 1].y = halves[3];
+        }
+
+        for(; i < count; ++i)
+        {
+            destination[i].x = floatToHalf(source[i].x);
+            destination[i].y = floatToHalf(source[i].y);
+        }
+    }
+}
+
+OBJVector3 OBJVertexEncoder::decodeNormal(OBJOctahedralNormal const& normal)
+{
+    OBJVector3 result;
+
+    result.x = std::max(static_cast<float>(normal.x) / SnormScale, -1.0f);
+    result.y = std::max(static_cast<float>(normal.y) / SnormScale, -1.0f);
+    result.z = 1.0f - std::fabs(result.x) - std::fabs(result.y);
+
+    // Unfold the lower hemisphere
+
+    const float t = std::max(-result.z, 0.0f);
+
+    result.x += (result.x >= 0.0f) ? -t : t;
+    result.y += (result.y >= 0.0f) ? -t : t;
+
+    const float inverseLength = 1.0f / std::sqrt((result.x * result.x) + (result.y * result.y) + (result.z * result.z));
+
+    result.x *= inverseLength;
+    result.y *= inverseLength;
+    result.z *= inverseLength;
+
+    return result;
+}
+
+OBJVector2 OBJVertexEncoder::decodeTexture(OBJPackedVector2 const& texture, OBJTextureEncoding const encoding)
+{
+    OBJVector2 result;
+
+    if(encoding == OBJTextureEncoding::Unorm16)
+    {
+        result.x = static_cast<float>(texture.x) / UnormScale;
+        result.y = static_cast<float>(texture.y) / UnormScale;
+    }
+    else if(encoding == OBJTextureEncoding::Half)
+    {
+        result.x = halfToFloat(texture.x);
+        result.y = halfToFloat(texture.y);
+    }
+
+    return result;
+}
+
+void OBJVertexEncoder::measureNormals(OBJVector3 const* source, OBJOctahedralNormal const* encoded, std::size_t const count, OBJEncodingReport& report)
+{
+    float minCosine = 1.0f;
+
+    for(std::size_t i = 0; i < count; ++i)
+    {
+        const float length = std::sqrt((source[i].x * source[i].x) + (source[i].y * source[i].y) + (source[i].z * source[i].z));
+
+        if(length > 0.0f)
+        {
+            const OBJVector3 decoded = decodeNormal(encoded[i]);
+            const float cosine = ((source[i].x * decoded.x) + (source[i].y * decoded.y) + (source[i].z * decoded.z)) / length;
+
+            minCosine = std::min(minCosine, cosine);
+        }
+    }
+
+    const float angle = std::acos(Clamp(minCosine, -1.0f, 1.0f)) * RadiansToDegrees;
+
+    report.maxNormalError = std::max(report.maxNormalError, angle);
+    report.normalCount += static_cast<uint32_t>(count);
+}
+
+void OBJVertexEncoder::measureTextures(OBJVector2 const* source, OBJPackedVector2 const* encoded, std::size_t const count, OBJTextureEncoding const encoding, OBJEncodingReport& report)
+{
+    for(std::size_t i = 0; i < count; ++i)
+    {
+        const OBJVector2 decoded = decodeTexture(encoded[i], encoding);
+
+        if((encoding == OBJTextureEncoding::Unorm16) && 
+           ((source[i].x < 0.0f) || (source[i].x > 1.0f) || (source[i].y < 0.0f) || (source[i].y > 1.0f)))
+        {
+            // Clamped values are reported separately so they do not mask the precision of the encoding
+            report.clampedTextureCount++;
+        }
+        else
+        {
+            report.maxTextureError = std::max(report.maxTextureError, std::fabs(decoded.x - source[i].x));
+            report.maxTextureError = std::max(report.maxTextureError, std::fabs(decoded.y - source[i].y));
+        }
+    }
+
+    report.textureCount += static_cast<uint32_t>(count);
+}
+
+uint16_t OBJVertexEncoder::floatToHalf(float const value)
+{
+    // Round-to-nearest-even conversion, handling denormals, infinities, and NaN.
+
+    const uint32_t float32Infinity = 255u << 23;
+    const uint32_t float16Maximum = (127u + 16u) << 23;
+    const uint32_t denormalMagicBits = ((127u - 15u) + (23u - 10u) + 1u) << 23;
+
+    uint32_t bits = 0;
+    std::memcpy(&bits, &value, sizeof(bits));
+
+    const uint32_t sign = bits & 0x80000000u;
+    bits ^= sign;
+
+    uint16_t result = 0;
+
+    if(bits >= float16Maximum)
+    {
+        result = (bits > float32Infinity) ? 0x7e00 : 0x7c00;
+    }
+    else if(bits < (113u << 23))
+    {
+        // Denormal result; let the floating point unit do the rounding
+        float magnitude = 0.0f;
+        float magic = 0.0f;
+
+        std::memcpy(&magnitude, &bits, sizeof(bits));
+        std::memcpy(&magic, &denormalMagicBits, sizeof(denormalMagicBits));
+
+        magnitude += magic;
+        std::memcpy(&bits, &magnitude, sizeof(bits));
+
+        result = static_cast<uint16_t>(bits - denormalMagicBits);
+    }
+    else
+    {
+        const uint32_t mantissaOdd = (bits >> 13) & 1;
+
+        bits -= (112u << 23);      // Rebias the exponent from 127 to 15
+        bits += 0xfff + mantissaOdd;
+
+        result = static_cast<uint16_t>(bits >> 13);
+    }
+
+    return static_cast<uint16_t>(result | (sign >> 16));
+}
+
+void OBJVertexEncoder::floatToHalf4(float const* value, uint16_t* result)
+{
+#ifdef OBJ_PARSER_SSE2_KERNELS
+    // Four-wide version of floatToHalf, producing identical results
+
+    const __m128i float16Maximum = _mm_set1_epi32((127 + 16) << 23);
+    const __m128i minimumNormal = _mm_set1_epi32((127 - 14) << 23);
+    const __m128i denormalMagic = _mm_set1_epi32(((127 - 15) + (23 - 10) + 1) << 23);
+    const __m128i normalBias = _mm_set1_epi32(0xfff - ((127 - 15) << 23));
+
+    const __m128 v = _mm_loadu_ps(value);
+    const __m128 sign = _mm_and_ps(v, _mm_set1_ps(-0.0f));
+    const __m128 absolute = _mm_xor_ps(v, sign);
+    const __m128i bits = _mm_castps_si128(absolute);
+
+    const __m128i isNaN = _mm_castps_si128(_mm_cmpunord_ps(absolute, absolute));
+    const __m128i isRegular = _mm_cmpgt_epi32(float16Maximum, bits);
+    const __m128i isDenormal = _mm_cmpgt_epi32(minimumNormal, bits);
+
+    const __m128i special = _mm_or_si128(_mm_and_si128(isNaN, _mm_set1_epi32(0x200)), _mm_set1_epi32(0x7c00));
+    const __m128i denormal = _mm_sub_epi32(_mm_castps_si128(_mm_add_ps(absolute, _mm_castsi128_ps(denormalMagic))), denormalMagic);
+
+    const __m128i mantissaOdd = _mm_srai_epi32(_mm_slli_epi32(bits, 31 - 13), 31);
+    const __m128i normal = _mm_srli_epi32(_mm_sub_epi32(_mm_add_epi32(bits, normalBias), mantissaOdd), 13);
+
+    __m128i half = _mm_or_si128(_mm_and_si128(isDenormal, denormal), _mm_andnot_si128(isDenormal, normal));
+    half = _mm_or_si128(_mm_and_si128(isRegular, half), _mm_andnot_si128(isRegular, special));
+    half = _mm_or_si128(half, _mm_srai_epi32(_mm_castps_si128(sign), 16));
+
+    // The sign extension above keeps every lane within int16, so the saturating pack is exact
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(result), _mm_packs_epi32(half, half));
+#else
+    for(int i = 0; i < 4; ++i)
+    {
+        result[i] = floatToHalf(value[i]);
+    }
+#endif
+}
+
+float OBJVertexEncoder::halfToFloat(uint16_t const value)
+{
+    const uint32_t shiftedExponent = 0x7c00u << 13;
+    const uint32_t denormalMagicBits = 113u << 23;
+
+    uint32_t bits = (static_cast<uint32_t>(value) & 0x7fff) << 13;
+    const uint32_t exponent = shiftedExponent & bits;
+
+    bits += (127u - 15u) << 23;
+
+    if(exponent == shiftedExponent)
+    {
+        // Infinity or NaN
+        bits += (128u - 16u) << 23;
+    }
+    else if(exponent == 0)
+    {
+        // Denormal
+        float magnitude = 0.0f;
+        float magic = 0.0f;
+
+        bits += 1u << 23;
+
+        std::memcpy(&magnitude, &bits, sizeof(bits));
+        std::memcpy(&magic, &denormalMagicBits, sizeof(denormalMagicBits));
+
+        magnitude -= magic;
+        std::memcpy(&bits, &magnitude, sizeof(bits));
+    }
+
+    bits |= (static_cast<uint32_t>(value) & 0x8000) << 16;
+
+    float result = 0.0f;
+    std::memcpy(&result, &bits, sizeof(bits));
+
+    return result;
+}
+
+//------------------------------------------------------------------------------------------
+// Protected Methods
+//------------------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------------------
+// Private Methods
+//------------------------------------------------------------------------------------------
@@ -0,0 +1,310 @@
+/*
+ * Copyright 2016 Steven T Sell (ssell@vertexfragment.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "OBJVertexPacker.hpp"
+#include "OBJVertexEncoding.hpp"
+#include "OBJState.hpp"
+
+#include <cstring>
+
+#if !defined(OBJ_PARSER_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2)))
+#define OBJ_PARSER_SSE2_KERNELS
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+    /**
+     * Per-component parameters of a normalized integer conversion, computed as:
+     *
+     *     trunc((clamp(value, low, high) * scale) + bias) - offset
+     *
+     * The bias keeps the sum positive, so that the truncation rounds to nearest.
+     */
+    struct QuantizeParams
+    {
+        float low[4];
+        float high[4];
+        float scale[4];
+        float bias[4];
+        int32_t offset[4];
+    };
+
+    QuantizeParams MakeParams(float const low, float const scaleXYZ, float const scaleW)
+    {
+        QuantizeParams result;
+
+        for(int i = 0; i < 4; ++i)
+        {
+            const float scale = (i < 3) ? scaleXYZ : scaleW;
+            const float offset = (low < 0.0f) ? (scale + 1.0f) : 0.0f;
+
+            result.low[i] = low;
+            result.high[i] = 1.0f;
+            result.scale[i] = scale;
+            result.bias[i] = offset + 0.5f;
+            result.offset[i] = static_cast<int32_t>(offset);
+        }
+
+        return result;
+    }
+
+    const QuantizeParams Snorm16 = MakeParams(-1.0f, 32767.0f, 32767.0f);
+    const QuantizeParams Snorm10_10_10_2 = MakeParams(-1.0f, 511.0f, 1.0f);
+    const QuantizeParams Unorm16 = MakeParams(0.0f, 65535.0f, 65535.0f);
+
+    void Quantize(float const* value, QuantizeParams const& params, int32_t* result)
+    {
+#ifdef OBJ_PARSER_SSE2_KERNELS
+        __m128 v = _mm_loadu_ps(value);
+
+        v = _mm_min_ps(_mm_max_ps(v, _mm_loadu_ps(params.low)), _mm_loadu_ps(params.high));
+        v = _mm_add_ps(_mm_mul_ps(v, _mm_loadu_ps(params.scale)), _mm_loadu_ps(params.bias));
+
+        const __m128i q = _mm_sub_epi32(_mm_cvttps_epi32(v), _mm_loadu_si128(reinterpret_cast<__m128i const*>(params.offset)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(result), q);
+#else
+        for(int i = 0; i < 4; ++i)
+        {
+            // Same operand order as minps/maxps, so that NaN becomes the lower bound on both paths
+            float v = (value[i] > params.low[i]) ? value[i] : params.low[i];
+            v = (v < params.high[i]) ? v : params.high[i];
+
+            result[i] = static_cast<int32_t>((v * params.scale[i]) + params.bias[i]) - params.offset[i];
+        }
+#endif
+    }
+
+    uint32_t Pack10_10_10_2(int32_t const* value)
+    {
+        return (static_cast<uint32_t>(value[0]) & 0x3ff) | 
+              ((static_cast<uint32_t>(value[1]) & 0x3ff) << 10) | 
+              ((static_cast<uint32_t>(value[2]) & 0x3ff) << 20) | 
+              ((static_cast<uint32_t>(value[3]) & 0x3) << 30);
+    }
+
+    /**
+     * Writes a normal or tangent. The w component is only written for tangents.
+     */
+    void WriteDirection(float const* value, OBJNormalFormat const format, bool const tangent, uint8_t* destination)
+    {
+        int32_t quantized[4];
+
+        if(format == OBJNormalFormat::Float3)
+        {
+            std::memcpy(destination, value, tangent ? 16 : 12);
+        }
+        else if(format == OBJNormalFormat::Snorm16x4)
+        {
+            Quantize(value, Snorm16, quantized);
+
+            const int16_t packed[4] = { static_cast<int16_t>(quantized[0]), static_cast<int16_t>(quantized[1]), static_cast<int16_t>(quantized[2]), static_cast<int16_t>(quantized[3]) };
+            std::memcpy(destination, packed, sizeof(packed));
+        }
+        else if(format == OBJNormalFormat::Snorm10_10_10_2)
+        {
+            Quantize(value, Snorm10_10_10_2, quantized);
+
+            const uint32_t packed = Pack10_10_10_2(quantized);
+            std::memcpy(destination, &packed, sizeof(packed));
+        }
+    }
+}
+
+//------------------------------------------------------------------------------------------
+// Constructors
+//------------------------------------------------------------------------------------------
+
+OBJVertexLayout::OBJVertexLayout()
+    : position(OBJPositionFormat::Float3),
+      normal(OBJNormalFormat::None),
+      texture(OBJTexCoordFormat::None),
+      tangent(OBJNormalFormat::None),
+      positionOffset(0),
+      normalOffset(0),
+      textureOffset(0),
+      tangentOffset(0),
+      stride(12)
+{
+
+}
+
+//------------------------------------------------------------------------------------------
+// Public Methods
+//------------------------------------------------------------------------------------------
+
+void OBJVertexLayout::computeOffsets()
+{
+    positionOffset = 0;
+    normalOffset = positionOffset + getSize(position);
+    textureOffset = normalOffset + getSize(normal, false);
+    tangentOffset = textureOffset + getSize(texture);
+    stride = tangentOffset + getSize(tangent, true);
+}
+
+bool OBJVertexLayout::isValid() const
+{
+    return ((positionOffset + getSize(position)) <= stride) &&
+           ((normal == OBJNormalFormat::None) || ((normalOffset + getSize(normal, false)) <= stride)) &&
+           ((texture == OBJTexCoordFormat::None) || ((textureOffset + getSize(texture)) <= stride)) &&
+           ((tangent == OBJNormalFormat::None) || ((tangentOffset + getSize(tangent, true)) <= stride));
+}
+
+uint32_t OBJVertexLayout::getSize(OBJPositionFormat const format)
+{
+    return (format == OBJPositionFormat::Half4) ? 8 : 12;
+}
+
+uint32_t OBJVertexLayout::getSize(OBJNormalFormat const format, bool const tangent)
+{
+    uint32_t result = 0;
+
+    switch(format)
+    {
+    case OBJNormalFormat::Float3:
+        result = tangent ? 16 : 12;
+        break;
+
+    case OBJNormalFormat::Snorm16x4:
+        result = 8;
+        break;
+
+    case OBJNormalFormat::Snorm10_10_10_2:
+        result = 4;
+        break;
+
+    default:
+        break;
+    }
+
+    return result;
+}
+
+uint32_t OBJVertexLayout::getSize(OBJTexCoordFormat const format)
+{
+    uint32_t result = 0;
+
+    switch(format)
+    {
+    case OBJTexCoordFormat::Float2:
+        result = 8;
+        break;
+
+    case OBJTexCoordFormat::Half2:
+    case OBJTexCoordFormat::Unorm16x2:
+        result = 4;
+        break;
+
+    default:
+        break;
+    }
+
+    return result;
+}
+
+bool OBJVertexPacker::pack(OBJState const& state, OBJVertexLayout const& layout, OBJVertexGroup const* sources, std::size_t const count, OBJVector4 const* tangents, void* destination)
+{
+    if(!layout.isValid() || ((layout.tangent != OBJNormalFormat::None) && (tangents == nullptr)))
+    {
+        return false;
+    }
+
+    uint8_t* vertex = static_cast<uint8_t*>(destination);
+    uint16_t halves[4];
+    int32_t quantized[4];
+
+    for(std::size_t i = 0; i < count; ++i, vertex += layout.stride)
+    {
+        OBJVertexGroup const& source = sources[i];
+
+        //----------------------------------------------------------------
+        // Position
+        //----------------------------------------------------------------
+
+        const OBJVector4 spatial = state.getSpatial(static_cast<OBJCount>(source.indexSpatial));
+        const float position[4] = { spatial.x, spatial.y, spatial.z, 1.0f };
+
+        if(layout.position == OBJPositionFormat::Float3)
+        {
+            std::memcpy(vertex + layout.positionOffset, position, 12);
+        }
+        else
+        {
+            OBJVertexEncoder::floatToHalf4(position, halves);
+            std::memcpy(vertex + layout.positionOffset, halves, 8);
+        }
+
+        //----------------------------------------------------------------
+        // Normal
+        //----------------------------------------------------------------
+
+        if(layout.normal != OBJNormalFormat::None)
+        {
+            const OBJVector3 normal = OBJStorage::Indices::isUsed(source.indexNormal) ? state.getNormal(static_cast<OBJCount>(source.indexNormal)) : OBJVector3();
+            const float value[4] = { normal.x, normal.y, normal.z, 0.0f };
+
+            WriteDirection(value, layout.normal, false, vertex + layout.normalOffset);
+        }
+
+        //----------------------------------------------------------------
+        // Texture Coordinate
+        //----------------------------------------------------------------
+
+        if(layout.texture != OBJTexCoordFormat::None)
+        {
+            const OBJVector2 texture = OBJStorage::Indices::isUsed(source.indexTexture) ? state.getTexture(static_cast<OBJCount>(source.indexTexture)) : OBJVector2();
+            const float value[4] = { texture.x, texture.y, 0.0f, 0.0f };
+
+            if(layout.texture == OBJTexCoordFormat::Float2)
+            {
+                std::memcpy(vertex + layout.textureOffset, value, 8);
+            }
+            else if(layout.texture == OBJTexCoordFormat::Half2)
+            {
+                OBJVertexEncoder::floatToHalf4(value, halves);
+                std::memcpy(vertex + layout.textureOffset, halves, 4);
+            }
+            else
+            {
+                Quantize(value, Unorm16, quantized);
+
+                const uint16_t packed[2] = { static_cast<uint16_t>(quantized[0]), static_cast<uint16_t>(quantized[1]) };
+                std::memcpy(vertex + layout.textureOffset, packed, sizeof(packed));
+            }
+        }
+
+        //----------------------------------------------------------------
+        // Tangent
+        //----------------------------------------------------------------
+
+        if(layout.tangent != OBJNormalFormat::None)
+        {
+            const float value[4] = { tangents[i].x, tangents[i].y, tangents[i].z, tangents[i].w };
+            WriteDirection(value, layout.tangent, true, vertex + layout.tangentOffset);
+        }
+    }
+
+    return true;
+}
+
+//------------------------------------------------------------------------------------------
+// Protected Methods
+//------------------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------------------
+// Private Methods
+//------------------------------------------------------------------------------------------
@@ -15,10 +15,26 @@
  */
 
 #include <iostream>
+#include <fstream>
 #include <string>
 #include <chrono>
+#include <cstdio>
+#include <sstream>
+#include <cmath>
+#include <algorithm>
+#include <vector>
+#include <cstring>
 
 #include "OBJParser.hpp"
+#include "OBJArena.hpp"
+#include "OBJSegmentedVector.hpp"
+#include "OBJMeshBuilder.hpp"
+#include "OBJBatchBuilder.hpp"
+#include "OBJVertexPacker.hpp"
+#include "OBJVertexCacheOptimizer.hpp"
+#include "OBJMeshletBuilder.hpp"
+#include "OBJNormalGenerator.hpp"
+#include "OBJTangentGenerator.hpp"
 
 //------------------------------------------------------------------------------------------
 
@@ -31,9 +47,9 @@ void OutputState(OBJState* state)
     //--------------------------------------------------------------------
 
     std::cout << "- Vertex Data" << "\n"
-              << "    Spatial Count: " << state->getSpatialData()->size() << "\n"
-              << "    Texture Count: " << state->getTextureData()->size() << "\n"
-              << "    Normals Count: " << state->getNormalData()->size()  << "\n"
+              << "    Spatial Count: " << state->getSpatialCount() << "\n"
+              << "    Texture Count: " << state->getTextureCount() << "\n"
+              << "    Normals Count: " << state->getNormalCount()  << "\n"
               << "     Params Count: " << state->getFreeFormState()->vertexParameterData.size() << std::endl;
     
     //--------------------------------------------------------------------
@@ -49,8 +65,8 @@ void OutputState(OBJState* state)
     {
         std::cout << "    Group:" << "\n"
                   << "             Name: " << group->name << "\n"
-                  << "         # Points: " << group->points.size() << "\n"
-                  << "          # Lines: " << group->lines.size() << "\n"
+                  << "         # Points: " << group->getPointCollectionCount() << "\n"
+                  << "          # Lines: " << group->getLineCount() << "\n"
                   << "          # Faces: " << group->faces.size() << std::endl;
     }
 
@@ -82,7 +98,6 @@ void ParsePath(std::string const& path, OBJParser& parser)
     const auto result = parser.parseOBJFile(path);
     const auto end = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
 
-    const auto elapsed = end - start;
     const double elapsedd = static_cast<double>(end - start) / static_cast<double>(1e9);
 
     if(result != OBJParser::Result::Success)
@@ -98,6 +113,1105 @@ void ParsePath(std::string const& path, OBJParser& parser)
     }
 }
 
+//------------------------------------------------------------------------------------------
+// Self Checks
+//
+// Run the sample with --check. Each check writes a small OBJ (and MTL) file to the 
+// working directory, parses it, and verifies the output of one part of the library.
+//------------------------------------------------------------------------------------------
+
+uint32_t g_CheckFailures = 0;
+
+void Check(bool const passed, std::string const& description)
+{
+    std::cout << (passed ? "    [PASS] " : "    [FAIL] ") << description << std::endl;
+
+    if(!passed)
+    {
+        ++g_CheckFailures;
+    }
+}
+
+bool WriteFile(std::string const& path, std::string const& contents)
+{
+    std::ofstream stream(path.c_str(), std::ios::out | std::ios::binary);
+    stream << contents;
+
+    return stream.good();
+}
+
+bool ParseSource(OBJParser& parser, std::string const& path, std::string const& source)
+{
+    if(!WriteFile(path, source))
+    {
+        std::cout << "    Error: Failed to write " << path << std::endl;
+        return false;
+    }
+
+    const auto result = parser.parseOBJFile(path);
+    std::remove(path.c_str());
+
+    if(result != OBJParser::Result::Success)
+    {
+        std::cout << "    Error: " << parser.getLastError() << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+std::string CubeSource(bool const smooth)
+{
+    std::string source = 
+        "v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\n"
+        "v 0 0 1\nv 1 0 1\nv 1 1 1\nv 0 1 1\n"
+        "g cube\n";
+
+    source += (smooth ? "s 1\n" : "s off\n");
+    source += 
+        "f 1 4 3 2\nf 5 6 7 8\nf 1 2 6 5\n"
+        "f 2 3 7 6\nf 3 4 8 7\nf 4 1 5 8\n";
+
+    return source;
+}
+
+/**
+ * Grid of width x height quads (split into triangles) in the xy plane.
+ *
+ * \param[in] mirrored If true, the texture u coordinate is mirrored about the center column, as on a symmetric model.
+ * \param[in] shuffled If true, the quads are written in a fixed pseudo-random order instead of row order.
+ */
+std::string GridSource(uint32_t const width, uint32_t const height, bool const mirrored, bool const shuffled)
+{
+    std::ostringstream source;
+
+    for(uint32_t y = 0; y <= height; ++y)
+    {
+        for(uint32_t x = 0; x <= width; ++x)
+        {
+            source << "v " << x << " " << y << " 0\n";
+        }
+    }
+
+    for(uint32_t y = 0; y <= height; ++y)
+    {
+        for(uint32_t x = 0; x <= width; ++x)
+        {
+            const uint32_t u = ((mirrored && (x > (width / 2))) ? (width - x) : x);
+            source << "vt " << (static_cast<float>(u) / static_cast<float>(width)) << " " << (static_cast<float>(y) / static_cast<float>(height)) << "\n";
+        }
+    }
+
+    source << "vn 0 0 1\ng grid\n";
+
+    std::vector<uint32_t> quads(width * height);
+
+    for(uint32_t i = 0; i < quads.size(); ++i)
+    {
+        quads[i] = i;
+    }
+
+    if(shuffled)
+    {
+        uint32_t seed = 12345;
+
+        for(std::size_t i = quads.size() - 1; i > 0; --i)
+        {
+            seed = (seed * 1664525u) + 1013904223u;
+            std::swap(quads[i], quads[seed % (i + 1)]);
+        }
+    }
+
+    for(auto quad : quads)
+    {
+        const uint32_t a = ((quad / width) * (width + 1)) + (quad % width) + 1;
+        const uint32_t b = a + 1;
+        const uint32_t c = a + width + 1;
+        const uint32_t d = c + 1;
+
+        source << "f " << a << "/" << a << "/1 " << b << "/" << b << "/1 " << d << "/" << d << "/1\n";
+        source << "f " << a << "/" << a << "/1 " << d << "/" << d << "/1 " << c << "/" << c << "/1\n";
+    }
+
+    return source.str();
+}
+
+/**
+ * \return One key per triangle of the index list, built from the sorted spatial indices of its corners. Sorted.
+ */
+std::vector<uint64_t> TriangleKeys(OBJMesh const& mesh, std::vector<uint32_t> const& indices)
+{
+    std::vector<uint64_t> keys;
+    keys.reserve(indices.size() / 3);
+
+    for(std::size_t i = 0; (i + 2) < indices.size(); i += 3)
+    {
+        uint64_t corners[3] = 
+        {
+            static_cast<uint64_t>(mesh.sources[indices[i]].indexSpatial),
+            static_cast<uint64_t>(mesh.sources[indices[i + 1]].indexSpatial),
+            static_cast<uint64_t>(mesh.sources[indices[i + 2]].indexSpatial)
+        };
+
+        std::sort(corners, corners + 3);
+        keys.push_back((corners[0] << 42) | (corners[1] << 21) | corners[2]);
+    }
+
+    std::sort(keys.begin(), keys.end());
+
+    return keys;
+}
+
+/**
+ * \return True if the position of every written vertex matches its source spatial vertex.
+ */
+bool VerticesMatchSources(OBJState const& state, OBJMesh const& mesh)
+{
+    for(uint32_t v = 0; v < mesh.vertexCount; ++v)
+    {
+        const OBJVector4 spatial = state.getSpatial(mesh.sources[v].indexSpatial);
+        float const* vertex = &mesh.vertices[v * mesh.vertexStride];
+
+        if((vertex[0] != spatial.x) || (vertex[1] != spatial.y) || (vertex[2] != spatial.z))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * \return True if every short index of every subset matches the full index list.
+ */
+bool ShortIndicesMatch(OBJMesh const& mesh)
+{
+    if(mesh.shortIndices.size() != mesh.indices.size())
+    {
+        return false;
+    }
+
+    for(auto const& subset : mesh.subsets)
+    {
+        for(uint32_t i = subset.firstIndex; i < (subset.firstIndex + subset.indexCount); ++i)
+        {
+            if((mesh.shortIndices[i] == 0xFFFF) || ((mesh.shortIndices[i] + subset.baseVertex) != mesh.indices[i]))
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+//------------------------------------------------------------------------------------------
+
+void CheckRenderStates()
+{
+    std::cout << "- Render States" << std::endl;
+
+    OBJParser parser;
+    OBJState* state = parser.getOBJState();
+
+    Check(ParseSource(parser, "./objcheck_states.obj", 
+        "v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\ng states\n"
+        "usemtl a\nf 1 2 3\nusemtl b\nf 1 3 4\nusemtl a\nf 1 2 4\nf 2 3 4\n"), "Parses the render state sample");
+
+    std::vector<OBJGroup const*> groups;
+    state->getGroups(groups);
+
+    if(groups.size() == 1)
+    {
+        OBJGroup const* group = groups[0];
+
+        Check((group->renderStateRanges.size() == 3) && (group->faces[0].renderState == group->faces[2].renderState) && (group->faces[0].renderState != group->faces[1].renderState), 
+              "Identical render states are shared across ranges");
+        Check((group->renderStateRanges[2].firstFace == 2) && (group->renderStateRanges[2].faceCount == 2), "Consecutive faces extend their range");
+    }
+    else
+    {
+        Check(false, "One group parsed");
+    }
+}
+
+void CheckLinesAndPoints()
+{
+    std::cout << "- Lines and Points" << std::endl;
+
+    OBJParser parser;
+    OBJState* state = parser.getOBJState();
+
+    Check(ParseSource(parser, "./objcheck_lines.obj", "v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\ng lines\nl 1 2 3\nl 3 4\np 1 2\n"), "Parses the line sample");
+
+    std::vector<OBJGroup const*> groups;
+    state->getGroups(groups);
+
+    if(groups.size() == 1)
+    {
+        OBJGroup const* group = groups[0];
+        OBJCount count = 0;
+        OBJVertexGroup const* line = group->getLine(1, count);
+
+        Check((group->getLineCount() == 2) && (count == 2) && (line[0].indexSpatial == 2) && (line[1].indexSpatial == 3), "Lines are stored in CSR form");
+
+        group->getPointCollection(0, count);
+        Check((group->getPointCollectionCount() == 1) && (count == 2), "Point collections are stored in CSR form");
+    }
+    else
+    {
+        Check(false, "One group parsed");
+    }
+}
+
+#ifndef OBJ_PARSER_NO_FREE_FORMS
+
+void CheckFreeForms()
+{
+    std::cout << "- Free-Form Pools" << std::endl;
+
+    OBJParser parser;
+    OBJFreeFormState const* freeForms = parser.getOBJState()->getFreeFormState();
+
+    // The second 'parm u' and 'trim' of the surface follow other appends to the same pool, so their ranges are relocated
+
+    Check(ParseSource(parser, "./objcheck_freeforms.obj", 
+        "v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\nvp 0 0\nvp 1 0\nvp 1 1\nvp 0 1\n"
+        "cstype bspline\ndeg 1\n"
+        "curv2 1 2 3 4\nparm u 0 0 1 1\nend\n"
+        "curv2 -2 -1\nparm u 0 1\nend\n"
+        "curv 0 1 1 2 3\nparm u 0 0 1 1\nend\n"
+        "surf 0 1 0 1 1 2 3 4\nparm u 0 0 1\nparm v 0 0 1 1\nparm u 1\n"
+        "trim 0 1 1\nhole 0 1 2\ntrim 1 0 2\nscrv 0 1 1\nsp 1 2\nsp 3\nend\n"), "Parses the free-form sample");
+
+    if((freeForms->curves2D.size() == 2) && (freeForms->curves.size() == 1) && (freeForms->surfaces.size() == 1))
+    {
+        OBJCurve2D const& first = freeForms->curves2D[0];
+        OBJCurve2D const& second = freeForms->curves2D[1];
+        OBJIndex const* firstIndices = freeForms->getIndices(first.parameterVertexIndices);
+        OBJIndex const* secondIndices = freeForms->getIndices(second.parameterVertexIndices);
+
+        Check((first.parameterVertexIndices.count == 4) && (firstIndices[0] == 1) && (firstIndices[3] == 4) && 
+              (second.parameterVertexIndices.count == 2) && (secondIndices[0] == 3) && (secondIndices[1] == 4) && 
+              (first.parametersU.count == 4) && (second.parametersU.count == 2), "Curve2D ranges hold their own points and parameters");
+
+        OBJCurve const& curve = freeForms->curves[0];
+        OBJVertexGroup const* curvePoints = freeForms->getControlPoints(curve.controlPoints);
+        float const* curveU = freeForms->getParameters(curve.parametersU);
+
+        Check((curve.controlPoints.count == 3) && (curvePoints[0].indexSpatial == 0) && (curvePoints[2].indexSpatial == 2) && 
+              (curve.parametersU.count == 4) && (curveU[1] == 0.0f) && (curveU[2] == 1.0f) && (freeForms->getParameters(curve.parametersV) == nullptr), 
+              "Curve ranges hold their own control points and parameters");
+
+        OBJSurface const& surface = freeForms->surfaces[0];
+        OBJVertexGroup const* surfacePoints = freeForms->getControlPoints(surface.controlPoints);
+        float const* surfaceU = freeForms->getParameters(surface.parametersU);
+        float const* surfaceV = freeForms->getParameters(surface.parametersV);
+
+        Check((surface.controlPoints.count == 4) && (surfacePoints[0].indexSpatial == 0) && (surfacePoints[3].indexSpatial == 3) && 
+              (surface.parametersV.count == 4) && (surfaceV[0] == 0.0f) && (surfaceV[3] == 1.0f), "Surface ranges hold their own control points and parameters");
+
+        Check((surface.parametersU.offset > surface.parametersV.offset) && (surface.parametersU.count == 4) && 
+              (surfaceU[0] == 0.0f) && (surfaceU[2] == 1.0f) && (surfaceU[3] == 1.0f) && ((surface.parametersU.offset + surface.parametersU.count) == freeForms->parameterPool.size()), 
+              "Appending to a range followed by another range relocates it intact");
+
+        OBJSimpleCurve const* trims = freeForms->getSimpleCurves(surface.trims);
+        OBJSimpleCurve const* holes = freeForms->getSimpleCurves(surface.holes);
+        OBJSimpleCurve const* special = freeForms->getSimpleCurves(surface.specialCurves);
+        OBJIndex const* specialPoints = freeForms->getIndices(surface.specialPoints);
+
+        Check((surface.trims.count == 2) && (surface.trims.offset > surface.holes.offset) && (trims[0].startParam == 0.0f) && (trims[1].startParam == 1.0f) && 
+              (surface.holes.count == 1) && (holes[0].endParam == 1.0f) && (surface.specialCurves.count == 1) && (special[0].endParam == 1.0f), 
+              "Trims, holes, and special curves share one pool");
+
+        Check((surface.specialPoints.count == 3) && (specialPoints[0] == 1) && (specialPoints[2] == 3), "Special points of several statements form one range");
+    }
+    else
+    {
+        Check(false, "Two curve2Ds, one curve, and one surface parsed");
+    }
+}
+
+#endif
+
+void CheckArena()
+{
+    std::cout << "- Arena Allocation" << std::endl;
+
+    OBJArena arena;
+    OBJParser parser(&arena);
+
+    Check(ParseSource(parser, "./objcheck_arena.obj", "v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\ng arena\nf 1 2 3\nf 1 3 4\nl 1 2\n") && 
+          (parser.getOBJState()->getSpatialCount() == 4), "Parses into an arena");
+
+    OBJStateResult result;
+    Check(!parser.getOBJState()->takeResult(result), "Arena-backed data can not be moved out");
+
+    // The clear only resets the arena, so every string held by the state must have been allocated from it.
+    // Names are longer than any small string buffer, and the sample is parsed twice to reuse the reset arena.
+
+    const std::string materials = "./objcheck_arena_material_library.mtl";
+    WriteFile(materials, "newmtl arena_material_with_a_long_name\nKd spectral arena_reflectance_curve.rfl 0.5\n");
+
+    std::string source = "mtllib objcheck_arena_material_library.mtl\nv 0 0 0\nv 1 0 0\nv 0 1 0\n"
+                         "g arena_group_with_a_long_name\nusemtl arena_material_with_a_long_name\nf 1 2 3\n";
+#ifndef OBJ_PARSER_NO_FREE_FORMS
+    source += "cstype bmatrix\ndeg 1\nbmat u 1 0 0 1\n";
+#endif
+
+    OBJState* state = parser.getOBJState();
+
+    Check(ParseSource(parser, "./objcheck_arena_strings.obj", source) && ParseSource(parser, "./objcheck_arena_strings.obj", source), "Parses the string sample twice into the arena");
+
+    std::vector<OBJGroup const*> groups;
+    state->getGroups(groups);
+
+    OBJArenaVector<OBJArenaString> const* libraries = state->getMaterialLibraries();
+
+    Check((groups.size() == 1) && (groups[0]->name == "arena_group_with_a_long_name") && (groups[0]->name.get_allocator().getArena() == &arena) &&
+          (libraries->size() == 1) && ((*libraries)[0] == "objcheck_arena_material_library.mtl") && ((*libraries)[0].get_allocator().getArena() == &arena),
+          "Group names and library paths are allocated from the arena");
+
+    if(groups.size() == 1)
+    {
+        const OBJRenderState renderState = state->getRenderState(groups[0]->faces[0].renderState);
+        Check((renderState.material == "arena_material_with_a_long_name") && (renderState.material.get_allocator().getArena() == nullptr), "Render states are copied out onto the heap");
+    }
+
+#ifndef OBJ_PARSER_NO_MTL
+    std::vector<OBJMaterial const*> parsed;
+    state->getMaterials(parsed);
+
+    Check((parsed.size() == 1) && (parsed[0]->getName() == "arena_material_with_a_long_name") && (parsed[0]->getName().get_allocator().getArena() == &arena) &&
+          (parsed[0]->getDiffuseReflectivity().rfl.path == "arena_reflectance_curve.rfl") && (parsed[0]->getDiffuseReflectivity().rfl.path.get_allocator().getArena() == &arena),
+          "Material names and paths are allocated from the arena");
+#endif
+
+#ifndef OBJ_PARSER_NO_FREE_FORMS
+    OBJFreeFormAttributeState const& attributes = state->getFreeFormState()->attributeStates.back();
+    Check((attributes.basisMatrixU.size() == 4) && (attributes.basisMatrixU.get_allocator().getArena() == &arena), "Basis matrices are allocated from the arena");
+#endif
+
+    std::remove(materials.c_str());
+}
+
+void CheckReuse()
+{
+    std::cout << "- Parser Reuse" << std::endl;
+
+    OBJParser parser;
+    OBJState* state = parser.getOBJState();
+    std::vector<OBJGroup const*> groups;
+
+    Check(ParseSource(parser, "./objcheck_first.obj", "v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\ng first\nf 1 2 3\nf 1 3 4\ng second\nf 2 3 4\n"), "Parses the first sample");
+    Check(ParseSource(parser, "./objcheck_latest.obj", "v 0 0 0\nv 1 0 0\nv 0 1 0\ng latest\nf 1 2 3\n"), "Parses the second sample with the same parser");
+
+    state->getGroups(groups);
+
+    Check((state->getSpatialCount() == 3) && (groups.size() == 1) && (groups[0]->name == "latest") && (groups[0]->faces.size() == 1), "Reused parser holds only the latest parse");
+}
+
+void CheckSegmentedVector()
+{
+    std::cout << "- Segmented Vector" << std::endl;
+
+    OBJSegmentedVector<std::string, 6> strings;
+    const std::string value(64, 'x');
+
+    strings.push_back(value);
+
+    // Each append copies an element of the container itself, through every growth of the first block
+
+    for(uint32_t i = 0; i < 200; ++i)
+    {
+        if(i % 2)
+        {
+            strings.push_back(strings[i / 2]);
+        }
+        else
+        {
+            strings.emplace_back(strings.back());
+        }
+    }
+
+    Check((strings.size() == 201) && (std::count(strings.begin(), strings.end(), value) == 201), "Appending an element of the container copies it intact");
+}
+
+void CheckQuantization()
+{
+    std::cout << "- Quantized Positions" << std::endl;
+
+    OBJParser parser;
+    OBJState* state = parser.getOBJState();
+
+    state->setSpatialQuantization(16);
+
+    Check(ParseSource(parser, "./objcheck_grid.obj", GridSource(8, 8, false, false)), "Parses the quantized sample");
+
+    float error = 0.0f;
+
+    for(uint32_t i = 0; i < state->getSpatialCount(); ++i)
+    {
+        const OBJVector4 spatial = state->getSpatial(i);
+        error = std::max(error, std::fabs(spatial.x - static_cast<float>(i % 9)) + std::fabs(spatial.y - static_cast<float>(i / 9)));
+    }
+
+    Check((state->getQuantizedSpatialData() != nullptr) && (state->getQuantizedSpatialData()->size() == 81) && (error <= (16.0f / 65535.0f)), "Quantized positions are within one step");
+}
+
+void CheckEncodings()
+{
+    std::cout << "- Encoded Normals and Texture Coordinates" << std::endl;
+
+    OBJParser parser;
+    OBJState* state = parser.getOBJState();
+
+    state->setNormalEncoding(OBJNormalEncoding::Octahedral16);
+    state->setTextureEncoding(OBJTextureEncoding::Unorm16);
+
+    Check(ParseSource(parser, "./objcheck_grid.obj", GridSource(8, 8, false, false)), "Parses the encoded sample");
+
+    const OBJVector3 normal = state->getNormal(0);
+    const OBJVector2 texture = state->getTexture(80);
+
+    Check((state->getEncodedNormalData() != nullptr) && (std::fabs(normal.z - 1.0f) < 1e-4f) && (std::fabs(normal.x) < 1e-4f), "Octahedral normals decode");
+    Check((state->getEncodedTextureData() != nullptr) && (std::fabs(texture.x - 1.0f) < 1e-4f) && (std::fabs(texture.y - 1.0f) < 1e-4f), "16-bit texture coordinates decode");
+}
+
+void CheckSpatialW()
+{
+    std::cout << "- Spatial w" << std::endl;
+
+    OBJParser parser;
+    OBJState* state = parser.getOBJState();
+
+    Check(ParseSource(parser, "./objcheck_packed.obj", "v 0 0 0\nv 1 0 0 1\nv 0 1 0\ng packed\nf 1 2 3\n"), "Parses the sample without w");
+    Check((state->getSpatialCount() == 3) && !state->hasSpatialW() && (state->getSpatial(1).w == 1.0f), "Spatial vertices are stored without w");
+
+    Check(ParseSource(parser, "./objcheck_w.obj", "v 0 0 0 2\nv 1 0 0\nv 0 1 0\ng w\nf 1 2 3\n"), "Parses the homogeneous sample");
+    Check(state->hasSpatialW() && (state->getSpatial(0).w == 2.0f) && (state->getSpatial(1).w == 1.0f), "Spatial w is kept when a vertex specifies it");
+}
+
+void CheckRelativeIndices()
+{
+    std::cout << "- Relative Indices" << std::endl;
+
+    OBJParser parser;
+    OBJState* state = parser.getOBJState();
+
+    Check(ParseSource(parser, "./objcheck_relative.obj", "v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\nvt 0 0\nvt 1 0\nvt 1 1\nvn 0 0 1\ng relative\nf 1/1/1 2/2/1 3/3/1\nf -1/-1/-1 -2/-2/-1 -3/-3/-1\n"), 
+          "Parses the relative index sample");
+
+    std::vector<OBJGroup const*> groups;
+    state->getGroups(groups);
+
+    if(groups.size() == 1)
+    {
+        OBJFace const& relative = groups[0]->faces[1];
+        Check((relative.group0.indexSpatial == 3) && (relative.group1.indexSpatial == 2) && (relative.group2.indexSpatial == 1) && (relative.group0.indexTexture == 2), "Negative indices resolve relative to the end");
+    }
+    else
+    {
+        Check(false, "One group parsed");
+    }
+
+#ifndef OBJ_PARSER_USE_64BIT_INDICES
+    Check(!ParseSource(parser, "./objcheck_overflow.obj", "v 0 0 0\nv 1 0 0\nv 0 1 0\ng overflow\nf 1 2 4294967299\n"), "Indices past the index width fail the parse");
+    Check(parser.getLastError().find("line 'f 1 2 4294967299' at byte offset 35 ") != std::string::npos, "Parse errors report the whole line and the offset of its start");
+#endif
+}
+
+void CheckTakeResult()
+{
+    std::cout << "- Result Transfer" << std::endl;
+
+    OBJParser parser;
+    OBJState* state = parser.getOBJState();
+    OBJStateResult result;
+
+    Check(ParseSource(parser, "./objcheck_result.obj", "v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\ng result\nf 1 2 3\nf 1 3 4\n"), "Parses the transfer sample");
+    Check(state->takeResult(result) && (result.packedSpatialData.size() == 4) && (result.groups.size() == 1) && (state->getSpatialCount() == 0), "Parsed data moves out of the state");
+}
+
+void CheckFreeze()
+{
+    std::cout << "- Frozen Snapshots" << std::endl;
+
+    OBJParser parser;
+    OBJState* state = parser.getOBJState();
+
+    Check(ParseSource(parser, "./objcheck_frozen.obj", "v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\ng frozen\nf 1 2 3\nf 1 3 4\nf 2 3 4\nl 1 2 3\nl 3 4\n"), "Parses the snapshot sample");
+
+    std::shared_ptr<OBJSnapshot const> snapshot = state->freeze();
+    state->clearState();
+
+    Check((snapshot != nullptr) && (snapshot->getGroupCount() == 1) && (snapshot->getData().spatialCount == 4) && 
+          (snapshot->getGroup(0).faceCount == 3) && (snapshot->getGroup(0).lineCount == 2) && (snapshot->getGroupName(0) == "frozen"), 
+          "Frozen snapshot outlives a clear of its state");
+}
+
+#ifndef OBJ_PARSER_NO_MTL
+
+void CheckTextureTable()
+{
+    std::cout << "- Texture Table" << std::endl;
+
+    const std::string materials = "./objcheck_textures.mtl";
+    WriteFile(materials, "newmtl a\nmap_Kd shared.png\nnewmtl b\nmap_Kd shared.png\nbump b_bump.png\n");
+
+    OBJParser parser;
+    OBJState* state = parser.getOBJState();
+
+    Check(ParseSource(parser, "./objcheck_textures.obj", "mtllib objcheck_textures.mtl\nv 0 0 0\nv 1 0 0\nv 1 1 0\ng textures\nusemtl a\nf 1 2 3\nusemtl b\nf 1 3 2\n"), 
+          "Parses the texture sample");
+
+    OBJMaterial const* a = nullptr;
+    OBJMaterial const* b = nullptr;
+    std::vector<OBJMaterial const*> parsed;
+    state->getMaterials(parsed);
+
+    for(auto material : parsed)
+    {
+        (material->getName() == "a" ? a : b) = material;
+    }
+
+    Check((a != nullptr) && (b != nullptr) && (a->getTexture(OBJTextureSlot::Diffuse) != 0) && (a->getTexture(OBJTextureSlot::Diffuse) == b->getTexture(OBJTextureSlot::Diffuse)) && 
+          (state->getTextureDescriptor(a->getTexture(OBJTextureSlot::Diffuse)).getPath() == "shared.png"), "Identical texture descriptors share one id");
+    Check((b != nullptr) && (b->getTexture(OBJTextureSlot::Bump) != 0) && (b->getTexture(OBJTextureSlot::Bump) != b->getTexture(OBJTextureSlot::Diffuse)), "Distinct texture descriptors get distinct ids");
+
+    std::remove(materials.c_str());
+}
+
+#endif
+
+void CheckMeshBuilder()
+{
+    std::cout << "- Mesh Builder" << std::endl;
+
+    OBJParser parser;
+    OBJState* state = parser.getOBJState();
+    OBJMeshBuilder builder;
+    OBJMesh mesh;
+
+    Check(ParseSource(parser, "./objcheck_grid.obj", GridSource(4, 4, false, false)) && builder.build(*state, mesh), "Builds the grid");
+    Check((mesh.vertexCount == 25) && (mesh.indices.size() == 96) && (mesh.subsets.size() == 1) && (mesh.vertexStride == 8), "Shared corners build one vertex each");
+
+    std::vector<OBJGroup const*> groups;
+    state->getGroups(groups);
+
+    bool matching = (groups.size() == 1) && (groups[0]->faces.size() * 3 == mesh.indices.size());
+
+    for(std::size_t f = 0; matching && (f < groups[0]->faces.size()); ++f)
+    {
+        OBJFace const& face = groups[0]->faces[f];
+        OBJVertexGroup const corners[3] = { face.group0, face.group1, face.group2 };
+
+        for(uint32_t c = 0; c < 3; ++c)
+        {
+            const OBJVector4 spatial = state->getSpatial(corners[c].indexSpatial);
+            const OBJVector2 texture = state->getTexture(corners[c].indexTexture);
+            float const* vertex = &mesh.vertices[mesh.indices[(f * 3) + c] * mesh.vertexStride];
+
+            matching = matching && (vertex[0] == spatial.x) && (vertex[1] == spatial.y) && (vertex[2] == spatial.z) && 
+                                   (vertex[mesh.textureOffset] == texture.x) && (vertex[mesh.textureOffset + 1] == texture.y);
+        }
+    }
+
+    Check(matching, "Every triangle corner holds the attributes of its face vertex");
+
+    builder.setIncludeTexture(false);
+    builder.setIncludeNormal(false);
+
+    Check(builder.build(*state, mesh) && (mesh.vertexCount == 25) && (mesh.vertexStride == 3) && (mesh.indices.size() == 96), "Positions-only grid builds 25 vertices");
+
+    // 1000 positions but 3000 distinct position/texture pairs, so the vertex table has to grow while building
+
+    std::ostringstream source;
+
+    for(uint32_t i = 0; i < 1000; ++i)
+    {
+        source << "v " << i << " " << (i % 7) << " 0\n";
+    }
+
+    for(uint32_t i = 0; i < 3000; ++i)
+    {
+        source << "vt " << (i / 3000.0f) << " " << ((i % 11) / 11.0f) << "\n";
+    }
+
+    source << "g growth\n";
+
+    for(uint32_t f = 0; f < 1000; ++f)
+    {
+        source << "f";
+
+        for(uint32_t c = 0; c < 3; ++c)
+        {
+            source << " " << (((f * 3 + c) % 1000) + 1) << "/" << (f * 3 + c + 1);
+        }
+
+        source << "\n";
+    }
+
+    OBJMeshBuilder growing;
+
+    Check(ParseSource(parser, "./objcheck_growth.obj", source.str()) && growing.build(*state, mesh), "Builds a mesh that outgrows the initial vertex table");
+    Check((mesh.vertexCount == 3000) && (mesh.indices.size() == 3000) && VerticesMatchSources(*state, mesh), "Vertices added while the table grows match their sources");
+}
+
+#ifndef OBJ_PARSER_NO_MTL
+
+void CheckBatches()
+{
+    std::cout << "- Draw Batches" << std::endl;
+
+    const std::string materials = "./objcheck_batches.mtl";
+    std::ostringstream source;
+
+    source << "mtllib objcheck_batches.mtl\nv 0 0 0\nv 1 0 0\nv 0 1 0\n";
+
+    for(uint32_t g = 0; g < 16; ++g)
+    {
+        source << "g part" << g << "\n";
+
+        for(uint32_t f = 0; f < 1000; ++f)
+        {
+            if((f % 250) == 0)
+            {
+                source << "usemtl " << (((g + (f / 250)) % 2) ? "a" : "b") << "\ns " << (f / 500) << "\n";
+            }
+
+            source << "f 1 2 3\n";
+        }
+    }
+
+    WriteFile(materials, "newmtl a\nKd 1 0 0\nnewmtl b\nKd 0 1 0\n");
+
+    OBJParser parser;
+    OBJState* state = parser.getOBJState();
+
+    Check(ParseSource(parser, "./objcheck_batches.obj", source.str()), "Parses the batch sample");
+
+    OBJBatchBuilder builder;
+    OBJDrawBatches serial;
+    OBJDrawBatches parallel;
+
+    builder.setSplitSmoothing(true);
+    builder.setThreadCount(1);
+    const bool builtSerial = builder.build(*state, serial);
+
+    builder.setThreadCount(4);
+    const bool builtParallel = builder.build(*state, parallel);
+
+    Check(builtSerial && builtParallel && (serial.faces == parallel.faces) && (serial.batches.size() == 4) && (parallel.batches.size() == 4), "Serial and parallel builds match");
+
+    bool sorted = true;
+    bool matching = true;
+    uint32_t total = 0;
+
+    for(std::size_t i = 0; i < parallel.batches.size(); ++i)
+    {
+        OBJDrawBatch const& batch = parallel.batches[i];
+
+        if((i > 0) && (batch.material < parallel.batches[i - 1].material))
+        {
+            sorted = false;
+        }
+
+        for(uint32_t f = batch.firstFace; f < (batch.firstFace + batch.faceCount); ++f)
+        {
+            const OBJRenderState renderState = state->getRenderState(parallel.faces[f]->renderState);
+            matching = matching && (batch.material != OBJDrawBatches::NoMaterial) && (renderState.material == parallel.materials[batch.material]->getName()) && (renderState.smoothing == batch.smoothing);
+        }
+
+        total += batch.faceCount;
+    }
+
+    Check(sorted && matching && (total == 16000) && (parallel.faces.size() == 16000), "Every face is in the batch of its material and smoothing group");
+
+    std::remove(materials.c_str());
+}
+
+#endif
+
+void CheckVertexPacker()
+{
+    std::cout << "- Vertex Packing" << std::endl;
+
+    OBJParser parser;
+    OBJState* state = parser.getOBJState();
+    OBJMeshBuilder builder;
+    OBJMesh mesh;
+
+    Check(ParseSource(parser, "./objcheck_grid.obj", GridSource(4, 4, false, false)) && builder.build(*state, mesh), "Builds the packing sample");
+
+    OBJVertexLayout layout;
+    layout.position = OBJPositionFormat::Float3;
+    layout.normal = OBJNormalFormat::Snorm16x4;
+    layout.texture = OBJTexCoordFormat::Unorm16x2;
+    layout.computeOffsets();
+
+    std::vector<uint8_t> packed(layout.stride * mesh.vertexCount);
+
+    Check(layout.isValid() && (layout.stride == 24) && OBJVertexPacker::pack(*state, layout, mesh.sources.data(), mesh.sources.size(), nullptr, packed.data()), "Packs a 24 byte layout");
+
+    float error = 0.0f;
+
+    for(uint32_t v = 0; v < mesh.vertexCount; ++v)
+    {
+        uint8_t const* vertex = &packed[v * layout.stride];
+
+        float position[3];
+        int16_t normal[4];
+        uint16_t texture[2];
+
+        std::memcpy(position, vertex + layout.positionOffset, sizeof(position));
+        std::memcpy(normal, vertex + layout.normalOffset, sizeof(normal));
+        std::memcpy(texture, vertex + layout.textureOffset, sizeof(texture));
+
+        const OBJVector4 expectedPosition = state->getSpatial(mesh.sources[v].indexSpatial);
+        const OBJVector2 expectedTexture = state->getTexture(mesh.sources[v].indexTexture);
+
+        error = std::max(error, std::fabs(position[0] - expectedPosition.x) + std::fabs(position[1] - expectedPosition.y) + std::fabs(position[2] - expectedPosition.z));
+        error = std::max(error, std::fabs((static_cast<float>(normal[2]) / 32767.0f) - 1.0f) + std::fabs(static_cast<float>(normal[0]) / 32767.0f));
+        error = std::max(error, std::fabs((static_cast<float>(texture[0]) / 65535.0f) - expectedTexture.x) + std::fabs((static_cast<float>(texture[1]) / 65535.0f) - expectedTexture.y));
+    }
+
+    Check(error < 1e-4f, "Packed attributes decode to their sources");
+}
+
+void CheckCacheOptimizer()
+{
+    std::cout << "- Vertex Cache Optimization" << std::endl;
+
+    OBJParser parser;
+    OBJState* state = parser.getOBJState();
+    OBJMeshBuilder builder;
+    OBJMesh mesh;
+
+    Check(ParseSource(parser, "./objcheck_grid.obj", GridSource(48, 48, false, true)) && builder.build(*state, mesh), "Builds the shuffled grid");
+
+    const std::vector<uint64_t> triangles = TriangleKeys(mesh, mesh.indices);
+
+    OBJVertexCacheOptimizer optimizer;
+    OBJVertexCacheReport report;
+    optimizer.optimize(mesh, report);
+
+    float acmr = 0.0f;
+    float atvr = 0.0f;
+    OBJVertexCacheOptimizer::measure(mesh.indices.data(), mesh.indices.size(), mesh.vertexCount, 16, acmr, atvr);
+
+    Check(report.acmrAfter < report.acmrBefore, "ACMR improves");
+    Check(std::fabs(acmr - report.acmrAfter) < 1e-5f, "Reported ACMR matches a separate measurement");
+    Check(TriangleKeys(mesh, mesh.indices) == triangles, "Optimization keeps every triangle");
+
+    OBJMesh clustered;
+    OBJVertexCacheOptimizer overdrawOptimizer;
+    OBJVertexCacheReport clusteredReport;
+
+    overdrawOptimizer.setOverdrawThreshold(1.05f);
+    builder.build(*state, clustered);
+    overdrawOptimizer.optimize(clustered, clusteredReport);
+
+    Check((clusteredReport.clusterCount > 1) && (TriangleKeys(clustered, clustered.indices) == triangles), "Overdraw ordering keeps every triangle");
+
+    OBJVertexCacheOptimizer::optimizeVertexFetch(mesh);
+
+    Check((TriangleKeys(mesh, mesh.indices) == triangles) && VerticesMatchSources(*state, mesh), "Vertex fetch reordering keeps every triangle and vertex");
+}
+
+void CheckMeshlets()
+{
+    std::cout << "- Meshlets" << std::endl;
+
+    OBJParser parser;
+    OBJState* state = parser.getOBJState();
+    OBJMeshBuilder builder;
+    OBJMesh mesh;
+
+    Check(ParseSource(parser, "./objcheck_grid.obj", GridSource(48, 48, false, true)) && builder.build(*state, mesh), "Builds the meshlet sample");
+
+    const std::vector<uint64_t> triangles = TriangleKeys(mesh, mesh.indices);
+
+    const uint32_t limits[2][2] = { { 64, 124 }, { 32, 40 } };
+
+    for(auto const& limit : limits)
+    {
+        OBJMeshletBuilder meshletBuilder;
+        OBJMeshlets meshlets;
+
+        meshletBuilder.setLimits(limit[0], limit[1]);
+        meshletBuilder.build(*state, mesh, meshlets);
+
+        bool bounded = !meshlets.meshlets.empty();
+        std::vector<uint32_t> indices;
+
+        for(auto const& meshlet : meshlets.meshlets)
+        {
+            bounded = bounded && (meshlet.vertexCount <= limit[0]) && (meshlet.triangleCount <= limit[1]);
+
+            for(uint32_t i = 0; i < (meshlet.triangleCount * 3); ++i)
+            {
+                const uint8_t local = meshlets.triangles[(meshlet.triangleOffset * 3) + i];
+                bounded = bounded && (local < meshlet.vertexCount);
+                indices.push_back(meshlets.vertices[meshlet.vertexOffset + local]);
+            }
+        }
+
+        std::ostringstream description;
+        description << "Meshlets stay within " << limit[0] << " vertices and " << limit[1] << " triangles";
+
+        Check(bounded, description.str());
+        Check(TriangleKeys(mesh, indices) == triangles, "Meshlets cover every triangle once");
+    }
+}
+
+void CheckNormals()
+{
+    std::cout << "- Normal Generation" << std::endl;
+
+    for(int smooth = 1; smooth >= 0; --smooth)
+    {
+        OBJParser parser;
+        OBJState* state = parser.getOBJState();
+        OBJNormalGenerator generator;
+
+        const bool parsed = ParseSource(parser, "./objcheck_cube.obj", CubeSource(smooth != 0));
+        const bool generated = parsed && generator.generate(*state);
+        const OBJCount expected = (smooth ? 8 : 24);
+
+        Check(generated && (state->getNormalCount() == expected), (smooth ? "Smooth cube has 8 normals" : "Faceted cube has 24 normals"));
+
+        if(!smooth && generated)
+        {
+            // Each faceted normal must be perpendicular to the edges of its face
+
+            std::vector<OBJGroup const*> groups;
+            state->getGroups(groups);
+
+            float error = 0.0f;
+
+            for(auto const& face : groups[0]->faces)
+            {
+                const OBJVector4 a = state->getSpatial(face.group0.indexSpatial);
+                const OBJVector4 b = state->getSpatial(face.group1.indexSpatial);
+                const OBJVector3 n = state->getNormal(face.group0.indexNormal);
+
+                error = std::max(error, std::fabs(((b.x - a.x) * n.x) + ((b.y - a.y) * n.y) + ((b.z - a.z) * n.z)));
+            }
+
+            Check(error < 1e-5f, "Faceted normals are perpendicular to their faces");
+
+            OBJMeshBuilder builder;
+            OBJMesh mesh;
+
+            Check(builder.build(*state, mesh) && (mesh.vertexCount == 24) && (mesh.indices.size() == 36), "Faceted cube builds 24 vertices and 36 indices");
+
+            builder.setIncludeNormal(false);
+
+            Check(builder.build(*state, mesh) && (mesh.vertexCount == 8) && (mesh.indices.size() == 36) && VerticesMatchSources(*state, mesh), "Positions-only cube builds 8 vertices");
+        }
+    }
+
+    OBJParser parser;
+    OBJParser other;
+    OBJState* state = parser.getOBJState();
+
+    Check(ParseSource(parser, "./objcheck_cube.obj", CubeSource(true)) && ParseSource(other, "./objcheck_cube.obj", CubeSource(true)), "Parses the face normal samples");
+
+    std::vector<OBJGroup const*> groups;
+    std::vector<OBJGroup const*> otherGroups;
+    state->getGroups(groups);
+    other.getOBJState()->getGroups(otherGroups);
+
+    const OBJCount normals[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+    const OBJCount outOfRange[4] = { 0, 0, 1, 0 };
+
+    state->appendNormals(std::vector<OBJVector3>(1));
+
+    Check(state->hasFaces(groups[0], 0, groups[0]->faces.size()) && !state->hasFaces(groups[0], 1, groups[0]->faces.size()) && !state->hasFaces(otherGroups[0], 0, 1), 
+          "Face ranges are only valid within the state's own groups");
+    Check(!state->setFaceNormals(otherGroups[0], 0, 2, normals) && !state->setFaceNormals(nullptr, 0, 2, normals), "Face normals of groups owned by another state are rejected");
+    Check(!state->setFaceNormals(groups[0], groups[0]->faces.size() - 1, 2, normals) && !state->setFaceNormals(groups[0], 0, 1, outOfRange), "Out of range faces and normals are rejected");
+    Check(state->setFaceNormals(groups[0], 0, 2, normals) && (groups[0]->faces[1].group2.indexNormal == groups[0]->faces[0].group0.indexNormal) && (state->getNormalCount() == 1), "Face normals of the state's own groups are replaced");
+}
+
+void CheckTangents()
+{
+    std::cout << "- Tangent Generation" << std::endl;
+
+    const std::string materials = "./objcheck_tangents.mtl";
+    WriteFile(materials, "newmtl bumped\nbump bumped_normal.png\n");
+
+    OBJParser parser;
+    OBJState* state = parser.getOBJState();
+    OBJMeshBuilder builder;
+    OBJMesh mesh;
+
+    Check(ParseSource(parser, "./objcheck_grid.obj", "mtllib objcheck_tangents.mtl\nusemtl bumped\n" + GridSource(16, 16, true, false)) && builder.build(*state, mesh), "Builds the mirrored grid");
+
+    const uint32_t vertexCount = mesh.vertexCount;
+    const std::vector<uint64_t> triangles = TriangleKeys(mesh, mesh.indices);
+
+    OBJTangentGenerator generator;
+    std::vector<OBJVector4> tangents;
+
+#ifndef OBJ_PARSER_NO_MTL
+    Check(OBJTangentGenerator::isBumpMapped(*state, state->getRenderState(mesh.subsets[0].renderState)) && !OBJTangentGenerator::isBumpMapped(*state, OBJRenderState()), 
+          "Bump-mapped render states are detected");
+#else
+    generator.setBumpMappedOnly(false);     // The material library is not loaded, so no subset is bump-mapped
+#endif
+
+    Check(generator.generate(*state, mesh, tangents) && (tangents.size() == mesh.vertexCount), "Generates one tangent per vertex");
+    Check((mesh.vertexCount > vertexCount) && (TriangleKeys(mesh, mesh.indices) == triangles) && VerticesMatchSources(*state, mesh), "Vertices on the mirror seam are split");
+
+    bool unit = true;
+    uint32_t mirrored = 0;
+
+    for(auto const& tangent : tangents)
+    {
+        const float length = std::sqrt((tangent.x * tangent.x) + (tangent.y * tangent.y) + (tangent.z * tangent.z));
+        unit = unit && (std::fabs(length - 1.0f) < 1e-4f) && (std::fabs(tangent.w) == 1.0f);
+        mirrored += ((tangent.w < 0.0f) ? 1 : 0);
+    }
+
+    Check(unit && (mirrored > 0) && (mirrored < tangents.size()), "Tangents are unit length with handedness on both sides of the seam");
+
+    // Without a bump-mapped material, subsets are only processed on request
+
+#ifndef OBJ_PARSER_NO_MTL
+    Check(ParseSource(parser, "./objcheck_grid.obj", GridSource(16, 16, true, false)) && builder.build(*state, mesh) && 
+          generator.generate(*state, mesh, tangents) && (mesh.vertexCount == vertexCount), "Subsets without a bump-mapped material are skipped");
+
+    generator.setBumpMappedOnly(false);
+#else
+    Check(ParseSource(parser, "./objcheck_grid.obj", GridSource(16, 16, true, false)), "Parses the grid without a material");
+#endif
+
+    Check(builder.build(*state, mesh) && generator.generate(*state, mesh, tangents) && (mesh.vertexCount > vertexCount) && (tangents.size() == mesh.vertexCount), 
+          "Every subset is processed when not limited to bump-mapped materials");
+
+    std::remove(materials.c_str());
+}
+
+void CheckShortIndices()
+{
+    std::cout << "- 16-bit Index Splitting" << std::endl;
+
+    {
+        OBJParser parser;
+        OBJState* state = parser.getOBJState();
+        OBJMeshBuilder builder;
+        OBJMesh mesh;
+
+        builder.setSubsetVertexLimit(300);
+        builder.setShortIndices(true);
+
+        Check(ParseSource(parser, "./objcheck_grid.obj", GridSource(40, 40, true, false)) && builder.build(*state, mesh), "Builds the split grid");
+        Check((mesh.subsets.size() > 4) && ShortIndicesMatch(mesh), "Short indices match the full indices of every subset");
+        Check(VerticesMatchSources(*state, mesh), "Vertices of split subsets match their sources");
+
+        std::vector<OBJVertexGroup> corners;
+
+        for(auto index : mesh.indices)
+        {
+            corners.push_back(mesh.sources[index]);
+        }
+
+        // Tangent split vertices must land within the subset that uses them
+
+        OBJTangentGenerator generator;
+        std::vector<OBJVector4> tangents;
+        generator.setBumpMappedOnly(false);
+
+        bool unchanged = generator.generate(*state, mesh, tangents) && (tangents.size() == mesh.vertexCount) && (corners.size() == mesh.indices.size());
+
+        for(std::size_t i = 0; unchanged && (i < corners.size()); ++i)
+        {
+            OBJVertexGroup const& source = mesh.sources[mesh.indices[i]];
+            unchanged = (source.indexSpatial == corners[i].indexSpatial) && (source.indexTexture == corners[i].indexTexture);
+        }
+
+        Check(unchanged && VerticesMatchSources(*state, mesh), "Tangent generation keeps the corners of every triangle");
+        Check(ShortIndicesMatch(mesh), "Short indices still match after tangent vertex splits");
+
+        OBJVertexCacheOptimizer optimizer;
+        OBJVertexCacheReport report;
+
+        optimizer.optimize(mesh, report);
+        Check(ShortIndicesMatch(mesh), "Short indices still match after cache optimization");
+
+        OBJVertexCacheOptimizer::optimizeVertexFetch(mesh);
+        Check(ShortIndicesMatch(mesh) && VerticesMatchSources(*state, mesh), "Short indices still match after vertex fetch optimization");
+    }
+
+    // The first subset is filled to the 16-bit limit, leaving no room for split vertices.
+    // Skipped when the storage policy can not index that many vertices (see OBJCompactStorage).
+
+    if(OBJStorage::Indices::isRepresentable(301 * 221))
+    {
+        OBJParser parser;
+        OBJState* state = parser.getOBJState();
+        OBJMeshBuilder builder;
+        OBJMesh mesh;
+
+        builder.setShortIndices(true);
+
+        Check(ParseSource(parser, "./objcheck_grid.obj", GridSource(300, 220, true, false)) && builder.build(*state, mesh), "Builds the full subset grid");
+
+        const uint32_t vertexCount = mesh.vertexCount;
+        const std::vector<uint32_t> indices = mesh.indices;
+
+        OBJTangentGenerator generator;
+        std::vector<OBJVector4> tangents;
+        generator.setBumpMappedOnly(false);
+
+        Check(!generator.generate(*state, mesh, tangents) && (mesh.vertexCount == vertexCount) && (mesh.indices == indices) && ShortIndicesMatch(mesh), 
+              "Splits that would overflow a subset are refused without changing the mesh");
+    }
+}
+
+uint32_t RunChecks()
+{
+    std::cout << "------------------------------------------------------\n"
+                 "- OBJParser Self Checks\n"
+                 "------------------------------------------------------" << std::endl;
+
+    g_CheckFailures = 0;
+
+    CheckRenderStates();
+    CheckLinesAndPoints();
+#ifndef OBJ_PARSER_NO_FREE_FORMS
+    CheckFreeForms();
+#endif
+    CheckArena();
+    CheckReuse();
+    CheckSegmentedVector();
+    CheckQuantization();
+    CheckEncodings();
+    CheckSpatialW();
+    CheckRelativeIndices();
+    CheckTakeResult();
+    CheckFreeze();
+#ifndef OBJ_PARSER_NO_MTL
+    CheckTextureTable();
+#endif
+    CheckMeshBuilder();
+#ifndef OBJ_PARSER_NO_MTL
+    CheckBatches();
+#endif
+    CheckVertexPacker();
+    CheckCacheOptimizer();
+    CheckMeshlets();
+    CheckNormals();
+    CheckTangents();
+    CheckShortIndices();
+
+    std::cout << "\n" << g_CheckFailures << " check(s) failed" << std::endl;
+
+    return g_CheckFailures;
+}
+
 void Loop()
 {
     OBJParser parser;
@@ -123,6 +1237,11 @@ void Loop()
 
 int main(int argc, char** argv)
 {
+    if((argc > 1) && (std::string(argv[1]) == "--check"))
+    {
+        return (RunChecks() == 0) ? 0 : 1;
+    }
+
     Loop();
 
     return 0;